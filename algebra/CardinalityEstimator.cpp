@@ -0,0 +1,234 @@
+#include "algebra/CardinalityEstimator.hpp"
+#include "algebra/Expression.hpp"
+#include "algebra/Operator.hpp"
+#include <algorithm>
+//---------------------------------------------------------------------------
+// (c) 2023 Thomas Neumann
+//---------------------------------------------------------------------------
+using namespace std;
+//---------------------------------------------------------------------------
+namespace saneql::algebra {
+//---------------------------------------------------------------------------
+optional<string> CardinalityEstimator::getConstant(Expression* expression)
+// Get the value of a constant
+{
+   // Look through casts, typed literals like '1995-03-15'::date are casts of text constants
+   while (auto cast = dynamic_cast<CastExpression*>(expression))
+      expression = cast->getInput();
+   if (auto c = dynamic_cast<ConstExpression*>(expression); c && !c->isNull()) return c->getValue();
+   return {};
+}
+//---------------------------------------------------------------------------
+const Schema::ColumnStatistics* CardinalityEstimator::getStatistics(const IU* iu) const
+// Get the statistics of an IU
+{
+   auto iter = columnStatistics.find(iu);
+   return (iter != columnStatistics.end()) ? iter->second : nullptr;
+}
+//---------------------------------------------------------------------------
+optional<double> CardinalityEstimator::estimateLess(const IU* iu, const string& value, bool orEqual) const
+// Estimate the fraction of rows where a column is less than (or equal to) a constant
+{
+   auto stats = getStatistics(iu);
+   if (!stats) return {};
+   auto less = stats->estimateLess(iu->getType(), value);
+   if (!less) return {};
+   double result = *less;
+   if (orEqual && stats->distinctValues) result += 1 / stats->distinctValues;
+   return min(result, 1.0) * (1 - stats->nullFraction);
+}
+//---------------------------------------------------------------------------
+double CardinalityEstimator::getDistinctValues(const IU* iu) const
+// Get the estimated number of distinct values of an IU
+{
+   auto iter = distinctValues.find(iu);
+   if (iter == distinctValues.end()) return 0;
+   double limit = getDistinctLimit(iu);
+   return limit ? min(iter->second, limit) : iter->second;
+}
+//---------------------------------------------------------------------------
+double CardinalityEstimator::getDistinctLimit(const IU* iu) const
+// Get the upper bound for the number of distinct values of an IU
+{
+   auto iter = distinctLimits.find(iu);
+   return (iter != distinctLimits.end()) ? iter->second : 0;
+}
+//---------------------------------------------------------------------------
+void CardinalityEstimator::limitDistinctValues(const unordered_set<const IU*>& ius, double limit)
+// Limit the number of distinct values of IUs
+{
+   for (auto iu : ius) {
+      auto iter = distinctLimits.find(iu);
+      if (iter == distinctLimits.end())
+         distinctLimits[iu] = limit;
+      else
+         iter->second = min(iter->second, limit);
+   }
+}
+//---------------------------------------------------------------------------
+double CardinalityEstimator::estimate(Operator& op)
+// Estimate the cardinality of an operator tree
+{
+   auto inputCardinality = [&]() { return estimate(**op.getInputs().front()); };
+   double result = defaultCardinality;
+   if (auto scan = dynamic_cast<TableScan*>(&op)) {
+      auto table = scan->getTable();
+      if (table && table->cardinality) result = table->cardinality;
+      unordered_set<const IU*> columns;
+      for (auto& c : scan->getColumns())
+         columns.insert(c.iu.get());
+      limitDistinctValues(columns, result);
+
+      // Remember the column statistics
+      if (table)
+         for (auto& c : scan->getColumns())
+            for (auto& tc : table->columns)
+               if ((tc.name == c.name) && tc.statistics.isKnown()) {
+                  columnStatistics[c.iu.get()] = &tc.statistics;
+                  if (tc.statistics.distinctValues) distinctValues[c.iu.get()] = tc.statistics.distinctValues;
+               }
+   } else if (auto select = dynamic_cast<Select*>(&op)) {
+      result = inputCardinality() * estimateSelectivity(*select->accessCondition());
+   } else if (dynamic_cast<Map*>(&op) || dynamic_cast<Window*>(&op)) {
+      result = inputCardinality();
+   } else if (auto groupBy = dynamic_cast<GroupBy*>(&op)) {
+      double input = inputCardinality();
+      result = 1;
+      for (auto& g : groupBy->getGroupBy()) {
+         auto ref = dynamic_cast<IURef*>(g.value.get());
+         double distinct = ref ? getDistinctValues(ref->getIU()) : 0;
+         result *= distinct ? distinct : input * defaultEqualitySelectivity;
+         result = min(result, input);
+      }
+      for (auto& g : groupBy->getGroupBy())
+         distinctValues[g.iu.get()] = result;
+   } else if (auto sort = dynamic_cast<Sort*>(&op)) {
+      result = inputCardinality();
+      if (sort->limit.has_value()) result = min<double>(result, *sort->limit);
+   } else if (auto join = dynamic_cast<Join*>(&op)) {
+      double left = estimate(*join->accessLeft()), right = estimate(*join->accessRight());
+      double inner = left * right * estimateSelectivity(*join->accessCondition());
+      switch (join->getJoinType()) {
+         case Join::JoinType::Inner: result = inner; break;
+         case Join::JoinType::LeftOuter: result = max(left, inner); break;
+         case Join::JoinType::RightOuter: result = max(right, inner); break;
+         case Join::JoinType::FullOuter: result = max(left + right, inner); break;
+         case Join::JoinType::LeftSemi: result = min(left, inner); break;
+         case Join::JoinType::RightSemi: result = min(right, inner); break;
+         case Join::JoinType::LeftAnti: result = left - min(left, inner) / 2; break;
+         case Join::JoinType::RightAnti: result = right - min(right, inner) / 2; break;
+      }
+   } else if (auto setOp = dynamic_cast<SetOperation*>(&op)) {
+      double left = estimate(*setOp->accessLeft()), right = estimate(*setOp->accessRight());
+      switch (setOp->getOp()) {
+         case SetOperation::Op::Union:
+         case SetOperation::Op::UnionAll: result = left + right; break;
+         case SetOperation::Op::Intersect:
+         case SetOperation::Op::IntersectAll: result = min(left, right); break;
+         case SetOperation::Op::Except:
+         case SetOperation::Op::ExceptAll: result = left; break;
+      }
+   } else if (auto inlineTable = dynamic_cast<InlineTable*>(&op)) {
+      result = inlineTable->rowCount;
+   } else if (auto cteRef = dynamic_cast<CTERef*>(&op)) {
+      result = estimate(*cteRef->getCTE().op);
+   }
+   return max(result, 1.0);
+}
+//---------------------------------------------------------------------------
+double CardinalityEstimator::estimateSelectivity(Expression& predicate) const
+// Estimate the selectivity of a predicate
+{
+   // The fraction of non-NULL values of an expression
+   auto nonNull = [&](Expression* e) {
+      auto ref = dynamic_cast<IURef*>(e);
+      auto stats = ref ? getStatistics(ref->getIU()) : nullptr;
+      return stats ? 1 - stats->nullFraction : 1;
+   };
+   // The selectivity of an equality comparison. Uses the larger known domain of both sides.
+   // Without known domains, a comparison of two columns is assumed to be a key/foreign key join
+   auto equality = [&](Expression& left, Expression* right) {
+      // A constant outside of the value range of a column does not qualify
+      for (auto [column, other] : {pair{&left, right}, pair{right, &left}}) {
+         auto ref = dynamic_cast<IURef*>(column);
+         auto stats = ref ? getStatistics(ref->getIU()) : nullptr;
+         auto value = other ? getConstant(other) : optional<string>();
+         if (stats && value) {
+            auto type = ref->getIU()->getType();
+            if ((stats->min && Schema::ColumnStatistics::less(type, *value, *stats->min)) || (stats->max && Schema::ColumnStatistics::less(type, *stats->max, *value))) return 0.0;
+         }
+      }
+      double distinct = 0, limit = 0;
+      for (auto e : {&left, right})
+         if (auto ref = dynamic_cast<IURef*>(e)) {
+            distinct = max(distinct, getDistinctValues(ref->getIU()));
+            if (double l = getDistinctLimit(ref->getIU()); l && ((!limit) || (l < limit))) limit = l;
+         }
+      if (distinct) return nonNull(&left) * nonNull(right) / distinct;
+      if (dynamic_cast<IURef*>(&left) && dynamic_cast<IURef*>(right) && limit) return 1 / limit;
+      return defaultEqualitySelectivity;
+   };
+   // The selectivity of a range comparison. Uses the histograms for comparisons between columns and constants
+   auto range = [&](Expression& left, Expression& right, bool less, bool orEqual) {
+      auto ref = dynamic_cast<IURef*>(&left);
+      auto value = getConstant(&right);
+      if ((!ref) || (!value)) {
+         ref = dynamic_cast<IURef*>(&right);
+         value = getConstant(&left);
+         less = !less;
+      }
+      if (ref && value) {
+         if (less) {
+            if (auto result = estimateLess(ref->getIU(), *value, orEqual)) return *result;
+         } else {
+            if (auto result = estimateLess(ref->getIU(), *value, !orEqual)) return max(nonNull(ref) - *result, 0.0);
+         }
+      }
+      return defaultRangeSelectivity;
+   };
+   // The selectivity of an IS NULL check
+   auto isNull = [&](Expression& input) {
+      auto ref = dynamic_cast<IURef*>(&input);
+      auto stats = ref ? getStatistics(ref->getIU()) : nullptr;
+      return stats ? stats->nullFraction : defaultEqualitySelectivity;
+   };
+
+   if (auto b = dynamic_cast<BinaryExpression*>(&predicate)) {
+      if (b->op == BinaryExpression::And) return estimateSelectivity(*b->left) * estimateSelectivity(*b->right);
+      if (b->op == BinaryExpression::Or) {
+         double left = estimateSelectivity(*b->left), right = estimateSelectivity(*b->right);
+         return left + right - left * right;
+      }
+   } else if (auto u = dynamic_cast<UnaryExpression*>(&predicate)) {
+      if (u->op == UnaryExpression::Not) return 1 - estimateSelectivity(*u->input);
+   } else if (auto c = dynamic_cast<ComparisonExpression*>(&predicate)) {
+      Expression* nullCheck = c->right.get();
+      while (auto cast = dynamic_cast<CastExpression*>(nullCheck))
+         nullCheck = cast->getInput();
+      bool isNullCheck = dynamic_cast<ConstExpression*>(nullCheck) && static_cast<ConstExpression*>(nullCheck)->isNull();
+      switch (c->mode) {
+         case ComparisonExpression::Equal: return equality(*c->left, c->right.get());
+         case ComparisonExpression::Is: return isNullCheck ? isNull(*c->left) : equality(*c->left, c->right.get());
+         case ComparisonExpression::NotEqual: return 1 - equality(*c->left, c->right.get());
+         case ComparisonExpression::IsNot: return isNullCheck ? 1 - isNull(*c->left) : 1 - equality(*c->left, c->right.get());
+         case ComparisonExpression::Less: return range(*c->left, *c->right, true, false);
+         case ComparisonExpression::LessOrEqual: return range(*c->left, *c->right, true, true);
+         case ComparisonExpression::Greater: return range(*c->left, *c->right, false, false);
+         case ComparisonExpression::GreaterOrEqual: return range(*c->left, *c->right, false, true);
+         case ComparisonExpression::Like: return defaultSelectivity;
+      }
+   } else if (auto b = dynamic_cast<BetweenExpression*>(&predicate)) {
+      auto ref = dynamic_cast<IURef*>(b->base.get());
+      auto lower = getConstant(b->lower.get()), upper = getConstant(b->upper.get());
+      if (ref && lower && upper) {
+         auto below = estimateLess(ref->getIU(), *lower, false), upTo = estimateLess(ref->getIU(), *upper, true);
+         if (below && upTo) return max(*upTo - *below, 0.0);
+      }
+   } else if (auto in = dynamic_cast<InExpression*>(&predicate)) {
+      return min(1.0, in->values.size() * equality(*in->probe, nullptr));
+   }
+   return defaultSelectivity;
+}
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
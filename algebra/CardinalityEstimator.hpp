@@ -0,0 +1,67 @@
+#ifndef H_saneql_CardinalityEstimator
+#define H_saneql_CardinalityEstimator
+//---------------------------------------------------------------------------
+#include "infra/Schema.hpp"
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+//---------------------------------------------------------------------------
+// SaneQL
+// (c) 2023 Thomas Neumann
+// SPDX-License-Identifier: BSD-3-Clause
+//---------------------------------------------------------------------------
+namespace saneql {
+//---------------------------------------------------------------------------
+namespace algebra {
+//---------------------------------------------------------------------------
+class Expression;
+class IU;
+class Operator;
+//---------------------------------------------------------------------------
+/// Estimates result sizes of operator trees from the schema statistics.
+/// Falls back to textbook selectivities when no statistics are known
+class CardinalityEstimator {
+   public:
+   /// The cardinality of tables without statistics
+   static constexpr double defaultCardinality = 1000;
+   /// The selectivity of equality predicates without statistics
+   static constexpr double defaultEqualitySelectivity = 0.1;
+   /// The selectivity of range predicates
+   static constexpr double defaultRangeSelectivity = 1.0 / 3;
+   /// The selectivity of other predicates
+   static constexpr double defaultSelectivity = 0.25;
+
+   private:
+   /// The known number of distinct values per IU
+   std::unordered_map<const IU*, double> distinctValues;
+   /// Upper bounds for the number of distinct values per IU
+   std::unordered_map<const IU*, double> distinctLimits;
+   /// The column statistics of IUs produced by table scans
+   std::unordered_map<const IU*, const Schema::ColumnStatistics*> columnStatistics;
+
+   /// Get the value of a constant (if it is a non-NULL constant)
+   static std::optional<std::string> getConstant(Expression* expression);
+   /// Get the statistics of an IU (if any)
+   const Schema::ColumnStatistics* getStatistics(const IU* iu) const;
+   /// Estimate the fraction of rows where a column is less than (or equal to) a constant. nullopt if unknown
+   std::optional<double> estimateLess(const IU* iu, const std::string& value, bool orEqual) const;
+
+   public:
+   /// Estimate the cardinality of an operator tree
+   double estimate(Operator& op);
+   /// Estimate the selectivity of a predicate
+   double estimateSelectivity(Expression& predicate) const;
+
+   /// Get the estimated number of distinct values of an IU. 0 if unknown
+   double getDistinctValues(const IU* iu) const;
+   /// Get the upper bound for the number of distinct values of an IU. 0 if unknown
+   double getDistinctLimit(const IU* iu) const;
+   /// Limit the number of distinct values of IUs, for example by the cardinality of their producer
+   void limitDistinctValues(const std::unordered_set<const IU*>& ius, double limit);
+};
+//---------------------------------------------------------------------------
+}
+}
+//---------------------------------------------------------------------------
+#endif
@@ -10,11 +10,58 @@ using namespace std;
 //---------------------------------------------------------------------------
 namespace saneql::algebra {
 //---------------------------------------------------------------------------
+namespace {
+//---------------------------------------------------------------------------
+/// Helper to copy subexpressions. Remembers if a subexpression could not be copied
+struct Cloner {
+   /// The substitutions
+   const Expression::Substitutions& substitutions;
+   /// Could all subexpressions be copied?
+   bool valid = true;
+
+   /// Copy an optional expression
+   unique_ptr<Expression> operator()(const unique_ptr<Expression>& e) {
+      if (!e) return {};
+      auto result = e->clone(substitutions);
+      if (!result) valid = false;
+      return result;
+   }
+   /// Copy a list of expressions
+   vector<unique_ptr<Expression>> operator()(const vector<unique_ptr<Expression>>& list) {
+      vector<unique_ptr<Expression>> result;
+      for (auto& e : list)
+         result.push_back((*this)(e));
+      return result;
+   }
+   /// Copy case entries
+   SimpleCaseExpression::Cases operator()(const SimpleCaseExpression::Cases& cases) {
+      SimpleCaseExpression::Cases result;
+      for (auto& c : cases) {
+         auto condition = (*this)(c.first);
+         result.emplace_back(move(condition), (*this)(c.second));
+      }
+      return result;
+   }
+};
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
 Expression::~Expression()
 // Destructor
 {
 }
 //---------------------------------------------------------------------------
+void Expression::collectUsage(IUUsage&)
+// Collect the used IUs
+{
+}
+//---------------------------------------------------------------------------
+unique_ptr<Expression> Expression::clone(const Substitutions&) const
+// Copy the expression, replacing the substituted IU references
+{
+   return {};
+}
+//---------------------------------------------------------------------------
 void Expression::generateOperand(SQLWriter& out)
 // Generate SQL in a form that is suitable as operand
 {
@@ -35,6 +82,19 @@ void IURef::generate(SQLWriter& out)
    out.writeIU(iu);
 }
 //---------------------------------------------------------------------------
+void IURef::collectUsage(IUUsage& usage)
+// Collect the used IUs
+{
+   usage.used.insert(iu);
+}
+//---------------------------------------------------------------------------
+unique_ptr<Expression> IURef::clone(const Substitutions& substitutions) const
+// Copy the expression
+{
+   if (auto iter = substitutions.find(iu); iter != substitutions.end()) return iter->second->clone({});
+   return make_unique<IURef>(iu);
+}
+//---------------------------------------------------------------------------
 void ConstExpression::generate(SQLWriter& out)
 // Generate SQL
 {
@@ -54,6 +114,30 @@ void ConstExpression::generate(SQLWriter& out)
    }
 }
 //---------------------------------------------------------------------------
+unique_ptr<Expression> ConstExpression::clone(const Substitutions&) const
+// Copy the expression
+{
+   if (null) return make_unique<ConstExpression>(nullptr, getType());
+   return make_unique<ConstExpression>(value, getType());
+}
+//---------------------------------------------------------------------------
+void ParameterExpression::generate(SQLWriter& out)
+// Generate SQL
+{
+   // Always cast, the database cannot infer parameter types in all contexts
+   out.write("cast(");
+   out.writeParameter(slot);
+   out.write(" as ");
+   out.writeType(getType());
+   out.write(")");
+}
+//---------------------------------------------------------------------------
+unique_ptr<Expression> ParameterExpression::clone(const Substitutions&) const
+// Copy the expression
+{
+   return make_unique<ParameterExpression>(slot, getType());
+}
+//---------------------------------------------------------------------------
 void CastExpression::generate(SQLWriter& out)
 // Generate SQL
 {
@@ -64,6 +148,21 @@ void CastExpression::generate(SQLWriter& out)
    out.write(")");
 }
 //---------------------------------------------------------------------------
+void CastExpression::collectUsage(IUUsage& usage)
+// Collect the used IUs
+{
+   input->collectUsage(usage);
+}
+//---------------------------------------------------------------------------
+unique_ptr<Expression> CastExpression::clone(const Substitutions& substitutions) const
+// Copy the expression
+{
+   Cloner cloner{substitutions};
+   auto i = cloner(input);
+   if (!cloner.valid) return {};
+   return make_unique<CastExpression>(move(i), getType());
+}
+//---------------------------------------------------------------------------
 ComparisonExpression::ComparisonExpression(unique_ptr<Expression> left, unique_ptr<Expression> right, Mode mode, Collate collate)
    : Expression(Type::getBool().withNullable((mode != Mode::Is) && (mode != Mode::IsNot) && (left->getType().isNullable() || right->getType().isNullable()))), left(move(left)), right(move(right)), mode(mode), collate(collate)
 // Constructor
@@ -88,6 +187,22 @@ void ComparisonExpression::generate(SQLWriter& out)
    right->generateOperand(out);
 }
 //---------------------------------------------------------------------------
+void ComparisonExpression::collectUsage(IUUsage& usage)
+// Collect the used IUs
+{
+   left->collectUsage(usage);
+   right->collectUsage(usage);
+}
+//---------------------------------------------------------------------------
+unique_ptr<Expression> ComparisonExpression::clone(const Substitutions& substitutions) const
+// Copy the expression
+{
+   Cloner cloner{substitutions};
+   auto l = cloner(left), r = cloner(right);
+   if (!cloner.valid) return {};
+   return make_unique<ComparisonExpression>(move(l), move(r), mode, collate);
+}
+//---------------------------------------------------------------------------
 BetweenExpression::BetweenExpression(unique_ptr<Expression> base, unique_ptr<Expression> lower, unique_ptr<Expression> upper, Collate collate)
    : Expression(Type::getBool().withNullable(base->getType().isNullable() || lower->getType().isNullable() || upper->getType().isNullable())), base(move(base)), lower(move(lower)), upper(move(upper)), collate(collate)
 // Constructor
@@ -104,6 +219,23 @@ void BetweenExpression::generate(SQLWriter& out)
    upper->generateOperand(out);
 }
 //---------------------------------------------------------------------------
+void BetweenExpression::collectUsage(IUUsage& usage)
+// Collect the used IUs
+{
+   base->collectUsage(usage);
+   lower->collectUsage(usage);
+   upper->collectUsage(usage);
+}
+//---------------------------------------------------------------------------
+unique_ptr<Expression> BetweenExpression::clone(const Substitutions& substitutions) const
+// Copy the expression
+{
+   Cloner cloner{substitutions};
+   auto b = cloner(base), l = cloner(lower), u = cloner(upper);
+   if (!cloner.valid) return {};
+   return make_unique<BetweenExpression>(move(b), move(l), move(u), collate);
+}
+//---------------------------------------------------------------------------
 InExpression::InExpression(unique_ptr<Expression> probe, vector<unique_ptr<Expression>> values, Collate collate)
    : Expression(Type::getBool().withNullable(probe->getType().isNullable() || any_of(values.begin(), values.end(), [](auto& e) { return e->getType().isNullable(); }))), probe(move(probe)), values(move(values)), collate(collate)
 // Constructor
@@ -126,6 +258,24 @@ void InExpression::generate(SQLWriter& out)
    out.write(")");
 }
 //---------------------------------------------------------------------------
+void InExpression::collectUsage(IUUsage& usage)
+// Collect the used IUs
+{
+   probe->collectUsage(usage);
+   for (auto& v : values)
+      v->collectUsage(usage);
+}
+//---------------------------------------------------------------------------
+unique_ptr<Expression> InExpression::clone(const Substitutions& substitutions) const
+// Copy the expression
+{
+   Cloner cloner{substitutions};
+   auto p = cloner(probe);
+   auto v = cloner(values);
+   if (!cloner.valid) return {};
+   return make_unique<InExpression>(move(p), move(v), collate);
+}
+//---------------------------------------------------------------------------
 BinaryExpression::BinaryExpression(unique_ptr<Expression> left, unique_ptr<Expression> right, Type resultType, Operation op)
    : Expression(resultType), left(move(left)), right(move(right)), op(op)
 // Constructor
@@ -150,6 +300,22 @@ void BinaryExpression::generate(SQLWriter& out)
    right->generateOperand(out);
 }
 //---------------------------------------------------------------------------
+void BinaryExpression::collectUsage(IUUsage& usage)
+// Collect the used IUs
+{
+   left->collectUsage(usage);
+   right->collectUsage(usage);
+}
+//---------------------------------------------------------------------------
+unique_ptr<Expression> BinaryExpression::clone(const Substitutions& substitutions) const
+// Copy the expression
+{
+   Cloner cloner{substitutions};
+   auto l = cloner(left), r = cloner(right);
+   if (!cloner.valid) return {};
+   return make_unique<BinaryExpression>(move(l), move(r), getType(), op);
+}
+//---------------------------------------------------------------------------
 UnaryExpression::UnaryExpression(unique_ptr<Expression> input, Type resultType, Operation op)
    : Expression(resultType), input(move(input)), op(op)
 // Constructor
@@ -167,6 +333,21 @@ void UnaryExpression::generate(SQLWriter& out)
    input->generateOperand(out);
 }
 //---------------------------------------------------------------------------
+void UnaryExpression::collectUsage(IUUsage& usage)
+// Collect the used IUs
+{
+   input->collectUsage(usage);
+}
+//---------------------------------------------------------------------------
+unique_ptr<Expression> UnaryExpression::clone(const Substitutions& substitutions) const
+// Copy the expression
+{
+   Cloner cloner{substitutions};
+   auto i = cloner(input);
+   if (!cloner.valid) return {};
+   return make_unique<UnaryExpression>(move(i), getType(), op);
+}
+//---------------------------------------------------------------------------
 ExtractExpression::ExtractExpression(unique_ptr<Expression> input, Part part)
    : Expression(Type::getInteger().withNullable(input->getType().isNullable())), input(move(input)), part(part)
 // Constructor
@@ -187,6 +368,21 @@ void ExtractExpression::generate(SQLWriter& out)
    out.write(")");
 }
 //---------------------------------------------------------------------------
+void ExtractExpression::collectUsage(IUUsage& usage)
+// Collect the used IUs
+{
+   input->collectUsage(usage);
+}
+//---------------------------------------------------------------------------
+unique_ptr<Expression> ExtractExpression::clone(const Substitutions& substitutions) const
+// Copy the expression
+{
+   Cloner cloner{substitutions};
+   auto i = cloner(input);
+   if (!cloner.valid) return {};
+   return make_unique<ExtractExpression>(move(i), part);
+}
+//---------------------------------------------------------------------------
 SubstrExpression::SubstrExpression(unique_ptr<Expression> value, unique_ptr<Expression> from, unique_ptr<Expression> len)
    : Expression(value->getType().withNullable(value->getType().isNullable() || (from ? from->getType().isNullable() : false) || (len ? len->getType().isNullable() : false))), value(move(value)), from(move(from)), len(move(len))
 // Constructor
@@ -209,6 +405,23 @@ void SubstrExpression::generate(SQLWriter& out)
    out.write(")");
 }
 //---------------------------------------------------------------------------
+void SubstrExpression::collectUsage(IUUsage& usage)
+// Collect the used IUs
+{
+   value->collectUsage(usage);
+   if (from) from->collectUsage(usage);
+   if (len) len->collectUsage(usage);
+}
+//---------------------------------------------------------------------------
+unique_ptr<Expression> SubstrExpression::clone(const Substitutions& substitutions) const
+// Copy the expression
+{
+   Cloner cloner{substitutions};
+   auto v = cloner(value), f = cloner(from), l = cloner(len);
+   if (!cloner.valid) return {};
+   return make_unique<SubstrExpression>(move(v), move(f), move(l));
+}
+//---------------------------------------------------------------------------
 SimpleCaseExpression::SimpleCaseExpression(unique_ptr<Expression> value, Cases cases, unique_ptr<Expression> defaultValue)
    : Expression(defaultValue->getType()), value(move(value)), cases(move(cases)), defaultValue(move(defaultValue))
 // Constructor
@@ -231,6 +444,28 @@ void SimpleCaseExpression::generate(SQLWriter& out)
    out.write(" end");
 }
 //---------------------------------------------------------------------------
+void SimpleCaseExpression::collectUsage(IUUsage& usage)
+// Collect the used IUs
+{
+   value->collectUsage(usage);
+   for (auto& c : cases) {
+      c.first->collectUsage(usage);
+      c.second->collectUsage(usage);
+   }
+   if (defaultValue) defaultValue->collectUsage(usage);
+}
+//---------------------------------------------------------------------------
+unique_ptr<Expression> SimpleCaseExpression::clone(const Substitutions& substitutions) const
+// Copy the expression
+{
+   Cloner cloner{substitutions};
+   auto v = cloner(value);
+   auto c = cloner(cases);
+   auto d = cloner(defaultValue);
+   if (!cloner.valid) return {};
+   return make_unique<SimpleCaseExpression>(move(v), move(c), move(d));
+}
+//---------------------------------------------------------------------------
 SearchedCaseExpression::SearchedCaseExpression(Cases cases, unique_ptr<Expression> defaultValue)
    : Expression(defaultValue->getType()), cases(move(cases)), defaultValue(move(defaultValue))
 // Constructor
@@ -252,6 +487,26 @@ void SearchedCaseExpression::generate(SQLWriter& out)
    out.write(" end");
 }
 //---------------------------------------------------------------------------
+void SearchedCaseExpression::collectUsage(IUUsage& usage)
+// Collect the used IUs
+{
+   for (auto& c : cases) {
+      c.first->collectUsage(usage);
+      c.second->collectUsage(usage);
+   }
+   if (defaultValue) defaultValue->collectUsage(usage);
+}
+//---------------------------------------------------------------------------
+unique_ptr<Expression> SearchedCaseExpression::clone(const Substitutions& substitutions) const
+// Copy the expression
+{
+   Cloner cloner{substitutions};
+   auto c = cloner(cases);
+   auto d = cloner(defaultValue);
+   if (!cloner.valid) return {};
+   return make_unique<SearchedCaseExpression>(move(c), move(d));
+}
+//---------------------------------------------------------------------------
 Aggregate::Aggregate(unique_ptr<Operator> input, vector<Aggregation> aggregates, unique_ptr<Expression> computation)
    : Expression(computation->getType()), input(move(input)), aggregates(move(aggregates)), computation(move(computation))
 // Constructor
@@ -297,6 +552,51 @@ void Aggregate::generate(SQLWriter& out)
    out.write(")");
 }
 //---------------------------------------------------------------------------
+void Aggregate::collectUsage(IUUsage& usage)
+// Collect the used IUs
+{
+   usage.subqueries.push_back(&input);
+   input->collectUsage(usage);
+   for (auto& a : aggregates) {
+      if (a.value) a.value->collectUsage(usage);
+      for (auto& p : a.parameters)
+         p->collectUsage(usage);
+   }
+   computation->collectUsage(usage);
+}
+//---------------------------------------------------------------------------
+unique_ptr<Expression> Aggregate::clone(const Substitutions& substitutions) const
+// Copy the expression
+{
+   // Operator trees cannot be copied, but a CTE can be referenced again with new IUs
+   auto ref = dynamic_cast<CTERef*>(input.get());
+   if (!ref) return {};
+   auto& cte = ref->getSharedCTE();
+   bool owner = ref->getColumns().empty();
+   if ((!owner) && (ref->getColumns().size() != cte->columns.size())) return {};
+   Substitutions mapping = substitutions;
+   vector<unique_ptr<IU>> columns;
+   vector<unique_ptr<Expression>> refs;
+   for (unsigned index = 0; index != cte->columns.size(); ++index) {
+      columns.push_back(make_unique<IU>(cte->columns[index]->getType()));
+      refs.push_back(make_unique<IURef>(columns.back().get()));
+      mapping[owner ? cte->columns[index] : ref->getColumns()[index].get()] = refs.back().get();
+   }
+
+   // Copy the aggregates, the computation references their new IUs
+   Cloner cloner{mapping};
+   vector<Aggregation> copies;
+   for (auto& a : aggregates) {
+      auto value = cloner(a.value);
+      copies.push_back({move(value), make_unique<IU>(a.iu->getType()), a.op, cloner(a.parameters)});
+      refs.push_back(make_unique<IURef>(copies.back().iu.get()));
+      mapping[a.iu.get()] = refs.back().get();
+   }
+   auto c = cloner(computation);
+   if (!cloner.valid) return {};
+   return make_unique<Aggregate>(make_unique<CTERef>(cte, move(columns)), move(copies), move(c));
+}
+//---------------------------------------------------------------------------
 ForeignCall::ForeignCall(string name, Type returnType, vector<unique_ptr<Expression>> arguments, CallType callType)
    : Expression(returnType), name(std::move(name)), arguments(std::move(arguments)), callType(callType)
 // Constructor
@@ -350,5 +650,21 @@ void ForeignCall::generate(SQLWriter& out) {
    }
 }
 //---------------------------------------------------------------------------
+void ForeignCall::collectUsage(IUUsage& usage)
+// Collect the used IUs
+{
+   for (auto& a : arguments)
+      a->collectUsage(usage);
+}
+//---------------------------------------------------------------------------
+unique_ptr<Expression> ForeignCall::clone(const Substitutions& substitutions) const
+// Copy the expression
+{
+   Cloner cloner{substitutions};
+   auto a = cloner(arguments);
+   if (!cloner.valid) return {};
+   return make_unique<ForeignCall>(name, getType(), move(a), callType);
+}
+//---------------------------------------------------------------------------
 }
 //---------------------------------------------------------------------------
@@ -4,6 +4,7 @@
 #include "infra/Schema.hpp"
 #include "semana/Functions.hpp"
 #include <memory>
+#include <unordered_map>
 #include <vector>
 //---------------------------------------------------------------------------
 // SaneQL
@@ -18,6 +19,7 @@ class SQLWriter;
 namespace algebra {
 //---------------------------------------------------------------------------
 class IU;
+class IUUsage;
 class Operator;
 //---------------------------------------------------------------------------
 /// Base class for expressions
@@ -27,6 +29,9 @@ class Expression {
    Type type;
 
    public:
+   /// Substitutions for IU references when copying expressions
+   using Substitutions = std::unordered_map<const IU*, const Expression*>;
+
    /// Constructor
    explicit Expression(Type type) : type(type) {}
    /// Destructor
@@ -39,6 +44,10 @@ class Expression {
    virtual void generate(SQLWriter& out) = 0;
    /// Generate SQL in a form that is suitable as operand
    virtual void generateOperand(SQLWriter& out);
+   /// Collect the used IUs
+   virtual void collectUsage(IUUsage& usage);
+   /// Copy the expression, replacing the substituted IU references. Returns nullptr if the expression cannot be copied
+   virtual std::unique_ptr<Expression> clone(const Substitutions& substitutions) const;
 };
 //---------------------------------------------------------------------------
 /// An IU reference
@@ -55,6 +64,10 @@ class IURef : public Expression {
 
    /// Generate SQL
    void generate(SQLWriter& out) override;
+   /// Collect the used IUs
+   void collectUsage(IUUsage& usage) override;
+   /// Copy the expression
+   std::unique_ptr<Expression> clone(const Substitutions& substitutions) const override;
    /// Generate SQL in a form that is suitable as operand
    void generateOperand(SQLWriter& out) override { generate(out); }
 };
@@ -72,8 +85,35 @@ class ConstExpression : public Expression {
    /// Constructor for NULL values
    ConstExpression(std::nullptr_t, Type type) : Expression(type), null(true) {}
 
+   /// Get the raw value
+   const std::string& getValue() const { return value; }
+   /// Is the value NULL?
+   bool isNull() const { return null; }
+
    /// Generate SQL
    void generate(SQLWriter& out) override;
+   /// Copy the expression
+   std::unique_ptr<Expression> clone(const Substitutions& substitutions) const override;
+   /// Generate SQL in a form that is suitable as operand
+   void generateOperand(SQLWriter& out) override { generate(out); }
+};
+//---------------------------------------------------------------------------
+/// A query parameter
+class ParameterExpression : public Expression {
+   /// The parameter slot, starting from 0
+   unsigned slot;
+
+   public:
+   /// Constructor
+   ParameterExpression(unsigned slot, Type type) : Expression(type), slot(slot) {}
+
+   /// Get the slot
+   unsigned getSlot() const { return slot; }
+
+   /// Generate SQL
+   void generate(SQLWriter& out) override;
+   /// Copy the expression
+   std::unique_ptr<Expression> clone(const Substitutions& substitutions) const override;
    /// Generate SQL in a form that is suitable as operand
    void generateOperand(SQLWriter& out) override { generate(out); }
 };
@@ -87,8 +127,15 @@ class CastExpression : public Expression {
    /// Constructor
    CastExpression(std::unique_ptr<Expression> input, Type type) : Expression(type), input(move(input)) {}
 
+   /// Get the input
+   Expression* getInput() const { return input.get(); }
+
    /// Generate SQL
    void generate(SQLWriter& out) override;
+   /// Collect the used IUs
+   void collectUsage(IUUsage& usage) override;
+   /// Copy the expression
+   std::unique_ptr<Expression> clone(const Substitutions& substitutions) const override;
 };
 //---------------------------------------------------------------------------
 /// A comparison expression
@@ -119,6 +166,10 @@ class ComparisonExpression : public Expression {
 
    /// Generate SQL
    void generate(SQLWriter& out) override;
+   /// Collect the used IUs
+   void collectUsage(IUUsage& usage) override;
+   /// Copy the expression
+   std::unique_ptr<Expression> clone(const Substitutions& substitutions) const override;
 };
 //---------------------------------------------------------------------------
 /// A between expression
@@ -135,6 +186,10 @@ class BetweenExpression : public Expression {
 
    /// Generate SQL
    void generate(SQLWriter& out) override;
+   /// Collect the used IUs
+   void collectUsage(IUUsage& usage) override;
+   /// Copy the expression
+   std::unique_ptr<Expression> clone(const Substitutions& substitutions) const override;
 };
 //---------------------------------------------------------------------------
 /// An in expression
@@ -153,6 +208,10 @@ class InExpression : public Expression {
 
    /// Generate SQL
    void generate(SQLWriter& out) override;
+   /// Collect the used IUs
+   void collectUsage(IUUsage& usage) override;
+   /// Copy the expression
+   std::unique_ptr<Expression> clone(const Substitutions& substitutions) const override;
 };
 //---------------------------------------------------------------------------
 /// A binary expression
@@ -181,6 +240,10 @@ class BinaryExpression : public Expression {
 
    /// Generate SQL
    void generate(SQLWriter& out) override;
+   /// Collect the used IUs
+   void collectUsage(IUUsage& usage) override;
+   /// Copy the expression
+   std::unique_ptr<Expression> clone(const Substitutions& substitutions) const override;
 };
 //---------------------------------------------------------------------------
 /// An unary expression
@@ -203,6 +266,10 @@ class UnaryExpression : public Expression {
 
    /// Generate SQL
    void generate(SQLWriter& out) override;
+   /// Collect the used IUs
+   void collectUsage(IUUsage& usage) override;
+   /// Copy the expression
+   std::unique_ptr<Expression> clone(const Substitutions& substitutions) const override;
 };
 //---------------------------------------------------------------------------
 /// An extract expression
@@ -225,6 +292,10 @@ class ExtractExpression : public Expression {
 
    /// Generate SQL
    void generate(SQLWriter& out) override;
+   /// Collect the used IUs
+   void collectUsage(IUUsage& usage) override;
+   /// Copy the expression
+   std::unique_ptr<Expression> clone(const Substitutions& substitutions) const override;
 };
 //---------------------------------------------------------------------------
 /// A substring expression
@@ -239,6 +310,10 @@ class SubstrExpression : public Expression {
 
    /// Generate SQL
    void generate(SQLWriter& out) override;
+   /// Collect the used IUs
+   void collectUsage(IUUsage& usage) override;
+   /// Copy the expression
+   std::unique_ptr<Expression> clone(const Substitutions& substitutions) const override;
 };
 //---------------------------------------------------------------------------
 /// A simple case expression
@@ -259,6 +334,10 @@ class SimpleCaseExpression : public Expression {
 
    /// Generate SQL
    void generate(SQLWriter& out) override;
+   /// Collect the used IUs
+   void collectUsage(IUUsage& usage) override;
+   /// Copy the expression
+   std::unique_ptr<Expression> clone(const Substitutions& substitutions) const override;
 };
 //---------------------------------------------------------------------------
 /// A searched case expression
@@ -277,6 +356,10 @@ class SearchedCaseExpression : public Expression {
 
    /// Generate SQL
    void generate(SQLWriter& out) override;
+   /// Collect the used IUs
+   void collectUsage(IUUsage& usage) override;
+   /// Copy the expression
+   std::unique_ptr<Expression> clone(const Substitutions& substitutions) const override;
 };
 //---------------------------------------------------------------------------
 /// Helper for aggregation steps
@@ -349,8 +432,19 @@ class Aggregate : public Expression, public AggregationLike {
    /// Constructor
    Aggregate(std::unique_ptr<Operator> input, std::vector<Aggregation> aggregates, std::unique_ptr<Expression> computation);
 
+   /// Access the input
+   std::unique_ptr<Operator>& accessInput() { return input; }
+   /// Get the aggregates
+   const std::vector<Aggregation>& getAggregates() const { return aggregates; }
+   /// Get the final result computation
+   Expression* getComputation() const { return computation.get(); }
+
    // Generate SQL
    void generate(SQLWriter& out) override;
+   /// Collect the used IUs
+   void collectUsage(IUUsage& usage) override;
+   /// Copy the expression. Only possible if the input is a CTE reference, the copy references the CTE again
+   std::unique_ptr<Expression> clone(const Substitutions& substitutions) const override;
 };
 //---------------------------------------------------------------------------
 /// A foreign call expression
@@ -373,6 +467,10 @@ struct ForeignCall : public Expression {
 
    /// Generate SQL
    void generate(SQLWriter& out) override;
+   /// Collect the used IUs
+   void collectUsage(IUUsage& usage) override;
+   /// Copy the expression
+   std::unique_ptr<Expression> clone(const Substitutions& substitutions) const override;
 };
 //---------------------------------------------------------------------------
 }
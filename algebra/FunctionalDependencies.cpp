@@ -0,0 +1,205 @@
+#include "algebra/FunctionalDependencies.hpp"
+#include "algebra/Expression.hpp"
+#include "algebra/Operator.hpp"
+#include <algorithm>
+#include <unordered_map>
+//---------------------------------------------------------------------------
+// (c) 2023 Thomas Neumann
+//---------------------------------------------------------------------------
+using namespace std;
+//---------------------------------------------------------------------------
+namespace saneql::algebra {
+//---------------------------------------------------------------------------
+static bool contains(const FunctionalDependencies::IUSet& set, const vector<const IU*>& ius)
+// Does a set contain all IUs?
+{
+   return all_of(ius.begin(), ius.end(), [&](const IU* iu) { return set.contains(iu); });
+}
+//---------------------------------------------------------------------------
+static const IU* getColumn(Expression* expression)
+// Get the IU of a column reference
+{
+   auto ref = dynamic_cast<IURef*>(expression);
+   return ref ? ref->getIU() : nullptr;
+}
+//---------------------------------------------------------------------------
+static bool isConstant(Expression* expression)
+// Is an expression a constant?
+{
+   while (auto cast = dynamic_cast<CastExpression*>(expression))
+      expression = cast->getInput();
+   return dynamic_cast<ConstExpression*>(expression);
+}
+//---------------------------------------------------------------------------
+void FunctionalDependencies::addKey(vector<const IU*> key)
+// Add a key if it is not implied by an existing one
+{
+   IUSet set(key.begin(), key.end());
+   for (auto& k : keys)
+      if (contains(set, k)) return;
+   erase_if(keys, [&](const vector<const IU*>& k) { return contains(IUSet(k.begin(), k.end()), key); });
+   if (keys.size() < maxKeys) keys.push_back(move(key));
+}
+//---------------------------------------------------------------------------
+void FunctionalDependencies::addEqualities(Expression& condition)
+// Add the dependencies implied by an equality predicate
+{
+   if (auto b = dynamic_cast<BinaryExpression*>(&condition); b && (b->op == BinaryExpression::And)) {
+      addEqualities(*b->left);
+      addEqualities(*b->right);
+      return;
+   }
+   auto c = dynamic_cast<ComparisonExpression*>(&condition);
+   if ((!c) || ((c->mode != ComparisonExpression::Equal) && (c->mode != ComparisonExpression::Is))) return;
+   auto left = getColumn(c->left.get()), right = getColumn(c->right.get());
+   if (left && right) {
+      dependencies.push_back({{left}, {right}});
+      dependencies.push_back({{right}, {left}});
+   } else if (left && isConstant(c->right.get())) {
+      dependencies.push_back({{}, {left}});
+   } else if (right && isConstant(c->left.get())) {
+      dependencies.push_back({{}, {right}});
+   }
+}
+//---------------------------------------------------------------------------
+FunctionalDependencies::IUSet FunctionalDependencies::computeClosure(IUSet ius) const
+// Compute the IUs that are determined by a set of IUs
+{
+   for (bool changed = true; changed;) {
+      changed = false;
+      for (auto& d : dependencies)
+         if (contains(ius, d.determinant))
+            for (auto iu : d.dependent)
+               changed |= ius.insert(iu).second;
+   }
+   return ius;
+}
+//---------------------------------------------------------------------------
+bool FunctionalDependencies::isUnique(const IUSet& ius) const
+// Is a set of IUs unique?
+{
+   if (keys.empty()) return false;
+   auto closure = computeClosure(ius);
+   return any_of(keys.begin(), keys.end(), [&](const vector<const IU*>& k) { return contains(closure, k); });
+}
+//---------------------------------------------------------------------------
+FunctionalDependencies FunctionalDependencies::derive(Operator& op)
+// Derive the keys and dependencies of an operator tree
+{
+   FunctionalDependencies result;
+   if (auto scan = dynamic_cast<TableScan*>(&op)) {
+      auto table = scan->getTable();
+      if (!table) return result;
+      vector<const IU*> columns;
+      unordered_map<string_view, const IU*> byName;
+      for (auto& c : scan->getColumns()) {
+         columns.push_back(c.iu.get());
+         byName[c.name] = c.iu.get();
+      }
+      // Keys with NULL values do not determine anything when NULLs compare equal
+      for (auto& k : table->getKeys()) {
+         vector<const IU*> key;
+         for (auto c : k) {
+            auto iter = byName.find(table->columns[c].name);
+            if ((iter == byName.end()) || table->columns[c].type.isNullable()) break;
+            key.push_back(iter->second);
+         }
+         if (key.size() != k.size()) continue;
+         result.dependencies.push_back({key, columns});
+         result.addKey(move(key));
+      }
+   } else if (auto select = dynamic_cast<Select*>(&op)) {
+      result = derive(*select->accessInput());
+      result.addEqualities(*select->accessCondition());
+   } else if (auto map = dynamic_cast<Map*>(&op)) {
+      result = derive(*map->accessInput());
+      for (auto& c : map->getComputations())
+         if (auto iu = getColumn(c.value.get())) {
+            result.dependencies.push_back({{iu}, {c.iu.get()}});
+            result.dependencies.push_back({{c.iu.get()}, {iu}});
+         }
+   } else if (dynamic_cast<Sort*>(&op) || dynamic_cast<Window*>(&op)) {
+      result = derive(**op.getInputs().front());
+   } else if (auto groupBy = dynamic_cast<GroupBy*>(&op)) {
+      auto input = derive(*groupBy->accessInput());
+      // Translate the dependencies between grouped columns
+      unordered_map<const IU*, const IU*> grouped;
+      vector<const IU*> groupIUs, aggregateIUs;
+      for (auto& g : groupBy->getGroupBy()) {
+         if (auto iu = getColumn(g.value.get())) grouped.emplace(iu, g.iu.get());
+         groupIUs.push_back(g.iu.get());
+      }
+      auto translate = [&](const vector<const IU*>& ius) {
+         vector<const IU*> translated;
+         for (auto iu : ius)
+            if (auto iter = grouped.find(iu); iter != grouped.end()) translated.push_back(iter->second);
+         return translated;
+      };
+      for (auto& d : input.dependencies) {
+         auto determinant = translate(d.determinant), dependent = translate(d.dependent);
+         if ((determinant.size() == d.determinant.size()) && (!dependent.empty())) result.dependencies.push_back({move(determinant), move(dependent)});
+      }
+      for (auto& k : input.keys)
+         if (auto key = translate(k); key.size() == k.size()) result.addKey(move(key));
+
+      for (auto& a : groupBy->accessAggregates())
+         aggregateIUs.push_back(a.iu.get());
+      result.dependencies.push_back({groupIUs, aggregateIUs});
+      result.addKey(move(groupIUs));
+   } else if (auto join = dynamic_cast<Join*>(&op)) {
+      auto left = derive(*join->accessLeft()), right = derive(*join->accessRight());
+      switch (join->getJoinType()) {
+         case Join::JoinType::LeftSemi:
+         case Join::JoinType::LeftAnti: return left;
+         case Join::JoinType::RightSemi:
+         case Join::JoinType::RightAnti: return right;
+         default: break;
+      }
+
+      // The dependencies that hold for matching tuples
+      FunctionalDependencies matches;
+      matches.dependencies = left.dependencies;
+      matches.dependencies.insert(matches.dependencies.end(), right.dependencies.begin(), right.dependencies.end());
+      matches.addEqualities(*join->accessCondition());
+      // A key of one side stays unique if it determines a key of the other side
+      auto determinesKey = [&](const vector<const IU*>& key, const FunctionalDependencies& other) {
+         auto closure = matches.computeClosure(IUSet(key.begin(), key.end()));
+         return any_of(other.keys.begin(), other.keys.end(), [&](const vector<const IU*>& k) { return contains(closure, k); });
+      };
+      auto type = join->getJoinType();
+      bool keepLeft = (type == Join::JoinType::Inner) || (type == Join::JoinType::LeftOuter);
+      bool keepRight = (type == Join::JoinType::Inner) || (type == Join::JoinType::RightOuter);
+      if (keepLeft)
+         for (auto& k : left.keys)
+            if (determinesKey(k, right)) result.addKey(k);
+      if (keepRight)
+         for (auto& k : right.keys)
+            if (determinesKey(k, left)) result.addKey(k);
+      for (auto& l : left.keys)
+         for (auto& r : right.keys) {
+            auto key = l;
+            key.insert(key.end(), r.begin(), r.end());
+            result.addKey(move(key));
+         }
+
+      // Padded NULL values violate the dependencies of the other side
+      switch (type) {
+         case Join::JoinType::Inner: result.dependencies = move(matches.dependencies); break;
+         case Join::JoinType::LeftOuter: result.dependencies = move(left.dependencies); break;
+         case Join::JoinType::RightOuter: result.dependencies = move(right.dependencies); break;
+         default: break;
+      }
+   } else if (auto setOp = dynamic_cast<SetOperation*>(&op)) {
+      auto o = setOp->getOp();
+      if ((o == SetOperation::Op::Union) || (o == SetOperation::Op::Except) || (o == SetOperation::Op::Intersect)) {
+         vector<const IU*> key;
+         for (auto& c : setOp->getResultColumns())
+            key.push_back(c.get());
+         result.addKey(move(key));
+      }
+   }
+   return result;
+}
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
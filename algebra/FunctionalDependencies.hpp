@@ -0,0 +1,65 @@
+#ifndef H_saneql_FunctionalDependencies
+#define H_saneql_FunctionalDependencies
+//---------------------------------------------------------------------------
+#include <unordered_set>
+#include <vector>
+//---------------------------------------------------------------------------
+// SaneQL
+// (c) 2023 Thomas Neumann
+// SPDX-License-Identifier: BSD-3-Clause
+//---------------------------------------------------------------------------
+namespace saneql {
+//---------------------------------------------------------------------------
+namespace algebra {
+//---------------------------------------------------------------------------
+class Expression;
+class IU;
+class Operator;
+//---------------------------------------------------------------------------
+/// Derives the unique keys and functional dependencies of operator trees from the
+/// key constraints of the schema and from the equality predicates of the query.
+/// NULL values compare equal, as in grouping. The derivation is conservative,
+/// missing keys or dependencies only prevent rewrites
+class FunctionalDependencies {
+   public:
+   /// A set of IUs
+   using IUSet = std::unordered_set<const IU*>;
+   /// A functional dependency, the determinant determines the dependent IUs
+   struct Dependency {
+      /// The determinant
+      std::vector<const IU*> determinant;
+      /// The dependent IUs
+      std::vector<const IU*> dependent;
+   };
+   /// The maximum number of keys that are tracked per operator
+   static constexpr unsigned maxKeys = 16;
+
+   private:
+   /// The unique keys. Every key determines all IUs, an empty key means at most one row
+   std::vector<std::vector<const IU*>> keys;
+   /// The functional dependencies
+   std::vector<Dependency> dependencies;
+
+   /// Add a key if it is not implied by an existing one
+   void addKey(std::vector<const IU*> key);
+   /// Add the dependencies implied by an equality predicate
+   void addEqualities(Expression& condition);
+
+   public:
+   /// Derive the keys and dependencies of an operator tree
+   static FunctionalDependencies derive(Operator& op);
+
+   /// Get the keys
+   const std::vector<std::vector<const IU*>>& getKeys() const { return keys; }
+   /// Get the dependencies
+   const std::vector<Dependency>& getDependencies() const { return dependencies; }
+   /// Compute the IUs that are determined by a set of IUs
+   IUSet computeClosure(IUSet ius) const;
+   /// Is a set of IUs unique, i.e., does it determine a key?
+   bool isUnique(const IUSet& ius) const;
+};
+//---------------------------------------------------------------------------
+}
+}
+//---------------------------------------------------------------------------
+#endif
@@ -0,0 +1,393 @@
+#include "algebra/JoinOrdering.hpp"
+#include "algebra/CardinalityEstimator.hpp"
+#include "algebra/Expression.hpp"
+#include "algebra/Operator.hpp"
+#include <bit>
+#include <optional>
+//---------------------------------------------------------------------------
+// (c) 2023 Thomas Neumann
+//---------------------------------------------------------------------------
+using namespace std;
+//---------------------------------------------------------------------------
+namespace saneql::algebra {
+//---------------------------------------------------------------------------
+namespace {
+//---------------------------------------------------------------------------
+/// A set of relations, one bit per relation
+using RelationSet = uint64_t;
+//---------------------------------------------------------------------------
+/// A join graph extracted from a tree of inner joins
+class JoinGraph {
+   public:
+   /// A relation, i.e., an input of the join tree that is not an inner join itself
+   struct Relation {
+      /// The operator tree. Still owned by the original join tree
+      unique_ptr<Operator>* op;
+      /// The produced IUs
+      unordered_set<const IU*> produced;
+      /// The estimated cardinality
+      double cardinality;
+      /// The neighbors in the join graph
+      RelationSet neighbors = 0;
+   };
+   /// A join predicate
+   struct Predicate {
+      /// The condition. Still owned by the original join tree
+      unique_ptr<Expression>* condition;
+      /// The referenced relations
+      RelationSet relations;
+      /// The estimated selectivity
+      double selectivity;
+   };
+   /// A (partial) join plan
+   struct Plan {
+      /// The joined relations
+      RelationSet relations;
+      /// The estimated cardinality
+      double cardinality;
+      /// The cost, the sum of all intermediate result sizes
+      double cost;
+      /// The input plans. The relation index for leaves
+      unsigned left, right;
+      /// Is the plan a single relation?
+      bool isLeaf() const { return has_single_bit(relations); }
+   };
+
+   private:
+   /// The estimator
+   CardinalityEstimator estimator;
+   /// The relations
+   vector<Relation> relations;
+   /// The predicates
+   vector<Predicate> predicates;
+   /// All plans
+   vector<Plan> plans;
+   /// The best known plan per relation set
+   unordered_map<RelationSet, unsigned> bestPlans;
+   /// The estimated cardinalities per relation set
+   mutable unordered_map<RelationSet, double> cardinalities;
+   /// The number of join pairs considered by dynamic programming
+   unsigned pairCount = 0;
+
+   /// Extract the graph from a join tree. Returns the plan that corresponds to the tree
+   optional<unsigned> extract(unique_ptr<Operator>& op);
+   /// Estimate the cardinality of a relation set
+   double estimateCardinality(RelationSet set) const;
+   /// Register a join of two plans. Returns the plan
+   unsigned addJoin(unsigned left, unsigned right);
+   /// Remember a plan if it is the best for its relation set
+   void updateBest(unsigned plan);
+   /// Get the neighbors of a relation set
+   RelationSet getNeighbors(RelationSet set) const;
+   /// Can two relation sets be joined without a cross product?
+   bool isConnected(RelationSet left, RelationSet right) const;
+   /// Renumber the relations in breadth-first order. Returns false if the graph is not connected
+   bool renumberBreadthFirst();
+
+   /// Enumerate all connected subgraphs and their complements (DPccp)
+   void enumerateCsg();
+   /// Extend a connected subgraph
+   void enumerateCsgRec(RelationSet s1, RelationSet excluded);
+   /// Enumerate the complements of a connected subgraph
+   void emitCsg(RelationSet s1);
+   /// Extend a complement
+   void enumerateCmpRec(RelationSet s1, RelationSet s2, RelationSet excluded);
+   /// Join a connected subgraph with a complement
+   void emitCsgCmp(RelationSet s1, RelationSet s2);
+   /// Order greedily, joining the pair with the smallest result first
+   unsigned orderGreedy();
+
+   /// Build the operator tree for a plan
+   unique_ptr<Operator> build(unsigned plan, bool root);
+
+   public:
+   /// Optimize a join tree. Returns true if the tree was changed
+   bool optimize(unique_ptr<Operator>& root);
+};
+//---------------------------------------------------------------------------
+optional<unsigned> JoinGraph::extract(unique_ptr<Operator>& op)
+// Extract the graph from a join tree
+{
+   auto join = dynamic_cast<Join*>(op.get());
+   if ((!join) || (join->getJoinType() != Join::JoinType::Inner)) {
+      if (relations.size() == ReorderJoins::maxRelations) return {};
+      Relation r{&op, {}, estimator.estimate(*op)};
+      op->collectProduced(r.produced);
+      estimator.limitDistinctValues(r.produced, r.cardinality);
+      RelationSet set = RelationSet(1) << relations.size();
+      relations.push_back(move(r));
+      plans.push_back({set, 0, 0, static_cast<unsigned>(relations.size() - 1), 0});
+      return plans.size() - 1;
+   }
+
+   auto left = extract(join->accessLeft());
+   if (!left) return {};
+   auto right = extract(join->accessRight());
+   if (!right) return {};
+
+   // The predicates can only reference relations within the subtree
+   vector<unique_ptr<Expression>*> conjuncts;
+   RewriteRule::collectConjuncts(join->accessCondition(), conjuncts);
+   for (auto c : conjuncts) {
+      IUUsage usage;
+      (*c)->collectUsage(usage);
+      RelationSet set = 0;
+      for (unsigned index = 0; index != relations.size(); ++index)
+         for (auto iu : usage.used)
+            if (relations[index].produced.contains(iu)) {
+               set |= RelationSet(1) << index;
+               break;
+            }
+      predicates.push_back({c, set, estimator.estimateSelectivity(**c)});
+   }
+   plans.push_back({plans[*left].relations | plans[*right].relations, 0, 0, *left, *right});
+   return plans.size() - 1;
+}
+//---------------------------------------------------------------------------
+double JoinGraph::estimateCardinality(RelationSet set) const
+// Estimate the cardinality of a relation set
+{
+   if (auto iter = cardinalities.find(set); iter != cardinalities.end()) return iter->second;
+   double result = 1;
+   for (unsigned index = 0; index != relations.size(); ++index)
+      if (set & (RelationSet(1) << index)) result *= relations[index].cardinality;
+   for (auto& p : predicates)
+      if (p.relations && ((p.relations & set) == p.relations)) result *= p.selectivity;
+   result = max(result, 1.0);
+   cardinalities[set] = result;
+   return result;
+}
+//---------------------------------------------------------------------------
+unsigned JoinGraph::addJoin(unsigned left, unsigned right)
+// Register a join of two plans
+{
+   RelationSet set = plans[left].relations | plans[right].relations;
+   double cardinality = estimateCardinality(set);
+   plans.push_back({set, cardinality, plans[left].cost + plans[right].cost + cardinality, left, right});
+   return plans.size() - 1;
+}
+//---------------------------------------------------------------------------
+void JoinGraph::updateBest(unsigned plan)
+// Remember a plan if it is the best for its relation set
+{
+   auto iter = bestPlans.find(plans[plan].relations);
+   if (iter == bestPlans.end())
+      bestPlans[plans[plan].relations] = plan;
+   else if (plans[plan].cost < plans[iter->second].cost)
+      iter->second = plan;
+}
+//---------------------------------------------------------------------------
+RelationSet JoinGraph::getNeighbors(RelationSet set) const
+// Get the neighbors of a relation set
+{
+   RelationSet result = 0;
+   for (unsigned index = 0; index != relations.size(); ++index)
+      if (set & (RelationSet(1) << index)) result |= relations[index].neighbors;
+   return result & ~set;
+}
+//---------------------------------------------------------------------------
+bool JoinGraph::isConnected(RelationSet left, RelationSet right) const
+// Can two relation sets be joined without a cross product?
+{
+   RelationSet set = left | right;
+   for (auto& p : predicates)
+      if ((p.relations & left) && (p.relations & right) && ((p.relations & set) == p.relations)) return true;
+   return false;
+}
+//---------------------------------------------------------------------------
+bool JoinGraph::renumberBreadthFirst()
+// Renumber the relations in breadth-first order
+{
+   // Binary predicates form the edges of the graph
+   for (auto& p : predicates)
+      if (popcount(p.relations) == 2)
+         for (unsigned index = 0; index != relations.size(); ++index)
+            if (p.relations & (RelationSet(1) << index)) relations[index].neighbors |= p.relations & ~(RelationSet(1) << index);
+
+   vector<unsigned> order{0}, position(relations.size());
+   RelationSet seen = 1;
+   for (unsigned next = 0; next != order.size(); ++next)
+      for (unsigned index = 0; index != relations.size(); ++index)
+         if ((relations[order[next]].neighbors & (RelationSet(1) << index)) && (!(seen & (RelationSet(1) << index)))) {
+            seen |= RelationSet(1) << index;
+            order.push_back(index);
+         }
+   if (order.size() != relations.size()) return false;
+
+   // Translate all relation sets
+   for (unsigned index = 0; index != order.size(); ++index)
+      position[order[index]] = index;
+   auto translate = [&](RelationSet set) {
+      RelationSet result = 0;
+      for (unsigned index = 0; index != relations.size(); ++index)
+         if (set & (RelationSet(1) << index)) result |= RelationSet(1) << position[index];
+      return result;
+   };
+   vector<Relation> renumbered;
+   for (auto index : order) {
+      renumbered.push_back(move(relations[index]));
+      renumbered.back().neighbors = translate(renumbered.back().neighbors);
+   }
+   relations = move(renumbered);
+   for (auto& p : predicates)
+      p.relations = translate(p.relations);
+   for (auto& p : plans) {
+      p.relations = translate(p.relations);
+      if (p.isLeaf()) p.left = countr_zero(p.relations);
+   }
+   return true;
+}
+//---------------------------------------------------------------------------
+void JoinGraph::enumerateCsg()
+// Enumerate all connected subgraphs and their complements
+{
+   for (unsigned index = relations.size(); (index-- > 0) && (pairCount <= ReorderJoins::maxDPPairs);) {
+      RelationSet s = RelationSet(1) << index;
+      emitCsg(s);
+      enumerateCsgRec(s, (s << 1) - 1);
+   }
+}
+//---------------------------------------------------------------------------
+void JoinGraph::enumerateCsgRec(RelationSet s1, RelationSet excluded)
+// Extend a connected subgraph
+{
+   if (pairCount > ReorderJoins::maxDPPairs) return;
+   RelationSet neighbors = getNeighbors(s1) & ~excluded;
+   // Enumerate the subsets in increasing order, the plans for subsets must be known before their supersets
+   for (RelationSet s = neighbors & -neighbors; s; s = (s - neighbors) & neighbors)
+      emitCsg(s1 | s);
+   for (RelationSet s = neighbors & -neighbors; s; s = (s - neighbors) & neighbors)
+      enumerateCsgRec(s1 | s, excluded | neighbors);
+}
+//---------------------------------------------------------------------------
+void JoinGraph::emitCsg(RelationSet s1)
+// Enumerate the complements of a connected subgraph
+{
+   // Complements only contain relations after the first relation of s1
+   RelationSet first = s1 & -s1;
+   RelationSet excluded = s1 | ((first << 1) - 1);
+   RelationSet neighbors = getNeighbors(s1) & ~excluded;
+   for (unsigned index = relations.size(); index-- > 0;) {
+      RelationSet s2 = RelationSet(1) << index;
+      if (!(neighbors & s2)) continue;
+      emitCsgCmp(s1, s2);
+      enumerateCmpRec(s1, s2, excluded | (neighbors & ((s2 << 1) - 1)));
+   }
+}
+//---------------------------------------------------------------------------
+void JoinGraph::enumerateCmpRec(RelationSet s1, RelationSet s2, RelationSet excluded)
+// Extend a complement
+{
+   if (pairCount > ReorderJoins::maxDPPairs) return;
+   RelationSet neighbors = getNeighbors(s2) & ~excluded;
+   for (RelationSet s = neighbors & -neighbors; s; s = (s - neighbors) & neighbors)
+      emitCsgCmp(s1, s2 | s);
+   for (RelationSet s = neighbors & -neighbors; s; s = (s - neighbors) & neighbors)
+      enumerateCmpRec(s1, s2 | s, excluded | neighbors);
+}
+//---------------------------------------------------------------------------
+void JoinGraph::emitCsgCmp(RelationSet s1, RelationSet s2)
+// Join a connected subgraph with a complement
+{
+   // The connected subgraphs are enumerated before their supersets
+   ++pairCount;
+   updateBest(addJoin(bestPlans.at(s1), bestPlans.at(s2)));
+}
+//---------------------------------------------------------------------------
+unsigned JoinGraph::orderGreedy()
+// Order greedily, joining the pair with the smallest result first
+{
+   vector<unsigned> current;
+   for (unsigned index = 0; index != relations.size(); ++index)
+      current.push_back(bestPlans.at(RelationSet(1) << index));
+   while (current.size() > 1) {
+      // Prefer pairs that are connected by a predicate over cross products
+      unsigned bestLeft = 0, bestRight = 1;
+      bool bestConnected = false;
+      double bestCardinality = 0;
+      for (unsigned left = 0; left != current.size(); ++left)
+         for (unsigned right = left + 1; right != current.size(); ++right) {
+            RelationSet l = plans[current[left]].relations, r = plans[current[right]].relations;
+            bool connected = isConnected(l, r);
+            double cardinality = estimateCardinality(l | r);
+            if ((connected > bestConnected) || ((connected == bestConnected) && ((!bestCardinality) || (cardinality < bestCardinality)))) {
+               bestLeft = left;
+               bestRight = right;
+               bestConnected = connected;
+               bestCardinality = cardinality;
+            }
+         }
+      current[bestLeft] = addJoin(current[bestLeft], current[bestRight]);
+      current.erase(current.begin() + bestRight);
+   }
+   return current.front();
+}
+//---------------------------------------------------------------------------
+unique_ptr<Operator> JoinGraph::build(unsigned plan, bool root)
+// Build the operator tree for a plan
+{
+   auto& p = plans[plan];
+   vector<unique_ptr<Expression>> conditions;
+   auto collect = [&](auto filter) {
+      for (auto& pred : predicates)
+         if (*pred.condition && filter(pred.relations)) conditions.push_back(move(*pred.condition));
+   };
+
+   // Predicates on a single relation filter the relation
+   if (p.isLeaf()) {
+      auto result = move(*relations[p.left].op);
+      collect([&](RelationSet set) { return set == p.relations; });
+      RewriteRule::addSelection(result, move(conditions));
+      return result;
+   }
+
+   auto left = build(p.left, false), right = build(p.right, false);
+   collect([&](RelationSet set) { return set && ((set & p.relations) == set); });
+   if (root) collect([](RelationSet set) { return !set; });
+   auto condition = RewriteRule::combineConjuncts(move(conditions));
+   if (!condition) condition = make_unique<ConstExpression>("true", Type::getBool());
+   return make_unique<Join>(move(left), move(right), move(condition), Join::JoinType::Inner);
+}
+//---------------------------------------------------------------------------
+bool JoinGraph::optimize(unique_ptr<Operator>& root)
+// Optimize a join tree
+{
+   auto original = extract(root);
+   if (!original) return false;
+
+   // Order by dynamic programming if the graph is connected and small enough, greedily otherwise
+   bool connected = renumberBreadthFirst();
+   for (unsigned index = 0; index != plans.size(); ++index) {
+      auto& p = plans[index];
+      p.cardinality = estimateCardinality(p.relations);
+      p.cost = p.isLeaf() ? 0 : (plans[p.left].cost + plans[p.right].cost + p.cardinality);
+      if (p.isLeaf()) bestPlans[p.relations] = index;
+   }
+   unsigned best;
+   if (connected && (relations.size() <= ReorderJoins::maxDPRelations)) enumerateCsg();
+   // Fall back to greedy ordering if the search space is too large
+   if (auto iter = bestPlans.find((RelationSet(2) << (relations.size() - 1)) - 1); iter != bestPlans.end() && (pairCount <= ReorderJoins::maxDPPairs))
+      best = iter->second;
+   else
+      best = orderGreedy();
+
+   // Keep the original order unless we found something cheaper
+   if (!(plans[best].cost < plans[*original].cost * (1 - 1e-9))) return false;
+   root = build(best, true);
+   return true;
+}
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
+bool ReorderJoins::apply(unique_ptr<Operator>& op)
+// Try to rewrite the operator in place
+{
+   auto join = dynamic_cast<Join*>(op.get());
+   if ((!join) || (join->getJoinType() != Join::JoinType::Inner)) return false;
+
+   JoinGraph graph;
+   return graph.optimize(op);
+}
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
@@ -0,0 +1,36 @@
+#ifndef H_saneql_JoinOrdering
+#define H_saneql_JoinOrdering
+//---------------------------------------------------------------------------
+#include "algebra/Optimizer.hpp"
+//---------------------------------------------------------------------------
+// SaneQL
+// (c) 2023 Thomas Neumann
+// SPDX-License-Identifier: BSD-3-Clause
+//---------------------------------------------------------------------------
+namespace saneql {
+//---------------------------------------------------------------------------
+namespace algebra {
+//---------------------------------------------------------------------------
+/// Reorders trees of inner joins. Extracts the join graph from consecutive inner joins,
+/// enumerates connected subgraph pairs by dynamic programming (DPccp), and picks the plan
+/// with the smallest sum of intermediate result sizes. Large or disconnected graphs are
+/// ordered greedily. The tree is only changed if the new order is estimated to be cheaper
+class ReorderJoins : public RewriteRule {
+   public:
+   /// The maximum number of relations for dynamic programming
+   static constexpr unsigned maxDPRelations = 14;
+   /// The maximum number of join pairs that dynamic programming considers before falling back to greedy ordering
+   static constexpr unsigned maxDPPairs = 100000;
+   /// The maximum number of relations that are considered at all
+   static constexpr unsigned maxRelations = 64;
+
+   /// Get the name of the rule
+   std::string_view getName() const override { return "reorderjoins"; }
+   /// Try to rewrite the operator in place
+   bool apply(std::unique_ptr<Operator>& op) override;
+};
+//---------------------------------------------------------------------------
+}
+}
+//---------------------------------------------------------------------------
+#endif
@@ -0,0 +1,180 @@
+#include "algebra/KeyRewrites.hpp"
+#include "algebra/Expression.hpp"
+#include "algebra/FunctionalDependencies.hpp"
+#include "algebra/Operator.hpp"
+#include <algorithm>
+#include <set>
+//---------------------------------------------------------------------------
+// (c) 2023 Thomas Neumann
+//---------------------------------------------------------------------------
+using namespace std;
+//---------------------------------------------------------------------------
+namespace saneql::algebra {
+//---------------------------------------------------------------------------
+static const IU* getColumn(Expression* expression)
+// Get the IU of a column reference
+{
+   auto ref = dynamic_cast<IURef*>(expression);
+   return ref ? ref->getIU() : nullptr;
+}
+//---------------------------------------------------------------------------
+bool EliminateDistinct::apply(unique_ptr<Operator>& op)
+// Try to rewrite the operator in place
+{
+   auto groupBy = dynamic_cast<GroupBy*>(op.get());
+   if ((!groupBy) || groupBy->getGroupBy().empty() || (!groupBy->accessAggregates().empty())) return false;
+   FunctionalDependencies::IUSet columns;
+   for (auto& g : groupBy->getGroupBy()) {
+      auto iu = getColumn(g.value.get());
+      if (!iu) return false;
+      columns.insert(iu);
+   }
+   if (!FunctionalDependencies::derive(*groupBy->accessInput()).isUnique(columns)) return false;
+
+   // Every group has exactly one row, the group by just renames the columns
+   auto input = move(groupBy->accessInput());
+   vector<Map::Entry> computations;
+   for (auto& g : groupBy->accessGroupBy())
+      computations.push_back({move(g.value), move(g.iu)});
+   op = make_unique<Map>(move(input), move(computations));
+   return true;
+}
+//---------------------------------------------------------------------------
+bool ReduceGroupBy::apply(unique_ptr<Operator>& op)
+// Try to rewrite the operator in place
+{
+   auto groupBy = dynamic_cast<GroupBy*>(op.get());
+   if ((!groupBy) || (groupBy->getGroupBy().size() < 2)) return false;
+   auto dependencies = FunctionalDependencies::derive(*groupBy->accessInput());
+   if (dependencies.getDependencies().empty()) return false;
+
+   // Drop columns from the back, the leading group by columns are usually the keys
+   auto& entries = groupBy->accessGroupBy();
+   vector<bool> removed(entries.size());
+   unsigned remaining = entries.size();
+   for (unsigned index = entries.size(); (index--) && (remaining > 1);) {
+      auto iu = getColumn(entries[index].value.get());
+      // min is not available for booleans in all dialects
+      if ((!iu) || (iu->getType().getType() == Type::Bool)) continue;
+      FunctionalDependencies::IUSet others;
+      for (unsigned other = 0; other != entries.size(); ++other)
+         if ((other != index) && (!removed[other]))
+            if (auto o = getColumn(entries[other].value.get())) others.insert(o);
+      if (dependencies.computeClosure(move(others)).contains(iu)) {
+         removed[index] = true;
+         --remaining;
+      }
+   }
+   if (remaining == entries.size()) return false;
+
+   // Compute the removed columns as aggregates, all values within a group are equal
+   vector<GroupBy::Entry> kept;
+   for (unsigned index = 0; index != entries.size(); ++index) {
+      if (removed[index])
+         groupBy->accessAggregates().push_back({move(entries[index].value), move(entries[index].iu), GroupBy::Op::Min});
+      else
+         kept.push_back(move(entries[index]));
+   }
+   entries = move(kept);
+   return true;
+}
+//---------------------------------------------------------------------------
+static const TableScan::Column* findSource(Operator& op, const IU* iu, TableScan*& scan)
+// Find the table column that produces an IU, passing only through operators that keep the values of the table rows
+{
+   if (auto s = dynamic_cast<TableScan*>(&op)) {
+      for (auto& c : s->getColumns())
+         if (c.iu.get() == iu) {
+            scan = s;
+            return &c;
+         }
+   } else if (dynamic_cast<Select*>(&op) || dynamic_cast<Map*>(&op) || dynamic_cast<Sort*>(&op) || dynamic_cast<Window*>(&op)) {
+      return findSource(**op.getInputs().front(), iu, scan);
+   } else if (auto join = dynamic_cast<Join*>(&op)) {
+      // The columns of the NULL padded side of outer joins do not stem from table rows
+      auto type = join->getJoinType();
+      if ((type != Join::JoinType::RightOuter) && (type != Join::JoinType::FullOuter) && (type != Join::JoinType::RightSemi) && (type != Join::JoinType::RightAnti))
+         if (auto c = findSource(*join->accessLeft(), iu, scan)) return c;
+      if ((type != Join::JoinType::LeftOuter) && (type != Join::JoinType::FullOuter) && (type != Join::JoinType::LeftSemi) && (type != Join::JoinType::LeftAnti))
+         if (auto c = findSource(*join->accessRight(), iu, scan)) return c;
+   }
+   return nullptr;
+}
+//---------------------------------------------------------------------------
+static bool isForeignKeyJoin(unique_ptr<Expression>& condition, TableScan& referenced, Operator& referencing)
+// Does a join condition match a non-nullable foreign key of the referencing side with the key of the referenced table?
+{
+   // All conjuncts must compare a referencing column with a referenced column
+   vector<unique_ptr<Expression>*> conjuncts;
+   RewriteRule::collectConjuncts(condition, conjuncts);
+   TableScan* source = nullptr;
+   set<pair<unsigned, unsigned>> pairs;
+   for (auto c : conjuncts) {
+      auto comparison = dynamic_cast<ComparisonExpression*>(c->get());
+      if ((!comparison) || (comparison->mode != ComparisonExpression::Equal)) return false;
+      auto left = getColumn(comparison->left.get()), right = getColumn(comparison->right.get());
+      if ((!left) || (!right)) return false;
+      if (any_of(referenced.getColumns().begin(), referenced.getColumns().end(), [&](auto& rc) { return rc.iu.get() == left; })) swap(left, right);
+      auto target = find_if(referenced.getColumns().begin(), referenced.getColumns().end(), [&](auto& rc) { return rc.iu.get() == right; });
+      if (target == referenced.getColumns().end()) return false;
+      TableScan* scan = nullptr;
+      auto column = findSource(referencing, left, scan);
+      if ((!column) || (source && (scan != source)) || (!scan->getTable())) return false;
+      source = scan;
+      auto from = scan->getTable()->findColumn(column->name), to = referenced.getTable()->findColumn(target->name);
+      if ((!from) || (!to)) return false;
+      pairs.emplace(*from, *to);
+   }
+   if (!source) return false;
+
+   // Look for a matching foreign key
+   auto keys = referenced.getTable()->getKeys();
+   for (auto& fk : source->getTable()->foreignKeys) {
+      if (fk.table != referenced.getName()) continue;
+      auto key = referenced.getTable()->resolveReference(fk);
+      if (key.empty() || none_of(keys.begin(), keys.end(), [&](auto& k) { return set(k.begin(), k.end()) == set(key.begin(), key.end()); })) continue;
+      // Rows with NULL values in the foreign key have no join partner
+      if (any_of(fk.columns.begin(), fk.columns.end(), [&](unsigned c) { return source->getTable()->columns[c].type.isNullable(); })) continue;
+      set<pair<unsigned, unsigned>> expected;
+      for (unsigned index = 0; index != key.size(); ++index)
+         expected.emplace(fk.columns[index], key[index]);
+      if (expected == pairs) return true;
+   }
+   return false;
+}
+//---------------------------------------------------------------------------
+bool EliminateJoins::apply(unique_ptr<Operator>& op)
+// Try to rewrite the operator in place
+{
+   auto join = dynamic_cast<Join*>(op.get());
+   if ((!join) || (join->getJoinType() != Join::JoinType::Inner) || (!collectQuery)) return false;
+
+   for (bool right : {true, false}) {
+      auto scan = dynamic_cast<TableScan*>((right ? join->accessRight() : join->accessLeft()).get());
+      auto& other = right ? join->accessLeft() : join->accessRight();
+      if ((!scan) || (!scan->getTable()) || (!isForeignKeyJoin(join->accessCondition(), *scan, *other))) continue;
+
+      // Check if the query uses the table besides the join condition
+      auto condition = move(join->accessCondition());
+      join->accessCondition() = make_unique<ConstExpression>("true", Type::getBool());
+      IUUsage usage;
+      collectQuery(usage);
+      for (bool changed = true; changed;) {
+         changed = false;
+         for (auto ref : usage.cteRefs)
+            changed |= ref->markUsedColumns(usage.used);
+      }
+      auto& columns = scan->getColumns();
+      if (any_of(columns.begin(), columns.end(), [&](auto& c) { return usage.used.contains(c.iu.get()); })) {
+         join->accessCondition() = move(condition);
+         continue;
+      }
+
+      op = move(other);
+      return true;
+   }
+   return false;
+}
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
@@ -0,0 +1,53 @@
+#ifndef H_saneql_KeyRewrites
+#define H_saneql_KeyRewrites
+//---------------------------------------------------------------------------
+#include "algebra/Optimizer.hpp"
+#include <functional>
+//---------------------------------------------------------------------------
+// SaneQL
+// (c) 2023 Thomas Neumann
+// SPDX-License-Identifier: BSD-3-Clause
+//---------------------------------------------------------------------------
+namespace saneql {
+//---------------------------------------------------------------------------
+namespace algebra {
+//---------------------------------------------------------------------------
+/// Removes duplicate elimination if the input is already unique
+class EliminateDistinct : public RewriteRule {
+   public:
+   /// Get the name of the rule
+   std::string_view getName() const override { return "eliminatedistinct"; }
+   /// Try to rewrite the operator in place
+   bool apply(std::unique_ptr<Operator>& op) override;
+};
+//---------------------------------------------------------------------------
+/// Removes group by columns that are functionally determined by the other group by
+/// columns. The removed columns are computed as min aggregates instead
+class ReduceGroupBy : public RewriteRule {
+   public:
+   /// Get the name of the rule
+   std::string_view getName() const override { return "reducegroupby"; }
+   /// Try to rewrite the operator in place
+   bool apply(std::unique_ptr<Operator>& op) override;
+};
+//---------------------------------------------------------------------------
+/// Removes inner joins with a table that is referenced by a foreign key if the query
+/// uses no columns of that table besides the join columns. Every row of the referencing
+/// side finds exactly one join partner then
+class EliminateJoins : public RewriteRule {
+   /// Collect the IU usage of the whole query
+   std::function<void(IUUsage&)> collectQuery;
+
+   public:
+   /// Get the name of the rule
+   std::string_view getName() const override { return "eliminatejoins"; }
+   /// Set the query that is rewritten
+   void setQuery(const std::function<void(IUUsage&)>& collect) override { collectQuery = collect; }
+   /// Try to rewrite the operator in place
+   bool apply(std::unique_ptr<Operator>& op) override;
+};
+//---------------------------------------------------------------------------
+}
+}
+//---------------------------------------------------------------------------
+#endif
@@ -1,5 +1,7 @@
 #include "algebra/Operator.hpp"
 #include "sql/SQLWriter.hpp"
+#include <algorithm>
+#include <stdexcept>
 //---------------------------------------------------------------------------
 // (c) 2023 Thomas Neumann
 //---------------------------------------------------------------------------
@@ -7,13 +9,265 @@ using namespace std;
 //---------------------------------------------------------------------------
 namespace saneql::algebra {
 //---------------------------------------------------------------------------
+bool SelectBlock::references(const Fragment& fragment) const
+// Does a fragment reference columns computed by the block?
+{
+   for (auto& c : columns)
+      if (fragment.ius.contains(c.first)) return true;
+   return false;
+}
+//---------------------------------------------------------------------------
+SelectBlock::Fragment SelectBlock::generateInlined(SQLWriter& out, const function<void()>& generate) const
+// Generate a fragment, writing the computations of the block instead of their IUs
+{
+   for (auto& c : columns)
+      out.replaceIU(c.first, &c.second);
+   Fragment result;
+   out.beginFragment(result);
+   generate();
+   out.endFragment();
+   for (auto& c : columns)
+      out.replaceIU(c.first, nullptr);
+   return result;
+}
+//---------------------------------------------------------------------------
+void SelectBlock::addCondition(SQLWriter& out, const function<void()>& generate)
+// Add a condition
+{
+   Fragment condition;
+   out.beginFragment(condition);
+   generate();
+   out.endFragment();
+
+   // Conditions are evaluated before window functions and limits, but can use the aggregates of a grouped block
+   if (windowed || isLimited()) {
+      wrap(out);
+   } else if (groupBy) {
+      having.push_back(generateInlined(out, generate));
+      return;
+   } else if (references(condition)) {
+      wrap(out);
+   }
+   where.push_back(move(condition));
+}
+//---------------------------------------------------------------------------
+void SelectBlock::wrap(SQLWriter& out)
+// Wrap the block in a derived table and continue with an empty block on top of it
+{
+   Fragment table;
+   out.beginFragment(table);
+   write(out);
+   out.write(" ");
+   out.writeTableAlias();
+   out.endFragment();
+   *this = SelectBlock();
+   from = move(table);
+}
+//---------------------------------------------------------------------------
+static void writeConditions(SQLWriter& out, const vector<SelectBlock::Fragment>& conditions)
+// Write a conjunction of conditions
+{
+   bool first = true;
+   for (auto& c : conditions) {
+      if (first)
+         first = false;
+      else
+         out.write(" and ");
+      if (conditions.size() > 1) out.write("(");
+      out.writeFragment(c);
+      if (conditions.size() > 1) out.write(")");
+   }
+}
+//---------------------------------------------------------------------------
+static void writeClauses(SQLWriter& out, const SelectBlock& block, const vector<unsigned>& groupPositions)
+// Write the clauses after the select list
+{
+   out.write(" from ");
+   out.writeFragment(block.from);
+   if (!block.where.empty()) {
+      out.write(" where ");
+      writeConditions(out, block.where);
+   }
+   if (block.groupBy) {
+      out.write(" group by ");
+      if (groupPositions.empty()) {
+         out.write("true");
+      } else {
+         for (unsigned index = 0, limit = groupPositions.size(); index < limit; ++index) {
+            if (index) out.write(", ");
+            out.write(to_string(groupPositions[index]));
+         }
+      }
+   }
+   if (!block.having.empty()) {
+      out.write(" having ");
+      writeConditions(out, block.having);
+   }
+   if (block.orderBy) {
+      out.write(" order by ");
+      out.writeFragment(*block.orderBy);
+   }
+   if (block.limit.has_value()) {
+      out.write(" limit ");
+      out.write(to_string(*block.limit));
+   }
+   if (block.offset.has_value()) {
+      out.write(" offset ");
+      out.write(to_string(*block.offset));
+   }
+}
+//---------------------------------------------------------------------------
+void SelectBlock::write(SQLWriter& out) const
+// Write the block as subquery
+{
+   out.write("(select ");
+   bool first = groupBy.has_value();
+   if (!groupBy) out.write("*");
+   for (auto& c : columns) {
+      if (first)
+         first = false;
+      else
+         out.write(", ");
+      out.writeFragment(c.second);
+      out.write(" as ");
+      out.writeIU(c.first);
+   }
+   vector<unsigned> groupPositions;
+   for (unsigned index = 0; index != groupBy.value_or(0); ++index)
+      groupPositions.push_back(index + 1);
+   writeClauses(out, *this, groupPositions);
+   out.write(")");
+}
+//---------------------------------------------------------------------------
+void SelectBlock::writeQuery(SQLWriter& out, const vector<pair<string, const IU*>>& result)
+// Write the block as the top level query, naming the result columns
+{
+   // The group by columns are referenced by their position in the result. Wrap the block if a group by column is not part of the result
+   vector<unsigned> groupPositions;
+   for (unsigned index = 0; index != groupBy.value_or(0); ++index) {
+      auto iter = find_if(result.begin(), result.end(), [&](auto& r) { return r.second == columns[index].first; });
+      if (iter == result.end()) {
+         wrap(out);
+         groupPositions.clear();
+         break;
+      }
+      groupPositions.push_back(iter - result.begin() + 1);
+   }
+
+   out.write("select ");
+   bool first = true;
+   for (auto& r : result) {
+      if (first)
+         first = false;
+      else
+         out.write(", ");
+      auto iter = find_if(columns.begin(), columns.end(), [&](auto& c) { return c.first == r.second; });
+      if (iter != columns.end())
+         out.writeFragment(iter->second);
+      else
+         out.writeIU(r.second);
+      out.write(" as ");
+      out.writeIdentifier(r.first);
+   }
+   writeClauses(out, *this, groupPositions);
+}
+//---------------------------------------------------------------------------
+template <class T, class GetIU>
+static bool pruneEntries(vector<T>& entries, const unordered_set<const IU*>& used, GetIU getIU, bool keepOne)
+// Remove the entries with unused IUs, optionally keeping at least one entry
+{
+   auto size = entries.size();
+   if (keepOne && none_of(entries.begin(), entries.end(), [&](auto& e) { return used.contains(getIU(e)); })) {
+      if (size > 1) entries.erase(entries.begin() + 1, entries.end());
+   } else {
+      erase_if(entries, [&](auto& e) { return !used.contains(getIU(e)); });
+   }
+   return entries.size() != size;
+}
+//---------------------------------------------------------------------------
+static void collectAggregates(IUUsage& usage, const vector<AggregationLike::Aggregation>& aggregates)
+// Collect the IUs used by aggregates
+{
+   for (auto& a : aggregates) {
+      if (a.value) a.value->collectUsage(usage);
+      for (auto& p : a.parameters)
+         p->collectUsage(usage);
+   }
+}
+//---------------------------------------------------------------------------
 Operator::~Operator()
 // Destructor
 {
 }
 //---------------------------------------------------------------------------
-TableScan::TableScan(string name, vector<Column> columns)
-   : name(move(name)), columns(move(columns))
+void Operator::generateBlock(SQLWriter& out, SelectBlock& block)
+// Generate SQL into a SELECT block for flat SQL generation
+{
+   out.beginFragment(block.from);
+   generate(out);
+   out.write(" ");
+   out.writeTableAlias();
+   out.endFragment();
+}
+//---------------------------------------------------------------------------
+bool Operator::pruneUnused(const unordered_set<const IU*>&)
+// Remove unused columns
+{
+   return false;
+}
+//---------------------------------------------------------------------------
+vector<unique_ptr<Operator>*> Operator::getInputs()
+// Get the inputs
+{
+   return {};
+}
+//---------------------------------------------------------------------------
+static void pruneColumns(const function<void(IUUsage&)>& collect)
+// Remove unused columns until nothing changes anymore
+{
+   while (true) {
+      IUUsage usage;
+      collect(usage);
+      for (bool changed = true; changed;) {
+         changed = false;
+         for (auto ref : usage.cteRefs)
+            changed |= ref->markUsedColumns(usage.used);
+      }
+
+      bool pruned = false;
+      for (auto op : usage.operators)
+         pruned |= op->pruneUnused(usage.used);
+      for (auto cte : usage.ctes)
+         pruned |= cte->pruneUnused(usage.used);
+      if (!pruned) break;
+   }
+}
+//---------------------------------------------------------------------------
+void Operator::pruneColumns(Operator& root, const vector<const IU*>& output)
+// Remove the columns and computations that are not needed to compute the output IUs
+{
+   algebra::pruneColumns([&](IUUsage& usage) {
+      usage.used.insert(output.begin(), output.end());
+      root.collectUsage(usage);
+   });
+}
+//---------------------------------------------------------------------------
+void Operator::pruneColumns(Expression& root)
+// Remove the unused columns of all subqueries of an expression
+{
+   algebra::pruneColumns([&](IUUsage& usage) { root.collectUsage(usage); });
+}
+//---------------------------------------------------------------------------
+void Operator::generateFlat(SQLWriter& out)
+// Generate flat SQL
+{
+   SelectBlock block;
+   generateBlock(out, block);
+   block.write(out);
+}
+//---------------------------------------------------------------------------
+TableScan::TableScan(string name, vector<Column> columns, shared_ptr<const Schema::Table> table)
+   : name(move(name)), columns(move(columns)), table(move(table))
 // Constructor
 {
 }
@@ -37,6 +291,26 @@ void TableScan::generate(SQLWriter& out)
    out.write(")");
 }
 //---------------------------------------------------------------------------
+void TableScan::collectUsage(IUUsage& usage)
+// Collect the used IUs
+{
+   usage.operators.push_back(this);
+}
+//---------------------------------------------------------------------------
+bool TableScan::pruneUnused(const unordered_set<const IU*>& used)
+// Remove unused columns
+{
+   // SQL needs at least one column
+   return pruneEntries(columns, used, [](auto& c) { return c.iu.get(); }, true);
+}
+//---------------------------------------------------------------------------
+void TableScan::collectProduced(unordered_set<const IU*>& produced)
+// Collect the produced IUs
+{
+   for (auto& c : columns)
+      produced.insert(c.iu.get());
+}
+//---------------------------------------------------------------------------
 Select::Select(unique_ptr<Operator> input, unique_ptr<Expression> condition)
    : input(move(input)), condition(move(condition))
 // Constructor
@@ -46,6 +320,10 @@ Select::Select(unique_ptr<Operator> input, unique_ptr<Expression> condition)
 void Select::generate(SQLWriter& out)
 // Generate SQL
 {
+   if (out.isFlatSQL()) {
+      generateFlat(out);
+      return;
+   }
    out.write("(select * from ");
    input->generate(out);
    out.write(" s where ");
@@ -53,6 +331,32 @@ void Select::generate(SQLWriter& out)
    out.write(")");
 }
 //---------------------------------------------------------------------------
+void Select::generateBlock(SQLWriter& out, SelectBlock& block)
+// Generate SQL into a SELECT block
+{
+   input->generateBlock(out, block);
+   block.addCondition(out, [&]() { condition->generate(out); });
+}
+//---------------------------------------------------------------------------
+void Select::collectUsage(IUUsage& usage)
+// Collect the used IUs
+{
+   input->collectUsage(usage);
+   condition->collectUsage(usage);
+}
+//---------------------------------------------------------------------------
+vector<unique_ptr<Operator>*> Select::getInputs()
+// Get the inputs
+{
+   return {&input};
+}
+//---------------------------------------------------------------------------
+void Select::collectProduced(unordered_set<const IU*>& produced)
+// Collect the produced IUs
+{
+   input->collectProduced(produced);
+}
+//---------------------------------------------------------------------------
 Map::Map(unique_ptr<Operator> input, vector<Entry> computations)
    : input(move(input)), computations(move(computations))
 // Constructor
@@ -62,6 +366,15 @@ Map::Map(unique_ptr<Operator> input, vector<Entry> computations)
 void Map::generate(SQLWriter& out)
 // Generate SQL
 {
+   if (out.isFlatSQL()) {
+      generateFlat(out);
+      return;
+   }
+   // All computations might have been pruned
+   if (computations.empty()) {
+      input->generate(out);
+      return;
+   }
    out.write("(select *");
    for (auto& c : computations) {
       out.write(", ");
@@ -74,6 +387,54 @@ void Map::generate(SQLWriter& out)
    out.write(" s)");
 }
 //---------------------------------------------------------------------------
+void Map::generateBlock(SQLWriter& out, SelectBlock& block)
+// Generate SQL into a SELECT block
+{
+   input->generateBlock(out, block);
+
+   // Computations cannot reference other computations of the same block
+   vector<SelectBlock::Fragment> values(computations.size());
+   bool wrap = false;
+   for (unsigned index = 0; index != computations.size(); ++index) {
+      out.beginFragment(values[index]);
+      computations[index].value->generate(out);
+      out.endFragment();
+      wrap |= block.references(values[index]);
+   }
+   if (wrap) block.wrap(out);
+   for (unsigned index = 0; index != computations.size(); ++index)
+      block.columns.emplace_back(computations[index].iu.get(), move(values[index]));
+}
+//---------------------------------------------------------------------------
+void Map::collectUsage(IUUsage& usage)
+// Collect the used IUs
+{
+   usage.operators.push_back(this);
+   input->collectUsage(usage);
+   for (auto& c : computations)
+      c.value->collectUsage(usage);
+}
+//---------------------------------------------------------------------------
+bool Map::pruneUnused(const unordered_set<const IU*>& used)
+// Remove unused columns
+{
+   return pruneEntries(computations, used, [](auto& c) { return c.iu.get(); }, false);
+}
+//---------------------------------------------------------------------------
+vector<unique_ptr<Operator>*> Map::getInputs()
+// Get the inputs
+{
+   return {&input};
+}
+//---------------------------------------------------------------------------
+void Map::collectProduced(unordered_set<const IU*>& produced)
+// Collect the produced IUs
+{
+   input->collectProduced(produced);
+   for (auto& c : computations)
+      produced.insert(c.iu.get());
+}
+//---------------------------------------------------------------------------
 SetOperation::SetOperation(unique_ptr<Operator> left, unique_ptr<Operator> right, vector<unique_ptr<Expression>> leftColumns, vector<unique_ptr<Expression>> rightColumns, vector<unique_ptr<IU>> resultColumns, Op op)
    : left(move(left)), right(move(right)), leftColumns(move(leftColumns)), rightColumns(move(rightColumns)), resultColumns(move(resultColumns)), op(op)
 // Constructor
@@ -130,6 +491,30 @@ void SetOperation::generate(SQLWriter& out)
    out.write(")");
 }
 //---------------------------------------------------------------------------
+void SetOperation::collectUsage(IUUsage& usage)
+// Collect the used IUs
+{
+   left->collectUsage(usage);
+   right->collectUsage(usage);
+   for (auto& c : leftColumns)
+      c->collectUsage(usage);
+   for (auto& c : rightColumns)
+      c->collectUsage(usage);
+}
+//---------------------------------------------------------------------------
+vector<unique_ptr<Operator>*> SetOperation::getInputs()
+// Get the inputs
+{
+   return {&left, &right};
+}
+//---------------------------------------------------------------------------
+void SetOperation::collectProduced(unordered_set<const IU*>& produced)
+// Collect the produced IUs
+{
+   for (auto& c : resultColumns)
+      produced.insert(c.get());
+}
+//---------------------------------------------------------------------------
 Join::Join(unique_ptr<Operator> left, unique_ptr<Operator> right, unique_ptr<Expression> condition, JoinType joinType)
    : left(move(left)), right(move(right)), condition(move(condition)), joinType(joinType)
 // Constructor
@@ -139,6 +524,10 @@ Join::Join(unique_ptr<Operator> left, unique_ptr<Operator> right, unique_ptr<Exp
 void Join::generate(SQLWriter& out)
 // Generate SQL
 {
+   if (out.isFlatSQL()) {
+      generateFlat(out);
+      return;
+   }
    switch (joinType) {
       case JoinType::Inner:
          out.write("(select * from ");
@@ -215,15 +604,131 @@ void Join::generate(SQLWriter& out)
    }
 }
 //---------------------------------------------------------------------------
+void Join::generateBlock(SQLWriter& out, SelectBlock& block)
+// Generate SQL into a SELECT block
+{
+   switch (joinType) {
+      case JoinType::Inner:
+      case JoinType::LeftOuter:
+      case JoinType::RightOuter:
+      case JoinType::FullOuter: {
+         SelectBlock rightBlock;
+         left->generateBlock(out, block);
+         right->generateBlock(out, rightBlock);
+
+         // The conditions of preserved sides can be evaluated after the join
+         bool leftPreserved = (joinType == JoinType::Inner) || (joinType == JoinType::LeftOuter);
+         bool rightPreserved = (joinType == JoinType::Inner) || (joinType == JoinType::RightOuter);
+         if ((!block.isPlain()) || ((!leftPreserved) && (!block.where.empty()))) block.wrap(out);
+         if ((!rightBlock.isPlain()) || ((!rightPreserved) && (!rightBlock.where.empty()))) rightBlock.wrap(out);
+
+         SelectBlock::Fragment from;
+         out.beginFragment(from);
+         out.writeFragment(block.from);
+         switch (joinType) {
+            case JoinType::Inner: out.write(" inner join "); break;
+            case JoinType::LeftOuter: out.write(" left outer join "); break;
+            case JoinType::RightOuter: out.write(" right outer join "); break;
+            default: out.write(" full outer join "); break;
+         }
+         if (rightBlock.joined) out.write("(");
+         out.writeFragment(rightBlock.from);
+         if (rightBlock.joined) out.write(")");
+         out.write(" on ");
+         condition->generate(out);
+         out.endFragment();
+         block.from = move(from);
+         block.joined = true;
+         for (auto& w : rightBlock.where)
+            block.where.push_back(move(w));
+         break;
+      }
+      case JoinType::LeftSemi:
+      case JoinType::RightSemi:
+      case JoinType::LeftAnti:
+      case JoinType::RightAnti: {
+         // Check the other side in an exists condition
+         bool leftOuter = (joinType == JoinType::LeftSemi) || (joinType == JoinType::LeftAnti);
+         bool anti = (joinType == JoinType::LeftAnti) || (joinType == JoinType::RightAnti);
+         SelectBlock innerBlock;
+         (leftOuter ? left : right)->generateBlock(out, block);
+         (leftOuter ? right : left)->generateBlock(out, innerBlock);
+         if (!innerBlock.isPlain()) innerBlock.wrap(out);
+         block.addCondition(out, [&]() {
+            out.write(anti ? "not exists(select * from " : "exists(select * from ");
+            out.writeFragment(innerBlock.from);
+            out.write(" where ");
+            for (auto& w : innerBlock.where) {
+               out.write("(");
+               out.writeFragment(w);
+               out.write(") and ");
+            }
+            if (!innerBlock.where.empty()) out.write("(");
+            condition->generate(out);
+            if (!innerBlock.where.empty()) out.write(")");
+            out.write(")");
+         });
+         break;
+      }
+   }
+}
+//---------------------------------------------------------------------------
+void Join::collectUsage(IUUsage& usage)
+// Collect the used IUs
+{
+   left->collectUsage(usage);
+   right->collectUsage(usage);
+   condition->collectUsage(usage);
+}
+//---------------------------------------------------------------------------
+vector<unique_ptr<Operator>*> Join::getInputs()
+// Get the inputs
+{
+   return {&left, &right};
+}
+//---------------------------------------------------------------------------
+void Join::collectProduced(unordered_set<const IU*>& produced)
+// Collect the produced IUs
+{
+   // Semi and anti joins only produce the columns of one side
+   if ((joinType != JoinType::RightSemi) && (joinType != JoinType::RightAnti)) left->collectProduced(produced);
+   if ((joinType != JoinType::LeftSemi) && (joinType != JoinType::LeftAnti)) right->collectProduced(produced);
+}
+//---------------------------------------------------------------------------
 GroupBy::GroupBy(unique_ptr<Operator> input, vector<Entry> groupBy, vector<Aggregation> aggregates)
    : input(move(input)), groupBy(move(groupBy)), aggregates(move(aggregates))
 // Constructor
 {
 }
 //---------------------------------------------------------------------------
+static void generateAggregate(SQLWriter& out, const GroupBy::Aggregation& a)
+// Generate an aggregate
+{
+   using Op = GroupBy::Op;
+   switch (a.op) {
+      case Op::CountStar: out.write("count(*)"); break;
+      case Op::Count: out.write("count("); break;
+      case Op::CountDistinct: out.write("count(distinct "); break;
+      case Op::Sum: out.write("sum("); break;
+      case Op::SumDistinct: out.write("sum(distinct "); break;
+      case Op::Avg: out.write("avg("); break;
+      case Op::AvgDistinct: out.write("avg(distinct "); break;
+      case Op::Min: out.write("min("); break;
+      case Op::Max: out.write("max("); break;
+   }
+   if (a.op != Op::CountStar) {
+      a.value->generate(out);
+      out.write(")");
+   }
+}
+//---------------------------------------------------------------------------
 void GroupBy::generate(SQLWriter& out)
 // Generate SQL
 {
+   if (out.isFlatSQL()) {
+      generateFlat(out);
+      return;
+   }
    out.write("(select ");
    bool first = true;
    for (auto& g : groupBy) {
@@ -240,21 +745,7 @@ void GroupBy::generate(SQLWriter& out)
          first = false;
       else
          out.write(", ");
-      switch (a.op) {
-         case Op::CountStar: out.write("count(*)"); break;
-         case Op::Count: out.write("count("); break;
-         case Op::CountDistinct: out.write("count(distinct "); break;
-         case Op::Sum: out.write("sum("); break;
-         case Op::SumDistinct: out.write("sum(distinct "); break;
-         case Op::Avg: out.write("avg("); break;
-         case Op::AvgDistinct: out.write("avg(distinct "); break;
-         case Op::Min: out.write("min("); break;
-         case Op::Max: out.write("max("); break;
-      }
-      if (a.op != Op::CountStar) {
-         a.value->generate(out);
-         out.write(")");
-      }
+      generateAggregate(out, a);
       out.write(" as ");
       out.writeIU(a.iu.get());
    }
@@ -272,30 +763,98 @@ void GroupBy::generate(SQLWriter& out)
    out.write(")");
 }
 //---------------------------------------------------------------------------
+void GroupBy::generateBlock(SQLWriter& out, SelectBlock& block)
+// Generate SQL into a SELECT block
+{
+   input->generateBlock(out, block);
+
+   // Aggregate the input rows directly if possible
+   vector<SelectBlock::Fragment> values(groupBy.size() + aggregates.size());
+   bool wrap = block.groupBy || block.windowed || block.orderBy || block.isLimited();
+   for (unsigned index = 0; index != values.size(); ++index) {
+      out.beginFragment(values[index]);
+      if (index < groupBy.size())
+         groupBy[index].value->generate(out);
+      else
+         generateAggregate(out, aggregates[index - groupBy.size()]);
+      out.endFragment();
+      wrap |= block.references(values[index]);
+   }
+   if (wrap) block.wrap(out);
+
+   // Computations that are not referenced are dropped
+   block.columns.clear();
+   for (unsigned index = 0; index != values.size(); ++index)
+      block.columns.emplace_back((index < groupBy.size()) ? groupBy[index].iu.get() : aggregates[index - groupBy.size()].iu.get(), move(values[index]));
+   block.groupBy = groupBy.size();
+}
+//---------------------------------------------------------------------------
+void GroupBy::collectUsage(IUUsage& usage)
+// Collect the used IUs
+{
+   usage.operators.push_back(this);
+   input->collectUsage(usage);
+   for (auto& g : groupBy)
+      g.value->collectUsage(usage);
+   collectAggregates(usage, aggregates);
+}
+//---------------------------------------------------------------------------
+bool GroupBy::pruneUnused(const unordered_set<const IU*>& used)
+// Remove unused columns
+{
+   // The group by columns determine the result and are kept. Without them SQL needs at least one aggregate
+   return pruneEntries(aggregates, used, [](auto& a) { return a.iu.get(); }, groupBy.empty());
+}
+//---------------------------------------------------------------------------
+vector<unique_ptr<Operator>*> GroupBy::getInputs()
+// Get the inputs
+{
+   return {&input};
+}
+//---------------------------------------------------------------------------
+void GroupBy::collectProduced(unordered_set<const IU*>& produced)
+// Collect the produced IUs
+{
+   for (auto& g : groupBy)
+      produced.insert(g.iu.get());
+   for (auto& a : aggregates)
+      produced.insert(a.iu.get());
+}
+//---------------------------------------------------------------------------
 Sort::Sort(unique_ptr<Operator> input, vector<Entry> order, optional<uint64_t> limit, optional<uint64_t> offset)
    : input(move(input)), order(move(order)), limit(limit), offset(offset)
 // Constructor
 {
 }
 //---------------------------------------------------------------------------
+void Sort::generateOrder(SQLWriter& out, const vector<Entry>& order)
+// Generate a sort order
+{
+   bool first = true;
+   for (auto& o : order) {
+      if (first)
+         first = false;
+      else
+         out.write(", ");
+      o.value->generate(out);
+      if (o.collate != Collate{}) throw runtime_error("collation not supported");
+      if (o.descending) out.write(" desc");
+   }
+}
+//---------------------------------------------------------------------------
 void Sort::generate(SQLWriter& out)
 // Generate SQL
 {
+   if (out.isFlatSQL()) {
+      generateFlat(out);
+      return;
+   }
    out.write("(select * from ");
    input->generate(out);
    out.write(" s");
    if (!order.empty()) {
       out.write(" order by ");
-      bool first = true;
-      for (auto& o : order) {
-         if (first)
-            first = false;
-         else
-            out.write(", ");
-         o.value->generate(out);
-         if (o.collate != Collate{}) out.write(" collate TODO"); // TODO
-         if (o.descending) out.write(" desc");
-      }
+      generateOrder(out, order);
    }
    if (limit.has_value()) {
       out.write(" limit ");
@@ -308,14 +867,46 @@ void Sort::generate(SQLWriter& out)
    out.write(")");
 }
 //---------------------------------------------------------------------------
+void Sort::generateBlock(SQLWriter& out, SelectBlock& block)
+// Generate SQL into a SELECT block
+{
+   input->generateBlock(out, block);
+   if (block.orderBy || block.isLimited()) block.wrap(out);
+
+   // The order can use all computations of the block
+   if (!order.empty()) block.orderBy = block.generateInlined(out, [&]() { generateOrder(out, order); });
+   block.limit = limit;
+   block.offset = offset;
+}
+//---------------------------------------------------------------------------
+void Sort::collectUsage(IUUsage& usage)
+// Collect the used IUs
+{
+   input->collectUsage(usage);
+   for (auto& o : order)
+      o.value->collectUsage(usage);
+}
+//---------------------------------------------------------------------------
+vector<unique_ptr<Operator>*> Sort::getInputs()
+// Get the inputs
+{
+   return {&input};
+}
+//---------------------------------------------------------------------------
+void Sort::collectProduced(unordered_set<const IU*>& produced)
+// Collect the produced IUs
+{
+   input->collectProduced(produced);
+}
+//---------------------------------------------------------------------------
 Window::Window(unique_ptr<Operator> input, vector<Aggregation> aggregates, vector<unique_ptr<Expression>> partitionBy, vector<Sort::Entry> orderBy)
    : input(move(input)), aggregates(move(aggregates)), partitionBy(move(partitionBy)), orderBy(move(orderBy))
 // Constructor
 {
 }
 //---------------------------------------------------------------------------
-void Window::generate(SQLWriter& out)
-// Generate SQL
+void Window::generateAggregate(SQLWriter& out, const Aggregation& a)
+// Generate a window aggregate
 {
    auto aggr = [&out](const char* name, const Aggregation& a, bool distinct = false) {
       out.write(name);
@@ -328,55 +919,57 @@ void Window::generate(SQLWriter& out)
       }
       out.write(")");
    };
+   switch (static_cast<WindowOp>(a.op)) {
+      case Op::CountStar: out.write("count(*)"); break;
+      case Op::Count: aggr("count", a); break;
+      case Op::CountDistinct: aggr("count", a, true); break;
+      case Op::Sum: aggr("sum", a); break;
+      case Op::SumDistinct: aggr("sum", a, true); break;
+      case Op::Avg: aggr("avg", a); break;
+      case Op::AvgDistinct: aggr("avg", a, true); break;
+      case Op::Min: aggr("min", a); break;
+      case Op::Max: aggr("max", a); break;
+      case Op::RowNumber: out.write("row_number()"); break;
+      case Op::Rank: aggr("rank", a); break;
+      case Op::DenseRank: aggr("dense_rank", a); break;
+      case Op::NTile: aggr("ntile", a); break;
+      case Op::Lead: aggr("lead", a); break;
+      case Op::Lag: aggr("lag", a); break;
+      case Op::FirstValue: aggr("first_value", a); break;
+      case Op::LastValue: aggr("last_value", a); break;
+   }
+   out.write(" over (");
+   if (!partitionBy.empty()) {
+      out.write("partition by ");
+      bool first = true;
+      for (auto& p : partitionBy) {
+         if (first)
+            first = false;
+         else
+            out.write(", ");
+         p->generate(out);
+      }
+   }
+   if (!orderBy.empty()) {
+      if (!partitionBy.empty()) out.write(" ");
+      out.write("order by ");
+      Sort::generateOrder(out, orderBy);
+   }
+   out.write(")");
+}
+//---------------------------------------------------------------------------
+void Window::generate(SQLWriter& out)
+// Generate SQL
+{
+   if (out.isFlatSQL()) {
+      generateFlat(out);
+      return;
+   }
    out.write("(select *");
    for (auto& a : aggregates) {
       out.write(", ");
-      switch (static_cast<WindowOp>(a.op)) {
-         case Op::CountStar: out.write("count(*)"); break;
-         case Op::Count: aggr("count", a); break;
-         case Op::CountDistinct: aggr("count", a, true); break;
-         case Op::Sum: aggr("sum", a); break;
-         case Op::SumDistinct: aggr("sum", a, true); break;
-         case Op::Avg: aggr("avg", a); break;
-         case Op::AvgDistinct: aggr("avg", a, true); break;
-         case Op::Min: aggr("min", a); break;
-         case Op::Max: aggr("max", a); break;
-         case Op::RowNumber: out.write("row_number()"); break;
-         case Op::Rank: aggr("rank", a); break;
-         case Op::DenseRank: aggr("dense_rank", a); break;
-         case Op::NTile: aggr("ntile", a); break;
-         case Op::Lead: aggr("lead", a); break;
-         case Op::Lag: aggr("lag", a); break;
-         case Op::FirstValue: aggr("first_value", a); break;
-         case Op::LastValue: aggr("last_value", a); break;
-      }
-      out.write(" over (");
-      if (!partitionBy.empty()) {
-         out.write("partition by ");
-         bool first = true;
-         for (auto& p : partitionBy) {
-            if (first)
-               first = false;
-            else
-               out.write(", ");
-            p->generate(out);
-         }
-      }
-      if (!orderBy.empty()) {
-         if (!partitionBy.empty()) out.write(" ");
-         out.write("order by ");
-         bool first = true;
-         for (auto& o : orderBy) {
-            if (first)
-               first = false;
-            else
-               out.write(", ");
-            o.value->generate(out);
-            if (o.collate != Collate{}) out.write(" collate TODO"); // TODO
-            if (o.descending) out.write(" desc");
-         }
-      }
-      out.write(") as ");
+      generateAggregate(out, a);
+      out.write(" as ");
       out.writeIU(a.iu.get());
    }
    out.write(" from ");
@@ -384,6 +977,58 @@ void Window::generate(SQLWriter& out)
    out.write(" s)");
 }
 //---------------------------------------------------------------------------
+void Window::generateBlock(SQLWriter& out, SelectBlock& block)
+// Generate SQL into a SELECT block
+{
+   input->generateBlock(out, block);
+
+   // Window functions are computed after grouping and before limits
+   vector<SelectBlock::Fragment> values(aggregates.size());
+   bool wrap = block.groupBy || block.isLimited();
+   for (unsigned index = 0; index != aggregates.size(); ++index) {
+      out.beginFragment(values[index]);
+      generateAggregate(out, aggregates[index]);
+      out.endFragment();
+      wrap |= block.references(values[index]);
+   }
+   if (wrap) block.wrap(out);
+   for (unsigned index = 0; index != aggregates.size(); ++index)
+      block.columns.emplace_back(aggregates[index].iu.get(), move(values[index]));
+   block.windowed = true;
+}
+//---------------------------------------------------------------------------
+void Window::collectUsage(IUUsage& usage)
+// Collect the used IUs
+{
+   usage.operators.push_back(this);
+   input->collectUsage(usage);
+   collectAggregates(usage, aggregates);
+   for (auto& p : partitionBy)
+      p->collectUsage(usage);
+   for (auto& o : orderBy)
+      o.value->collectUsage(usage);
+}
+//---------------------------------------------------------------------------
+bool Window::pruneUnused(const unordered_set<const IU*>& used)
+// Remove unused columns
+{
+   return pruneEntries(aggregates, used, [](auto& a) { return a.iu.get(); }, false);
+}
+//---------------------------------------------------------------------------
+vector<unique_ptr<Operator>*> Window::getInputs()
+// Get the inputs
+{
+   return {&input};
+}
+//---------------------------------------------------------------------------
+void Window::collectProduced(unordered_set<const IU*>& produced)
+// Collect the produced IUs
+{
+   input->collectProduced(produced);
+   for (auto& a : aggregates)
+      produced.insert(a.iu.get());
+}
+//---------------------------------------------------------------------------
 InlineTable::InlineTable(vector<unique_ptr<algebra::IU>> columns, vector<unique_ptr<algebra::Expression>> values, unsigned rowCount)
    : columns(move(columns)), values(move(values)), rowCount(move(rowCount))
 // Constructor
@@ -436,5 +1081,162 @@ void InlineTable::generate(SQLWriter& out)
    out.write(")");
 }
 //---------------------------------------------------------------------------
+void InlineTable::collectUsage(IUUsage& usage)
+// Collect the used IUs
+{
+   for (auto& v : values)
+      v->collectUsage(usage);
+}
+//---------------------------------------------------------------------------
+void InlineTable::collectProduced(unordered_set<const IU*>& produced)
+// Collect the produced IUs
+{
+   for (auto& c : columns)
+      produced.insert(c.get());
+}
+//---------------------------------------------------------------------------
+CTE::CTE(unique_ptr<Operator> op, vector<const IU*> columns)
+   : op(move(op)), columns(move(columns))
+// Constructor
+{
+}
+//---------------------------------------------------------------------------
+bool CTE::pruneUnused(const unordered_set<const IU*>& used)
+// Remove unused columns
+{
+   return erase_if(columns, [&](auto iu) { return !used.contains(iu); }) > 0;
+}
+//---------------------------------------------------------------------------
+CTERef::CTERef(shared_ptr<CTE> cte, vector<unique_ptr<IU>> columns)
+   : cte(move(cte)), columns(move(columns))
+// Constructor
+{
+   ++this->cte->useCount;
+   if (!this->columns.empty()) sources = this->cte->columns;
+}
+//---------------------------------------------------------------------------
+CTERef::~CTERef()
+// Destructor
+{
+   --cte->useCount;
+}
+//---------------------------------------------------------------------------
+void CTERef::generateBlock(SQLWriter& out, SelectBlock& block)
+// Generate SQL into a SELECT block
+{
+   // A CTE that is used only once is merged into the block
+   if ((cte->useCount == 1) && columns.empty())
+      cte->op->generateBlock(out, block);
+   else
+      Operator::generateBlock(out, block);
+}
+//---------------------------------------------------------------------------
+void CTERef::generate(SQLWriter& out)
+// Generate SQL
+{
+   auto writeColumns = [&]() {
+      bool first = true;
+      for (unsigned index = 0; index != columns.size(); ++index) {
+         if (first)
+            first = false;
+         else
+            out.write(", ");
+         out.writeIU(sources[index]);
+         out.write(" as ");
+         out.writeIU(columns[index].get());
+      }
+   };
+
+   // Expand the CTE in place if it is used only once
+   if (cte->useCount == 1) {
+      if (columns.empty()) {
+         cte->op->generate(out);
+      } else {
+         out.write("(select ");
+         writeColumns();
+         out.write(" from ");
+         cte->op->generate(out);
+         out.write(" s)");
+      }
+      return;
+   }
+
+   // Define the CTE on first use
+   if (!out.isCTEDefined(cte.get())) {
+      out.beginCTE(cte.get());
+      out.write("select ");
+      bool first = true;
+      for (auto c : cte->columns) {
+         if (first)
+            first = false;
+         else
+            out.write(", ");
+         out.writeIU(c);
+      }
+      out.write(" from ");
+      cte->op->generate(out);
+      out.write(" s");
+      out.endCTE();
+   }
+
+   if (columns.empty()) {
+      out.write("(select * from ");
+   } else {
+      out.write("(select ");
+      writeColumns();
+      out.write(" from ");
+   }
+   out.writeCTE(cte.get());
+   out.write(")");
+}
+//---------------------------------------------------------------------------
+void CTERef::collectUsage(IUUsage& usage)
+// Collect the used IUs
+{
+   usage.operators.push_back(this);
+   usage.cteRefs.push_back(this);
+   if (usage.ctes.insert(cte.get()).second) cte->op->collectUsage(usage);
+}
+//---------------------------------------------------------------------------
+bool CTERef::markUsedColumns(unordered_set<const IU*>& used)
+// Mark the CTE columns that are needed for the used columns of the reference
+{
+   bool changed = false;
+   if (!columns.empty()) {
+      // SQL needs at least one column
+      if (none_of(columns.begin(), columns.end(), [&](auto& c) { return used.contains(c.get()); })) used.insert(columns.front().get());
+      for (unsigned index = 0; index != columns.size(); ++index)
+         if (used.contains(columns[index].get())) changed |= used.insert(sources[index]).second;
+   }
+   if ((!cte->columns.empty()) && none_of(cte->columns.begin(), cte->columns.end(), [&](auto iu) { return used.contains(iu); })) changed |= used.insert(cte->columns.front()).second;
+   return changed;
+}
+//---------------------------------------------------------------------------
+bool CTERef::pruneUnused(const unordered_set<const IU*>& used)
+// Remove unused columns
+{
+   unsigned size = columns.size(), target = 0;
+   for (unsigned index = 0; index != size; ++index)
+      if (used.contains(columns[index].get())) {
+         columns[target] = move(columns[index]);
+         sources[target] = sources[index];
+         ++target;
+      }
+   columns.resize(target);
+   sources.resize(target);
+   return target != size;
+}
+//---------------------------------------------------------------------------
+void CTERef::collectProduced(unordered_set<const IU*>& produced)
+// Collect the produced IUs
+{
+   if (columns.empty()) {
+      produced.insert(cte->columns.begin(), cte->columns.end());
+   } else {
+      for (auto& c : columns)
+         produced.insert(c.get());
+   }
+}
+//---------------------------------------------------------------------------
 }
 //---------------------------------------------------------------------------
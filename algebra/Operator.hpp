@@ -3,8 +3,11 @@
 //---------------------------------------------------------------------------
 #include "algebra/Expression.hpp"
 #include "infra/Schema.hpp"
+#include "sql/SQLWriter.hpp"
+#include <functional>
 #include <memory>
 #include <optional>
+#include <unordered_set>
 //---------------------------------------------------------------------------
 // SaneQL
 // (c) 2023 Thomas Neumann
@@ -12,8 +15,6 @@
 //---------------------------------------------------------------------------
 namespace saneql {
 //---------------------------------------------------------------------------
-class SQLWriter;
-//---------------------------------------------------------------------------
 namespace algebra {
 //---------------------------------------------------------------------------
 /// An information unit
@@ -29,6 +30,67 @@ class IU {
    const Type& getType() const { return type; }
 };
 //---------------------------------------------------------------------------
+class CTE;
+class CTERef;
+//---------------------------------------------------------------------------
+/// The IU usage of an operator tree. Used to prune unused columns and to find nested operator trees
+class IUUsage {
+   public:
+   /// The used IUs
+   std::unordered_set<const IU*> used;
+   /// The operators that might compute unused columns
+   std::vector<Operator*> operators;
+   /// The CTE references
+   std::vector<CTERef*> cteRefs;
+   /// The visited CTEs
+   std::unordered_set<CTE*> ctes;
+   /// The inputs of subqueries
+   std::vector<std::unique_ptr<Operator>*> subqueries;
+};
+//---------------------------------------------------------------------------
+/// A SELECT block under construction. Flat SQL generation merges consecutive operators into one block
+class SelectBlock {
+   public:
+   using Fragment = SQLWriter::Fragment;
+
+   /// The FROM clause
+   Fragment from;
+   /// Is the FROM clause a join?
+   bool joined = false;
+   /// The WHERE conditions
+   std::vector<Fragment> where;
+   /// The computed columns. Appended to the input columns, or the whole select list for grouped blocks
+   std::vector<std::pair<const IU*, Fragment>> columns;
+   /// The number of group by columns, the group by columns are first in the select list
+   std::optional<unsigned> groupBy;
+   /// The HAVING conditions
+   std::vector<Fragment> having;
+   /// The ORDER BY clause (if any)
+   std::optional<Fragment> orderBy;
+   /// View
+   std::optional<uint64_t> limit, offset;
+   /// Does the block contain window functions?
+   bool windowed = false;
+
+   /// Is the block a plain FROM/WHERE block?
+   bool isPlain() const { return columns.empty() && !groupBy && !orderBy && !limit && !offset; }
+   /// Is the output limited?
+   bool isLimited() const { return limit || offset; }
+   /// Does a fragment reference columns computed by the block?
+   bool references(const Fragment& fragment) const;
+
+   /// Generate a fragment, writing the computations of the block instead of their IUs
+   Fragment generateInlined(SQLWriter& out, const std::function<void()>& generate) const;
+   /// Add a condition
+   void addCondition(SQLWriter& out, const std::function<void()>& generate);
+   /// Wrap the block in a derived table and continue with an empty block on top of it
+   void wrap(SQLWriter& out);
+   /// Write the block as subquery
+   void write(SQLWriter& out) const;
+   /// Write the block as the top level query, naming the result columns
+   void writeQuery(SQLWriter& out, const std::vector<std::pair<std::string, const IU*>>& result);
+};
+//---------------------------------------------------------------------------
 /// Base class for operators
 class Operator {
    public:
@@ -37,6 +99,25 @@ class Operator {
 
    // Generate SQL
    virtual void generate(SQLWriter& out) = 0;
+   // Generate SQL into a SELECT block for flat SQL generation. The block is empty initially
+   virtual void generateBlock(SQLWriter& out, SelectBlock& block);
+   // Collect the used IUs
+   virtual void collectUsage(IUUsage& usage) = 0;
+   // Remove unused columns. Returns true if something was removed
+   virtual bool pruneUnused(const std::unordered_set<const IU*>& used);
+   // Get the inputs. Rewrites can replace them
+   virtual std::vector<std::unique_ptr<Operator>*> getInputs();
+   // Collect the produced IUs
+   virtual void collectProduced(std::unordered_set<const IU*>& produced) = 0;
+
+   /// Remove the columns and computations that are not needed to compute the output IUs
+   static void pruneColumns(Operator& root, const std::vector<const IU*>& output);
+   /// Remove the unused columns of all subqueries of an expression
+   static void pruneColumns(Expression& root);
+
+   protected:
+   /// Generate flat SQL
+   void generateFlat(SQLWriter& out);
 };
 //---------------------------------------------------------------------------
 /// A table scan operator
@@ -55,13 +136,28 @@ class TableScan : public Operator {
    std::string name;
    /// The columns
    std::vector<Column> columns;
+   /// The table definition (if known)
+   std::shared_ptr<const Schema::Table> table;
 
    public:
    /// Constructor
-   TableScan(std::string name, std::vector<Column> columns);
+   TableScan(std::string name, std::vector<Column> columns, std::shared_ptr<const Schema::Table> table = nullptr);
+
+   /// Get the table name
+   const std::string& getName() const { return name; }
+   /// Get the columns
+   const std::vector<Column>& getColumns() const { return columns; }
+   /// Get the table definition (if known)
+   const Schema::Table* getTable() const { return table.get(); }
 
    // Generate SQL
    void generate(SQLWriter& out) override;
+   // Collect the used IUs
+   void collectUsage(IUUsage& usage) override;
+   // Remove unused columns
+   bool pruneUnused(const std::unordered_set<const IU*>& used) override;
+   // Collect the produced IUs
+   void collectProduced(std::unordered_set<const IU*>& produced) override;
 };
 //---------------------------------------------------------------------------
 /// A select operator
@@ -75,8 +171,21 @@ class Select : public Operator {
    /// Constructor
    Select(std::unique_ptr<Operator> input, std::unique_ptr<Expression> condition);
 
+   /// Access the input
+   std::unique_ptr<Operator>& accessInput() { return input; }
+   /// Access the filter condition
+   std::unique_ptr<Expression>& accessCondition() { return condition; }
+
    // Generate SQL
    void generate(SQLWriter& out) override;
+   // Generate SQL into a SELECT block
+   void generateBlock(SQLWriter& out, SelectBlock& block) override;
+   // Collect the used IUs
+   void collectUsage(IUUsage& usage) override;
+   // Get the inputs
+   std::vector<std::unique_ptr<Operator>*> getInputs() override;
+   // Collect the produced IUs
+   void collectProduced(std::unordered_set<const IU*>& produced) override;
 };
 //---------------------------------------------------------------------------
 /// A map operator
@@ -94,8 +203,23 @@ class Map : public Operator {
    /// Constructor
    Map(std::unique_ptr<Operator> input, std::vector<Entry> computations);
 
+   /// Access the input
+   std::unique_ptr<Operator>& accessInput() { return input; }
+   /// Get the computations
+   const std::vector<Entry>& getComputations() const { return computations; }
+
    // Generate SQL
    void generate(SQLWriter& out) override;
+   // Generate SQL into a SELECT block
+   void generateBlock(SQLWriter& out, SelectBlock& block) override;
+   // Collect the used IUs
+   void collectUsage(IUUsage& usage) override;
+   // Remove unused columns
+   bool pruneUnused(const std::unordered_set<const IU*>& used) override;
+   // Get the inputs
+   std::vector<std::unique_ptr<Operator>*> getInputs() override;
+   // Collect the produced IUs
+   void collectProduced(std::unordered_set<const IU*>& produced) override;
 };
 //---------------------------------------------------------------------------
 /// A set operation operator
@@ -125,8 +249,27 @@ class SetOperation : public Operator {
    /// Constructor
    SetOperation(std::unique_ptr<Operator> left, std::unique_ptr<Operator> right, std::vector<std::unique_ptr<Expression>> leftColumns, std::vector<std::unique_ptr<Expression>> rightColumns, std::vector<std::unique_ptr<IU>> resultColumns, Op op);
 
+   /// Get the operation
+   Op getOp() const { return op; }
+   /// Access the left input
+   std::unique_ptr<Operator>& accessLeft() { return left; }
+   /// Access the right input
+   std::unique_ptr<Operator>& accessRight() { return right; }
+   /// Get the input columns of the left side
+   const std::vector<std::unique_ptr<Expression>>& getLeftColumns() const { return leftColumns; }
+   /// Get the input columns of the right side
+   const std::vector<std::unique_ptr<Expression>>& getRightColumns() const { return rightColumns; }
+   /// Get the result columns
+   const std::vector<std::unique_ptr<IU>>& getResultColumns() const { return resultColumns; }
+
    // Generate SQL
    void generate(SQLWriter& out) override;
+   // Collect the used IUs
+   void collectUsage(IUUsage& usage) override;
+   // Get the inputs
+   std::vector<std::unique_ptr<Operator>*> getInputs() override;
+   // Collect the produced IUs
+   void collectProduced(std::unordered_set<const IU*>& produced) override;
 };
 //---------------------------------------------------------------------------
 /// A join operator
@@ -156,8 +299,25 @@ class Join : public Operator {
    /// Constructor
    Join(std::unique_ptr<Operator> left, std::unique_ptr<Operator> right, std::unique_ptr<Expression> condition, JoinType joinType);
 
+   /// Get the join type
+   JoinType getJoinType() const { return joinType; }
+   /// Access the left input
+   std::unique_ptr<Operator>& accessLeft() { return left; }
+   /// Access the right input
+   std::unique_ptr<Operator>& accessRight() { return right; }
+   /// Access the join condition
+   std::unique_ptr<Expression>& accessCondition() { return condition; }
+
    // Generate SQL
    void generate(SQLWriter& out) override;
+   // Generate SQL into a SELECT block
+   void generateBlock(SQLWriter& out, SelectBlock& block) override;
+   // Collect the used IUs
+   void collectUsage(IUUsage& usage) override;
+   // Get the inputs
+   std::vector<std::unique_ptr<Operator>*> getInputs() override;
+   // Collect the produced IUs
+   void collectProduced(std::unordered_set<const IU*>& produced) override;
 };
 //---------------------------------------------------------------------------
 /// A group by operator
@@ -174,8 +334,27 @@ class GroupBy : public Operator, public AggregationLike {
    /// Constructor
    GroupBy(std::unique_ptr<Operator> input, std::vector<Entry> groupBy, std::vector<Aggregation> aggregates);
 
+   /// Access the input
+   std::unique_ptr<Operator>& accessInput() { return input; }
+   /// Get the group by expressions
+   const std::vector<Entry>& getGroupBy() const { return groupBy; }
+   /// Access the group by expressions
+   std::vector<Entry>& accessGroupBy() { return groupBy; }
+   /// Access the aggregates
+   std::vector<Aggregation>& accessAggregates() { return aggregates; }
+
    // Generate SQL
    void generate(SQLWriter& out) override;
+   // Generate SQL into a SELECT block
+   void generateBlock(SQLWriter& out, SelectBlock& block) override;
+   // Collect the used IUs
+   void collectUsage(IUUsage& usage) override;
+   // Remove unused columns
+   bool pruneUnused(const std::unordered_set<const IU*>& used) override;
+   // Get the inputs
+   std::vector<std::unique_ptr<Operator>*> getInputs() override;
+   // Collect the produced IUs
+   void collectProduced(std::unordered_set<const IU*>& produced) override;
 };
 //---------------------------------------------------------------------------
 /// A sort operator
@@ -201,8 +380,18 @@ class Sort : public Operator {
    /// Constructor
    Sort(std::unique_ptr<Operator> input, std::vector<Entry> order, std::optional<uint64_t> limit, std::optional<uint64_t> offset);
 
+   /// Generate a sort order. Throws for collations, none is supported yet
+   static void generateOrder(SQLWriter& out, const std::vector<Entry>& order);
    // Generate SQL
    void generate(SQLWriter& out) override;
+   // Generate SQL into a SELECT block
+   void generateBlock(SQLWriter& out, SelectBlock& block) override;
+   // Collect the used IUs
+   void collectUsage(IUUsage& usage) override;
+   // Get the inputs
+   std::vector<std::unique_ptr<Operator>*> getInputs() override;
+   // Collect the produced IUs
+   void collectProduced(std::unordered_set<const IU*>& produced) override;
 };
 //---------------------------------------------------------------------------
 /// A window operator
@@ -220,12 +409,34 @@ class Window : public Operator, public AggregationLike {
    /// The order by expression
    std::vector<Sort::Entry> orderBy;
 
+   /// Generate a window aggregate
+   void generateAggregate(SQLWriter& out, const Aggregation& a);
+
    public:
    /// Constructor
    Window(std::unique_ptr<Operator> input, std::vector<Aggregation> aggregates, std::vector<std::unique_ptr<Expression>> partitionBy, std::vector<Sort::Entry> orderBy);
 
+   /// Access the input
+   std::unique_ptr<Operator>& accessInput() { return input; }
+   /// Get the aggregates
+   const std::vector<Aggregation>& getAggregates() const { return aggregates; }
+   /// Get the partition by expressions
+   const std::vector<std::unique_ptr<Expression>>& getPartitionBy() const { return partitionBy; }
+   /// Get the order by expressions
+   const std::vector<Sort::Entry>& getOrderBy() const { return orderBy; }
+
    // Generate SQL
    void generate(SQLWriter& out) override;
+   // Generate SQL into a SELECT block
+   void generateBlock(SQLWriter& out, SelectBlock& block) override;
+   // Collect the used IUs
+   void collectUsage(IUUsage& usage) override;
+   // Remove unused columns
+   bool pruneUnused(const std::unordered_set<const IU*>& used) override;
+   // Get the inputs
+   std::vector<std::unique_ptr<Operator>*> getInputs() override;
+   // Collect the produced IUs
+   void collectProduced(std::unordered_set<const IU*>& produced) override;
 };
 //---------------------------------------------------------------------------
 /// An inline table definition
@@ -244,6 +455,65 @@ class InlineTable : public Operator {
 
    // Generate SQL
    void generate(SQLWriter& out) override;
+   // Collect the used IUs
+   void collectUsage(IUUsage& usage) override;
+   // Collect the produced IUs
+   void collectProduced(std::unordered_set<const IU*>& produced) override;
+};
+//---------------------------------------------------------------------------
+/// A common table expression, an operator tree that is referenced multiple times
+class CTE {
+   public:
+   /// The operator tree
+   std::unique_ptr<Operator> op;
+   /// The produced columns
+   std::vector<const IU*> columns;
+   /// The number of references
+   unsigned useCount = 0;
+
+   /// Constructor
+   CTE(std::unique_ptr<Operator> op, std::vector<const IU*> columns);
+
+   /// Remove unused columns. Returns true if something was removed
+   bool pruneUnused(const std::unordered_set<const IU*>& used);
+};
+//---------------------------------------------------------------------------
+/// A reference to a common table expression
+class CTERef : public Operator {
+   /// The referenced CTE
+   std::shared_ptr<CTE> cte;
+   /// The produced columns. Empty if the CTE columns are produced directly
+   std::vector<std::unique_ptr<IU>> columns;
+   /// The CTE columns, parallel to the produced columns
+   std::vector<const IU*> sources;
+
+   public:
+   /// Constructor
+   CTERef(std::shared_ptr<CTE> cte, std::vector<std::unique_ptr<IU>> columns);
+   /// Destructor
+   ~CTERef();
+
+   /// Get the referenced CTE
+   CTE& getCTE() const { return *cte; }
+   /// Get the referenced CTE for further references
+   const std::shared_ptr<CTE>& getSharedCTE() const { return cte; }
+   /// Get the produced columns
+   const std::vector<std::unique_ptr<IU>>& getColumns() const { return columns; }
+   /// Get the CTE columns
+   const std::vector<const IU*>& getSources() const { return sources; }
+
+   // Generate SQL
+   void generate(SQLWriter& out) override;
+   // Generate SQL into a SELECT block
+   void generateBlock(SQLWriter& out, SelectBlock& block) override;
+   // Collect the used IUs
+   void collectUsage(IUUsage& usage) override;
+   // Remove unused columns
+   bool pruneUnused(const std::unordered_set<const IU*>& used) override;
+   /// Mark the CTE columns that are needed for the used columns of the reference. Returns true if new IUs were marked
+   bool markUsedColumns(std::unordered_set<const IU*>& used);
+   // Collect the produced IUs
+   void collectProduced(std::unordered_set<const IU*>& produced) override;
 };
 //---------------------------------------------------------------------------
 }
@@ -0,0 +1,322 @@
+#include "algebra/Optimizer.hpp"
+#include "algebra/Expression.hpp"
+#include "algebra/JoinOrdering.hpp"
+#include "algebra/KeyRewrites.hpp"
+#include "algebra/Operator.hpp"
+#include <algorithm>
+#include <functional>
+//---------------------------------------------------------------------------
+// (c) 2023 Thomas Neumann
+//---------------------------------------------------------------------------
+using namespace std;
+//---------------------------------------------------------------------------
+namespace saneql::algebra {
+//---------------------------------------------------------------------------
+RewriteRule::~RewriteRule()
+// Destructor
+{
+}
+//---------------------------------------------------------------------------
+void RewriteRule::setQuery(const function<void(IUUsage&)>&)
+// Set the query that is rewritten
+{
+}
+//---------------------------------------------------------------------------
+void RewriteRule::collectConjuncts(unique_ptr<Expression>& condition, vector<unique_ptr<Expression>*>& conjuncts)
+// Collect the conjuncts of a condition
+{
+   if (auto b = dynamic_cast<BinaryExpression*>(condition.get()); b && (b->op == BinaryExpression::And)) {
+      collectConjuncts(b->left, conjuncts);
+      collectConjuncts(b->right, conjuncts);
+   } else {
+      conjuncts.push_back(&condition);
+   }
+}
+//---------------------------------------------------------------------------
+unique_ptr<Expression> RewriteRule::combineConjuncts(vector<unique_ptr<Expression>> conjuncts)
+// Combine conjuncts into one condition
+{
+   unique_ptr<Expression> result;
+   for (auto& c : conjuncts) {
+      if (!result) {
+         result = move(c);
+      } else {
+         Type type = Type::getBool().withNullable(result->getType().isNullable() || c->getType().isNullable());
+         result = make_unique<BinaryExpression>(move(result), move(c), type, BinaryExpression::And);
+      }
+   }
+   return result;
+}
+//---------------------------------------------------------------------------
+static unordered_set<const IU*> getUsed(Expression& e)
+// Get the IUs used by an expression
+{
+   IUUsage usage;
+   e.collectUsage(usage);
+   return move(usage.used);
+}
+//---------------------------------------------------------------------------
+static unordered_set<const IU*> getProduced(Operator& op)
+// Get the IUs produced by an operator
+{
+   unordered_set<const IU*> produced;
+   op.collectProduced(produced);
+   return produced;
+}
+//---------------------------------------------------------------------------
+static bool intersects(const unordered_set<const IU*>& a, const unordered_set<const IU*>& b)
+// Do two IU sets intersect?
+{
+   return any_of(a.begin(), a.end(), [&](const IU* iu) { return b.contains(iu); });
+}
+//---------------------------------------------------------------------------
+void RewriteRule::addSelection(unique_ptr<Operator>& input, vector<unique_ptr<Expression>> conjuncts)
+// Filter an input by the given conjuncts, merging them into an existing selection
+{
+   if (conjuncts.empty()) return;
+   if (auto select = dynamic_cast<Select*>(input.get())) {
+      conjuncts.insert(conjuncts.begin(), move(select->accessCondition()));
+      select->accessCondition() = combineConjuncts(move(conjuncts));
+   } else {
+      input = make_unique<Select>(move(input), combineConjuncts(move(conjuncts)));
+   }
+}
+//---------------------------------------------------------------------------
+static bool pushConjuncts(unique_ptr<Operator>& op, const function<bool(Expression&)>& canPush, const function<void(unique_ptr<Expression>)>& push)
+// Push the conjuncts of a selection into its input. Removes the selection if all conjuncts were pushed
+{
+   auto& select = static_cast<Select&>(*op);
+   vector<unique_ptr<Expression>*> conjuncts;
+   RewriteRule::collectConjuncts(select.accessCondition(), conjuncts);
+   if (none_of(conjuncts.begin(), conjuncts.end(), [&](auto c) { return canPush(**c); })) return false;
+
+   vector<unique_ptr<Expression>> remaining;
+   for (auto c : conjuncts) {
+      if (canPush(**c))
+         push(move(*c));
+      else
+         remaining.push_back(move(*c));
+   }
+   if (remaining.empty())
+      op = move(select.accessInput());
+   else
+      select.accessCondition() = RewriteRule::combineConjuncts(move(remaining));
+   return true;
+}
+//---------------------------------------------------------------------------
+static bool pushIntoJoin(unique_ptr<Operator>& op, Join& join)
+// Push the conjuncts of a selection below a join
+{
+   enum class Target {
+      Keep,
+      Left,
+      Right,
+      Condition
+   };
+   auto leftProduced = getProduced(*join.accessLeft()), rightProduced = getProduced(*join.accessRight());
+   auto getTarget = [&](Expression& e) {
+      auto used = getUsed(e);
+      bool usesLeft = intersects(used, leftProduced), usesRight = intersects(used, rightProduced);
+      switch (join.getJoinType()) {
+         case Join::JoinType::Inner:
+            if (!usesRight) return Target::Left;
+            if (!usesLeft) return Target::Right;
+            return Target::Condition;
+         case Join::JoinType::LeftOuter: return usesRight ? Target::Keep : Target::Left;
+         case Join::JoinType::RightOuter: return usesLeft ? Target::Keep : Target::Right;
+         case Join::JoinType::FullOuter: return Target::Keep;
+         case Join::JoinType::LeftSemi:
+         case Join::JoinType::LeftAnti: return Target::Left;
+         case Join::JoinType::RightSemi:
+         case Join::JoinType::RightAnti: return Target::Right;
+      }
+      return Target::Keep;
+   };
+
+   vector<unique_ptr<Expression>> left, right, condition;
+   bool pushed = pushConjuncts(op, [&](Expression& e) { return getTarget(e) != Target::Keep; }, [&](unique_ptr<Expression> e) {
+      switch (getTarget(*e)) {
+         case Target::Keep: break;
+         case Target::Left: left.push_back(move(e)); break;
+         case Target::Right: right.push_back(move(e)); break;
+         case Target::Condition: condition.push_back(move(e)); break;
+      }
+   });
+   if (!pushed) return false;
+
+   RewriteRule::addSelection(join.accessLeft(), move(left));
+   RewriteRule::addSelection(join.accessRight(), move(right));
+   if (!condition.empty()) {
+      condition.insert(condition.begin(), move(join.accessCondition()));
+      join.accessCondition() = RewriteRule::combineConjuncts(move(condition));
+   }
+   return true;
+}
+//---------------------------------------------------------------------------
+static bool pushIntoMap(unique_ptr<Operator>& op, Map& map)
+// Push the conjuncts of a selection below a map
+{
+   unordered_set<const IU*> computed;
+   for (auto& c : map.getComputations())
+      computed.insert(c.iu.get());
+
+   vector<unique_ptr<Expression>> below;
+   bool pushed = pushConjuncts(op, [&](Expression& e) { return !intersects(getUsed(e), computed); }, [&](unique_ptr<Expression> e) { below.push_back(move(e)); });
+   if (pushed) RewriteRule::addSelection(map.accessInput(), move(below));
+   return pushed;
+}
+//---------------------------------------------------------------------------
+static bool pushIntoSetOperation(unique_ptr<Operator>& op, SetOperation& setOp)
+// Push the conjuncts of a selection into both inputs of a set operation
+{
+   // Translate the result columns into the input columns of each side
+   Expression::Substitutions leftColumns, rightColumns;
+   auto& resultColumns = setOp.getResultColumns();
+   for (unsigned index = 0; index != resultColumns.size(); ++index) {
+      leftColumns[resultColumns[index].get()] = setOp.getLeftColumns()[index].get();
+      rightColumns[resultColumns[index].get()] = setOp.getRightColumns()[index].get();
+   }
+
+   // Conjuncts with subqueries cannot be copied
+   vector<unique_ptr<Expression>> left, right;
+   bool pushed = pushConjuncts(op, [&](Expression& e) { return !!e.clone({}); }, [&](unique_ptr<Expression> e) {
+      left.push_back(e->clone(leftColumns));
+      right.push_back(e->clone(rightColumns));
+   });
+   if (!pushed) return false;
+
+   RewriteRule::addSelection(setOp.accessLeft(), move(left));
+   RewriteRule::addSelection(setOp.accessRight(), move(right));
+   return true;
+}
+//---------------------------------------------------------------------------
+bool MergeSelections::apply(unique_ptr<Operator>& op)
+// Try to rewrite the operator in place
+{
+   auto select = dynamic_cast<Select*>(op.get());
+   if ((!select) || (!dynamic_cast<Select*>(select->accessInput().get()))) return false;
+
+   // Conditions of the lower selection stay first
+   auto& input = select->accessInput();
+   vector<unique_ptr<Expression>> conditions;
+   conditions.push_back(move(select->accessCondition()));
+   addSelection(input, move(conditions));
+   op = move(input);
+   return true;
+}
+//---------------------------------------------------------------------------
+bool PushDownSelections::apply(unique_ptr<Operator>& op)
+// Try to rewrite the operator in place
+{
+   auto select = dynamic_cast<Select*>(op.get());
+   if (!select) return false;
+
+   auto input = select->accessInput().get();
+   if (auto join = dynamic_cast<Join*>(input)) return pushIntoJoin(op, *join);
+   if (auto map = dynamic_cast<Map*>(input)) return pushIntoMap(op, *map);
+   if (auto setOp = dynamic_cast<SetOperation*>(input)) return pushIntoSetOperation(op, *setOp);
+   return false;
+}
+//---------------------------------------------------------------------------
+Optimizer::Optimizer()
+// Constructor
+{
+}
+//---------------------------------------------------------------------------
+Optimizer Optimizer::createDefault()
+// Create an optimizer with the default rules
+{
+   Optimizer optimizer;
+   optimizer.addRule(make_unique<MergeSelections>());
+   optimizer.addRule(make_unique<PushDownSelections>());
+   // The key based rewrites see the join conditions after pushdown
+   optimizer.addPhase();
+   optimizer.addRule(make_unique<MergeSelections>());
+   optimizer.addRule(make_unique<EliminateJoins>());
+   optimizer.addRule(make_unique<EliminateDistinct>());
+   optimizer.addRule(make_unique<ReduceGroupBy>());
+   // Join ordering works on the join trees without interleaved selections
+   optimizer.addPhase();
+   optimizer.addRule(make_unique<ReorderJoins>());
+   return optimizer;
+}
+//---------------------------------------------------------------------------
+void Optimizer::addPhase()
+// Start a new phase
+{
+   phases.emplace_back();
+}
+//---------------------------------------------------------------------------
+void Optimizer::addRule(unique_ptr<RewriteRule> rule)
+// Register a rule in the current phase
+{
+   if (phases.empty()) addPhase();
+   phases.back().push_back(move(rule));
+}
+//---------------------------------------------------------------------------
+bool Optimizer::rewrite(const Phase& rules, unique_ptr<Operator>& op)
+// Apply the rules of a phase to a tree once
+{
+   // Rules can replace the operator, apply them until the current position is stable
+   bool changed = false;
+   for (bool applied = true; applied;) {
+      applied = false;
+      for (auto& r : rules)
+         applied |= r->apply(op);
+      changed |= applied;
+   }
+   for (auto input : op->getInputs())
+      changed |= rewrite(rules, *input);
+   return changed;
+}
+//---------------------------------------------------------------------------
+void Optimizer::optimizeTree(unique_ptr<Operator>& root)
+// Optimize a tree
+{
+   for (auto& phase : phases)
+      for (unsigned pass = 0; pass != maxPasses; ++pass)
+         if (!rewrite(phase, root)) break;
+}
+//---------------------------------------------------------------------------
+void Optimizer::optimizeQuery(const vector<unique_ptr<Operator>*>& trees, const function<void(IUUsage&)>& collect)
+// Optimize all trees of a query
+{
+   for (auto& phase : phases)
+      for (auto& r : phase)
+         r->setQuery(collect);
+   for (auto t : trees)
+      optimizeTree(*t);
+   for (auto& phase : phases)
+      for (auto& r : phase)
+         r->setQuery({});
+}
+//---------------------------------------------------------------------------
+void Optimizer::optimize(unique_ptr<Operator>& root, const vector<const IU*>& output)
+// Optimize an operator tree that produces the given output, including its subqueries and CTEs
+{
+   // The rewrites keep subqueries and CTEs in place, we can collect them upfront
+   IUUsage usage;
+   root->collectUsage(usage);
+   vector<unique_ptr<Operator>*> trees{&root};
+   trees.insert(trees.end(), usage.subqueries.begin(), usage.subqueries.end());
+   for (auto c : usage.ctes)
+      trees.push_back(&c->op);
+   optimizeQuery(trees, [&](IUUsage& usage) {
+      usage.used.insert(output.begin(), output.end());
+      root->collectUsage(usage);
+   });
+}
+//---------------------------------------------------------------------------
+void Optimizer::optimize(Expression& root)
+// Optimize the subqueries of an expression
+{
+   IUUsage usage;
+   root.collectUsage(usage);
+   vector<unique_ptr<Operator>*> trees(usage.subqueries.begin(), usage.subqueries.end());
+   for (auto c : usage.ctes)
+      trees.push_back(&c->op);
+   optimizeQuery(trees, [&](IUUsage& usage) { root.collectUsage(usage); });
+}
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
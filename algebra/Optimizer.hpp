@@ -0,0 +1,104 @@
+#ifndef H_saneql_Optimizer
+#define H_saneql_Optimizer
+//---------------------------------------------------------------------------
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <vector>
+//---------------------------------------------------------------------------
+// SaneQL
+// (c) 2023 Thomas Neumann
+// SPDX-License-Identifier: BSD-3-Clause
+//---------------------------------------------------------------------------
+namespace saneql {
+//---------------------------------------------------------------------------
+namespace algebra {
+//---------------------------------------------------------------------------
+class Expression;
+class IU;
+class IUUsage;
+class Operator;
+//---------------------------------------------------------------------------
+/// A rewrite rule for operator trees
+class RewriteRule {
+   public:
+   /// Destructor
+   virtual ~RewriteRule();
+
+   /// Get the name of the rule
+   virtual std::string_view getName() const = 0;
+   /// Try to rewrite the operator in place. Returns true if the tree was changed
+   virtual bool apply(std::unique_ptr<Operator>& op) = 0;
+   /// Set the query that is rewritten. The callback collects the IU usage of the whole query, including its output
+   virtual void setQuery(const std::function<void(IUUsage&)>& collect);
+
+   /// Collect the conjuncts of a condition. The conjuncts stay owned by the condition
+   static void collectConjuncts(std::unique_ptr<Expression>& condition, std::vector<std::unique_ptr<Expression>*>& conjuncts);
+   /// Combine conjuncts into one condition. Returns nullptr if there are no conjuncts
+   static std::unique_ptr<Expression> combineConjuncts(std::vector<std::unique_ptr<Expression>> conjuncts);
+   /// Filter an input by the given conjuncts, merging them into an existing selection
+   static void addSelection(std::unique_ptr<Operator>& input, std::vector<std::unique_ptr<Expression>> conjuncts);
+};
+//---------------------------------------------------------------------------
+/// Merges a selection into a selection below it
+class MergeSelections : public RewriteRule {
+   public:
+   /// Get the name of the rule
+   std::string_view getName() const override { return "mergeselections"; }
+   /// Try to rewrite the operator in place
+   bool apply(std::unique_ptr<Operator>& op) override;
+};
+//---------------------------------------------------------------------------
+/// Pushes the conjuncts of a selection below joins, maps, and set operations
+class PushDownSelections : public RewriteRule {
+   public:
+   /// Get the name of the rule
+   std::string_view getName() const override { return "pushdownselections"; }
+   /// Try to rewrite the operator in place
+   bool apply(std::unique_ptr<Operator>& op) override;
+};
+//---------------------------------------------------------------------------
+/// A rule based optimizer. The rules are grouped into phases that run one after the other.
+/// A phase applies its rules top-down until no rule changes the tree anymore
+class Optimizer {
+   public:
+   /// A phase of rules
+   using Phase = std::vector<std::unique_ptr<RewriteRule>>;
+
+   private:
+   /// The phases, in application order
+   std::vector<Phase> phases;
+   /// The maximum number of passes over the tree per phase
+   unsigned maxPasses = 100;
+
+   /// Apply the rules of a phase to a tree once. Returns true if the tree was changed
+   bool rewrite(const Phase& rules, std::unique_ptr<Operator>& op);
+   /// Optimize a tree
+   void optimizeTree(std::unique_ptr<Operator>& root);
+   /// Optimize all trees of a query
+   void optimizeQuery(const std::vector<std::unique_ptr<Operator>*>& trees, const std::function<void(IUUsage&)>& collect);
+
+   public:
+   /// Constructor. Creates an optimizer without rules
+   Optimizer();
+
+   /// Create an optimizer with the default rules
+   static Optimizer createDefault();
+
+   /// Start a new phase. Its rules run after the earlier phases are done
+   void addPhase();
+   /// Register a rule in the current phase
+   void addRule(std::unique_ptr<RewriteRule> rule);
+   /// Get the phases
+   const std::vector<Phase>& getPhases() const { return phases; }
+
+   /// Optimize an operator tree that produces the given output, including its subqueries and CTEs
+   void optimize(std::unique_ptr<Operator>& root, const std::vector<const IU*>& output);
+   /// Optimize the subqueries of an expression
+   void optimize(Expression& root);
+};
+//---------------------------------------------------------------------------
+}
+}
+//---------------------------------------------------------------------------
+#endif
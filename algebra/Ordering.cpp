@@ -0,0 +1,50 @@
+#include "algebra/Ordering.hpp"
+#include "algebra/Expression.hpp"
+#include "algebra/Operator.hpp"
+#include "semana/SemanticAnalysis.hpp"
+#include <algorithm>
+//---------------------------------------------------------------------------
+// (c) 2023 Thomas Neumann
+//---------------------------------------------------------------------------
+using namespace std;
+//---------------------------------------------------------------------------
+namespace saneql::algebra {
+//---------------------------------------------------------------------------
+static const IU* getColumn(Expression* expression)
+// Get the IU of a column reference
+{
+   auto ref = dynamic_cast<IURef*>(expression);
+   return ref ? ref->getIU() : nullptr;
+}
+//---------------------------------------------------------------------------
+Ordering Ordering::derive(Operator& op)
+// Derive the order of an operator tree
+{
+   Ordering result;
+   if (auto sort = dynamic_cast<Sort*>(&op)) {
+      // The order is known up to the first computed value. A collation might treat distinct values as peers
+      for (auto& o : sort->order) {
+         auto iu = getColumn(o.value.get());
+         if ((!iu) || (o.collate != Collate{})) break;
+         if (any_of(result.entries.begin(), result.entries.end(), [&](const Entry& e) { return e.iu == iu; })) continue;
+         result.entries.push_back({iu, o.descending});
+      }
+   } else if (auto select = dynamic_cast<Select*>(&op)) {
+      result = derive(*select->accessInput());
+   } else if (auto map = dynamic_cast<Map*>(&op)) {
+      result = derive(*map->accessInput());
+   }
+   // All other operators produce their rows in an arbitrary order, in particular windows emit their partitions one after the other
+   return result;
+}
+//---------------------------------------------------------------------------
+bool Ordering::isGrouped(const IUSet& ius) const
+// Are rows with equal values of a set of IUs adjacent?
+{
+   // The order within the prefix does not matter
+   if (ius.size() > entries.size()) return false;
+   return all_of(entries.begin(), entries.begin() + ius.size(), [&](const Entry& e) { return ius.contains(e.iu); });
+}
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
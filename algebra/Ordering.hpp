@@ -0,0 +1,51 @@
+#ifndef H_saneql_Ordering
+#define H_saneql_Ordering
+//---------------------------------------------------------------------------
+#include <unordered_set>
+#include <vector>
+//---------------------------------------------------------------------------
+// SaneQL
+// (c) 2023 Thomas Neumann
+// SPDX-License-Identifier: BSD-3-Clause
+//---------------------------------------------------------------------------
+namespace saneql {
+//---------------------------------------------------------------------------
+namespace algebra {
+//---------------------------------------------------------------------------
+class IU;
+class Operator;
+//---------------------------------------------------------------------------
+/// Derives the order in which operator trees produce their rows. Only sorts establish
+/// an order, operators that process their input row by row preserve it. NULL values
+/// are adjacent, as in grouping. The derivation is conservative, a missing order only
+/// prevents order-based execution strategies
+class Ordering {
+   public:
+   /// A set of IUs
+   using IUSet = std::unordered_set<const IU*>;
+   /// An entry of the order
+   struct Entry {
+      /// The column
+      const IU* iu;
+      /// Descending?
+      bool descending;
+   };
+
+   private:
+   /// The order, each column occurs at most once
+   std::vector<Entry> entries;
+
+   public:
+   /// Derive the order of an operator tree
+   static Ordering derive(Operator& op);
+
+   /// Get the order
+   const std::vector<Entry>& getEntries() const { return entries; }
+   /// Are rows with equal values of a set of IUs adjacent? True if the IUs form a prefix of the order
+   bool isGrouped(const IUSet& ius) const;
+};
+//---------------------------------------------------------------------------
+}
+}
+//---------------------------------------------------------------------------
+#endif
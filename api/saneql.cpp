@@ -0,0 +1,239 @@
+#include "api/saneql.h"
+#include "driver/Compiler.hpp"
+#include "driver/PreparedQuery.hpp"
+#include "infra/Schema.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <stdexcept>
+//---------------------------------------------------------------------------
+// (c) 2023 Thomas Neumann
+//---------------------------------------------------------------------------
+using namespace std;
+using namespace saneql;
+//---------------------------------------------------------------------------
+struct saneql_schema {
+   /// The schema
+   Schema schema;
+};
+//---------------------------------------------------------------------------
+struct saneql_compiler {
+   /// The compiler
+   Compiler compiler;
+
+   /// Constructor
+   explicit saneql_compiler(const Schema& schema) : compiler(schema) {}
+};
+//---------------------------------------------------------------------------
+struct saneql_prepared {
+   /// The prepared query
+   PreparedQuery query;
+
+   /// Constructor
+   saneql_prepared(const Schema& schema, string query, vector<Type> parameterTypes) : query(schema, move(query), move(parameterTypes)) {}
+};
+//---------------------------------------------------------------------------
+namespace {
+//---------------------------------------------------------------------------
+/// A provider that asks a callback for the definition of tables
+class CallbackProvider : public Schema::Provider {
+   /// The callback
+   saneql_table_callback callback;
+   /// The callback context
+   void* context;
+   /// The catalog version
+   uint64_t version;
+
+   public:
+   /// Constructor
+   CallbackProvider(saneql_table_callback callback, void* context, uint64_t version) : callback(callback), context(context), version(version) {}
+
+   /// Load a table
+   optional<Schema::Table> loadTable(string_view name) const override;
+   /// Get the names of all tables. The callback cannot enumerate the tables
+   vector<string> getTableNames() const override { return {}; }
+   /// Get the catalog version
+   uint64_t getVersion() const override { return version; }
+};
+//---------------------------------------------------------------------------
+optional<Schema::Table> CallbackProvider::loadTable(string_view name) const
+// Load a table
+{
+   unique_ptr<char, decltype(&free)> ddl(callback(context, string(name).c_str()), &free);
+   if (!ddl) return {};
+   optional<Schema::Table> result;
+   Schema::parseDDL(ddl.get(), [&](string tableName, Schema::Table table) {
+      if (tableName == name) result = move(table);
+   });
+   if (!result) throw runtime_error("the definition of table '" + string(name) + "' does not create it");
+   return result;
+}
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
+static char* copyString(string_view str)
+// Copy a string into malloc-ed memory
+{
+   auto result = static_cast<char*>(malloc(str.size() + 1));
+   if (!result) return nullptr;
+   memcpy(result, str.data(), str.size());
+   result[str.size()] = 0;
+   return result;
+}
+//---------------------------------------------------------------------------
+saneql_schema* saneql_schema_create(void)
+// Create the default schema
+{
+   try {
+      auto result = new saneql_schema;
+      result->schema.populateSchema();
+      return result;
+   } catch (...) {
+      return nullptr;
+   }
+}
+//---------------------------------------------------------------------------
+saneql_schema* saneql_schema_create_from_file(const char* path, char** error)
+// Create a schema from a file
+{
+   if (error) *error = nullptr;
+   try {
+      auto result = make_unique<saneql_schema>();
+      result->schema.loadSchema(path);
+      return result.release();
+   } catch (const bad_alloc&) {
+      return nullptr;
+   } catch (const exception& e) {
+      if (error) *error = copyString(e.what());
+      return nullptr;
+   }
+}
+//---------------------------------------------------------------------------
+saneql_schema* saneql_schema_create_with_callback(saneql_table_callback callback, void* context, size_t cache_size, uint64_t version)
+// Create a schema that loads tables on demand through a callback
+{
+   if (!callback) return nullptr;
+   try {
+      auto result = make_unique<saneql_schema>();
+      result->schema.setProvider(make_unique<CallbackProvider>(callback, context, version), cache_size);
+      return result.release();
+   } catch (...) {
+      return nullptr;
+   }
+}
+//---------------------------------------------------------------------------
+void saneql_schema_destroy(saneql_schema* schema)
+// Destroy a schema
+{
+   delete schema;
+}
+//---------------------------------------------------------------------------
+int saneql_schema_load_statistics(saneql_schema* schema, const char* path, char** error)
+// Load table statistics
+{
+   try {
+      ifstream in(path);
+      if (!in.is_open()) throw runtime_error("unable to read "s + path);
+      schema->schema.loadStatistics(in);
+      return 0;
+   } catch (const bad_alloc&) {
+      return 1;
+   } catch (const exception& e) {
+      if (error) *error = copyString(e.what());
+      return 1;
+   }
+}
+//---------------------------------------------------------------------------
+saneql_compiler* saneql_compiler_create(const saneql_schema* schema)
+// Create a compiler for a schema
+{
+   if (!schema) return nullptr;
+   return new (nothrow) saneql_compiler(schema->schema);
+}
+//---------------------------------------------------------------------------
+void saneql_compiler_destroy(saneql_compiler* compiler)
+// Destroy a compiler
+{
+   delete compiler;
+}
+//---------------------------------------------------------------------------
+template <class T>
+static int produceString(char** result, T&& producer)
+// Store the result of a producer or its error message
+{
+   try {
+      *result = copyString(producer());
+      return *result ? 0 : 1;
+   } catch (const bad_alloc&) {
+      *result = nullptr;
+      return 1;
+   } catch (const exception& e) {
+      *result = copyString(e.what());
+      return 1;
+   }
+}
+//---------------------------------------------------------------------------
+int saneql_compile(saneql_compiler* compiler, const char* query, size_t length, char** result)
+// Compile a query
+{
+   return produceString(result, [&]() { return compiler->compiler.compile(string_view(query, length)); });
+}
+//---------------------------------------------------------------------------
+saneql_prepared* saneql_prepare(const saneql_schema* schema, const char* query, size_t length, const char* const* parameter_types, size_t parameter_count, char** error)
+// Prepare a query with parameters
+{
+   if (error) *error = nullptr;
+   if (!schema) return nullptr;
+   try {
+      SemanticAnalysis semana(schema->schema);
+      vector<Type> types;
+      for (size_t index = 0; index != parameter_count; ++index)
+         types.push_back(parameter_types[index] ? semana.parseSimpleTypeName(parameter_types[index]) : Type::getUnknown());
+      return new saneql_prepared(schema->schema, string(query, length), move(types));
+   } catch (const bad_alloc&) {
+      return nullptr;
+   } catch (const exception& e) {
+      if (error) *error = copyString(e.what());
+      return nullptr;
+   }
+}
+//---------------------------------------------------------------------------
+void saneql_prepared_destroy(saneql_prepared* prepared)
+// Destroy a prepared query
+{
+   delete prepared;
+}
+//---------------------------------------------------------------------------
+size_t saneql_prepared_parameter_count(const saneql_prepared* prepared)
+// Get the number of parameters of a prepared query
+{
+   return prepared->query.getParameterTypes().size();
+}
+//---------------------------------------------------------------------------
+int saneql_prepared_sql(const saneql_prepared* prepared, int placeholder_style, char** result)
+// Generate the SQL text with placeholders
+{
+   auto style = (placeholder_style == SANEQL_PLACEHOLDER_POSITIONAL) ? SQLWriter::PlaceholderStyle::Positional : SQLWriter::PlaceholderStyle::Numbered;
+   return produceString(result, [&]() { return prepared->query.generate(style); });
+}
+//---------------------------------------------------------------------------
+int saneql_prepared_bind(const saneql_prepared* prepared, const char* const* values, size_t count, char** result)
+// Generate the SQL text with the parameter values embedded
+{
+   return produceString(result, [&]() {
+      vector<optional<string>> bound;
+      for (size_t index = 0; index != count; ++index)
+         bound.push_back(values[index] ? optional<string>(values[index]) : nullopt);
+      return prepared->query.generate(bound);
+   });
+}
+//---------------------------------------------------------------------------
+void saneql_free(char* str)
+// Release a string returned by the library
+{
+   free(str);
+}
+//---------------------------------------------------------------------------
@@ -0,0 +1,88 @@
+#ifndef H_saneql_api
+#define H_saneql_api
+//---------------------------------------------------------------------------
+#include <stddef.h>
+#include <stdint.h>
+//---------------------------------------------------------------------------
+// SaneQL
+// (c) 2023 Thomas Neumann
+// SPDX-License-Identifier: BSD-3-Clause
+//---------------------------------------------------------------------------
+// C interface of libsaneql. All functions are reentrant, different compiler
+// handles can be used concurrently from different threads. A schema handle
+// is read-only after creation and can be shared between compilers.
+//---------------------------------------------------------------------------
+#ifdef __cplusplus
+extern "C" {
+#endif
+//---------------------------------------------------------------------------
+/// A database schema
+typedef struct saneql_schema saneql_schema;
+/// A compiler instance. Reuses memory between queries, must not be used concurrently
+typedef struct saneql_compiler saneql_compiler;
+/// A prepared query. Is read-only after creation and can be used concurrently
+typedef struct saneql_prepared saneql_prepared;
+
+/// Placeholder styles for prepared queries
+enum {
+   /// $1, $2, ...
+   SANEQL_PLACEHOLDER_NUMBERED = 0,
+   /// ? in order of appearance
+   SANEQL_PLACEHOLDER_POSITIONAL = 1
+};
+//---------------------------------------------------------------------------
+/// Create the default schema. Returns NULL on failure
+saneql_schema* saneql_schema_create(void);
+/// Create a schema from a file with SQL DDL or a snapshot written by
+/// "saneql --write-snapshot". Returns NULL on failure and stores the error
+/// message in *error if error is not NULL
+saneql_schema* saneql_schema_create_from_file(const char* path, char** error);
+/// Describes a table on demand. Returns the create table statement of the
+/// table in malloc-ed memory, which is released by saneql, or NULL if the
+/// table does not exist. Is called concurrently from different threads
+typedef char* (*saneql_table_callback)(void* context, const char* name);
+/// Create a schema that loads tables on demand through a callback. At most
+/// cache_size tables are kept in memory. The version identifies the catalog
+/// contents and must change whenever a table changes. Returns NULL on failure
+saneql_schema* saneql_schema_create_with_callback(saneql_table_callback callback, void* context, size_t cache_size, uint64_t version);
+/// Destroy a schema. All compilers using it must be destroyed first
+void saneql_schema_destroy(saneql_schema* schema);
+/// Load table statistics as produced by "saneql --analyze". Must be called
+/// before the schema is used by compilers. Returns 0 on success, otherwise
+/// returns a non-zero value and stores the error message in *error if error
+/// is not NULL. *error is left untouched on success
+int saneql_schema_load_statistics(saneql_schema* schema, const char* path, char** error);
+
+/// Create a compiler for a schema. Returns NULL on failure
+saneql_compiler* saneql_compiler_create(const saneql_schema* schema);
+/// Destroy a compiler
+void saneql_compiler_destroy(saneql_compiler* compiler);
+
+/// Compile a query. Returns 0 on success and stores the SQL text in *result,
+/// otherwise returns a non-zero value and stores the error message in *result.
+/// The result string must be released with saneql_free
+int saneql_compile(saneql_compiler* compiler, const char* query, size_t length, char** result);
+
+/// Prepare a query with parameters ($1, $2, ...). parameter_types names the
+/// types of the parameters ("integer", "text", "date", ...), NULL entries leave
+/// the type to casts within the query ($1::integer). Returns NULL on failure
+/// and stores the error message in *error if error is not NULL
+saneql_prepared* saneql_prepare(const saneql_schema* schema, const char* query, size_t length, const char* const* parameter_types, size_t parameter_count, char** error);
+/// Destroy a prepared query
+void saneql_prepared_destroy(saneql_prepared* prepared);
+/// Get the number of parameters of a prepared query
+size_t saneql_prepared_parameter_count(const saneql_prepared* prepared);
+/// Generate the SQL text with placeholders. Same result conventions as saneql_compile
+int saneql_prepared_sql(const saneql_prepared* prepared, int placeholder_style, char** result);
+/// Generate the SQL text with the parameter values embedded. A NULL value is
+/// the SQL NULL value. Same result conventions as saneql_compile
+int saneql_prepared_bind(const saneql_prepared* prepared, const char* const* values, size_t count, char** result);
+
+/// Release a string returned by the library
+void saneql_free(char* str);
+//---------------------------------------------------------------------------
+#ifdef __cplusplus
+}
+#endif
+//---------------------------------------------------------------------------
+#endif
@@ -0,0 +1,355 @@
+#ifndef H_parser_AST
+#define H_parser_AST
+//---------------------------------------------------------------------------
+#include "parser/ASTBase.hpp"
+#include <iosfwd>
+//---------------------------------------------------------------------------
+namespace saneql::ast {
+//---------------------------------------------------------------------------
+// LCOV_EXCL_START
+//---------------------------------------------------------------------------
+// An AST node. This is the generic base class, each specific node forms a subclass
+class AST : public saneql::ASTBase {
+   public:
+   /// All known types
+   enum class Type : unsigned { Token,Access,BinaryExpression,Call,Cast,DefineFunction,FuncArg,FuncArgNamed,LetArg,LetEntry,List,Literal,Parameter,QueryBody,Type,TypeArg,UnaryExpression };
+
+   /// Constructor
+   AST(std::string_view content,uintptr_t descriptor) : saneql::ASTBase(content,descriptor) {}
+
+   /// Get the node type
+   Type getType() const { return static_cast<Type>(getRawType()); }
+};
+//---------------------------------------------------------------------------
+std::ostream& operator<<(std::ostream& out,AST::Type type);
+//---------------------------------------------------------------------------
+/// A token terminal node
+class Token : public AST {
+   public:
+   /// Constructor
+   template <class T> Token(const T& token) : AST(token.content,AST::buildDescriptor(static_cast<unsigned>(AST::Type::Token),token.encoding,0)) { computeHash(); }
+   /// Get as string
+   std::string asString() const { return getTokenValue(getRawSubType()); }
+   /// A type safe cast
+   static inline const Token* cast(const AST* node) { assert((!node)||(node->AST::getType()==AST::Type::Token)); return static_cast<const Token*>(node); }
+   /// A type safe cast
+   static inline const Token& ref(const AST* node) { assert((!!node)&&(node->AST::getType()==AST::Type::Token)); return *static_cast<const Token*>(node); }
+};
+//---------------------------------------------------------------------------
+/// An AST node
+class Access : public AST {
+   public:
+   /// Subnode
+   AST* base;
+   /// Subnode
+   AST* part;
+
+   /// Constructor
+   Access(std::string_view _content,AST* base,AST* part) : AST(_content,AST::buildDescriptor(AST::Type::Access,0,2)),base(base),part(part) { computeHash(); }
+   /// A type safe cast
+   static inline const Access* cast(const AST* node) { assert((!node)||(node->AST::getType()==AST::Type::Access)); return static_cast<const Access*>(node); }
+   /// A type safe cast
+   static inline const Access& ref(const AST* node) { assert((!!node)&&(node->AST::getType()==AST::Type::Access)); return *static_cast<const Access*>(node); }
+   /// A type safe cast
+   static inline const Access& ref(const AST& node) { assert((node.AST::getType()==AST::Type::Access)); return static_cast<const Access&>(node); }
+};
+//---------------------------------------------------------------------------
+/// An AST node
+class BinaryExpression : public AST {
+   public:
+   /// The specific subtype
+   enum class SubType : unsigned { And, Div, Equals, Greater, GreaterOrEqual, Less, LessOrEqual, Minus, Mod, Mul, NotEquals, Or, Plus, Pow };
+   /// Get the subtype
+   SubType getSubType() const { return static_cast<SubType>(getRawSubType()); }
+   /// Subnode
+   AST* left;
+   /// Subnode
+   AST* right;
+
+   /// Constructor
+   BinaryExpression(std::string_view _content,SubType _subType,AST* left,AST* right) : AST(_content,AST::buildDescriptor(AST::Type::BinaryExpression,_subType,2)),left(left),right(right) { computeHash(); }
+   /// A type safe cast
+   static inline const BinaryExpression* cast(const AST* node) { assert((!node)||(node->AST::getType()==AST::Type::BinaryExpression)); return static_cast<const BinaryExpression*>(node); }
+   /// A type safe cast
+   static inline const BinaryExpression& ref(const AST* node) { assert((!!node)&&(node->AST::getType()==AST::Type::BinaryExpression)); return *static_cast<const BinaryExpression*>(node); }
+   /// A type safe cast
+   static inline const BinaryExpression& ref(const AST& node) { assert((node.AST::getType()==AST::Type::BinaryExpression)); return static_cast<const BinaryExpression&>(node); }
+};
+//---------------------------------------------------------------------------
+/// An AST node
+class Call : public AST {
+   public:
+   /// Subnode
+   AST* func;
+   /// Subnode
+   AST* args;
+
+   /// Constructor
+   Call(std::string_view _content,AST* func,AST* args) : AST(_content,AST::buildDescriptor(AST::Type::Call,0,2)),func(func),args(args) { computeHash(); }
+   /// A type safe cast
+   static inline const Call* cast(const AST* node) { assert((!node)||(node->AST::getType()==AST::Type::Call)); return static_cast<const Call*>(node); }
+   /// A type safe cast
+   static inline const Call& ref(const AST* node) { assert((!!node)&&(node->AST::getType()==AST::Type::Call)); return *static_cast<const Call*>(node); }
+   /// A type safe cast
+   static inline const Call& ref(const AST& node) { assert((node.AST::getType()==AST::Type::Call)); return static_cast<const Call&>(node); }
+};
+//---------------------------------------------------------------------------
+/// An AST node
+class Cast : public AST {
+   public:
+   /// Subnode
+   AST* value;
+   /// Subnode
+   AST* type;
+
+   /// Constructor
+   Cast(std::string_view _content,AST* value,AST* type) : AST(_content,AST::buildDescriptor(AST::Type::Cast,0,2)),value(value),type(type) { computeHash(); }
+   /// A type safe cast
+   static inline const Cast* cast(const AST* node) { assert((!node)||(node->AST::getType()==AST::Type::Cast)); return static_cast<const Cast*>(node); }
+   /// A type safe cast
+   static inline const Cast& ref(const AST* node) { assert((!!node)&&(node->AST::getType()==AST::Type::Cast)); return *static_cast<const Cast*>(node); }
+   /// A type safe cast
+   static inline const Cast& ref(const AST& node) { assert((node.AST::getType()==AST::Type::Cast)); return static_cast<const Cast&>(node); }
+};
+//---------------------------------------------------------------------------
+/// An AST node
+class DefineFunction : public AST {
+   public:
+   /// Subnode
+   AST* name;
+   /// Subnode
+   AST* args;
+   /// Subnode
+   AST* body;
+
+   /// Constructor
+   DefineFunction(std::string_view _content,AST* name,AST* args,AST* body) : AST(_content,AST::buildDescriptor(AST::Type::DefineFunction,0,3)),name(name),args(args),body(body) { computeHash(); }
+   /// A type safe cast
+   static inline const DefineFunction* cast(const AST* node) { assert((!node)||(node->AST::getType()==AST::Type::DefineFunction)); return static_cast<const DefineFunction*>(node); }
+   /// A type safe cast
+   static inline const DefineFunction& ref(const AST* node) { assert((!!node)&&(node->AST::getType()==AST::Type::DefineFunction)); return *static_cast<const DefineFunction*>(node); }
+   /// A type safe cast
+   static inline const DefineFunction& ref(const AST& node) { assert((node.AST::getType()==AST::Type::DefineFunction)); return static_cast<const DefineFunction&>(node); }
+};
+//---------------------------------------------------------------------------
+/// An AST node
+class FuncArg : public AST {
+   public:
+   /// The specific subtype
+   enum class SubType : unsigned { Flat, List };
+   /// Get the subtype
+   SubType getSubType() const { return static_cast<SubType>(getRawSubType()); }
+   /// Subnode
+   AST* name;
+   /// Subnode
+   AST* value;
+
+   /// Constructor
+   FuncArg(std::string_view _content,SubType _subType,AST* name,AST* value) : AST(_content,AST::buildDescriptor(AST::Type::FuncArg,_subType,2)),name(name),value(value) { computeHash(); }
+   /// A type safe cast
+   static inline const FuncArg* cast(const AST* node) { assert((!node)||(node->AST::getType()==AST::Type::FuncArg)); return static_cast<const FuncArg*>(node); }
+   /// A type safe cast
+   static inline const FuncArg& ref(const AST* node) { assert((!!node)&&(node->AST::getType()==AST::Type::FuncArg)); return *static_cast<const FuncArg*>(node); }
+   /// A type safe cast
+   static inline const FuncArg& ref(const AST& node) { assert((node.AST::getType()==AST::Type::FuncArg)); return static_cast<const FuncArg&>(node); }
+};
+//---------------------------------------------------------------------------
+/// An AST node
+class FuncArgNamed : public AST {
+   public:
+   /// The specific subtype
+   enum class SubType : unsigned { Case, Flat, List };
+   /// Get the subtype
+   SubType getSubType() const { return static_cast<SubType>(getRawSubType()); }
+   /// Subnode
+   AST* name;
+   /// Subnode
+   AST* value;
+
+   /// Constructor
+   FuncArgNamed(std::string_view _content,SubType _subType,AST* name,AST* value) : AST(_content,AST::buildDescriptor(AST::Type::FuncArgNamed,_subType,2)),name(name),value(value) { computeHash(); }
+   /// A type safe cast
+   static inline const FuncArgNamed* cast(const AST* node) { assert((!node)||(node->AST::getType()==AST::Type::FuncArgNamed)); return static_cast<const FuncArgNamed*>(node); }
+   /// A type safe cast
+   static inline const FuncArgNamed& ref(const AST* node) { assert((!!node)&&(node->AST::getType()==AST::Type::FuncArgNamed)); return *static_cast<const FuncArgNamed*>(node); }
+   /// A type safe cast
+   static inline const FuncArgNamed& ref(const AST& node) { assert((node.AST::getType()==AST::Type::FuncArgNamed)); return static_cast<const FuncArgNamed&>(node); }
+};
+//---------------------------------------------------------------------------
+/// An AST node
+class LetArg : public AST {
+   public:
+   /// Subnode
+   AST* name;
+   /// Subnode
+   AST* type;
+   /// Subnode
+   AST* value;
+
+   /// Constructor
+   LetArg(std::string_view _content,AST* name,AST* type,AST* value) : AST(_content,AST::buildDescriptor(AST::Type::LetArg,0,3)),name(name),type(type),value(value) { computeHash(); }
+   /// A type safe cast
+   static inline const LetArg* cast(const AST* node) { assert((!node)||(node->AST::getType()==AST::Type::LetArg)); return static_cast<const LetArg*>(node); }
+   /// A type safe cast
+   static inline const LetArg& ref(const AST* node) { assert((!!node)&&(node->AST::getType()==AST::Type::LetArg)); return *static_cast<const LetArg*>(node); }
+   /// A type safe cast
+   static inline const LetArg& ref(const AST& node) { assert((node.AST::getType()==AST::Type::LetArg)); return static_cast<const LetArg&>(node); }
+};
+//---------------------------------------------------------------------------
+/// An AST node
+class LetEntry : public AST {
+   public:
+   /// Subnode
+   AST* name;
+   /// Subnode
+   AST* args;
+   /// Subnode
+   AST* body;
+
+   /// Constructor
+   LetEntry(std::string_view _content,AST* name,AST* args,AST* body) : AST(_content,AST::buildDescriptor(AST::Type::LetEntry,0,3)),name(name),args(args),body(body) { computeHash(); }
+   /// A type safe cast
+   static inline const LetEntry* cast(const AST* node) { assert((!node)||(node->AST::getType()==AST::Type::LetEntry)); return static_cast<const LetEntry*>(node); }
+   /// A type safe cast
+   static inline const LetEntry& ref(const AST* node) { assert((!!node)&&(node->AST::getType()==AST::Type::LetEntry)); return *static_cast<const LetEntry*>(node); }
+   /// A type safe cast
+   static inline const LetEntry& ref(const AST& node) { assert((node.AST::getType()==AST::Type::LetEntry)); return static_cast<const LetEntry&>(node); }
+};
+//---------------------------------------------------------------------------
+/// An AST node
+class List : public AST {
+   public:
+   /// Subnode
+   AST* head;
+   /// Subnode
+   AST* tail;
+
+   /// Constructor
+   List(std::string_view _content,AST* head,AST* tail) : AST(_content,AST::buildDescriptor(AST::Type::List,0,2)),head(head),tail(tail) { computeHash(); }
+   /// A type safe cast
+   static inline const List* cast(const AST* node) { assert((!node)||(node->AST::getType()==AST::Type::List)); return static_cast<const List*>(node); }
+   /// A type safe cast
+   static inline const List& ref(const AST* node) { assert((!!node)&&(node->AST::getType()==AST::Type::List)); return *static_cast<const List*>(node); }
+   /// A type safe cast
+   static inline const List& ref(const AST& node) { assert((node.AST::getType()==AST::Type::List)); return static_cast<const List&>(node); }
+};
+//---------------------------------------------------------------------------
+/// An AST node
+class Literal : public AST {
+   public:
+   /// The specific subtype
+   enum class SubType : unsigned { False, Float, Integer, Null, String, True };
+   /// Get the subtype
+   SubType getSubType() const { return static_cast<SubType>(getRawSubType()); }
+   /// Subnode
+   AST* arg;
+
+   /// Constructor
+   Literal(std::string_view _content,SubType _subType,AST* arg) : AST(_content,AST::buildDescriptor(AST::Type::Literal,_subType,1)),arg(arg) { computeHash(); }
+   /// A type safe cast
+   static inline const Literal* cast(const AST* node) { assert((!node)||(node->AST::getType()==AST::Type::Literal)); return static_cast<const Literal*>(node); }
+   /// A type safe cast
+   static inline const Literal& ref(const AST* node) { assert((!!node)&&(node->AST::getType()==AST::Type::Literal)); return *static_cast<const Literal*>(node); }
+   /// A type safe cast
+   static inline const Literal& ref(const AST& node) { assert((node.AST::getType()==AST::Type::Literal)); return static_cast<const Literal&>(node); }
+};
+//---------------------------------------------------------------------------
+/// An AST node
+class Parameter : public AST {
+   public:
+   /// Subnode
+   AST* arg;
+
+   /// Constructor
+   Parameter(std::string_view _content,AST* arg) : AST(_content,AST::buildDescriptor(AST::Type::Parameter,0,1)),arg(arg) { computeHash(); }
+   /// A type safe cast
+   static inline const Parameter* cast(const AST* node) { assert((!node)||(node->AST::getType()==AST::Type::Parameter)); return static_cast<const Parameter*>(node); }
+   /// A type safe cast
+   static inline const Parameter& ref(const AST* node) { assert((!!node)&&(node->AST::getType()==AST::Type::Parameter)); return *static_cast<const Parameter*>(node); }
+   /// A type safe cast
+   static inline const Parameter& ref(const AST& node) { assert((node.AST::getType()==AST::Type::Parameter)); return static_cast<const Parameter&>(node); }
+};
+//---------------------------------------------------------------------------
+/// An AST node
+class QueryBody : public AST {
+   public:
+   /// Subnode
+   AST* lets;
+   /// Subnode
+   AST* body;
+
+   /// Constructor
+   QueryBody(std::string_view _content,AST* lets,AST* body) : AST(_content,AST::buildDescriptor(AST::Type::QueryBody,0,2)),lets(lets),body(body) { computeHash(); }
+   /// A type safe cast
+   static inline const QueryBody* cast(const AST* node) { assert((!node)||(node->AST::getType()==AST::Type::QueryBody)); return static_cast<const QueryBody*>(node); }
+   /// A type safe cast
+   static inline const QueryBody& ref(const AST* node) { assert((!!node)&&(node->AST::getType()==AST::Type::QueryBody)); return *static_cast<const QueryBody*>(node); }
+   /// A type safe cast
+   static inline const QueryBody& ref(const AST& node) { assert((node.AST::getType()==AST::Type::QueryBody)); return static_cast<const QueryBody&>(node); }
+};
+//---------------------------------------------------------------------------
+/// An AST node
+class Type : public AST {
+   public:
+   /// The specific subtype
+   enum class SubType : unsigned { Parameter, Simple, SubTypes };
+   /// Get the subtype
+   SubType getSubType() const { return static_cast<SubType>(getRawSubType()); }
+   /// Subnode
+   AST* name;
+   /// Subnode
+   AST* arg;
+
+   /// Constructor
+   Type(std::string_view _content,SubType _subType,AST* name,AST* arg) : AST(_content,AST::buildDescriptor(AST::Type::Type,_subType,2)),name(name),arg(arg) { computeHash(); }
+   /// A type safe cast
+   static inline const Type* cast(const AST* node) { assert((!node)||(node->AST::getType()==AST::Type::Type)); return static_cast<const Type*>(node); }
+   /// A type safe cast
+   static inline const Type& ref(const AST* node) { assert((!!node)&&(node->AST::getType()==AST::Type::Type)); return *static_cast<const Type*>(node); }
+   /// A type safe cast
+   static inline const Type& ref(const AST& node) { assert((node.AST::getType()==AST::Type::Type)); return static_cast<const Type&>(node); }
+};
+//---------------------------------------------------------------------------
+/// An AST node
+class TypeArg : public AST {
+   public:
+   /// Subnode
+   AST* name;
+   /// Subnode
+   AST* value;
+
+   /// Constructor
+   TypeArg(std::string_view _content,AST* name,AST* value) : AST(_content,AST::buildDescriptor(AST::Type::TypeArg,0,2)),name(name),value(value) { computeHash(); }
+   /// A type safe cast
+   static inline const TypeArg* cast(const AST* node) { assert((!node)||(node->AST::getType()==AST::Type::TypeArg)); return static_cast<const TypeArg*>(node); }
+   /// A type safe cast
+   static inline const TypeArg& ref(const AST* node) { assert((!!node)&&(node->AST::getType()==AST::Type::TypeArg)); return *static_cast<const TypeArg*>(node); }
+   /// A type safe cast
+   static inline const TypeArg& ref(const AST& node) { assert((node.AST::getType()==AST::Type::TypeArg)); return static_cast<const TypeArg&>(node); }
+};
+//---------------------------------------------------------------------------
+/// An AST node
+class UnaryExpression : public AST {
+   public:
+   /// The specific subtype
+   enum class SubType : unsigned { Minus, Not, Plus };
+   /// Get the subtype
+   SubType getSubType() const { return static_cast<SubType>(getRawSubType()); }
+   /// Subnode
+   AST* value;
+
+   /// Constructor
+   UnaryExpression(std::string_view _content,SubType _subType,AST* value) : AST(_content,AST::buildDescriptor(AST::Type::UnaryExpression,_subType,1)),value(value) { computeHash(); }
+   /// A type safe cast
+   static inline const UnaryExpression* cast(const AST* node) { assert((!node)||(node->AST::getType()==AST::Type::UnaryExpression)); return static_cast<const UnaryExpression*>(node); }
+   /// A type safe cast
+   static inline const UnaryExpression& ref(const AST* node) { assert((!!node)&&(node->AST::getType()==AST::Type::UnaryExpression)); return *static_cast<const UnaryExpression*>(node); }
+   /// A type safe cast
+   static inline const UnaryExpression& ref(const AST& node) { assert((node.AST::getType()==AST::Type::UnaryExpression)); return static_cast<const UnaryExpression&>(node); }
+};
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
+// LCOV_EXCL_STOP
+//---------------------------------------------------------------------------
+#endif
@@ -0,0 +1,2943 @@
+// A Bison parser, made by GNU Bison 3.8.2.
+
+// Skeleton implementation for Bison LALR(1) parsers in C++
+
+// Copyright (C) 2002-2015, 2018-2021 Free Software Foundation, Inc.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// As a special exception, you may create a larger work that contains
+// part or all of the Bison parser skeleton and distribute that work
+// under terms of your choice, so long as that work isn't itself a
+// parser generator using the skeleton or a modified version thereof
+// as a parser skeleton.  Alternatively, if you modify or redistribute
+// the parser skeleton itself, you may (at your option) remove this
+// special exception, which will cause the skeleton and the resulting
+// Bison output files to be licensed under the GNU General Public
+// License without this special exception.
+
+// This special exception was added by the Free Software Foundation in
+// version 2.2 of Bison.
+
+// DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+// especially those whose name start with YY_ or yy_.  They are
+// private implementation details that can be changed or removed.
+
+
+
+
+
+// "%code requires" blocks.
+#line 13 "bin/parser/saneql.expanded.ypp"
+
+#include "parser/AST.hpp"
+#include "parser/SaneQLLexer.hpp"
+#include "parser/SaneQLParser.hpp"
+
+#ifdef __clang__
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunused-but-set-variable"
+#endif
+
+// LCOV_EXCL_START
+
+#line 56 "bin/parser/saneql_parser.cpp"
+
+
+# include <cstdlib> // std::abort
+# include <iostream>
+# include <stdexcept>
+# include <string>
+# include <vector>
+
+#if defined __cplusplus
+# define YY_CPLUSPLUS __cplusplus
+#else
+# define YY_CPLUSPLUS 199711L
+#endif
+
+// Support move semantics when possible.
+#if 201103L <= YY_CPLUSPLUS
+# define YY_MOVE           std::move
+# define YY_MOVE_OR_COPY   move
+# define YY_MOVE_REF(Type) Type&&
+# define YY_RVREF(Type)    Type&&
+# define YY_COPY(Type)     Type
+#else
+# define YY_MOVE
+# define YY_MOVE_OR_COPY   copy
+# define YY_MOVE_REF(Type) Type&
+# define YY_RVREF(Type)    const Type&
+# define YY_COPY(Type)     const Type&
+#endif
+
+// Support noexcept when possible.
+#if 201103L <= YY_CPLUSPLUS
+# define YY_NOEXCEPT noexcept
+# define YY_NOTHROW
+#else
+# define YY_NOEXCEPT
+# define YY_NOTHROW throw ()
+#endif
+
+// Support constexpr when possible.
+#if 201703 <= YY_CPLUSPLUS
+# define YY_CONSTEXPR constexpr
+#else
+# define YY_CONSTEXPR
+#endif
+
+
+
+#ifndef YY_ATTRIBUTE_PURE
+# if defined __GNUC__ && 2 < __GNUC__ + (96 <= __GNUC_MINOR__)
+#  define YY_ATTRIBUTE_PURE __attribute__ ((__pure__))
+# else
+#  define YY_ATTRIBUTE_PURE
+# endif
+#endif
+
+#ifndef YY_ATTRIBUTE_UNUSED
+# if defined __GNUC__ && 2 < __GNUC__ + (7 <= __GNUC_MINOR__)
+#  define YY_ATTRIBUTE_UNUSED __attribute__ ((__unused__))
+# else
+#  define YY_ATTRIBUTE_UNUSED
+# endif
+#endif
+
+/* Suppress unused-variable warnings by "using" E.  */
+#if ! defined lint || defined __GNUC__
+# define YY_USE(E) ((void) (E))
+#else
+# define YY_USE(E) /* empty */
+#endif
+
+/* Suppress an incorrect diagnostic about yylval being uninitialized.  */
+#if defined __GNUC__ && ! defined __ICC && 406 <= __GNUC__ * 100 + __GNUC_MINOR__
+# if __GNUC__ * 100 + __GNUC_MINOR__ < 407
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")
+# else
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")              \
+    _Pragma ("GCC diagnostic ignored \"-Wmaybe-uninitialized\"")
+# endif
+# define YY_IGNORE_MAYBE_UNINITIALIZED_END      \
+    _Pragma ("GCC diagnostic pop")
+#else
+# define YY_INITIAL_VALUE(Value) Value
+#endif
+#ifndef YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+# define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+# define YY_IGNORE_MAYBE_UNINITIALIZED_END
+#endif
+#ifndef YY_INITIAL_VALUE
+# define YY_INITIAL_VALUE(Value) /* Nothing. */
+#endif
+
+#if defined __cplusplus && defined __GNUC__ && ! defined __ICC && 6 <= __GNUC__
+# define YY_IGNORE_USELESS_CAST_BEGIN                          \
+    _Pragma ("GCC diagnostic push")                            \
+    _Pragma ("GCC diagnostic ignored \"-Wuseless-cast\"")
+# define YY_IGNORE_USELESS_CAST_END            \
+    _Pragma ("GCC diagnostic pop")
+#endif
+#ifndef YY_IGNORE_USELESS_CAST_BEGIN
+# define YY_IGNORE_USELESS_CAST_BEGIN
+# define YY_IGNORE_USELESS_CAST_END
+#endif
+
+# ifndef YY_CAST
+#  ifdef __cplusplus
+#   define YY_CAST(Type, Val) static_cast<Type> (Val)
+#   define YY_REINTERPRET_CAST(Type, Val) reinterpret_cast<Type> (Val)
+#  else
+#   define YY_CAST(Type, Val) ((Type) (Val))
+#   define YY_REINTERPRET_CAST(Type, Val) ((Type) (Val))
+#  endif
+# endif
+# ifndef YY_NULLPTR
+#  if defined __cplusplus
+#   if 201103L <= __cplusplus
+#    define YY_NULLPTR nullptr
+#   else
+#    define YY_NULLPTR 0
+#   endif
+#  else
+#   define YY_NULLPTR ((void*)0)
+#  endif
+# endif
+
+/* Debug traces.  */
+#ifndef YYDEBUG
+# define YYDEBUG 0
+#endif
+
+#line 3 "bin/parser/saneql.expanded.ypp"
+namespace saneql { namespace saneqlparser {
+#line 192 "bin/parser/saneql_parser.cpp"
+
+
+  /// A point in a source file.
+  class position
+  {
+  public:
+    /// Type for file name.
+    typedef const std::string filename_type;
+    /// Type for line and column numbers.
+    typedef int counter_type;
+
+    /// Construct a position.
+    explicit position (filename_type* f = YY_NULLPTR,
+                       counter_type l = 1,
+                       counter_type c = 1)
+      : filename (f)
+      , line (l)
+      , column (c)
+    {}
+
+
+    /// Initialization.
+    void initialize (filename_type* fn = YY_NULLPTR,
+                     counter_type l = 1,
+                     counter_type c = 1)
+    {
+      filename = fn;
+      line = l;
+      column = c;
+    }
+
+    /** \name Line and Column related manipulators
+     ** \{ */
+    /// (line related) Advance to the COUNT next lines.
+    void lines (counter_type count = 1)
+    {
+      if (count)
+        {
+          column = 1;
+          line = add_ (line, count, 1);
+        }
+    }
+
+    /// (column related) Advance to the COUNT next columns.
+    void columns (counter_type count = 1)
+    {
+      column = add_ (column, count, 1);
+    }
+    /** \} */
+
+    /// File name to which this position refers.
+    filename_type* filename;
+    /// Current line number.
+    counter_type line;
+    /// Current column number.
+    counter_type column;
+
+  public:
+    /// Compute max (min, lhs+rhs).
+    static counter_type add_ (counter_type lhs, counter_type rhs, counter_type min)
+    {
+      return lhs + rhs < min ? min : lhs + rhs;
+    }
+  };
+
+  /// Add \a width columns, in place.
+  inline position&
+  operator+= (position& res, position::counter_type width)
+  {
+    res.columns (width);
+    return res;
+  }
+
+  /// Add \a width columns.
+  inline position
+  operator+ (position res, position::counter_type width)
+  {
+    return res += width;
+  }
+
+  /// Subtract \a width columns, in place.
+  inline position&
+  operator-= (position& res, position::counter_type width)
+  {
+    return res += -width;
+  }
+
+  /// Subtract \a width columns.
+  inline position
+  operator- (position res, position::counter_type width)
+  {
+    return res -= width;
+  }
+
+  /** \brief Intercept output stream redirection.
+   ** \param ostr the destination output stream
+   ** \param pos a reference to the position to redirect
+   */
+  template <typename YYChar>
+  std::basic_ostream<YYChar>&
+  operator<< (std::basic_ostream<YYChar>& ostr, const position& pos)
+  {
+    if (pos.filename)
+      ostr << *pos.filename << ':';
+    return ostr << pos.line << '.' << pos.column;
+  }
+
+  /// Two points in a source file.
+  class location
+  {
+  public:
+    /// Type for file name.
+    typedef position::filename_type filename_type;
+    /// Type for line and column numbers.
+    typedef position::counter_type counter_type;
+
+    /// Construct a location from \a b to \a e.
+    location (const position& b, const position& e)
+      : begin (b)
+      , end (e)
+    {}
+
+    /// Construct a 0-width location in \a p.
+    explicit location (const position& p = position ())
+      : begin (p)
+      , end (p)
+    {}
+
+    /// Construct a 0-width location in \a f, \a l, \a c.
+    explicit location (filename_type* f,
+                       counter_type l = 1,
+                       counter_type c = 1)
+      : begin (f, l, c)
+      , end (f, l, c)
+    {}
+
+
+    /// Initialization.
+    void initialize (filename_type* f = YY_NULLPTR,
+                     counter_type l = 1,
+                     counter_type c = 1)
+    {
+      begin.initialize (f, l, c);
+      end = begin;
+    }
+
+    /** \name Line and Column related manipulators
+     ** \{ */
+  public:
+    /// Reset initial location to final location.
+    void step ()
+    {
+      begin = end;
+    }
+
+    /// Extend the current location to the COUNT next columns.
+    void columns (counter_type count = 1)
+    {
+      end += count;
+    }
+
+    /// Extend the current location to the COUNT next lines.
+    void lines (counter_type count = 1)
+    {
+      end.lines (count);
+    }
+    /** \} */
+
+
+  public:
+    /// Beginning of the located region.
+    position begin;
+    /// End of the located region.
+    position end;
+  };
+
+  /// Join two locations, in place.
+  inline location&
+  operator+= (location& res, const location& end)
+  {
+    res.end = end.end;
+    return res;
+  }
+
+  /// Join two locations.
+  inline location
+  operator+ (location res, const location& end)
+  {
+    return res += end;
+  }
+
+  /// Add \a width columns to the end position, in place.
+  inline location&
+  operator+= (location& res, location::counter_type width)
+  {
+    res.columns (width);
+    return res;
+  }
+
+  /// Add \a width columns to the end position.
+  inline location
+  operator+ (location res, location::counter_type width)
+  {
+    return res += width;
+  }
+
+  /// Subtract \a width columns to the end position, in place.
+  inline location&
+  operator-= (location& res, location::counter_type width)
+  {
+    return res += -width;
+  }
+
+  /// Subtract \a width columns to the end position.
+  inline location
+  operator- (location res, location::counter_type width)
+  {
+    return res -= width;
+  }
+
+  /** \brief Intercept output stream redirection.
+   ** \param ostr the destination output stream
+   ** \param loc a reference to the location to redirect
+   **
+   ** Avoid duplicate information.
+   */
+  template <typename YYChar>
+  std::basic_ostream<YYChar>&
+  operator<< (std::basic_ostream<YYChar>& ostr, const location& loc)
+  {
+    location::counter_type end_col
+      = 0 < loc.end.column ? loc.end.column - 1 : 0;
+    ostr << loc.begin;
+    if (loc.end.filename
+        && (!loc.begin.filename
+            || *loc.begin.filename != *loc.end.filename))
+      ostr << '-' << loc.end.filename << ':' << loc.end.line << '.' << end_col;
+    else if (loc.begin.line < loc.end.line)
+      ostr << '-' << loc.end.line << '.' << end_col;
+    else if (loc.begin.column < end_col)
+      ostr << '-' << end_col;
+    return ostr;
+  }
+
+
+  /// A Bison parser.
+  class parser
+  {
+  public:
+#ifdef YYSTYPE
+# ifdef __GNUC__
+#  pragma GCC message "bison: do not #define YYSTYPE in C++, use %define api.value.type"
+# endif
+    typedef YYSTYPE value_type;
+#else
+    /// Symbol semantic values.
+    typedef saneql::ast::AST* value_type;
+#endif
+    /// Backward compatibility (Bison 3.8).
+    typedef value_type semantic_type;
+
+    /// Symbol locations.
+    typedef location location_type;
+
+    /// Syntax errors thrown from user actions.
+    struct syntax_error : std::runtime_error
+    {
+      syntax_error (const location_type& l, const std::string& m)
+        : std::runtime_error (m)
+        , location (l)
+      {}
+
+      syntax_error (const syntax_error& s)
+        : std::runtime_error (s.what ())
+        , location (s.location)
+      {}
+
+      ~syntax_error () YY_NOEXCEPT YY_NOTHROW;
+
+      location_type location;
+    };
+
+    /// Token kinds.
+    struct token
+    {
+      enum token_kind_type
+      {
+        YYEMPTY = -2,
+    EndOfFile = 0,                 // "end-of-file"
+    YYerror = 256,                 // error
+    YYUNDEF = 257,                 // "invalid token"
+    Error = 258,                   // Error
+    IDENT = 259,                   // "identifier"
+    FCONST = 260,                  // "floatliteral"
+    SCONST = 261,                  // "stringliteral"
+    BCONST = 262,                  // "bitstringliteral"
+    XCONST = 263,                  // "hexstringliteral"
+    Op = 264,                      // "<operator>"
+    ICONST = 265,                  // "intliteral"
+    PARAM = 266,                   // "'$?'"
+    TYPECAST = 267,                // "'::'"
+    DOT_DOT = 268,                 // "'..'"
+    COLON_EQUALS = 269,            // "':='"
+    EQUALS_GREATER = 270,          // "'=>'"
+    LESS_EQUALS = 271,             // "'<='"
+    GREATER_EQUALS = 272,          // "'>='"
+    NOT_EQUALS = 273,              // "'<>'"
+    MODE_EXPRESSION = 274,         // MODE_EXPRESSION
+    MODE_TYPE = 275,               // MODE_TYPE
+    AND = 276,                     // "'&&'"
+    OR = 277,                      // "'||'"
+    NOT = 278,                     // "'!'"
+    LET = 279,                     // "let"
+    DEFUN = 280,                   // "defun"
+    NULL_P = 281,                  // "null"
+    TRUE_P = 282,                  // "true"
+    FALSE_P = 283,                 // "false"
+    TABLE = 284,                   // "table"
+    IS = 285,                      // IS
+    ESCAPE = 286,                  // ESCAPE
+    POSTFIXOP = 287,               // POSTFIXOP
+    OPERATOR = 288,                // OPERATOR
+    UMINUS = 289                   // UMINUS
+      };
+      /// Backward compatibility alias (Bison 3.6).
+      typedef token_kind_type yytokentype;
+    };
+
+    /// Token kind, as returned by yylex.
+    typedef token::token_kind_type token_kind_type;
+
+    /// Backward compatibility alias (Bison 3.6).
+    typedef token_kind_type token_type;
+
+    /// Symbol kinds.
+    struct symbol_kind
+    {
+      enum symbol_kind_type
+      {
+        YYNTOKENS = 52, ///< Number of tokens.
+        S_YYEMPTY = -2,
+        S_YYEOF = 0,                             // "end-of-file"
+        S_YYerror = 1,                           // error
+        S_YYUNDEF = 2,                           // "invalid token"
+        S_Error = 3,                             // Error
+        S_IDENT = 4,                             // "identifier"
+        S_FCONST = 5,                            // "floatliteral"
+        S_SCONST = 6,                            // "stringliteral"
+        S_BCONST = 7,                            // "bitstringliteral"
+        S_XCONST = 8,                            // "hexstringliteral"
+        S_Op = 9,                                // "<operator>"
+        S_ICONST = 10,                           // "intliteral"
+        S_PARAM = 11,                            // "'$?'"
+        S_TYPECAST = 12,                         // "'::'"
+        S_DOT_DOT = 13,                          // "'..'"
+        S_COLON_EQUALS = 14,                     // "':='"
+        S_EQUALS_GREATER = 15,                   // "'=>'"
+        S_LESS_EQUALS = 16,                      // "'<='"
+        S_GREATER_EQUALS = 17,                   // "'>='"
+        S_NOT_EQUALS = 18,                       // "'<>'"
+        S_MODE_EXPRESSION = 19,                  // MODE_EXPRESSION
+        S_MODE_TYPE = 20,                        // MODE_TYPE
+        S_AND = 21,                              // "'&&'"
+        S_OR = 22,                               // "'||'"
+        S_NOT = 23,                              // "'!'"
+        S_LET = 24,                              // "let"
+        S_DEFUN = 25,                            // "defun"
+        S_NULL_P = 26,                           // "null"
+        S_TRUE_P = 27,                           // "true"
+        S_FALSE_P = 28,                          // "false"
+        S_TABLE = 29,                            // "table"
+        S_IS = 30,                               // IS
+        S_31_ = 31,                              // '<'
+        S_32_ = 32,                              // '>'
+        S_33_ = 33,                              // '='
+        S_ESCAPE = 34,                           // ESCAPE
+        S_POSTFIXOP = 35,                        // POSTFIXOP
+        S_OPERATOR = 36,                         // OPERATOR
+        S_37_ = 37,                              // '+'
+        S_38_ = 38,                              // '-'
+        S_39_ = 39,                              // '*'
+        S_40_ = 40,                              // '/'
+        S_41_ = 41,                              // '%'
+        S_42_ = 42,                              // '^'
+        S_UMINUS = 43,                           // UMINUS
+        S_44_ = 44,                              // '['
+        S_45_ = 45,                              // ']'
+        S_46_ = 46,                              // '('
+        S_47_ = 47,                              // ')'
+        S_48_ = 48,                              // '.'
+        S_49_ = 49,                              // ','
+        S_50_ = 50,                              // '{'
+        S_51_ = 51,                              // '}'
+        S_YYACCEPT = 52,                         // $accept
+        S_Query = 53,                            // Query
+        S_DefineFunction = 54,                   // DefineFunction
+        S_QueryBody = 55,                        // QueryBody
+        S_LetList = 56,                          // LetList
+        S_LetEntry = 57,                         // LetEntry
+        S_LetArgs = 58,                          // LetArgs
+        S_LetArgsList = 59,                      // LetArgsList
+        S_LetArg = 60,                           // LetArg
+        S_Identifier = 61,                       // Identifier
+        S_Softkeywords = 62,                     // Softkeywords
+        S_Type = 63,                             // Type
+        S_TypeList = 64,                         // TypeList
+        S_TypeArgList = 65,                      // TypeArgList
+        S_TypeArg = 66,                          // TypeArg
+        S_Iconst = 67,                           // Iconst
+        S_Expression = 68,                       // Expression
+        S_a_expr = 69,                           // a_expr
+        S_AexprConst = 70,                       // AexprConst
+        S_Sconst = 71,                           // Sconst
+        S_FuncArgs = 72,                         // FuncArgs
+        S_FuncArg = 73,                          // FuncArg
+        S_FuncArgList = 74,                      // FuncArgList
+        S_FuncArgListNe = 75,                    // FuncArgListNe
+        S_FuncArgNamed = 76                      // FuncArgNamed
+      };
+    };
+
+    /// (Internal) symbol kind.
+    typedef symbol_kind::symbol_kind_type symbol_kind_type;
+
+    /// The number of tokens.
+    static const symbol_kind_type YYNTOKENS = symbol_kind::YYNTOKENS;
+
+    /// A complete symbol.
+    ///
+    /// Expects its Base type to provide access to the symbol kind
+    /// via kind ().
+    ///
+    /// Provide access to semantic value and location.
+    template <typename Base>
+    struct basic_symbol : Base
+    {
+      /// Alias to Base.
+      typedef Base super_type;
+
+      /// Default constructor.
+      basic_symbol () YY_NOEXCEPT
+        : value ()
+        , location ()
+      {}
+
+#if 201103L <= YY_CPLUSPLUS
+      /// Move constructor.
+      basic_symbol (basic_symbol&& that)
+        : Base (std::move (that))
+        , value (std::move (that.value))
+        , location (std::move (that.location))
+      {}
+#endif
+
+      /// Copy constructor.
+      basic_symbol (const basic_symbol& that);
+      /// Constructor for valueless symbols.
+      basic_symbol (typename Base::kind_type t,
+                    YY_MOVE_REF (location_type) l);
+
+      /// Constructor for symbols with semantic value.
+      basic_symbol (typename Base::kind_type t,
+                    YY_RVREF (value_type) v,
+                    YY_RVREF (location_type) l);
+
+      /// Destroy the symbol.
+      ~basic_symbol ()
+      {
+        clear ();
+      }
+
+
+
+      /// Destroy contents, and record that is empty.
+      void clear () YY_NOEXCEPT
+      {
+        Base::clear ();
+      }
+
+      /// The user-facing name of this symbol.
+      std::string name () const YY_NOEXCEPT
+      {
+        return parser::symbol_name (this->kind ());
+      }
+
+      /// Backward compatibility (Bison 3.6).
+      symbol_kind_type type_get () const YY_NOEXCEPT;
+
+      /// Whether empty.
+      bool empty () const YY_NOEXCEPT;
+
+      /// Destructive move, \a s is emptied into this.
+      void move (basic_symbol& s);
+
+      /// The semantic value.
+      value_type value;
+
+      /// The location.
+      location_type location;
+
+    public:
+#if YY_CPLUSPLUS < 201103L
+      /// Assignment operator.
+      basic_symbol& operator= (const basic_symbol& that);
+#endif
+    };
+
+    /// Type access provider for token (enum) based symbols.
+    struct by_kind
+    {
+      /// The symbol kind as needed by the constructor.
+      typedef token_kind_type kind_type;
+
+      /// Default constructor.
+      by_kind () YY_NOEXCEPT;
+
+#if 201103L <= YY_CPLUSPLUS
+      /// Move constructor.
+      by_kind (by_kind&& that) YY_NOEXCEPT;
+#endif
+
+      /// Copy constructor.
+      by_kind (const by_kind& that) YY_NOEXCEPT;
+
+      /// Constructor from (external) token numbers.
+      by_kind (kind_type t) YY_NOEXCEPT;
+
+
+
+      /// Record that this symbol is empty.
+      void clear () YY_NOEXCEPT;
+
+      /// Steal the symbol kind from \a that.
+      void move (by_kind& that);
+
+      /// The (internal) type number (corresponding to \a type).
+      /// \a empty when empty.
+      symbol_kind_type kind () const YY_NOEXCEPT;
+
+      /// Backward compatibility (Bison 3.6).
+      symbol_kind_type type_get () const YY_NOEXCEPT;
+
+      /// The symbol kind.
+      /// \a S_YYEMPTY when empty.
+      symbol_kind_type kind_;
+    };
+
+    /// Backward compatibility for a private implementation detail (Bison 3.6).
+    typedef by_kind by_type;
+
+    /// "External" symbols: returned by the scanner.
+    struct symbol_type : basic_symbol<by_kind>
+    {};
+
+    /// Build a parser object.
+    parser (saneql::ASTContainer& container_yyarg, saneql::SaneQLLexer& lexer_yyarg);
+    virtual ~parser ();
+
+#if 201103L <= YY_CPLUSPLUS
+    /// Non copyable.
+    parser (const parser&) = delete;
+    /// Non copyable.
+    parser& operator= (const parser&) = delete;
+#endif
+
+    /// Parse.  An alias for parse ().
+    /// \returns  0 iff parsing succeeded.
+    int operator() ();
+
+    /// Parse.
+    /// \returns  0 iff parsing succeeded.
+    virtual int parse ();
+
+#if YYDEBUG
+    /// The current debugging stream.
+    std::ostream& debug_stream () const YY_ATTRIBUTE_PURE;
+    /// Set the current debugging stream.
+    void set_debug_stream (std::ostream &);
+
+    /// Type for debugging levels.
+    typedef int debug_level_type;
+    /// The current debugging level.
+    debug_level_type debug_level () const YY_ATTRIBUTE_PURE;
+    /// Set the current debugging level.
+    void set_debug_level (debug_level_type l);
+#endif
+
+    /// Report a syntax error.
+    /// \param loc    where the syntax error is found.
+    /// \param msg    a description of the syntax error.
+    virtual void error (const location_type& loc, const std::string& msg);
+
+    /// Report a syntax error.
+    void error (const syntax_error& err);
+
+    /// The user-facing name of the symbol whose (internal) number is
+    /// YYSYMBOL.  No bounds checking.
+    static std::string symbol_name (symbol_kind_type yysymbol);
+
+
+
+    class context
+    {
+    public:
+      context (const parser& yyparser, const symbol_type& yyla);
+      const symbol_type& lookahead () const YY_NOEXCEPT { return yyla_; }
+      symbol_kind_type token () const YY_NOEXCEPT { return yyla_.kind (); }
+      const location_type& location () const YY_NOEXCEPT { return yyla_.location; }
+
+      /// Put in YYARG at most YYARGN of the expected tokens, and return the
+      /// number of tokens stored in YYARG.  If YYARG is null, return the
+      /// number of expected tokens (guaranteed to be less than YYNTOKENS).
+      int expected_tokens (symbol_kind_type yyarg[], int yyargn) const;
+
+    public:
+      const parser& yyparser_;
+      const symbol_type& yyla_;
+    };
+
+  public:
+#if YY_CPLUSPLUS < 201103L
+    /// Non copyable.
+    parser (const parser&);
+    /// Non copyable.
+    parser& operator= (const parser&);
+#endif
+
+
+    /// Stored state numbers (used for stacks).
+    typedef unsigned char state_type;
+
+    /// The arguments of the error message.
+    int yy_syntax_error_arguments_ (const context& yyctx,
+                                    symbol_kind_type yyarg[], int yyargn) const;
+
+    /// Generate an error message.
+    /// \param yyctx     the context in which the error occurred.
+    virtual std::string yysyntax_error_ (const context& yyctx) const;
+    /// Compute post-reduction state.
+    /// \param yystate   the current state
+    /// \param yysym     the nonterminal to push on the stack
+    static state_type yy_lr_goto_state_ (state_type yystate, int yysym);
+
+    /// Whether the given \c yypact_ value indicates a defaulted state.
+    /// \param yyvalue   the value to check
+    static bool yy_pact_value_is_default_ (int yyvalue) YY_NOEXCEPT;
+
+    /// Whether the given \c yytable_ value indicates a syntax error.
+    /// \param yyvalue   the value to check
+    static bool yy_table_value_is_error_ (int yyvalue) YY_NOEXCEPT;
+
+    static const signed char yypact_ninf_;
+    static const signed char yytable_ninf_;
+
+    /// Convert a scanner token kind \a t to a symbol kind.
+    /// In theory \a t should be a token_kind_type, but character literals
+    /// are valid, yet not members of the token_kind_type enum.
+    static symbol_kind_type yytranslate_ (int t) YY_NOEXCEPT;
+
+    /// Convert the symbol name \a n to a form suitable for a diagnostic.
+    static std::string yytnamerr_ (const char *yystr);
+
+    /// For a symbol, its name in clear.
+    static const char* const yytname_[];
+
+
+    // Tables.
+    // YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
+    // STATE-NUM.
+    static const short yypact_[];
+
+    // YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
+    // Performed when YYTABLE does not specify something else to do.  Zero
+    // means the default is an error.
+    static const signed char yydefact_[];
+
+    // YYPGOTO[NTERM-NUM].
+    static const short yypgoto_[];
+
+    // YYDEFGOTO[NTERM-NUM].
+    static const signed char yydefgoto_[];
+
+    // YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
+    // positive, shift that token.  If negative, reduce the rule whose
+    // number is the opposite.  If YYTABLE_NINF, syntax error.
+    static const short yytable_[];
+
+    static const short yycheck_[];
+
+    // YYSTOS[STATE-NUM] -- The symbol kind of the accessing symbol of
+    // state STATE-NUM.
+    static const signed char yystos_[];
+
+    // YYR1[RULE-NUM] -- Symbol kind of the left-hand side of rule RULE-NUM.
+    static const signed char yyr1_[];
+
+    // YYR2[RULE-NUM] -- Number of symbols on the right-hand side of rule RULE-NUM.
+    static const signed char yyr2_[];
+
+
+#if YYDEBUG
+    // YYRLINE[YYN] -- Source line where rule number YYN was defined.
+    static const unsigned char yyrline_[];
+    /// Report on the debug stream that the rule \a r is going to be reduced.
+    virtual void yy_reduce_print_ (int r) const;
+    /// Print the state stack on the debug stream.
+    virtual void yy_stack_print_ () const;
+
+    /// Debugging level.
+    int yydebug_;
+    /// Debug stream.
+    std::ostream* yycdebug_;
+
+    /// \brief Display a symbol kind, value and location.
+    /// \param yyo    The output stream.
+    /// \param yysym  The symbol.
+    template <typename Base>
+    void yy_print_ (std::ostream& yyo, const basic_symbol<Base>& yysym) const;
+#endif
+
+    /// \brief Reclaim the memory associated to a symbol.
+    /// \param yymsg     Why this token is reclaimed.
+    ///                  If null, print nothing.
+    /// \param yysym     The symbol.
+    template <typename Base>
+    void yy_destroy_ (const char* yymsg, basic_symbol<Base>& yysym) const;
+
+  public:
+    /// Type access provider for state based symbols.
+    struct by_state
+    {
+      /// Default constructor.
+      by_state () YY_NOEXCEPT;
+
+      /// The symbol kind as needed by the constructor.
+      typedef state_type kind_type;
+
+      /// Constructor.
+      by_state (kind_type s) YY_NOEXCEPT;
+
+      /// Copy constructor.
+      by_state (const by_state& that) YY_NOEXCEPT;
+
+      /// Record that this symbol is empty.
+      void clear () YY_NOEXCEPT;
+
+      /// Steal the symbol kind from \a that.
+      void move (by_state& that);
+
+      /// The symbol kind (corresponding to \a state).
+      /// \a symbol_kind::S_YYEMPTY when empty.
+      symbol_kind_type kind () const YY_NOEXCEPT;
+
+      /// The state number used to denote an empty symbol.
+      /// We use the initial state, as it does not have a value.
+      enum { empty_state = 0 };
+
+      /// The state.
+      /// \a empty when empty.
+      state_type state;
+    };
+
+    /// "Internal" symbol: element of the stack.
+    struct stack_symbol_type : basic_symbol<by_state>
+    {
+      /// Superclass.
+      typedef basic_symbol<by_state> super_type;
+      /// Construct an empty symbol.
+      stack_symbol_type ();
+      /// Move or copy construction.
+      stack_symbol_type (YY_RVREF (stack_symbol_type) that);
+      /// Steal the contents from \a sym to build this.
+      stack_symbol_type (state_type s, YY_MOVE_REF (symbol_type) sym);
+#if YY_CPLUSPLUS < 201103L
+      /// Assignment, needed by push_back by some old implementations.
+      /// Moves the contents of that.
+      stack_symbol_type& operator= (stack_symbol_type& that);
+
+      /// Assignment, needed by push_back by other implementations.
+      /// Needed by some other old implementations.
+      stack_symbol_type& operator= (const stack_symbol_type& that);
+#endif
+    };
+
+    /// A stack with random access from its top.
+    template <typename T, typename S = std::vector<T> >
+    class stack
+    {
+    public:
+      // Hide our reversed order.
+      typedef typename S::iterator iterator;
+      typedef typename S::const_iterator const_iterator;
+      typedef typename S::size_type size_type;
+      typedef typename std::ptrdiff_t index_type;
+
+      stack (size_type n = 200) YY_NOEXCEPT
+        : seq_ (n)
+      {}
+
+#if 201103L <= YY_CPLUSPLUS
+      /// Non copyable.
+      stack (const stack&) = delete;
+      /// Non copyable.
+      stack& operator= (const stack&) = delete;
+#endif
+
+      /// Random access.
+      ///
+      /// Index 0 returns the topmost element.
+      const T&
+      operator[] (index_type i) const
+      {
+        return seq_[size_type (size () - 1 - i)];
+      }
+
+      /// Random access.
+      ///
+      /// Index 0 returns the topmost element.
+      T&
+      operator[] (index_type i)
+      {
+        return seq_[size_type (size () - 1 - i)];
+      }
+
+      /// Steal the contents of \a t.
+      ///
+      /// Close to move-semantics.
+      void
+      push (YY_MOVE_REF (T) t)
+      {
+        seq_.push_back (T ());
+        operator[] (0).move (t);
+      }
+
+      /// Pop elements from the stack.
+      void
+      pop (std::ptrdiff_t n = 1) YY_NOEXCEPT
+      {
+        for (; 0 < n; --n)
+          seq_.pop_back ();
+      }
+
+      /// Pop all elements from the stack.
+      void
+      clear () YY_NOEXCEPT
+      {
+        seq_.clear ();
+      }
+
+      /// Number of elements on the stack.
+      index_type
+      size () const YY_NOEXCEPT
+      {
+        return index_type (seq_.size ());
+      }
+
+      /// Iterator on top of the stack (going downwards).
+      const_iterator
+      begin () const YY_NOEXCEPT
+      {
+        return seq_.begin ();
+      }
+
+      /// Bottom of the stack.
+      const_iterator
+      end () const YY_NOEXCEPT
+      {
+        return seq_.end ();
+      }
+
+      /// Present a slice of the top of a stack.
+      class slice
+      {
+      public:
+        slice (const stack& stack, index_type range) YY_NOEXCEPT
+          : stack_ (stack)
+          , range_ (range)
+        {}
+
+        const T&
+        operator[] (index_type i) const
+        {
+          return stack_[range_ - i];
+        }
+
+      public:
+        const stack& stack_;
+        index_type range_;
+      };
+
+    public:
+#if YY_CPLUSPLUS < 201103L
+      /// Non copyable.
+      stack (const stack&);
+      /// Non copyable.
+      stack& operator= (const stack&);
+#endif
+      /// The wrapped container.
+      S seq_;
+    };
+
+
+    /// Stack type.
+    typedef stack<stack_symbol_type> stack_type;
+
+    /// The stack.
+    stack_type yystack_;
+
+    /// Push a new state on the stack.
+    /// \param m    a debug message to display
+    ///             if null, no trace is output.
+    /// \param sym  the symbol
+    /// \warning the contents of \a s.value is stolen.
+    void yypush_ (const char* m, YY_MOVE_REF (stack_symbol_type) sym);
+
+    /// Push a new look ahead token on the state on the stack.
+    /// \param m    a debug message to display
+    ///             if null, no trace is output.
+    /// \param s    the state
+    /// \param sym  the symbol (for its value and location).
+    /// \warning the contents of \a sym.value is stolen.
+    void yypush_ (const char* m, state_type s, YY_MOVE_REF (symbol_type) sym);
+
+    /// Pop \a n symbols from the stack.
+    void yypop_ (int n = 1) YY_NOEXCEPT;
+
+    /// Constants.
+    enum
+    {
+      yylast_ = 425,     ///< Last index in yytable_.
+      yynnts_ = 25,  ///< Number of nonterminal symbols.
+      yyfinal_ = 10 ///< Termination state number.
+    };
+
+
+    // User arguments.
+    saneql::ASTContainer& container;
+    saneql::SaneQLLexer& lexer;
+
+  };
+
+
+#line 3 "bin/parser/saneql.expanded.ypp"
+} } // saneql::saneqlparser
+#line 1137 "bin/parser/saneql_parser.cpp"
+
+
+
+
+
+
+// Unqualified %code blocks.
+#line 25 "bin/parser/saneql.expanded.ypp"
+
+static int yylex(saneql::saneqlparser::parser::semantic_type* yylval,saneql::saneqlparser::parser::location_type* yyloc,saneql::ASTContainer& container,saneql::SaneQLLexer& lexer);
+
+#line 1149 "bin/parser/saneql_parser.cpp"
+
+
+#ifndef YY_
+# if defined YYENABLE_NLS && YYENABLE_NLS
+#  if ENABLE_NLS
+#   include <libintl.h> // FIXME: INFRINGES ON USER NAME SPACE.
+#   define YY_(msgid) dgettext ("bison-runtime", msgid)
+#  endif
+# endif
+# ifndef YY_
+#  define YY_(msgid) msgid
+# endif
+#endif
+
+
+// Whether we are compiled with exception support.
+#ifndef YY_EXCEPTIONS
+# if defined __GNUC__ && !defined __EXCEPTIONS
+#  define YY_EXCEPTIONS 0
+# else
+#  define YY_EXCEPTIONS 1
+# endif
+#endif
+
+#define YYRHSLOC(Rhs, K) ((Rhs)[K].location)
+/* YYLLOC_DEFAULT -- Set CURRENT to span from RHS[1] to RHS[N].
+   If N is 0, then set CURRENT to the empty location which ends
+   the previous symbol: RHS[0] (always defined).  */
+
+# ifndef YYLLOC_DEFAULT
+#  define YYLLOC_DEFAULT(Current, Rhs, N)                               \
+    do                                                                  \
+      if (N)                                                            \
+        {                                                               \
+          (Current).begin  = YYRHSLOC (Rhs, 1).begin;                   \
+          (Current).end    = YYRHSLOC (Rhs, N).end;                     \
+        }                                                               \
+      else                                                              \
+        {                                                               \
+          (Current).begin = (Current).end = YYRHSLOC (Rhs, 0).end;      \
+        }                                                               \
+    while (false)
+# endif
+
+
+// Enable debugging if requested.
+#if YYDEBUG
+
+// A pseudo ostream that takes yydebug_ into account.
+# define YYCDEBUG if (yydebug_) (*yycdebug_)
+
+# define YY_SYMBOL_PRINT(Title, Symbol)         \
+  do {                                          \
+    if (yydebug_)                               \
+    {                                           \
+      *yycdebug_ << Title << ' ';               \
+      yy_print_ (*yycdebug_, Symbol);           \
+      *yycdebug_ << '\n';                       \
+    }                                           \
+  } while (false)
+
+# define YY_REDUCE_PRINT(Rule)          \
+  do {                                  \
+    if (yydebug_)                       \
+      yy_reduce_print_ (Rule);          \
+  } while (false)
+
+# define YY_STACK_PRINT()               \
+  do {                                  \
+    if (yydebug_)                       \
+      yy_stack_print_ ();                \
+  } while (false)
+
+#else // !YYDEBUG
+
+# define YYCDEBUG if (false) std::cerr
+# define YY_SYMBOL_PRINT(Title, Symbol)  YY_USE (Symbol)
+# define YY_REDUCE_PRINT(Rule)           static_cast<void> (0)
+# define YY_STACK_PRINT()                static_cast<void> (0)
+
+#endif // !YYDEBUG
+
+#define yyerrok         (yyerrstatus_ = 0)
+#define yyclearin       (yyla.clear ())
+
+#define YYACCEPT        goto yyacceptlab
+#define YYABORT         goto yyabortlab
+#define YYERROR         goto yyerrorlab
+#define YYRECOVERING()  (!!yyerrstatus_)
+
+#line 3 "bin/parser/saneql.expanded.ypp"
+namespace saneql { namespace saneqlparser {
+#line 1242 "bin/parser/saneql_parser.cpp"
+
+  /// Build a parser object.
+  parser::parser (saneql::ASTContainer& container_yyarg, saneql::SaneQLLexer& lexer_yyarg)
+#if YYDEBUG
+    : yydebug_ (false),
+      yycdebug_ (&std::cerr),
+#else
+    :
+#endif
+      container (container_yyarg),
+      lexer (lexer_yyarg)
+  {}
+
+  parser::~parser ()
+  {}
+
+  parser::syntax_error::~syntax_error () YY_NOEXCEPT YY_NOTHROW
+  {}
+
+  /*---------.
+  | symbol.  |
+  `---------*/
+
+  // basic_symbol.
+  template <typename Base>
+  parser::basic_symbol<Base>::basic_symbol (const basic_symbol& that)
+    : Base (that)
+    , value (that.value)
+    , location (that.location)
+  {}
+
+
+  /// Constructor for valueless symbols.
+  template <typename Base>
+  parser::basic_symbol<Base>::basic_symbol (typename Base::kind_type t, YY_MOVE_REF (location_type) l)
+    : Base (t)
+    , value ()
+    , location (l)
+  {}
+
+  template <typename Base>
+  parser::basic_symbol<Base>::basic_symbol (typename Base::kind_type t, YY_RVREF (value_type) v, YY_RVREF (location_type) l)
+    : Base (t)
+    , value (YY_MOVE (v))
+    , location (YY_MOVE (l))
+  {}
+
+
+  template <typename Base>
+  parser::symbol_kind_type
+  parser::basic_symbol<Base>::type_get () const YY_NOEXCEPT
+  {
+    return this->kind ();
+  }
+
+
+  template <typename Base>
+  bool
+  parser::basic_symbol<Base>::empty () const YY_NOEXCEPT
+  {
+    return this->kind () == symbol_kind::S_YYEMPTY;
+  }
+
+  template <typename Base>
+  void
+  parser::basic_symbol<Base>::move (basic_symbol& s)
+  {
+    super_type::move (s);
+    value = YY_MOVE (s.value);
+    location = YY_MOVE (s.location);
+  }
+
+  // by_kind.
+  parser::by_kind::by_kind () YY_NOEXCEPT
+    : kind_ (symbol_kind::S_YYEMPTY)
+  {}
+
+#if 201103L <= YY_CPLUSPLUS
+  parser::by_kind::by_kind (by_kind&& that) YY_NOEXCEPT
+    : kind_ (that.kind_)
+  {
+    that.clear ();
+  }
+#endif
+
+  parser::by_kind::by_kind (const by_kind& that) YY_NOEXCEPT
+    : kind_ (that.kind_)
+  {}
+
+  parser::by_kind::by_kind (token_kind_type t) YY_NOEXCEPT
+    : kind_ (yytranslate_ (t))
+  {}
+
+
+
+  void
+  parser::by_kind::clear () YY_NOEXCEPT
+  {
+    kind_ = symbol_kind::S_YYEMPTY;
+  }
+
+  void
+  parser::by_kind::move (by_kind& that)
+  {
+    kind_ = that.kind_;
+    that.clear ();
+  }
+
+  parser::symbol_kind_type
+  parser::by_kind::kind () const YY_NOEXCEPT
+  {
+    return kind_;
+  }
+
+
+  parser::symbol_kind_type
+  parser::by_kind::type_get () const YY_NOEXCEPT
+  {
+    return this->kind ();
+  }
+
+
+
+  // by_state.
+  parser::by_state::by_state () YY_NOEXCEPT
+    : state (empty_state)
+  {}
+
+  parser::by_state::by_state (const by_state& that) YY_NOEXCEPT
+    : state (that.state)
+  {}
+
+  void
+  parser::by_state::clear () YY_NOEXCEPT
+  {
+    state = empty_state;
+  }
+
+  void
+  parser::by_state::move (by_state& that)
+  {
+    state = that.state;
+    that.clear ();
+  }
+
+  parser::by_state::by_state (state_type s) YY_NOEXCEPT
+    : state (s)
+  {}
+
+  parser::symbol_kind_type
+  parser::by_state::kind () const YY_NOEXCEPT
+  {
+    if (state == empty_state)
+      return symbol_kind::S_YYEMPTY;
+    else
+      return YY_CAST (symbol_kind_type, yystos_[+state]);
+  }
+
+  parser::stack_symbol_type::stack_symbol_type ()
+  {}
+
+  parser::stack_symbol_type::stack_symbol_type (YY_RVREF (stack_symbol_type) that)
+    : super_type (YY_MOVE (that.state), YY_MOVE (that.value), YY_MOVE (that.location))
+  {
+#if 201103L <= YY_CPLUSPLUS
+    // that is emptied.
+    that.state = empty_state;
+#endif
+  }
+
+  parser::stack_symbol_type::stack_symbol_type (state_type s, YY_MOVE_REF (symbol_type) that)
+    : super_type (s, YY_MOVE (that.value), YY_MOVE (that.location))
+  {
+    // that is emptied.
+    that.kind_ = symbol_kind::S_YYEMPTY;
+  }
+
+#if YY_CPLUSPLUS < 201103L
+  parser::stack_symbol_type&
+  parser::stack_symbol_type::operator= (const stack_symbol_type& that)
+  {
+    state = that.state;
+    value = that.value;
+    location = that.location;
+    return *this;
+  }
+
+  parser::stack_symbol_type&
+  parser::stack_symbol_type::operator= (stack_symbol_type& that)
+  {
+    state = that.state;
+    value = that.value;
+    location = that.location;
+    // that is emptied.
+    that.state = empty_state;
+    return *this;
+  }
+#endif
+
+  template <typename Base>
+  void
+  parser::yy_destroy_ (const char* yymsg, basic_symbol<Base>& yysym) const
+  {
+    if (yymsg)
+      YY_SYMBOL_PRINT (yymsg, yysym);
+
+    // User destructor.
+    YY_USE (yysym.kind ());
+  }
+
+#if YYDEBUG
+  template <typename Base>
+  void
+  parser::yy_print_ (std::ostream& yyo, const basic_symbol<Base>& yysym) const
+  {
+    std::ostream& yyoutput = yyo;
+    YY_USE (yyoutput);
+    if (yysym.empty ())
+      yyo << "empty symbol";
+    else
+      {
+        symbol_kind_type yykind = yysym.kind ();
+        yyo << (yykind < YYNTOKENS ? "token" : "nterm")
+            << ' ' << yysym.name () << " ("
+            << yysym.location << ": ";
+        YY_USE (yykind);
+        yyo << ')';
+      }
+  }
+#endif
+
+  void
+  parser::yypush_ (const char* m, YY_MOVE_REF (stack_symbol_type) sym)
+  {
+    if (m)
+      YY_SYMBOL_PRINT (m, sym);
+    yystack_.push (YY_MOVE (sym));
+  }
+
+  void
+  parser::yypush_ (const char* m, state_type s, YY_MOVE_REF (symbol_type) sym)
+  {
+#if 201103L <= YY_CPLUSPLUS
+    yypush_ (m, stack_symbol_type (s, std::move (sym)));
+#else
+    stack_symbol_type ss (s, sym);
+    yypush_ (m, ss);
+#endif
+  }
+
+  void
+  parser::yypop_ (int n) YY_NOEXCEPT
+  {
+    yystack_.pop (n);
+  }
+
+#if YYDEBUG
+  std::ostream&
+  parser::debug_stream () const
+  {
+    return *yycdebug_;
+  }
+
+  void
+  parser::set_debug_stream (std::ostream& o)
+  {
+    yycdebug_ = &o;
+  }
+
+
+  parser::debug_level_type
+  parser::debug_level () const
+  {
+    return yydebug_;
+  }
+
+  void
+  parser::set_debug_level (debug_level_type l)
+  {
+    yydebug_ = l;
+  }
+#endif // YYDEBUG
+
+  parser::state_type
+  parser::yy_lr_goto_state_ (state_type yystate, int yysym)
+  {
+    int yyr = yypgoto_[yysym - YYNTOKENS] + yystate;
+    if (0 <= yyr && yyr <= yylast_ && yycheck_[yyr] == yystate)
+      return yytable_[yyr];
+    else
+      return yydefgoto_[yysym - YYNTOKENS];
+  }
+
+  bool
+  parser::yy_pact_value_is_default_ (int yyvalue) YY_NOEXCEPT
+  {
+    return yyvalue == yypact_ninf_;
+  }
+
+  bool
+  parser::yy_table_value_is_error_ (int yyvalue) YY_NOEXCEPT
+  {
+    return yyvalue == yytable_ninf_;
+  }
+
+  int
+  parser::operator() ()
+  {
+    return parse ();
+  }
+
+  int
+  parser::parse ()
+  {
+    int yyn;
+    /// Length of the RHS of the rule being reduced.
+    int yylen = 0;
+
+    // Error handling.
+    int yynerrs_ = 0;
+    int yyerrstatus_ = 0;
+
+    /// The lookahead symbol.
+    symbol_type yyla;
+
+    /// The locations where the error started and ended.
+    stack_symbol_type yyerror_range[3];
+
+    /// The return value of parse ().
+    int yyresult;
+
+#if YY_EXCEPTIONS
+    try
+#endif // YY_EXCEPTIONS
+      {
+    YYCDEBUG << "Starting parse\n";
+
+
+    /* Initialize the stack.  The initial state will be set in
+       yynewstate, since the latter expects the semantical and the
+       location values to have been already stored, initialize these
+       stacks with a primary value.  */
+    yystack_.clear ();
+    yypush_ (YY_NULLPTR, 0, YY_MOVE (yyla));
+
+  /*-----------------------------------------------.
+  | yynewstate -- push a new symbol on the stack.  |
+  `-----------------------------------------------*/
+  yynewstate:
+    YYCDEBUG << "Entering state " << int (yystack_[0].state) << '\n';
+    YY_STACK_PRINT ();
+
+    // Accept?
+    if (yystack_[0].state == yyfinal_)
+      YYACCEPT;
+
+    goto yybackup;
+
+
+  /*-----------.
+  | yybackup.  |
+  `-----------*/
+  yybackup:
+    // Try to take a decision without lookahead.
+    yyn = yypact_[+yystack_[0].state];
+    if (yy_pact_value_is_default_ (yyn))
+      goto yydefault;
+
+    // Read a lookahead token.
+    if (yyla.empty ())
+      {
+        YYCDEBUG << "Reading a token\n";
+#if YY_EXCEPTIONS
+        try
+#endif // YY_EXCEPTIONS
+          {
+            yyla.kind_ = yytranslate_ (yylex (&yyla.value, &yyla.location, container, lexer));
+          }
+#if YY_EXCEPTIONS
+        catch (const syntax_error& yyexc)
+          {
+            YYCDEBUG << "Caught exception: " << yyexc.what() << '\n';
+            error (yyexc);
+            goto yyerrlab1;
+          }
+#endif // YY_EXCEPTIONS
+      }
+    YY_SYMBOL_PRINT ("Next token is", yyla);
+
+    if (yyla.kind () == symbol_kind::S_YYerror)
+    {
+      // The scanner already issued an error message, process directly
+      // to error recovery.  But do not keep the error token as
+      // lookahead, it is too special and may lead us to an endless
+      // loop in error recovery. */
+      yyla.kind_ = symbol_kind::S_YYUNDEF;
+      goto yyerrlab1;
+    }
+
+    /* If the proper action on seeing token YYLA.TYPE is to reduce or
+       to detect an error, take that action.  */
+    yyn += yyla.kind ();
+    if (yyn < 0 || yylast_ < yyn || yycheck_[yyn] != yyla.kind ())
+      {
+        goto yydefault;
+      }
+
+    // Reduce or error.
+    yyn = yytable_[yyn];
+    if (yyn <= 0)
+      {
+        if (yy_table_value_is_error_ (yyn))
+          goto yyerrlab;
+        yyn = -yyn;
+        goto yyreduce;
+      }
+
+    // Count tokens shifted since error; after three, turn off error status.
+    if (yyerrstatus_)
+      --yyerrstatus_;
+
+    // Shift the lookahead token.
+    yypush_ ("Shifting", state_type (yyn), YY_MOVE (yyla));
+    goto yynewstate;
+
+
+  /*-----------------------------------------------------------.
+  | yydefault -- do the default action for the current state.  |
+  `-----------------------------------------------------------*/
+  yydefault:
+    yyn = yydefact_[+yystack_[0].state];
+    if (yyn == 0)
+      goto yyerrlab;
+    goto yyreduce;
+
+
+  /*-----------------------------.
+  | yyreduce -- do a reduction.  |
+  `-----------------------------*/
+  yyreduce:
+    yylen = yyr2_[yyn];
+    {
+      stack_symbol_type yylhs;
+      yylhs.state = yy_lr_goto_state_ (yystack_[yylen].state, yyr1_[yyn]);
+      /* If YYLEN is nonzero, implement the default value of the
+         action: '$$ = $1'.  Otherwise, use the top of the stack.
+
+         Otherwise, the following line sets YYLHS.VALUE to garbage.
+         This behavior is undocumented and Bison users should not rely
+         upon it.  */
+      if (yylen)
+        yylhs.value = yystack_[yylen - 1].value;
+      else
+        yylhs.value = yystack_[0].value;
+
+      // Default location.
+      {
+        stack_type::slice range (yystack_, yylen);
+        YYLLOC_DEFAULT (yylhs.location, range, yylen);
+        yyerror_range[1].location = yylhs.location;
+      }
+
+      // Perform the reduction.
+      YY_REDUCE_PRINT (yyn);
+#if YY_EXCEPTIONS
+      try
+#endif // YY_EXCEPTIONS
+        {
+          switch (yyn)
+            {
+  case 2: // Query: DefineFunction
+#line 88 "bin/parser/saneql.expanded.ypp"
+                  { container.setResult(yystack_[0].value); }
+#line 1716 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 3: // Query: QueryBody
+#line 89 "bin/parser/saneql.expanded.ypp"
+             { container.setResult(yystack_[0].value); }
+#line 1722 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 4: // DefineFunction: "defun" Identifier '(' ')' QueryBody
+#line 93 "bin/parser/saneql.expanded.ypp"
+                                      { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::DefineFunction,0,3),yystack_[3].value,nullptr,yystack_[0].value)); }
+#line 1728 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 5: // DefineFunction: "defun" Identifier '(' LetArgsList ')' QueryBody
+#line 94 "bin/parser/saneql.expanded.ypp"
+                                                  { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::DefineFunction,0,3),yystack_[4].value,yystack_[2].value,yystack_[0].value)); }
+#line 1734 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 6: // QueryBody: LetList Expression
+#line 98 "bin/parser/saneql.expanded.ypp"
+                      { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::QueryBody,0,2),yystack_[1].value,yystack_[0].value)); }
+#line 1740 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 7: // LetList: LetList LetEntry
+#line 102 "bin/parser/saneql.expanded.ypp"
+                    { yylhs.value = static_cast<saneql::ast::List*>(container.appendList(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column), saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::List,0,2),yystack_[1].value,yystack_[0].value)); }
+#line 1746 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 8: // LetList: %empty
+#line 103 "bin/parser/saneql.expanded.ypp"
+          { yylhs.value = nullptr; }
+#line 1752 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 9: // LetEntry: "let" Identifier LetArgs "':='" Expression ','
+#line 107 "bin/parser/saneql.expanded.ypp"
+                                                      { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::LetEntry,0,3),yystack_[4].value,yystack_[3].value,yystack_[1].value)); }
+#line 1758 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 10: // LetArgs: '(' LetArgsList ')'
+#line 111 "bin/parser/saneql.expanded.ypp"
+                       { yylhs.value = yystack_[1].value; }
+#line 1764 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 11: // LetArgs: %empty
+#line 112 "bin/parser/saneql.expanded.ypp"
+          { yylhs.value = nullptr; }
+#line 1770 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 12: // LetArgsList: LetArgsList ',' LetArg
+#line 116 "bin/parser/saneql.expanded.ypp"
+                          { yylhs.value = static_cast<saneql::ast::List*>(container.appendList(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column), saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::List,0,2),yystack_[2].value,yystack_[0].value)); }
+#line 1776 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 13: // LetArgsList: LetArg
+#line 117 "bin/parser/saneql.expanded.ypp"
+          { yylhs.value = static_cast<saneql::ast::List*>(container.createList(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column), saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::List,0,2),yystack_[0].value)); }
+#line 1782 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 14: // LetArg: Identifier
+#line 121 "bin/parser/saneql.expanded.ypp"
+              { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::LetArg,0,3),yystack_[0].value,nullptr,nullptr)); }
+#line 1788 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 15: // LetArg: Identifier Type
+#line 122 "bin/parser/saneql.expanded.ypp"
+                   { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::LetArg,0,3),yystack_[1].value,yystack_[0].value,nullptr)); }
+#line 1794 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 16: // LetArg: Identifier "':='" Expression
+#line 123 "bin/parser/saneql.expanded.ypp"
+                                      { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::LetArg,0,3),yystack_[2].value,nullptr,yystack_[0].value)); }
+#line 1800 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 17: // LetArg: Identifier Type "':='" Expression
+#line 124 "bin/parser/saneql.expanded.ypp"
+                                           { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::LetArg,0,3),yystack_[3].value,yystack_[2].value,yystack_[0].value)); }
+#line 1806 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 21: // Type: Identifier
+#line 140 "bin/parser/saneql.expanded.ypp"
+              { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::Type,saneql::ast::Type::SubType::Simple,2),yystack_[0].value,nullptr)); }
+#line 1812 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 22: // Type: Identifier '{' TypeList '}'
+#line 141 "bin/parser/saneql.expanded.ypp"
+                               { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::Type,saneql::ast::Type::SubType::SubTypes,2),yystack_[3].value,yystack_[1].value)); }
+#line 1818 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 23: // Type: Identifier '{' TypeArgList '}'
+#line 142 "bin/parser/saneql.expanded.ypp"
+                                  { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::Type,saneql::ast::Type::SubType::Parameter,2),yystack_[3].value,yystack_[1].value)); }
+#line 1824 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 24: // TypeList: Type
+#line 146 "bin/parser/saneql.expanded.ypp"
+        { yylhs.value = static_cast<saneql::ast::List*>(container.createList(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column), saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::List,0,2),yystack_[0].value)); }
+#line 1830 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 25: // TypeList: TypeList ',' Type
+#line 147 "bin/parser/saneql.expanded.ypp"
+                     { yylhs.value = static_cast<saneql::ast::List*>(container.appendList(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column), saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::List,0,2),yystack_[2].value,yystack_[0].value)); }
+#line 1836 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 26: // TypeArgList: TypeArg
+#line 151 "bin/parser/saneql.expanded.ypp"
+           { yylhs.value = static_cast<saneql::ast::List*>(container.createList(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column), saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::List,0,2),yystack_[0].value)); }
+#line 1842 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 27: // TypeArgList: TypeArgList ',' TypeArg
+#line 152 "bin/parser/saneql.expanded.ypp"
+                           { yylhs.value = static_cast<saneql::ast::List*>(container.appendList(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column), saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::List,0,2),yystack_[2].value,yystack_[0].value)); }
+#line 1848 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 28: // TypeArg: Iconst
+#line 156 "bin/parser/saneql.expanded.ypp"
+          { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::TypeArg,0,2),nullptr,yystack_[0].value)); }
+#line 1854 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 29: // TypeArg: Identifier "':='" Iconst
+#line 157 "bin/parser/saneql.expanded.ypp"
+                                  { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::TypeArg,0,2),yystack_[2].value,yystack_[0].value)); }
+#line 1860 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 32: // a_expr: Identifier
+#line 173 "bin/parser/saneql.expanded.ypp"
+              { yylhs.value = yystack_[0].value; }
+#line 1866 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 33: // a_expr: AexprConst
+#line 174 "bin/parser/saneql.expanded.ypp"
+              { yylhs.value = yystack_[0].value; }
+#line 1872 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 34: // a_expr: '(' a_expr ')'
+#line 175 "bin/parser/saneql.expanded.ypp"
+                  { yylhs.value = yystack_[1].value; }
+#line 1878 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 35: // a_expr: a_expr "'::'" Type
+#line 176 "bin/parser/saneql.expanded.ypp"
+                        { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::Cast,0,2),yystack_[2].value,yystack_[0].value)); }
+#line 1884 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 36: // a_expr: '+' a_expr
+#line 177 "bin/parser/saneql.expanded.ypp"
+                           { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::UnaryExpression,saneql::ast::UnaryExpression::SubType::Plus,1),yystack_[0].value)); }
+#line 1890 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 37: // a_expr: '-' a_expr
+#line 178 "bin/parser/saneql.expanded.ypp"
+                           { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::UnaryExpression,saneql::ast::UnaryExpression::SubType::Minus,1),yystack_[0].value)); }
+#line 1896 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 38: // a_expr: a_expr '+' a_expr
+#line 179 "bin/parser/saneql.expanded.ypp"
+                     { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::BinaryExpression,saneql::ast::BinaryExpression::SubType::Plus,2),yystack_[2].value,yystack_[0].value)); }
+#line 1902 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 39: // a_expr: a_expr '-' a_expr
+#line 180 "bin/parser/saneql.expanded.ypp"
+                     { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::BinaryExpression,saneql::ast::BinaryExpression::SubType::Minus,2),yystack_[2].value,yystack_[0].value)); }
+#line 1908 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 40: // a_expr: a_expr '*' a_expr
+#line 181 "bin/parser/saneql.expanded.ypp"
+                     { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::BinaryExpression,saneql::ast::BinaryExpression::SubType::Mul,2),yystack_[2].value,yystack_[0].value)); }
+#line 1914 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 41: // a_expr: a_expr '/' a_expr
+#line 182 "bin/parser/saneql.expanded.ypp"
+                     { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::BinaryExpression,saneql::ast::BinaryExpression::SubType::Div,2),yystack_[2].value,yystack_[0].value)); }
+#line 1920 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 42: // a_expr: a_expr '%' a_expr
+#line 183 "bin/parser/saneql.expanded.ypp"
+                     { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::BinaryExpression,saneql::ast::BinaryExpression::SubType::Mod,2),yystack_[2].value,yystack_[0].value)); }
+#line 1926 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 43: // a_expr: a_expr '^' a_expr
+#line 184 "bin/parser/saneql.expanded.ypp"
+                     { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::BinaryExpression,saneql::ast::BinaryExpression::SubType::Pow,2),yystack_[2].value,yystack_[0].value)); }
+#line 1932 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 44: // a_expr: a_expr '<' a_expr
+#line 185 "bin/parser/saneql.expanded.ypp"
+                     { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::BinaryExpression,saneql::ast::BinaryExpression::SubType::Less,2),yystack_[2].value,yystack_[0].value)); }
+#line 1938 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 45: // a_expr: a_expr '>' a_expr
+#line 186 "bin/parser/saneql.expanded.ypp"
+                     { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::BinaryExpression,saneql::ast::BinaryExpression::SubType::Greater,2),yystack_[2].value,yystack_[0].value)); }
+#line 1944 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 46: // a_expr: a_expr '=' a_expr
+#line 187 "bin/parser/saneql.expanded.ypp"
+                     { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::BinaryExpression,saneql::ast::BinaryExpression::SubType::Equals,2),yystack_[2].value,yystack_[0].value)); }
+#line 1950 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 47: // a_expr: a_expr "'<='" a_expr
+#line 188 "bin/parser/saneql.expanded.ypp"
+                             { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::BinaryExpression,saneql::ast::BinaryExpression::SubType::LessOrEqual,2),yystack_[2].value,yystack_[0].value)); }
+#line 1956 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 48: // a_expr: a_expr "'>='" a_expr
+#line 189 "bin/parser/saneql.expanded.ypp"
+                                { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::BinaryExpression,saneql::ast::BinaryExpression::SubType::GreaterOrEqual,2),yystack_[2].value,yystack_[0].value)); }
+#line 1962 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 49: // a_expr: a_expr "'<>'" a_expr
+#line 190 "bin/parser/saneql.expanded.ypp"
+                            { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::BinaryExpression,saneql::ast::BinaryExpression::SubType::NotEquals,2),yystack_[2].value,yystack_[0].value)); }
+#line 1968 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 50: // a_expr: a_expr "'&&'" a_expr
+#line 191 "bin/parser/saneql.expanded.ypp"
+                     { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::BinaryExpression,saneql::ast::BinaryExpression::SubType::And,2),yystack_[2].value,yystack_[0].value)); }
+#line 1974 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 51: // a_expr: a_expr "'||'" a_expr
+#line 192 "bin/parser/saneql.expanded.ypp"
+                    { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::BinaryExpression,saneql::ast::BinaryExpression::SubType::Or,2),yystack_[2].value,yystack_[0].value)); }
+#line 1980 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 52: // a_expr: "'!'" a_expr
+#line 193 "bin/parser/saneql.expanded.ypp"
+              { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::UnaryExpression,saneql::ast::UnaryExpression::SubType::Not,1),yystack_[0].value)); }
+#line 1986 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 53: // a_expr: a_expr '.' Identifier
+#line 194 "bin/parser/saneql.expanded.ypp"
+                         { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::Access,0,2),yystack_[2].value,yystack_[0].value)); }
+#line 1992 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 54: // a_expr: a_expr '(' ')'
+#line 195 "bin/parser/saneql.expanded.ypp"
+                  { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::Call,0,2),yystack_[2].value,nullptr)); }
+#line 1998 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 55: // a_expr: a_expr '(' FuncArgs ')'
+#line 196 "bin/parser/saneql.expanded.ypp"
+                           { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::Call,0,2),yystack_[3].value,yystack_[1].value)); }
+#line 2004 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 56: // AexprConst: Iconst
+#line 200 "bin/parser/saneql.expanded.ypp"
+          { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::Literal,saneql::ast::Literal::SubType::Integer,1),yystack_[0].value)); }
+#line 2010 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 57: // AexprConst: "floatliteral"
+#line 201 "bin/parser/saneql.expanded.ypp"
+          { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::Literal,saneql::ast::Literal::SubType::Float,1),yystack_[0].value)); }
+#line 2016 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 58: // AexprConst: Sconst
+#line 202 "bin/parser/saneql.expanded.ypp"
+          { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::Literal,saneql::ast::Literal::SubType::String,1),yystack_[0].value)); }
+#line 2022 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 59: // AexprConst: "true"
+#line 203 "bin/parser/saneql.expanded.ypp"
+          { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::Literal,saneql::ast::Literal::SubType::True,1),nullptr)); }
+#line 2028 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 60: // AexprConst: "false"
+#line 204 "bin/parser/saneql.expanded.ypp"
+           { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::Literal,saneql::ast::Literal::SubType::False,1),nullptr)); }
+#line 2034 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 61: // AexprConst: "null"
+#line 205 "bin/parser/saneql.expanded.ypp"
+          { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::Literal,saneql::ast::Literal::SubType::Null,1),nullptr)); }
+#line 2040 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 62: // AexprConst: "'$?'"
+#line 206 "bin/parser/saneql.expanded.ypp"
+         { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::Parameter,0,1),yystack_[0].value)); }
+#line 2046 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 64: // FuncArgs: FuncArgs ',' FuncArg
+#line 214 "bin/parser/saneql.expanded.ypp"
+                        { yylhs.value = static_cast<saneql::ast::List*>(container.appendList(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column), saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::List,0,2),yystack_[2].value,yystack_[0].value)); }
+#line 2052 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 65: // FuncArgs: FuncArg
+#line 215 "bin/parser/saneql.expanded.ypp"
+           { yylhs.value = static_cast<saneql::ast::List*>(container.createList(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column), saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::List,0,2),yystack_[0].value)); }
+#line 2058 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 66: // FuncArg: Identifier "':='" Expression
+#line 219 "bin/parser/saneql.expanded.ypp"
+                                      { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::FuncArg,saneql::ast::FuncArg::SubType::Flat,2),yystack_[2].value,yystack_[0].value)); }
+#line 2064 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 67: // FuncArg: Identifier "':='" '{' FuncArgList '}'
+#line 220 "bin/parser/saneql.expanded.ypp"
+                                               { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::FuncArg,saneql::ast::FuncArg::SubType::List,2),yystack_[4].value,yystack_[1].value)); }
+#line 2070 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 68: // FuncArg: Expression
+#line 221 "bin/parser/saneql.expanded.ypp"
+              { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::FuncArg,saneql::ast::FuncArg::SubType::Flat,2),nullptr,yystack_[0].value)); }
+#line 2076 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 69: // FuncArg: '{' FuncArgList '}'
+#line 222 "bin/parser/saneql.expanded.ypp"
+                       { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::FuncArg,saneql::ast::FuncArg::SubType::List,2),nullptr,yystack_[1].value)); }
+#line 2082 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 71: // FuncArgList: %empty
+#line 227 "bin/parser/saneql.expanded.ypp"
+          { yylhs.value = nullptr; }
+#line 2088 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 72: // FuncArgListNe: FuncArgListNe ',' FuncArgNamed
+#line 231 "bin/parser/saneql.expanded.ypp"
+                                  { yylhs.value = static_cast<saneql::ast::List*>(container.appendList(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column), saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::List,0,2),yystack_[2].value,yystack_[0].value)); }
+#line 2094 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 73: // FuncArgListNe: FuncArgNamed
+#line 232 "bin/parser/saneql.expanded.ypp"
+                { yylhs.value = static_cast<saneql::ast::List*>(container.createList(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column), saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::List,0,2),yystack_[0].value)); }
+#line 2100 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 74: // FuncArgNamed: Expression
+#line 236 "bin/parser/saneql.expanded.ypp"
+              { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::FuncArgNamed,saneql::ast::FuncArgNamed::SubType::Flat,2),nullptr,yystack_[0].value)); }
+#line 2106 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 75: // FuncArgNamed: Identifier "':='" Expression
+#line 237 "bin/parser/saneql.expanded.ypp"
+                                      { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::FuncArgNamed,saneql::ast::FuncArgNamed::SubType::Flat,2),yystack_[2].value,yystack_[0].value)); }
+#line 2112 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 76: // FuncArgNamed: Expression "'=>'" Expression
+#line 238 "bin/parser/saneql.expanded.ypp"
+                                        { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::FuncArgNamed,saneql::ast::FuncArgNamed::SubType::Case,2),yystack_[2].value,yystack_[0].value)); }
+#line 2118 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 77: // FuncArgNamed: '{' FuncArgList '}'
+#line 239 "bin/parser/saneql.expanded.ypp"
+                       { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::FuncArgNamed,saneql::ast::FuncArgNamed::SubType::List,2),nullptr,yystack_[1].value)); }
+#line 2124 "bin/parser/saneql_parser.cpp"
+    break;
+
+  case 78: // FuncArgNamed: Identifier "':='" '{' FuncArgList '}'
+#line 240 "bin/parser/saneql.expanded.ypp"
+                                               { yylhs.value = static_cast<saneql::ast::AST*>(container.allocateASTImpl(lexer.getRangeFromBounds(yylhs.location.begin.column,yylhs.location.end.column),saneql::ASTBase::buildDescriptor(saneql::ast::AST::Type::FuncArgNamed,saneql::ast::FuncArgNamed::SubType::List,2),yystack_[4].value,yystack_[1].value)); }
+#line 2130 "bin/parser/saneql_parser.cpp"
+    break;
+
+
+#line 2134 "bin/parser/saneql_parser.cpp"
+
+            default:
+              break;
+            }
+        }
+#if YY_EXCEPTIONS
+      catch (const syntax_error& yyexc)
+        {
+          YYCDEBUG << "Caught exception: " << yyexc.what() << '\n';
+          error (yyexc);
+          YYERROR;
+        }
+#endif // YY_EXCEPTIONS
+      YY_SYMBOL_PRINT ("-> $$ =", yylhs);
+      yypop_ (yylen);
+      yylen = 0;
+
+      // Shift the result of the reduction.
+      yypush_ (YY_NULLPTR, YY_MOVE (yylhs));
+    }
+    goto yynewstate;
+
+
+  /*--------------------------------------.
+  | yyerrlab -- here on detecting error.  |
+  `--------------------------------------*/
+  yyerrlab:
+    // If not already recovering from an error, report this error.
+    if (!yyerrstatus_)
+      {
+        ++yynerrs_;
+        context yyctx (*this, yyla);
+        std::string msg = yysyntax_error_ (yyctx);
+        error (yyla.location, YY_MOVE (msg));
+      }
+
+
+    yyerror_range[1].location = yyla.location;
+    if (yyerrstatus_ == 3)
+      {
+        /* If just tried and failed to reuse lookahead token after an
+           error, discard it.  */
+
+        // Return failure if at end of input.
+        if (yyla.kind () == symbol_kind::S_YYEOF)
+          YYABORT;
+        else if (!yyla.empty ())
+          {
+            yy_destroy_ ("Error: discarding", yyla);
+            yyla.clear ();
+          }
+      }
+
+    // Else will try to reuse lookahead token after shifting the error token.
+    goto yyerrlab1;
+
+
+  /*---------------------------------------------------.
+  | yyerrorlab -- error raised explicitly by YYERROR.  |
+  `---------------------------------------------------*/
+  yyerrorlab:
+    /* Pacify compilers when the user code never invokes YYERROR and
+       the label yyerrorlab therefore never appears in user code.  */
+    if (false)
+      YYERROR;
+
+    /* Do not reclaim the symbols of the rule whose action triggered
+       this YYERROR.  */
+    yypop_ (yylen);
+    yylen = 0;
+    YY_STACK_PRINT ();
+    goto yyerrlab1;
+
+
+  /*-------------------------------------------------------------.
+  | yyerrlab1 -- common code for both syntax error and YYERROR.  |
+  `-------------------------------------------------------------*/
+  yyerrlab1:
+    yyerrstatus_ = 3;   // Each real token shifted decrements this.
+    // Pop stack until we find a state that shifts the error token.
+    for (;;)
+      {
+        yyn = yypact_[+yystack_[0].state];
+        if (!yy_pact_value_is_default_ (yyn))
+          {
+            yyn += symbol_kind::S_YYerror;
+            if (0 <= yyn && yyn <= yylast_
+                && yycheck_[yyn] == symbol_kind::S_YYerror)
+              {
+                yyn = yytable_[yyn];
+                if (0 < yyn)
+                  break;
+              }
+          }
+
+        // Pop the current state because it cannot handle the error token.
+        if (yystack_.size () == 1)
+          YYABORT;
+
+        yyerror_range[1].location = yystack_[0].location;
+        yy_destroy_ ("Error: popping", yystack_[0]);
+        yypop_ ();
+        YY_STACK_PRINT ();
+      }
+    {
+      stack_symbol_type error_token;
+
+      yyerror_range[2].location = yyla.location;
+      YYLLOC_DEFAULT (error_token.location, yyerror_range, 2);
+
+      // Shift the error token.
+      error_token.state = state_type (yyn);
+      yypush_ ("Shifting", YY_MOVE (error_token));
+    }
+    goto yynewstate;
+
+
+  /*-------------------------------------.
+  | yyacceptlab -- YYACCEPT comes here.  |
+  `-------------------------------------*/
+  yyacceptlab:
+    yyresult = 0;
+    goto yyreturn;
+
+
+  /*-----------------------------------.
+  | yyabortlab -- YYABORT comes here.  |
+  `-----------------------------------*/
+  yyabortlab:
+    yyresult = 1;
+    goto yyreturn;
+
+
+  /*-----------------------------------------------------.
+  | yyreturn -- parsing is finished, return the result.  |
+  `-----------------------------------------------------*/
+  yyreturn:
+    if (!yyla.empty ())
+      yy_destroy_ ("Cleanup: discarding lookahead", yyla);
+
+    /* Do not reclaim the symbols of the rule whose action triggered
+       this YYABORT or YYACCEPT.  */
+    yypop_ (yylen);
+    YY_STACK_PRINT ();
+    while (1 < yystack_.size ())
+      {
+        yy_destroy_ ("Cleanup: popping", yystack_[0]);
+        yypop_ ();
+      }
+
+    return yyresult;
+  }
+#if YY_EXCEPTIONS
+    catch (...)
+      {
+        YYCDEBUG << "Exception caught: cleaning lookahead and stack\n";
+        // Do not try to display the values of the reclaimed symbols,
+        // as their printers might throw an exception.
+        if (!yyla.empty ())
+          yy_destroy_ (YY_NULLPTR, yyla);
+
+        while (1 < yystack_.size ())
+          {
+            yy_destroy_ (YY_NULLPTR, yystack_[0]);
+            yypop_ ();
+          }
+        throw;
+      }
+#endif // YY_EXCEPTIONS
+  }
+
+  void
+  parser::error (const syntax_error& yyexc)
+  {
+    error (yyexc.location, yyexc.what ());
+  }
+
+  /* Return YYSTR after stripping away unnecessary quotes and
+     backslashes, so that it's suitable for yyerror.  The heuristic is
+     that double-quoting is unnecessary unless the string contains an
+     apostrophe, a comma, or backslash (other than backslash-backslash).
+     YYSTR is taken from yytname.  */
+  std::string
+  parser::yytnamerr_ (const char *yystr)
+  {
+    if (*yystr == '"')
+      {
+        std::string yyr;
+        char const *yyp = yystr;
+
+        for (;;)
+          switch (*++yyp)
+            {
+            case '\'':
+            case ',':
+              goto do_not_strip_quotes;
+
+            case '\\':
+              if (*++yyp != '\\')
+                goto do_not_strip_quotes;
+              else
+                goto append;
+
+            append:
+            default:
+              yyr += *yyp;
+              break;
+
+            case '"':
+              return yyr;
+            }
+      do_not_strip_quotes: ;
+      }
+
+    return yystr;
+  }
+
+  std::string
+  parser::symbol_name (symbol_kind_type yysymbol)
+  {
+    return yytnamerr_ (yytname_[yysymbol]);
+  }
+
+
+
+  // parser::context.
+  parser::context::context (const parser& yyparser, const symbol_type& yyla)
+    : yyparser_ (yyparser)
+    , yyla_ (yyla)
+  {}
+
+  int
+  parser::context::expected_tokens (symbol_kind_type yyarg[], int yyargn) const
+  {
+    // Actual number of expected tokens
+    int yycount = 0;
+
+    const int yyn = yypact_[+yyparser_.yystack_[0].state];
+    if (!yy_pact_value_is_default_ (yyn))
+      {
+        /* Start YYX at -YYN if negative to avoid negative indexes in
+           YYCHECK.  In other words, skip the first -YYN actions for
+           this state because they are default actions.  */
+        const int yyxbegin = yyn < 0 ? -yyn : 0;
+        // Stay within bounds of both yycheck and yytname.
+        const int yychecklim = yylast_ - yyn + 1;
+        const int yyxend = yychecklim < YYNTOKENS ? yychecklim : YYNTOKENS;
+        for (int yyx = yyxbegin; yyx < yyxend; ++yyx)
+          if (yycheck_[yyx + yyn] == yyx && yyx != symbol_kind::S_YYerror
+              && !yy_table_value_is_error_ (yytable_[yyx + yyn]))
+            {
+              if (!yyarg)
+                ++yycount;
+              else if (yycount == yyargn)
+                return 0;
+              else
+                yyarg[yycount++] = YY_CAST (symbol_kind_type, yyx);
+            }
+      }
+
+    if (yyarg && yycount == 0 && 0 < yyargn)
+      yyarg[0] = symbol_kind::S_YYEMPTY;
+    return yycount;
+  }
+
+
+
+
+
+
+  int
+  parser::yy_syntax_error_arguments_ (const context& yyctx,
+                                                 symbol_kind_type yyarg[], int yyargn) const
+  {
+    /* There are many possibilities here to consider:
+       - If this state is a consistent state with a default action, then
+         the only way this function was invoked is if the default action
+         is an error action.  In that case, don't check for expected
+         tokens because there are none.
+       - The only way there can be no lookahead present (in yyla) is
+         if this state is a consistent state with a default action.
+         Thus, detecting the absence of a lookahead is sufficient to
+         determine that there is no unexpected or expected token to
+         report.  In that case, just report a simple "syntax error".
+       - Don't assume there isn't a lookahead just because this state is
+         a consistent state with a default action.  There might have
+         been a previous inconsistent state, consistent state with a
+         non-default action, or user semantic action that manipulated
+         yyla.  (However, yyla is currently not documented for users.)
+       - Of course, the expected token list depends on states to have
+         correct lookahead information, and it depends on the parser not
+         to perform extra reductions after fetching a lookahead from the
+         scanner and before detecting a syntax error.  Thus, state merging
+         (from LALR or IELR) and default reductions corrupt the expected
+         token list.  However, the list is correct for canonical LR with
+         one exception: it will still contain any token that will not be
+         accepted due to an error action in a later state.
+    */
+
+    if (!yyctx.lookahead ().empty ())
+      {
+        if (yyarg)
+          yyarg[0] = yyctx.token ();
+        int yyn = yyctx.expected_tokens (yyarg ? yyarg + 1 : yyarg, yyargn - 1);
+        return yyn + 1;
+      }
+    return 0;
+  }
+
+  // Generate an error message.
+  std::string
+  parser::yysyntax_error_ (const context& yyctx) const
+  {
+    // Its maximum.
+    enum { YYARGS_MAX = 5 };
+    // Arguments of yyformat.
+    symbol_kind_type yyarg[YYARGS_MAX];
+    int yycount = yy_syntax_error_arguments_ (yyctx, yyarg, YYARGS_MAX);
+
+    char const* yyformat = YY_NULLPTR;
+    switch (yycount)
+      {
+#define YYCASE_(N, S)                         \
+        case N:                               \
+          yyformat = S;                       \
+        break
+      default: // Avoid compiler warnings.
+        YYCASE_ (0, YY_("syntax error"));
+        YYCASE_ (1, YY_("syntax error, unexpected %s"));
+        YYCASE_ (2, YY_("syntax error, unexpected %s, expecting %s"));
+        YYCASE_ (3, YY_("syntax error, unexpected %s, expecting %s or %s"));
+        YYCASE_ (4, YY_("syntax error, unexpected %s, expecting %s or %s or %s"));
+        YYCASE_ (5, YY_("syntax error, unexpected %s, expecting %s or %s or %s or %s"));
+#undef YYCASE_
+      }
+
+    std::string yyres;
+    // Argument number.
+    std::ptrdiff_t yyi = 0;
+    for (char const* yyp = yyformat; *yyp; ++yyp)
+      if (yyp[0] == '%' && yyp[1] == 's' && yyi < yycount)
+        {
+          yyres += symbol_name (yyarg[yyi++]);
+          ++yyp;
+        }
+      else
+        yyres += *yyp;
+    return yyres;
+  }
+
+
+  const signed char parser::yypact_ninf_ = -84;
+
+  const signed char parser::yytable_ninf_ = -1;
+
+  const short
+  parser::yypact_[] =
+  {
+      -8,    50,    18,   -84,   -84,   218,   -84,   -84,   -18,   -84,
+     -84,   -84,   -84,   -84,   -84,   247,    50,   -84,   -84,   -84,
+     247,   247,   247,   -84,   -84,   -84,   -84,   283,   -84,   -84,
+       1,   328,    14,    11,    11,   250,    50,   247,   247,   247,
+     247,   247,   247,   247,   247,   247,   247,   247,   247,   247,
+     247,    15,    50,   -84,   -38,   -84,     2,    50,    49,   -84,
+      23,   -84,   361,   361,   361,   328,   316,   361,   361,   361,
+     105,   105,    -9,    -9,    -9,    11,   -84,   102,    53,   -84,
+     -37,   -84,   -84,   -84,   -84,    50,   247,    57,   -25,   247,
+       3,   102,    60,    62,    13,    26,   -84,   131,   -84,   160,
+     -84,   -84,   -84,   247,   -84,    29,   -10,   -84,    17,    21,
+     -84,   -84,    30,   189,   247,   -84,   102,   102,   -84,   -84,
+     -84,   -84,    70,    50,   -84,     3,   -84,   -84,   102,   -84,
+     -84,   -84,    32,   -84,   -84,    72,   -84,    36,   -84,   -84
+  };
+
+  const signed char
+  parser::yydefact_[] =
+  {
+       8,     0,     0,     2,     3,     0,    18,    20,     0,    19,
+       1,    57,    63,    30,    62,     0,     0,    61,    59,    60,
+       0,     0,     0,     7,    32,    56,     6,    31,    33,    58,
+       0,    52,    11,    36,    37,     0,     0,     0,     0,     0,
+       0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+       0,     0,     0,     8,     0,    13,    14,     0,     0,    34,
+      21,    35,    47,    48,    49,    50,    51,    44,    45,    46,
+      38,    39,    40,    41,    42,    43,    54,    71,    32,    68,
+       0,    65,    53,     4,     8,     0,     0,    15,     0,     0,
+       0,    71,    32,    74,     0,    70,    73,     0,    55,     0,
+       5,    12,    16,     0,    10,     0,    21,    24,     0,     0,
+      26,    28,     0,     0,     0,    69,     0,    71,    66,    64,
+      17,     9,     0,     0,    22,     0,    23,    77,    71,    75,
+      76,    72,     0,    29,    25,     0,    27,     0,    67,    78
+  };
+
+  const short
+  parser::yypgoto_[] =
+  {
+     -84,   -84,   -84,   -26,   -84,   -84,   -84,    31,     6,    -1,
+     -84,   -54,   -84,   -84,   -33,   -76,    -4,   375,   -84,   -84,
+     -84,    -5,   -83,   -84,   -20
+  };
+
+  const signed char
+  parser::yydefgoto_[] =
+  {
+       0,     2,     3,     4,     5,    23,    58,    54,    55,    24,
+       9,    61,   108,   109,   110,    25,    93,    27,    28,    29,
+      80,    81,    94,    95,    96
+  };
+
+  const short
+  parser::yytable_[] =
+  {
+       8,    26,    87,    36,   122,     6,     6,     6,   112,    84,
+      98,    85,    99,    13,   111,    32,    86,     1,    10,     6,
+      11,    12,   104,    36,    85,    13,    14,    83,    30,    56,
+       7,     7,     7,    50,   132,    60,   107,    51,    15,    52,
+      90,    17,    18,    19,     7,   137,   133,    79,    53,   111,
+      78,    82,    20,    21,     6,    60,    56,    51,   100,    52,
+      57,    22,    76,    89,   115,    77,   123,    97,   124,   134,
+     125,   103,   126,    90,   113,   116,    92,   114,   121,     7,
+      13,   127,   102,   138,    56,   105,   122,   139,    88,   106,
+      92,   101,   136,   118,   119,    79,   131,     0,    78,   120,
+       0,     0,     0,     0,     0,     0,     6,    11,    12,   129,
+     130,     0,    13,    14,     0,    92,    92,    36,     0,     0,
+       0,     0,    60,     0,   135,    15,     0,    92,    17,    18,
+      19,     7,     0,     0,     0,     6,    11,    12,     0,    20,
+      21,    13,    14,     0,    47,    48,    49,    50,    22,     0,
+       0,    51,    91,    52,    15,     0,     0,    17,    18,    19,
+       7,     0,     0,     0,     6,    11,    12,     0,    20,    21,
+      13,    14,     0,     0,     0,     0,     0,    22,     0,     0,
+       0,   117,     0,    15,     0,     0,    17,    18,    19,     7,
+       0,     0,     0,     6,    11,    12,     0,    20,    21,    13,
+      14,     0,     0,     0,     0,     0,    22,     0,     0,     0,
+      77,     0,    15,     0,     0,    17,    18,    19,     7,     0,
+       0,     0,     6,    11,    12,     0,    20,    21,    13,    14,
+       0,     0,     0,     0,     0,    22,     0,     0,     0,   128,
+       0,    15,    16,     0,    17,    18,    19,     7,     0,     0,
+       0,     6,    11,    12,     0,    20,    21,    13,    14,     0,
+       0,     0,    36,     0,    22,     0,    37,    38,    39,     0,
+      15,    40,    41,    17,    18,    19,     7,     0,     0,     0,
+       0,    42,    43,    44,    20,    21,     0,    45,    46,    47,
+      48,    49,    50,    22,     0,    36,    51,    59,    52,    37,
+      38,    39,     0,     0,    40,    41,     0,     0,     0,     0,
+       0,     0,     0,     0,    42,    43,    44,     0,     0,     0,
+      45,    46,    47,    48,    49,    50,     0,     0,    36,    51,
+       0,    52,    37,    38,    39,     0,     0,    40,     0,     0,
+      36,     0,     0,     0,    37,    38,    39,    42,    43,    44,
+       0,     0,     0,    45,    46,    47,    48,    49,    50,    42,
+      43,    44,    51,     0,    52,    45,    46,    47,    48,    49,
+      50,     0,     0,    36,    51,     0,    52,    -1,    -1,    -1,
+       0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+      31,     0,    -1,    -1,    -1,    33,    34,    35,    45,    46,
+      47,    48,    49,    50,     0,     0,     0,    51,     0,    52,
+       0,     0,    62,    63,    64,    65,    66,    67,    68,    69,
+      70,    71,    72,    73,    74,    75
+  };
+
+  const short
+  parser::yycheck_[] =
+  {
+       1,     5,    56,    12,    14,     4,     4,     4,    91,    47,
+      47,    49,    49,    10,    90,    16,    14,    25,     0,     4,
+       5,     6,    47,    12,    49,    10,    11,    53,    46,    30,
+      29,    29,    29,    42,   117,    36,    90,    46,    23,    48,
+      50,    26,    27,    28,    29,   128,   122,    51,    47,   125,
+      51,    52,    37,    38,     4,    56,    57,    46,    84,    48,
+      46,    46,    47,    14,    51,    50,    49,    14,    51,   123,
+      49,    14,    51,    50,    14,    49,    77,    15,    49,    29,
+      10,    51,    86,    51,    85,    89,    14,    51,    57,    90,
+      91,    85,   125,    97,    99,    99,   116,    -1,    99,   103,
+      -1,    -1,    -1,    -1,    -1,    -1,     4,     5,     6,   113,
+     114,    -1,    10,    11,    -1,   116,   117,    12,    -1,    -1,
+      -1,    -1,   123,    -1,   125,    23,    -1,   128,    26,    27,
+      28,    29,    -1,    -1,    -1,     4,     5,     6,    -1,    37,
+      38,    10,    11,    -1,    39,    40,    41,    42,    46,    -1,
+      -1,    46,    50,    48,    23,    -1,    -1,    26,    27,    28,
+      29,    -1,    -1,    -1,     4,     5,     6,    -1,    37,    38,
+      10,    11,    -1,    -1,    -1,    -1,    -1,    46,    -1,    -1,
+      -1,    50,    -1,    23,    -1,    -1,    26,    27,    28,    29,
+      -1,    -1,    -1,     4,     5,     6,    -1,    37,    38,    10,
+      11,    -1,    -1,    -1,    -1,    -1,    46,    -1,    -1,    -1,
+      50,    -1,    23,    -1,    -1,    26,    27,    28,    29,    -1,
+      -1,    -1,     4,     5,     6,    -1,    37,    38,    10,    11,
+      -1,    -1,    -1,    -1,    -1,    46,    -1,    -1,    -1,    50,
+      -1,    23,    24,    -1,    26,    27,    28,    29,    -1,    -1,
+      -1,     4,     5,     6,    -1,    37,    38,    10,    11,    -1,
+      -1,    -1,    12,    -1,    46,    -1,    16,    17,    18,    -1,
+      23,    21,    22,    26,    27,    28,    29,    -1,    -1,    -1,
+      -1,    31,    32,    33,    37,    38,    -1,    37,    38,    39,
+      40,    41,    42,    46,    -1,    12,    46,    47,    48,    16,
+      17,    18,    -1,    -1,    21,    22,    -1,    -1,    -1,    -1,
+      -1,    -1,    -1,    -1,    31,    32,    33,    -1,    -1,    -1,
+      37,    38,    39,    40,    41,    42,    -1,    -1,    12,    46,
+      -1,    48,    16,    17,    18,    -1,    -1,    21,    -1,    -1,
+      12,    -1,    -1,    -1,    16,    17,    18,    31,    32,    33,
+      -1,    -1,    -1,    37,    38,    39,    40,    41,    42,    31,
+      32,    33,    46,    -1,    48,    37,    38,    39,    40,    41,
+      42,    -1,    -1,    12,    46,    -1,    48,    16,    17,    18,
+      -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,
+      15,    -1,    31,    32,    33,    20,    21,    22,    37,    38,
+      39,    40,    41,    42,    -1,    -1,    -1,    46,    -1,    48,
+      -1,    -1,    37,    38,    39,    40,    41,    42,    43,    44,
+      45,    46,    47,    48,    49,    50
+  };
+
+  const signed char
+  parser::yystos_[] =
+  {
+       0,    25,    53,    54,    55,    56,     4,    29,    61,    62,
+       0,     5,     6,    10,    11,    23,    24,    26,    27,    28,
+      37,    38,    46,    57,    61,    67,    68,    69,    70,    71,
+      46,    69,    61,    69,    69,    69,    12,    16,    17,    18,
+      21,    22,    31,    32,    33,    37,    38,    39,    40,    41,
+      42,    46,    48,    47,    59,    60,    61,    46,    58,    47,
+      61,    63,    69,    69,    69,    69,    69,    69,    69,    69,
+      69,    69,    69,    69,    69,    69,    47,    50,    61,    68,
+      72,    73,    61,    55,    47,    49,    14,    63,    59,    14,
+      50,    50,    61,    68,    74,    75,    76,    14,    47,    49,
+      55,    60,    68,    14,    47,    68,    61,    63,    64,    65,
+      66,    67,    74,    14,    15,    51,    49,    50,    68,    73,
+      68,    49,    14,    49,    51,    49,    51,    51,    50,    68,
+      68,    76,    74,    67,    63,    61,    66,    74,    51,    51
+  };
+
+  const signed char
+  parser::yyr1_[] =
+  {
+       0,    52,    53,    53,    54,    54,    55,    56,    56,    57,
+      58,    58,    59,    59,    60,    60,    60,    60,    61,    61,
+      62,    63,    63,    63,    64,    64,    65,    65,    66,    66,
+      67,    68,    69,    69,    69,    69,    69,    69,    69,    69,
+      69,    69,    69,    69,    69,    69,    69,    69,    69,    69,
+      69,    69,    69,    69,    69,    69,    70,    70,    70,    70,
+      70,    70,    70,    71,    72,    72,    73,    73,    73,    73,
+      74,    74,    75,    75,    76,    76,    76,    76,    76
+  };
+
+  const signed char
+  parser::yyr2_[] =
+  {
+       0,     2,     1,     1,     5,     6,     2,     2,     0,     6,
+       3,     0,     3,     1,     1,     2,     3,     4,     1,     1,
+       1,     1,     4,     4,     1,     3,     1,     3,     1,     3,
+       1,     1,     1,     1,     3,     3,     2,     2,     3,     3,
+       3,     3,     3,     3,     3,     3,     3,     3,     3,     3,
+       3,     3,     2,     3,     3,     4,     1,     1,     1,     1,
+       1,     1,     1,     1,     3,     1,     3,     5,     1,     3,
+       1,     0,     3,     1,     1,     3,     3,     3,     5
+  };
+
+
+#if YYDEBUG || 1
+  // YYTNAME[SYMBOL-NUM] -- String name of the symbol SYMBOL-NUM.
+  // First, the terminals, then, starting at \a YYNTOKENS, nonterminals.
+  const char*
+  const parser::yytname_[] =
+  {
+  "\"end-of-file\"", "error", "\"invalid token\"", "Error",
+  "\"identifier\"", "\"floatliteral\"", "\"stringliteral\"",
+  "\"bitstringliteral\"", "\"hexstringliteral\"", "\"<operator>\"",
+  "\"intliteral\"", "\"'$?'\"", "\"'::'\"", "\"'..'\"", "\"':='\"",
+  "\"'=>'\"", "\"'<='\"", "\"'>='\"", "\"'<>'\"", "MODE_EXPRESSION",
+  "MODE_TYPE", "\"'&&'\"", "\"'||'\"", "\"'!'\"", "\"let\"", "\"defun\"",
+  "\"null\"", "\"true\"", "\"false\"", "\"table\"", "IS", "'<'", "'>'",
+  "'='", "ESCAPE", "POSTFIXOP", "OPERATOR", "'+'", "'-'", "'*'", "'/'",
+  "'%'", "'^'", "UMINUS", "'['", "']'", "'('", "')'", "'.'", "','", "'{'",
+  "'}'", "$accept", "Query", "DefineFunction", "QueryBody", "LetList",
+  "LetEntry", "LetArgs", "LetArgsList", "LetArg", "Identifier",
+  "Softkeywords", "Type", "TypeList", "TypeArgList", "TypeArg", "Iconst",
+  "Expression", "a_expr", "AexprConst", "Sconst", "FuncArgs", "FuncArg",
+  "FuncArgList", "FuncArgListNe", "FuncArgNamed", YY_NULLPTR
+  };
+#endif
+
+
+#if YYDEBUG
+  const unsigned char
+  parser::yyrline_[] =
+  {
+       0,    88,    88,    89,    93,    94,    98,   102,   103,   107,
+     111,   112,   116,   117,   121,   122,   123,   124,   128,   129,
+     133,   140,   141,   142,   146,   147,   151,   152,   156,   157,
+     161,   169,   173,   174,   175,   176,   177,   178,   179,   180,
+     181,   182,   183,   184,   185,   186,   187,   188,   189,   190,
+     191,   192,   193,   194,   195,   196,   200,   201,   202,   203,
+     204,   205,   206,   210,   214,   215,   219,   220,   221,   222,
+     226,   227,   231,   232,   236,   237,   238,   239,   240
+  };
+
+  void
+  parser::yy_stack_print_ () const
+  {
+    *yycdebug_ << "Stack now";
+    for (stack_type::const_iterator
+           i = yystack_.begin (),
+           i_end = yystack_.end ();
+         i != i_end; ++i)
+      *yycdebug_ << ' ' << int (i->state);
+    *yycdebug_ << '\n';
+  }
+
+  void
+  parser::yy_reduce_print_ (int yyrule) const
+  {
+    int yylno = yyrline_[yyrule];
+    int yynrhs = yyr2_[yyrule];
+    // Print the symbols being reduced, and their result.
+    *yycdebug_ << "Reducing stack by rule " << yyrule - 1
+               << " (line " << yylno << "):\n";
+    // The symbols being reduced.
+    for (int yyi = 0; yyi < yynrhs; yyi++)
+      YY_SYMBOL_PRINT ("   $" << yyi + 1 << " =",
+                       yystack_[(yynrhs) - (yyi + 1)]);
+  }
+#endif // YYDEBUG
+
+  parser::symbol_kind_type
+  parser::yytranslate_ (int t) YY_NOEXCEPT
+  {
+    // YYTRANSLATE[TOKEN-NUM] -- Symbol number corresponding to
+    // TOKEN-NUM as returned by yylex.
+    static
+    const signed char
+    translate_table[] =
+    {
+       0,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,    41,     2,     2,
+      46,    47,    39,    37,    49,    38,    48,    40,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+      31,    33,    32,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,    44,     2,    45,    42,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,    50,     2,    51,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     1,     2,     3,     4,
+       5,     6,     7,     8,     9,    10,    11,    12,    13,    14,
+      15,    16,    17,    18,    19,    20,    21,    22,    23,    24,
+      25,    26,    27,    28,    29,    30,    34,    35,    36,    43
+    };
+    // Last valid token kind.
+    const int code_max = 289;
+
+    if (t <= 0)
+      return symbol_kind::S_YYEOF;
+    else if (t <= code_max)
+      return static_cast <symbol_kind_type> (translate_table[t]);
+    else
+      return symbol_kind::S_YYUNDEF;
+  }
+
+#line 3 "bin/parser/saneql.expanded.ypp"
+} } // saneql::saneqlparser
+#line 2803 "bin/parser/saneql_parser.cpp"
+
+#line 243 "bin/parser/saneql.expanded.ypp"
+
+
+namespace saneql { namespace saneqlparser {
+
+void parser::error(const location_type&,const std::string&) {
+   // unreachable
+}
+
+class reportingparser final : public parser {
+
+  public:
+  reportingparser(saneql::ASTContainer& container,saneql::SaneQLLexer& lexer) : parser(container,lexer) {}
+
+#define N_TOKENS_VAR YYNTOKENS
+  std::string yysyntax_error_ (const context& yyctx) const override
+  {
+     auto yystate = yyctx.yyparser_.yystack_[0].state;
+     auto& yyla = yyctx.lookahead();
+     const char* gotSymbol=nullptr;
+     std::vector<const char*> expectedSymbols;
+#define ERROR_TOKEN_VAR symbol_kind::S_YYerror
+     if (!yyla.empty ()) {
+        const int firstKeyword = yytranslate_(saneqlparser::parser::token::LET);
+        const int identifier = yytranslate_(saneqlparser::parser::token::IDENT);
+        int yytoken = yyla.type_get ();
+        gotSymbol = yytname_[yytoken];
+        if ((*gotSymbol=='"')&&(yytoken<firstKeyword))
+           ++gotSymbol;
+
+        bool expectedIdent=false;
+        int yyn = yypact_[yystate];
+        if (!yy_pact_value_is_default_ (yyn))
+          {
+            int yyxbegin = yyn < 0 ? -yyn : 0;
+            int yychecklim = yylast_ - yyn + 1;
+            int yyxend = yychecklim < N_TOKENS_VAR ? yychecklim : N_TOKENS_VAR;
+            for (int yyx = yyxbegin; yyx < yyxend; ++yyx)
+              if (yycheck_[yyx + yyn] == yyx && yyx != ERROR_TOKEN_VAR
+                  && !yy_table_value_is_error_ (yytable_[yyx + yyn]))
+                {
+                  if (yyx==identifier) expectedIdent=true;
+                }
+          }
+        if (!yy_pact_value_is_default_ (yyn))
+          {
+            int yyxbegin = yyn < 0 ? -yyn : 0;
+            int yychecklim = yylast_ - yyn + 1;
+            int yyxend = yychecklim < N_TOKENS_VAR ? yychecklim : N_TOKENS_VAR;
+            for (int yyx = yyxbegin; yyx < yyxend; ++yyx)
+              if (yycheck_[yyx + yyn] == yyx && yyx != ERROR_TOKEN_VAR
+                  && !yy_table_value_is_error_ (yytable_[yyx + yyn]))
+                {
+                   if ((yyx<firstKeyword)||(!expectedIdent)) {
+                      const char* s=yytname_[yyx];
+                      if ((*s=='"')&&(yyx<firstKeyword))
+                         ++s;
+                      expectedSymbols.push_back(s);
+                   }
+                }
+          }
+      }
+#undef ERROR_TOKEN_VAR
+#undef N_TOKENS_VAR
+
+      lexer.reportSyntaxError(yyla.location.begin.column,gotSymbol,expectedSymbols);
+      return {};
+  }
+};
+
+}}
+
+
+// All non-keyword SaneQLLexer tokens and their corresponding bison tokens
+#define SQLLEXER_TOKENS(A,B) \
+   A(Eof,EndOfFile) A(Error,Error) B(Asterisk,'*') B(Circumflex,'^') A(ClientCommand,Error) B(Colon,':') A(ColonColon,TYPECAST) A(ColonEquals,COLON_EQUALS) B(Comma,',') \
+   B(Dot,'.') A(DotDot,DOT_DOT) B(Equals,'=') A(EqualsGreater,EQUALS_GREATER) A(Exclamation, NOT) A(Float,FCONST) B(Greater,'>') A(GreaterEquals,GREATER_EQUALS) A(Identifier,IDENT) \
+   A(Integer,ICONST) B(LCurly,'{') B(LParen,'(') B(LSquare,'[') B(Less,'<') A(LessEquals,LESS_EQUALS) B(Minus,'-') A(NotEquals,NOT_EQUALS) A(Operator,Op) B(Percent,'%') \
+   A(Parameter,PARAM) B(Plus,'+') B(RCurly,'}') B(RParen,')') B(RSquare,']') B(SemiColon,';') B(Solidus,'/') A(String,SCONST) A(UnterminatedLiteral,Error) A(UnterminatedMultilineComment,Error)
+
+// The mapping table from SaneQLLexer tokens to bison tokens
+static constexpr saneql::saneqlparser::parser::token::yytokentype tokenTable[]={
+#define A(X,Y) saneql::saneqlparser::parser::token::Y,
+#define B(X,Y) static_cast<saneql::saneqlparser::parser::token::yytokentype>(Y),
+SQLLEXER_TOKENS(A,B)
+#undef A
+#undef B
+
+#define KEYWORD(A,B,C) saneql::saneqlparser::parser::token::B,
+#include "parser/Keywords.hpp"
+#undef KEYWORD
+};
+
+// LCOV_EXCL_STOP
+
+// Verify that the mapping table is correct
+#define A(X,Y) static_assert(tokenTable[static_cast<unsigned>(saneql::SaneQLLexer::Token::X)]==saneql::saneqlparser::parser::token::Y,"incorrect token mapping");
+#define B(X,Y) static_assert(tokenTable[static_cast<unsigned>(saneql::SaneQLLexer::Token::X)]==static_cast<saneql::saneqlparser::parser::token::yytokentype>(Y),"incorrect token mapping");
+SQLLEXER_TOKENS(A,B)
+#undef A
+#undef B
+
+#define KEYWORD(A,B,C) static_assert(tokenTable[static_cast<unsigned>(saneql::SaneQLLexer::Token::B)]==saneql::saneqlparser::parser::token::B,"incorrect token mapping");
+#include "parser/Keywords.hpp"
+#undef KEYWORD
+
+// Lexer interface
+static int yylex(saneql::saneqlparser::parser::semantic_type* yylval,saneql::saneqlparser::parser::location_type* yyloc,saneql::ASTContainer& container,saneql::SaneQLLexer& lexer)
+{
+   // Get the next token
+   saneql::SaneQLLexer::TokenInfo info;
+   auto token=lexer.next(info);
+
+   // Construct a token node
+   *yylval=new (container.allocateRaw(sizeof(saneql::ast::Token))) saneql::ast::Token(info);
+
+   // Construct a location
+#define POSITION_COUNTER_TYPE saneql::saneqlparser::position::counter_type
+   *yyloc=saneql::saneqlparser::parser::location_type{saneql::saneqlparser::position{nullptr,1,static_cast<POSITION_COUNTER_TYPE>(lexer.getColumnId(info.content.begin()))},saneql::saneqlparser::position{nullptr,1,static_cast<POSITION_COUNTER_TYPE>(lexer.getColumnId(info.content.end()))}};
+#undef POSITION_COUNTER_TYPE
+
+   // And return the mapped token
+   return tokenTable[static_cast<unsigned>(token)];
+}
+
+namespace saneql {
+
+ast::AST* SaneQLParser::parse(ASTContainer& container,std::string_view input)
+{
+   SaneQLLexer lexer(input);
+   saneqlparser::reportingparser parser(container,lexer);
+   if (parser.parse()!=0) return nullptr;
+   return container.getResult<ast::AST>();
+}
+
+}
+
+#ifdef __clang__
+#pragma clang diagnostic pop
+#endif
@@ -0,0 +1,126 @@
+#include "driver/Analyzer.hpp"
+#include "infra/Schema.hpp"
+#include <algorithm>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <unordered_set>
+//---------------------------------------------------------------------------
+// (c) 2023 Thomas Neumann
+//---------------------------------------------------------------------------
+using namespace std;
+//---------------------------------------------------------------------------
+namespace saneql {
+//---------------------------------------------------------------------------
+namespace {
+//---------------------------------------------------------------------------
+/// The statistics of a column while reading the data
+struct ColumnInfo {
+   /// The type
+   Type type;
+   /// The hashes of the distinct values
+   unordered_set<uint64_t> hashes;
+   /// The number of NULL values
+   uint64_t nullCount = 0;
+   /// The number of non-NULL values
+   uint64_t valueCount = 0;
+   /// The smallest and largest value
+   string minValue, maxValue;
+   /// The sampled values
+   vector<string> sample;
+
+   /// Constructor
+   explicit ColumnInfo(Type type) : type(type) {}
+
+   /// Add a value
+   void add(string_view value, mt19937_64& random);
+   /// Produce the statistics
+   Schema::ColumnStatistics finish(uint64_t rowCount);
+};
+//---------------------------------------------------------------------------
+void ColumnInfo::add(string_view value, mt19937_64& random)
+// Add a value
+{
+   if (value.empty()) {
+      ++nullCount;
+      return;
+   }
+   hashes.insert(hash<string_view>()(value));
+   if ((!valueCount) || Schema::ColumnStatistics::less(type, value, minValue)) minValue = value;
+   if ((!valueCount) || Schema::ColumnStatistics::less(type, maxValue, value)) maxValue = value;
+   ++valueCount;
+
+   // Reservoir sampling
+   if (sample.size() < Analyzer::sampleSize) {
+      sample.emplace_back(value);
+   } else {
+      uint64_t slot = uniform_int_distribution<uint64_t>(0, valueCount - 1)(random);
+      if (slot < Analyzer::sampleSize) sample[slot] = value;
+   }
+}
+//---------------------------------------------------------------------------
+Schema::ColumnStatistics ColumnInfo::finish(uint64_t rowCount)
+// Produce the statistics
+{
+   Schema::ColumnStatistics result;
+   result.distinctValues = hashes.size();
+   result.nullFraction = rowCount ? static_cast<double>(nullCount) / rowCount : 0;
+   if (!valueCount) return result;
+   result.min = minValue;
+   result.max = maxValue;
+
+   // Pick equi-depth bounds from the sorted sample. The outer bounds are the exact extremes
+   sort(sample.begin(), sample.end(), [&](const string& a, const string& b) { return Schema::ColumnStatistics::less(type, a, b); });
+   unsigned buckets = min<uint64_t>(Analyzer::bucketCount, sample.size());
+   for (unsigned index = 0; index <= buckets; ++index)
+      result.histogram.push_back(sample[min<size_t>(index * sample.size() / buckets, sample.size() - 1)]);
+   result.histogram.front() = minValue;
+   result.histogram.back() = maxValue;
+   return result;
+}
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
+void Analyzer::analyze(const string& table, istream& in)
+// Analyze the data of a table and store the statistics in the schema
+{
+   auto definition = schema.lookupTable(table);
+   if (!definition) throw runtime_error("unknown table '" + table + "'");
+   vector<ColumnInfo> columns;
+   for (auto& c : definition->columns)
+      columns.emplace_back(c.type);
+
+   // Use a fixed seed to get reproducible statistics
+   mt19937_64 random(42);
+   string line;
+   uint64_t rowCount = 0;
+   while (getline(in, line)) {
+      ++rowCount;
+      string_view rest = line;
+      // dbgen terminates every row with a delimiter
+      if ((!rest.empty()) && (rest.back() == delimiter)) rest.remove_suffix(1);
+      for (unsigned index = 0; index != columns.size(); ++index) {
+         size_t end = rest.find(delimiter);
+         if ((end != string_view::npos) == (index + 1 == columns.size()))
+            throw runtime_error(table + " row " + to_string(rowCount) + ": expected " + to_string(columns.size()) + " fields");
+         columns[index].add(rest.substr(0, end), random);
+         rest = (end == string_view::npos) ? string_view() : rest.substr(end + 1);
+      }
+   }
+
+   vector<Schema::ColumnStatistics> statistics;
+   for (auto& c : columns)
+      statistics.push_back(c.finish(rowCount));
+   schema.setStatistics(table, rowCount, move(statistics));
+}
+//---------------------------------------------------------------------------
+void Analyzer::analyze(const string& table, const string& file)
+// Analyze the data file of a table
+{
+   ifstream in(file);
+   if (!in.is_open()) throw runtime_error("unable to read " + file);
+   analyze(table, in);
+}
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
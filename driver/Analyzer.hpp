@@ -0,0 +1,44 @@
+#ifndef H_saneql_Analyzer
+#define H_saneql_Analyzer
+//---------------------------------------------------------------------------
+#include <iosfwd>
+#include <string>
+//---------------------------------------------------------------------------
+// SaneQL
+// (c) 2023 Thomas Neumann
+// SPDX-License-Identifier: BSD-3-Clause
+//---------------------------------------------------------------------------
+namespace saneql {
+//---------------------------------------------------------------------------
+class Schema;
+//---------------------------------------------------------------------------
+/// Computes table statistics from local data files. The files contain one row
+/// per line with delimiter separated fields in column order, as produced by the
+/// TPC-H dbgen tool. Empty fields are NULL. Distinct counts are exact, the
+/// histograms are built from a random sample of the values
+class Analyzer {
+   public:
+   /// The number of values per column that are sampled for the histograms
+   static constexpr unsigned sampleSize = 30000;
+   /// The number of histogram buckets
+   static constexpr unsigned bucketCount = 100;
+
+   private:
+   /// The schema
+   Schema& schema;
+   /// The field delimiter
+   char delimiter;
+
+   public:
+   /// Constructor
+   explicit Analyzer(Schema& schema, char delimiter = '|') : schema(schema), delimiter(delimiter) {}
+
+   /// Analyze the data of a table and store the statistics in the schema
+   void analyze(const std::string& table, std::istream& in);
+   /// Analyze the data file of a table
+   void analyze(const std::string& table, const std::string& file);
+};
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
+#endif
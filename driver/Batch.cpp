@@ -0,0 +1,128 @@
+#include "driver/Batch.hpp"
+#include "driver/Compiler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+//---------------------------------------------------------------------------
+// (c) 2023 Thomas Neumann
+//---------------------------------------------------------------------------
+using namespace std;
+//---------------------------------------------------------------------------
+namespace saneql {
+//---------------------------------------------------------------------------
+namespace {
+//---------------------------------------------------------------------------
+/// The result of compiling one file
+struct Result {
+   /// The generated SQL or the error message
+   string output;
+   /// Success?
+   bool ok;
+};
+//---------------------------------------------------------------------------
+static string readFile(const string& file)
+// Read a file
+{
+   ifstream in(file);
+   if (!in.is_open()) throw runtime_error("unable to read " + file);
+   ostringstream output;
+   output << in.rdbuf();
+   output << "\n";
+   return output.str();
+}
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
+BatchCompiler::BatchCompiler(const Schema& schema, unsigned threadCount, CompileCache* cache)
+   : schema(schema), threadCount(threadCount ? threadCount : max(thread::hardware_concurrency(), 1u)), cache(cache)
+// Constructor
+{
+}
+//---------------------------------------------------------------------------
+vector<string> BatchCompiler::collectFiles(const vector<string>& paths)
+// Expand directories into the contained .sane files
+{
+   vector<string> result;
+   for (auto& p : paths) {
+      if (filesystem::is_directory(p)) {
+         vector<string> files;
+         for (auto& e : filesystem::recursive_directory_iterator(p))
+            if (e.is_regular_file() && (e.path().extension() == ".sane"))
+               files.push_back(e.path().string());
+         sort(files.begin(), files.end());
+         result.insert(result.end(), files.begin(), files.end());
+      } else {
+         result.push_back(p);
+      }
+   }
+   return result;
+}
+//---------------------------------------------------------------------------
+unsigned BatchCompiler::compile(const vector<string>& files, ostream& out, ostream& err)
+// Compile all files, writing the results in input order
+{
+   vector<optional<Result>> results(files.size());
+   atomic<size_t> nextFile{0};
+   mutex resultLock;
+   condition_variable resultReady;
+
+   // Compile the files in parallel
+   auto worker = [&]() {
+      Compiler compiler(schema);
+      compiler.setCache(cache);
+      compiler.setMaterializeCTEs(materializeCTEs);
+      compiler.setFlatSQL(flatSQL);
+      while (true) {
+         size_t index = nextFile++;
+         if (index >= files.size()) break;
+         Result result;
+         try {
+            auto query = readFile(files[index]);
+            result = {placeholderStyle ? compiler.compileParameterized(query, *placeholderStyle).toString() : compiler.compile(query), true};
+         } catch (const exception& e) {
+            result = {e.what(), false};
+         }
+         unique_lock lock(resultLock);
+         results[index] = move(result);
+         resultReady.notify_one();
+      }
+   };
+   vector<thread> threads;
+   for (unsigned index = 0, limit = min<size_t>(threadCount, files.size()); index != limit; ++index)
+      threads.emplace_back(worker);
+
+   // Write the results in order as soon as they become available
+   unsigned failed = 0;
+   for (size_t index = 0; index != files.size(); ++index) {
+      Result result;
+      {
+         unique_lock lock(resultLock);
+         resultReady.wait(lock, [&]() { return results[index].has_value(); });
+         result = move(*results[index]);
+         results[index].reset();
+      }
+      if (result.ok) {
+         out << "-- " << files[index] << "\n"
+             << result.output << "\n";
+      } else {
+         err << files[index] << ": " << result.output << "\n";
+         ++failed;
+      }
+   }
+   out.flush();
+
+   for (auto& t : threads)
+      t.join();
+   return failed;
+}
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
@@ -0,0 +1,57 @@
+#ifndef H_saneql_Batch
+#define H_saneql_Batch
+//---------------------------------------------------------------------------
+#include "sql/SQLWriter.hpp"
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <vector>
+//---------------------------------------------------------------------------
+// SaneQL
+// (c) 2023 Thomas Neumann
+// SPDX-License-Identifier: BSD-3-Clause
+//---------------------------------------------------------------------------
+namespace saneql {
+//---------------------------------------------------------------------------
+class CompileCache;
+class Schema;
+//---------------------------------------------------------------------------
+/// Compiles many query files in parallel against one shared schema.
+/// Every worker thread uses its own Compiler instance, the schema, the
+/// function tables, and the keyword table are read-only and thus shared.
+class BatchCompiler {
+   private:
+   /// The schema
+   const Schema& schema;
+   /// The number of worker threads
+   unsigned threadCount;
+   /// The shared compile cache (if any)
+   CompileCache* cache;
+   /// The placeholder style if literals are lifted into parameters
+   std::optional<SQLWriter::PlaceholderStyle> placeholderStyle;
+   /// Evaluate shared lets only once?
+   bool materializeCTEs = false;
+   /// Merge operators into few SELECT blocks?
+   bool flatSQL = false;
+
+   public:
+   /// Constructor. A thread count of 0 uses all available cores
+   BatchCompiler(const Schema& schema, unsigned threadCount, CompileCache* cache = nullptr);
+
+   /// Lift literals into parameters
+   void setPlaceholderStyle(SQLWriter::PlaceholderStyle style) { placeholderStyle = style; }
+   /// Evaluate shared lets only once
+   void setMaterializeCTEs(bool materialize) { materializeCTEs = materialize; }
+   /// Merge operators into few SELECT blocks
+   void setFlatSQL(bool flat) { flatSQL = flat; }
+
+   /// Expand directories into the contained .sane files
+   static std::vector<std::string> collectFiles(const std::vector<std::string>& paths);
+
+   /// Compile all files, writing the results in input order. Returns the number of failed queries
+   unsigned compile(const std::vector<std::string>& files, std::ostream& out, std::ostream& err);
+};
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
+#endif
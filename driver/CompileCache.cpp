@@ -0,0 +1,179 @@
+#include "driver/CompileCache.hpp"
+#include "parser/ASTBase.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+//---------------------------------------------------------------------------
+// (c) 2023 Thomas Neumann
+//---------------------------------------------------------------------------
+using namespace std;
+//---------------------------------------------------------------------------
+namespace saneql {
+//---------------------------------------------------------------------------
+/// The header of disk cache entries
+static constexpr string_view diskHeader = "saneql-cache 5\n";
+//---------------------------------------------------------------------------
+CompileCache::CompileCache(size_t capacity, string directory)
+   : capacity(max<size_t>(capacity, 1)), directory(move(directory))
+// Constructor
+{
+   if (!this->directory.empty()) filesystem::create_directories(this->directory);
+}
+//---------------------------------------------------------------------------
+CompileCache::~CompileCache()
+// Destructor
+{
+}
+//---------------------------------------------------------------------------
+uint64_t CompileCache::computeKey(const ASTBase* tree, uint64_t schemaVersion, string_view variant)
+// Compute the cache key
+{
+   return tree->getHash() ^ (schemaVersion * 0x9E3779B97F4A7C15ull) ^ (hash<string_view>()(variant) * 0xC2B2AE3D27D4EB4Full);
+}
+//---------------------------------------------------------------------------
+void CompileCache::createEntry(Entry&& entry)
+// Construct an in-memory entry
+{
+   entries.push_front(move(entry));
+   lookupTable.emplace(entries.front().key, entries.begin());
+
+   // Evict the least recently used entry if needed
+   if (entries.size() > capacity) {
+      auto victim = prev(entries.end());
+      auto range = lookupTable.equal_range(victim->key);
+      for (auto iter = range.first; iter != range.second; ++iter)
+         if (iter->second == victim) {
+            lookupTable.erase(iter);
+            break;
+         }
+      entries.pop_back();
+   }
+}
+//---------------------------------------------------------------------------
+string CompileCache::getFileName(uint64_t key) const
+// Get the file name of a disk entry
+{
+   char name[32];
+   snprintf(name, sizeof(name), "%016llx.sqlcache", static_cast<unsigned long long>(key));
+   return directory + "/" + name;
+}
+//---------------------------------------------------------------------------
+optional<CompileCache::Entry> CompileCache::lookupDisk(uint64_t key, uint64_t schemaVersion, string_view variant, const string& shape) const
+// Lookup a query in the disk cache
+{
+   ifstream in(getFileName(key), ios::binary);
+   if (!in.is_open()) return {};
+   ostringstream buffer;
+   buffer << in.rdbuf();
+   string content = buffer.str();
+
+   // Check the header
+   string_view reader = content;
+   if (!reader.starts_with(diskHeader)) return {};
+   reader.remove_prefix(diskHeader.size());
+   auto readLine = [&reader]() -> optional<string_view> {
+      auto end = reader.find('\n');
+      if (end == string_view::npos) return {};
+      auto result = reader.substr(0, end);
+      reader.remove_prefix(end + 1);
+      return result;
+   };
+   auto readNumber = [&readLine]() -> optional<uint64_t> {
+      auto line = readLine();
+      if ((!line) || line->empty()) return {};
+      uint64_t result = 0;
+      for (char c : *line) {
+         if ((c < '0') || (c > '9')) return {};
+         result = result * 10 + (c - '0');
+      }
+      return result;
+   };
+   auto version = readNumber();
+   auto storedVariant = readLine();
+   auto shapeSize = readNumber(), placeholderCount = readNumber();
+   if ((!version) || (!storedVariant) || (!shapeSize) || (!placeholderCount) || (*version != schemaVersion) || (*storedVariant != variant) || (*shapeSize > reader.size())) return {};
+   Entry e{key, schemaVersion, string(variant), {}, {}};
+   for (uint64_t index = 0; index != *placeholderCount; ++index) {
+      auto slot = readNumber();
+      if (!slot) return {};
+      e.result.placeholders.push_back(*slot);
+   }
+
+   // Verify the query
+   if (reader.substr(0, *shapeSize) != shape) return {};
+   e.shape = shape;
+   e.result.sql = reader.substr(*shapeSize);
+   return e;
+}
+//---------------------------------------------------------------------------
+void CompileCache::writeDisk(const Entry& entry)
+// Write an entry to the disk cache
+{
+   // Write to a temporary file first to never expose partial entries
+   auto fileName = getFileName(entry.key);
+   auto tempName = fileName + "." + to_string(getpid()) + "." + to_string(diskWrites++);
+   {
+      ofstream out(tempName, ios::binary);
+      if (!out.is_open()) return;
+      out << diskHeader << entry.schemaVersion << "\n"
+          << entry.variant << "\n"
+          << entry.shape.size() << "\n"
+          << entry.result.placeholders.size() << "\n";
+      for (auto slot : entry.result.placeholders)
+         out << slot << "\n";
+      out << entry.shape << entry.result.sql;
+      if (!out.good()) {
+         out.close();
+         filesystem::remove(tempName);
+         return;
+      }
+   }
+   error_code ec;
+   filesystem::rename(tempName, fileName, ec);
+   if (ec) filesystem::remove(tempName, ec);
+}
+//---------------------------------------------------------------------------
+optional<CompileCache::Result> CompileCache::lookup(const ASTBase* tree, uint64_t schemaVersion, string_view variant)
+// Lookup a query
+{
+   uint64_t key = computeKey(tree, schemaVersion, variant);
+   string shape;
+   {
+      unique_lock lock(latch);
+      auto range = lookupTable.equal_range(key);
+      for (auto iter = range.first; iter != range.second; ++iter) {
+         auto e = iter->second;
+         if ((e->schemaVersion != schemaVersion) || (e->variant != variant)) continue;
+         if (shape.empty()) tree->serialize(shape);
+         if (e->shape == shape) {
+            entries.splice(entries.begin(), entries, e);
+            return e->result;
+         }
+      }
+   }
+   if (directory.empty()) return {};
+
+   // Read the disk entry without holding the latch and remember it in memory
+   if (shape.empty()) tree->serialize(shape);
+   auto e = lookupDisk(key, schemaVersion, variant, shape);
+   if (!e) return {};
+   Result result = e->result;
+   unique_lock lock(latch);
+   createEntry(move(*e));
+   return result;
+}
+//---------------------------------------------------------------------------
+void CompileCache::insert(const ASTBase* tree, uint64_t schemaVersion, string_view variant, Result result)
+// Remember the result for a query
+{
+   Entry e{computeKey(tree, schemaVersion, variant), schemaVersion, string(variant), {}, move(result)};
+   tree->serialize(e.shape);
+   if (!directory.empty()) writeDisk(e);
+   unique_lock lock(latch);
+   createEntry(move(e));
+}
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
@@ -0,0 +1,90 @@
+#ifndef H_saneql_CompileCache
+#define H_saneql_CompileCache
+//---------------------------------------------------------------------------
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+//---------------------------------------------------------------------------
+// SaneQL
+// (c) 2023 Thomas Neumann
+// SPDX-License-Identifier: BSD-3-Clause
+//---------------------------------------------------------------------------
+namespace saneql {
+//---------------------------------------------------------------------------
+class ASTBase;
+//---------------------------------------------------------------------------
+/// A cache that maps queries to their generated SQL. Entries are keyed by
+/// the structural AST hash, the schema version, and a variant string that
+/// describes the compilation mode. Hits are verified with the canonical
+/// AST representation. Keeps an LRU bounded in-memory cache and an
+/// optional on-disk cache directory. Can be shared between threads.
+class CompileCache {
+   public:
+   /// A cached compilation result
+   struct Result {
+      /// The generated SQL
+      std::string sql;
+      /// The parameters in the order their placeholders appear in the SQL
+      std::vector<unsigned> placeholders;
+   };
+
+   private:
+   /// A cache entry
+   struct Entry {
+      /// The key
+      uint64_t key;
+      /// The schema version
+      uint64_t schemaVersion;
+      /// The variant
+      std::string variant;
+      /// The canonical AST representation
+      std::string shape;
+      /// The result
+      Result result;
+   };
+
+   /// The maximum number of in-memory entries
+   size_t capacity;
+   /// The cache directory (if any)
+   std::string directory;
+   /// The entries in LRU order, most recently used first
+   std::list<Entry> entries;
+   /// The lookup table
+   std::unordered_multimap<uint64_t, std::list<Entry>::iterator> lookupTable;
+   /// The latch. Protects the in-memory entries, disk accesses happen outside
+   std::mutex latch;
+   /// The number of disk writes, used for unique temporary file names
+   std::atomic<uint64_t> diskWrites = 0;
+
+   /// Compute the cache key
+   static uint64_t computeKey(const ASTBase* tree, uint64_t schemaVersion, std::string_view variant);
+   /// Construct an in-memory entry
+   void createEntry(Entry&& entry);
+   /// Get the file name of a disk entry
+   std::string getFileName(uint64_t key) const;
+   /// Lookup a query in the disk cache
+   std::optional<Entry> lookupDisk(uint64_t key, uint64_t schemaVersion, std::string_view variant, const std::string& shape) const;
+   /// Write an entry to the disk cache
+   void writeDisk(const Entry& entry);
+
+   public:
+   /// Constructor
+   explicit CompileCache(size_t capacity, std::string directory = {});
+   /// Destructor
+   ~CompileCache();
+
+   /// Lookup a query
+   std::optional<Result> lookup(const ASTBase* tree, uint64_t schemaVersion, std::string_view variant = {});
+   /// Remember the result for a query
+   void insert(const ASTBase* tree, uint64_t schemaVersion, std::string_view variant, Result result);
+};
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
+#endif
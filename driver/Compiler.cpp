@@ -0,0 +1,241 @@
+#include "driver/Compiler.hpp"
+#include "algebra/Operator.hpp"
+#include "algebra/Optimizer.hpp"
+#include "driver/CompileCache.hpp"
+#include "infra/Schema.hpp"
+#include "parser/AST.hpp"
+#include "parser/SaneQLParser.hpp"
+#include "semana/LiteralLifting.hpp"
+#include <algorithm>
+#include <ostream>
+#include <stdexcept>
+//---------------------------------------------------------------------------
+// (c) 2023 Thomas Neumann
+//---------------------------------------------------------------------------
+using namespace std;
+//---------------------------------------------------------------------------
+namespace saneql {
+//---------------------------------------------------------------------------
+void Compiler::setupWriter(SQLWriter& sql) const
+// Prepare a SQL writer
+{
+   sql.setMaterializeCTEs(materializeCTEs);
+   sql.setFlatSQL(flatSQL);
+}
+//---------------------------------------------------------------------------
+static bool hasSharedCTEs(SemanticAnalysis::ExpressionResult& res)
+// Does the query reference a CTE more than once?
+{
+   algebra::IUUsage usage;
+   if (res.isScalar())
+      res.scalar()->collectUsage(usage);
+   else
+      res.table()->collectUsage(usage);
+   return any_of(usage.ctes.begin(), usage.ctes.end(), [](const algebra::CTE* cte) { return cte->useCount > 1; });
+}
+//---------------------------------------------------------------------------
+string Compiler::getVariant() const
+// Get the cache variant for the generation options
+{
+   string variant;
+   if (materializeCTEs) variant += 'm';
+   if (flatSQL) variant += 'f';
+   return variant;
+}
+//---------------------------------------------------------------------------
+string Compiler::compile(string_view query)
+// Compile a query into SQL. Throws on errors
+{
+   // Parse the query, reusing the memory of previous queries
+   container.reset();
+   auto tree = SaneQLParser::parse(container, query);
+   if (!tree) throw runtime_error("syntax error");
+
+   // Did we see the query before?
+   string variant = getVariant();
+   if (cache)
+      if (auto cached = cache->lookup(tree, schema.getVersion(), variant)) return move(cached->sql);
+
+   // Analyze it
+   SemanticAnalysis semana(schema);
+   auto res = semana.analyzeQuery(tree);
+   optimizeQuery(res);
+
+   // And generate SQL
+   SQLWriter sql;
+   setupWriter(sql);
+   generateQuery(sql, res);
+   auto result = move(sql).getResult();
+   if (cache) cache->insert(tree, schema.getVersion(), variant, {result, {}});
+   return result;
+}
+//---------------------------------------------------------------------------
+void Compiler::compile(string_view query, ostream& out)
+// Compile a query into SQL and write it to a stream. Throws on errors
+{
+   // The cache needs the complete SQL text
+   if (cache) {
+      auto sql = compile(query);
+      out.write(sql.data(), sql.size());
+      return;
+   }
+
+   container.reset();
+   auto tree = SaneQLParser::parse(container, query);
+   if (!tree) throw runtime_error("syntax error");
+   SemanticAnalysis semana(schema);
+   auto res = semana.analyzeQuery(tree);
+   optimizeQuery(res);
+
+   // Shared CTEs can be referenced first at any point, their definitions must precede the result
+   if (hasSharedCTEs(res)) {
+      SQLWriter sql;
+      setupWriter(sql);
+      generateQuery(sql, res);
+      sql.writeResult(out);
+      return;
+   }
+
+   // Stream the SQL while generating it
+   SQLWriter sql(out);
+   setupWriter(sql);
+   generateQuery(sql, res);
+   sql.finish();
+}
+//---------------------------------------------------------------------------
+Compiler::ParameterizedQuery Compiler::compileParameterized(string_view query, SQLWriter::PlaceholderStyle style)
+// Compile a query into SQL with placeholders instead of literals
+{
+   // Parse the query and lift the literals
+   container.reset();
+   auto tree = SaneQLParser::parse(container, query);
+   if (!tree) throw runtime_error("syntax error");
+   vector<LiteralLifting::Literal> literals;
+   auto lifted = LiteralLifting::lift(container, tree, literals);
+
+   // The parameter types, the placeholder style, and the CTE mode are part of the cache key
+   vector<Type> types;
+   string variant = getVariant();
+   variant += (style == SQLWriter::PlaceholderStyle::Numbered) ? "$" : "?";
+   for (auto& l : literals) {
+      types.push_back(l.type);
+      variant += " " + l.type.getName() + to_string(l.type.getLength());
+   }
+
+   // Compile the lifted query if we did not see it before
+   optional<CompileCache::Result> compiled;
+   if (cache) compiled = cache->lookup(lifted, schema.getVersion(), variant);
+   if (!compiled) {
+      try {
+         SemanticAnalysis semana(schema);
+         semana.setParameterTypes(move(types));
+         auto res = semana.analyzeQuery(lifted);
+         optimizeQuery(res);
+         SQLWriter sql;
+         sql.setPlaceholderStyle(style);
+         setupWriter(sql);
+         generateQuery(sql, res);
+         compiled = CompileCache::Result{move(sql).getResult(), sql.getPlaceholders()};
+      } catch (const exception&) {
+         // A literal was used where a constant is required, for example through a let argument. Compile without lifting
+         return {compile(query), {}};
+      }
+      if (cache) cache->insert(lifted, schema.getVersion(), variant, *compiled);
+   }
+
+   // Collect the bindings. Explicit parameters of the query are bound by the caller
+   ParameterizedQuery result{move(compiled->sql), {}};
+   if (literals.empty()) {
+      return result;
+   } else if (style == SQLWriter::PlaceholderStyle::Numbered) {
+      for (auto& l : literals)
+         result.bindings.push_back(move(l.value));
+   } else {
+      for (auto slot : compiled->placeholders)
+         result.bindings.push_back(literals[slot].value);
+   }
+   return result;
+}
+//---------------------------------------------------------------------------
+string Compiler::ParameterizedQuery::toString() const
+// Format as SQL text followed by a comment line per binding
+{
+   SQLWriter out;
+   out.write(sql);
+   for (unsigned index = 0; index != bindings.size(); ++index) {
+      out.write("\n-- " + to_string(index + 1) + ": ");
+      out.writeString(bindings[index]);
+   }
+   return move(out).getResult();
+}
+//---------------------------------------------------------------------------
+void Compiler::optimizeQuery(SemanticAnalysis::ExpressionResult& res)
+// Optimize an analyzed query
+{
+   // Rewrite the operator trees and remove the columns that the query does not need
+   auto optimizer = algebra::Optimizer::createDefault();
+   if (res.isScalar()) {
+      optimizer.optimize(*res.scalar());
+      algebra::Operator::pruneColumns(*res.scalar());
+   } else {
+      vector<const algebra::IU*> output;
+      for (auto& c : res.getBinding().getColumns())
+         output.push_back(c.iu);
+      optimizer.optimize(res.table(), output);
+      algebra::Operator::pruneColumns(*res.table(), output);
+   }
+}
+//---------------------------------------------------------------------------
+void Compiler::generateQuery(SQLWriter& sql, SemanticAnalysis::ExpressionResult& res)
+// Generate the SQL for an analyzed query
+{
+   if (res.isScalar()) {
+      sql.write("select ");
+      res.scalar()->generate(sql);
+   } else if (sql.isFlatSQL()) {
+      vector<pair<string, const algebra::IU*>> columns;
+      for (auto& c : res.getBinding().getColumns())
+         columns.emplace_back(c.name, c.iu);
+      algebra::SelectBlock block;
+      res.table()->generateBlock(sql, block);
+      block.writeQuery(sql, columns);
+   } else {
+      algebra::Sort* sort = nullptr;
+      auto tree = res.table().get();
+      if (auto s = dynamic_cast<algebra::Sort*>(tree)) {
+         sort = s;
+         tree = sort->input.get();
+      }
+      sql.write("select ");
+      bool first = true;
+      for (auto& c : res.getBinding().getColumns()) {
+         if (first)
+            first = false;
+         else
+            sql.write(", ");
+         sql.writeIU(c.iu);
+         sql.write(" as ");
+         sql.writeIdentifier(c.name);
+      }
+      sql.write(" from ");
+      tree->generate(sql);
+      sql.write(" s");
+      if (sort) {
+         if (!sort->order.empty()) {
+            sql.write(" order by ");
+            algebra::Sort::generateOrder(sql, sort->order);
+         }
+         if (sort->limit.has_value()) {
+            sql.write(" limit ");
+            sql.write(to_string(*(sort->limit)));
+         }
+         if (sort->offset.has_value()) {
+            sql.write(" offset ");
+            sql.write(to_string(*(sort->offset)));
+         }
+      }
+   }
+}
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
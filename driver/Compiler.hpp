@@ -0,0 +1,77 @@
+#ifndef H_saneql_Compiler
+#define H_saneql_Compiler
+//---------------------------------------------------------------------------
+#include "parser/ASTBase.hpp"
+#include "semana/SemanticAnalysis.hpp"
+#include "sql/SQLWriter.hpp"
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+//---------------------------------------------------------------------------
+// SaneQL
+// (c) 2023 Thomas Neumann
+// SPDX-License-Identifier: BSD-3-Clause
+//---------------------------------------------------------------------------
+namespace saneql {
+//---------------------------------------------------------------------------
+class CompileCache;
+class Schema;
+//---------------------------------------------------------------------------
+/// The compilation pipeline from SaneQL text to SQL text
+class Compiler {
+   private:
+   /// The schema
+   const Schema& schema;
+   /// The AST container. Reused between queries
+   ASTContainer container;
+   /// The compile cache (if any)
+   CompileCache* cache = nullptr;
+   /// Emit shared lets as materialized CTEs?
+   bool materializeCTEs = false;
+   /// Generate flat SQL?
+   bool flatSQL = false;
+
+   /// Prepare a SQL writer
+   void setupWriter(SQLWriter& sql) const;
+   /// Get the cache variant for the generation options
+   std::string getVariant() const;
+
+   public:
+   /// A query with lifted literals
+   struct ParameterizedQuery {
+      /// The SQL text with placeholders
+      std::string sql;
+      /// The values to bind. One entry per parameter for numbered placeholders, one entry per placeholder otherwise
+      std::vector<std::string> bindings;
+
+      /// Format as SQL text followed by a comment line per binding
+      std::string toString() const;
+   };
+
+   /// Constructor
+   explicit Compiler(const Schema& schema) : schema(schema) {}
+
+   /// Use a compile cache
+   void setCache(CompileCache* newCache) { cache = newCache; }
+   /// Emit lets that are referenced multiple times as materialized CTEs
+   void setMaterializeCTEs(bool materialize) { materializeCTEs = materialize; }
+   /// Merge consecutive operators into as few SELECT blocks as possible
+   void setFlatSQL(bool flat) { flatSQL = flat; }
+
+   /// Compile a query into SQL. Throws on errors
+   std::string compile(std::string_view query);
+   /// Compile a query into SQL and write it to a stream. Streams the SQL while generating it if no cache is used. Throws on errors
+   void compile(std::string_view query, std::ostream& out);
+   /// Compile a query into SQL with placeholders instead of literals. Queries that only differ in their literals share the same SQL. Throws on errors
+   ParameterizedQuery compileParameterized(std::string_view query, SQLWriter::PlaceholderStyle style);
+
+   /// Optimize an analyzed query. Rewrites the operator trees and removes unused columns
+   static void optimizeQuery(SemanticAnalysis::ExpressionResult& res);
+   /// Generate the SQL for an analyzed query
+   static void generateQuery(SQLWriter& out, SemanticAnalysis::ExpressionResult& res);
+};
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
+#endif
@@ -0,0 +1,61 @@
+#include "driver/PreparedQuery.hpp"
+#include "algebra/Expression.hpp"
+#include "algebra/Operator.hpp"
+#include "driver/Compiler.hpp"
+#include "parser/AST.hpp"
+#include "parser/SaneQLParser.hpp"
+#include <stdexcept>
+//---------------------------------------------------------------------------
+// (c) 2023 Thomas Neumann
+//---------------------------------------------------------------------------
+using namespace std;
+//---------------------------------------------------------------------------
+namespace saneql {
+//---------------------------------------------------------------------------
+PreparedQuery::PreparedQuery(const Schema& schema, string query, vector<Type> parameterTypes)
+   : query(move(query))
+// Constructor
+{
+   auto tree = SaneQLParser::parse(container, this->query);
+   if (!tree) throw runtime_error("syntax error");
+
+   semana = make_unique<SemanticAnalysis>(schema);
+   semana->setParameterTypes(move(parameterTypes));
+   result = make_unique<SemanticAnalysis::ExpressionResult>(semana->analyzeQuery(tree));
+   Compiler::optimizeQuery(*result);
+}
+//---------------------------------------------------------------------------
+PreparedQuery::~PreparedQuery()
+// Destructor
+{
+}
+//---------------------------------------------------------------------------
+string PreparedQuery::generate(SQLWriter::PlaceholderStyle style) const
+// Generate SQL with placeholders
+{
+   SQLWriter sql;
+   sql.setPlaceholderStyle(style);
+   Compiler::generateQuery(sql, *result);
+   return move(sql).getResult();
+}
+//---------------------------------------------------------------------------
+string PreparedQuery::generate(const vector<optional<string>>& values) const
+// Generate SQL with the parameter values embedded
+{
+   if (values.size() != getParameterTypes().size()) throw runtime_error("expected " + to_string(getParameterTypes().size()) + " parameter values, got " + to_string(values.size()));
+   SQLWriter sql;
+   sql.setParameterValues(&values);
+   Compiler::generateQuery(sql, *result);
+   return move(sql).getResult();
+}
+//---------------------------------------------------------------------------
+execution::Result PreparedQuery::execute(execution::Database& database, const vector<optional<string>>& values, unsigned threadCount, execution::NativeCompiler* compiler) const
+// Execute the query on the data of a database
+{
+   if (values.size() > getParameterTypes().size()) throw runtime_error("expected " + to_string(getParameterTypes().size()) + " parameter values, got " + to_string(values.size()));
+   execution::Executor executor(database, threadCount, compiler);
+   return executor.execute(*result, values);
+}
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
@@ -0,0 +1,59 @@
+#ifndef H_saneql_PreparedQuery
+#define H_saneql_PreparedQuery
+//---------------------------------------------------------------------------
+#include "execution/Executor.hpp"
+#include "parser/ASTBase.hpp"
+#include "semana/SemanticAnalysis.hpp"
+#include "sql/SQLWriter.hpp"
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+//---------------------------------------------------------------------------
+// SaneQL
+// (c) 2023 Thomas Neumann
+// SPDX-License-Identifier: BSD-3-Clause
+//---------------------------------------------------------------------------
+namespace saneql {
+//---------------------------------------------------------------------------
+class Schema;
+namespace execution {
+class Database;
+}
+//---------------------------------------------------------------------------
+/// A query with parameters ($1, $2, ...) that is parsed and analyzed once.
+/// Parameter types are declared by the caller or by casts within the query
+/// ($1::integer). The analyzed query can then generate SQL repeatedly, either
+/// with placeholders or with bound parameter values.
+class PreparedQuery {
+   private:
+   /// The query text. The AST references it
+   std::string query;
+   /// The AST container
+   ASTContainer container;
+   /// The semantic analysis. Kept alive as long as the analyzed query
+   std::unique_ptr<SemanticAnalysis> semana;
+   /// The analyzed query
+   std::unique_ptr<SemanticAnalysis::ExpressionResult> result;
+
+   public:
+   /// Constructor. Parses and analyzes the query, throws on errors
+   PreparedQuery(const Schema& schema, std::string query, std::vector<Type> parameterTypes = {});
+   /// Destructor
+   ~PreparedQuery();
+
+   /// Get the parameter types. Parameters that are not used by the query have the unknown type
+   const std::vector<Type>& getParameterTypes() const { return semana->getParameterTypes(); }
+
+   /// Generate SQL with placeholders
+   std::string generate(SQLWriter::PlaceholderStyle style = SQLWriter::PlaceholderStyle::Numbered) const;
+   /// Generate SQL with the parameter values embedded. A missing value is NULL
+   std::string generate(const std::vector<std::optional<std::string>>& values) const;
+   /// Execute the query on the data of a database. A missing value is NULL, a thread count of 0 uses all available cores. Aggregations over table scans are compiled if a compiler is given
+   execution::Result execute(execution::Database& database, const std::vector<std::optional<std::string>>& values = {}, unsigned threadCount = 0, execution::NativeCompiler* compiler = nullptr) const;
+};
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
+#endif
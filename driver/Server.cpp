@@ -0,0 +1,186 @@
+#include "driver/Server.hpp"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+//---------------------------------------------------------------------------
+// (c) 2023 Thomas Neumann
+//---------------------------------------------------------------------------
+using namespace std;
+//---------------------------------------------------------------------------
+namespace saneql {
+//---------------------------------------------------------------------------
+/// The pending output size at which a client is no longer read from until it accepted the output
+static constexpr size_t maxPendingOutput = 1 << 20;
+/// The maximum size of an incomplete request. Clients exceeding it are disconnected
+static constexpr size_t maxPendingInput = 16 << 20;
+//---------------------------------------------------------------------------
+static bool setNonBlocking(int fd)
+// Make a socket non-blocking
+{
+   int flags = ::fcntl(fd, F_GETFL);
+   return (flags >= 0) && (::fcntl(fd, F_SETFL, flags | O_NONBLOCK) >= 0);
+}
+//---------------------------------------------------------------------------
+static bool wouldBlock()
+// Did the last socket operation fail only because it would block?
+{
+   return (errno == EINTR) || (errno == EAGAIN) || (errno == EWOULDBLOCK);
+}
+//---------------------------------------------------------------------------
+Server::Server(const Schema& schema, string socketPath, CompileCache* cache)
+   : socketPath(move(socketPath)), compiler(schema)
+// Constructor
+{
+   compiler.setCache(cache);
+}
+//---------------------------------------------------------------------------
+Server::~Server()
+// Destructor
+{
+   for (auto& c : clients)
+      ::close(c.first);
+   if (listenFd >= 0) {
+      ::close(listenFd);
+      ::unlink(socketPath.c_str());
+   }
+}
+//---------------------------------------------------------------------------
+void Server::acceptClient()
+// Accept a new client
+{
+   int fd = ::accept(listenFd, nullptr, nullptr);
+   if (fd < 0) return;
+   if (!setNonBlocking(fd)) {
+      ::close(fd);
+      return;
+   }
+   clients[fd];
+}
+//---------------------------------------------------------------------------
+bool Server::readClient(int fd, Client& client)
+// Read from a client. Returns false if the connection is closed
+{
+   char buffer[64 << 10];
+   auto got = ::recv(fd, buffer, sizeof(buffer), 0);
+   if (got < 0) return wouldBlock();
+   if (got == 0) return false;
+   client.input.append(buffer, got);
+
+   // Process all complete requests
+   size_t start = 0;
+   while (true) {
+      auto end = client.input.find('\0', start);
+      if (end == string::npos) break;
+      client.output += handleRequest(string_view(client.input).substr(start, end - start));
+      start = end + 1;
+   }
+   client.input.erase(0, start);
+   if (client.input.size() > maxPendingInput) return false;
+
+   // Send as much as possible right away, the rest is sent once the socket is writable
+   return writeClient(fd, client);
+}
+//---------------------------------------------------------------------------
+bool Server::writeClient(int fd, Client& client)
+// Send pending output to a client. Returns false if the connection is closed
+{
+   size_t sent = 0;
+   while (sent < client.output.size()) {
+      auto written = ::send(fd, client.output.data() + sent, client.output.size() - sent, MSG_NOSIGNAL);
+      if (written < 0) {
+         if (errno == EINTR) continue;
+         if (wouldBlock()) break;
+         return false;
+      }
+      sent += written;
+   }
+   client.output.erase(0, sent);
+   return true;
+}
+//---------------------------------------------------------------------------
+string Server::handleRequest(string_view query)
+// Handle a single request
+{
+   auto start = chrono::steady_clock::now();
+   string result;
+   bool ok = true;
+   try {
+      if (placeholderStyle)
+         result = compiler.compileParameterized(query, *placeholderStyle).toString();
+      else
+         result = compiler.compile(query);
+   } catch (const exception& e) {
+      result = e.what();
+      ok = false;
+   }
+   auto latency = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+   ++requestCount;
+   totalLatency += latency;
+
+   string response = ok ? "ok " : "error ";
+   response += to_string(latency);
+   response += '\n';
+   response += result;
+   response += '\0';
+   return response;
+}
+//---------------------------------------------------------------------------
+void Server::run()
+// Run the server loop
+{
+   // Create the socket
+   sockaddr_un addr{};
+   addr.sun_family = AF_UNIX;
+   if (socketPath.size() >= sizeof(addr.sun_path)) throw runtime_error("socket path too long");
+   memcpy(addr.sun_path, socketPath.data(), socketPath.size());
+   listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+   if ((listenFd < 0) || (!setNonBlocking(listenFd))) throw runtime_error("unable to create socket");
+   ::unlink(socketPath.c_str());
+   if (::bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) throw runtime_error("unable to bind to '" + socketPath + "'");
+   if (::listen(listenFd, 128) < 0) throw runtime_error("unable to listen on '" + socketPath + "'");
+   cerr << "listening on " << socketPath << endl;
+
+   // And serve requests
+   vector<pollfd> fds;
+   while (true) {
+      fds.clear();
+      fds.push_back({listenFd, POLLIN, 0});
+      for (auto& c : clients) {
+         // Clients that do not accept their responses are not read from
+         short events = (c.second.output.size() < maxPendingOutput) ? POLLIN : 0;
+         if (!c.second.output.empty()) events |= POLLOUT;
+         fds.push_back({c.first, events, 0});
+      }
+      if (::poll(fds.data(), fds.size(), -1) < 0) {
+         if (errno == EINTR) continue;
+         throw runtime_error("poll failed");
+      }
+
+      for (auto& p : fds) {
+         if (!p.revents) continue;
+         if (p.fd == listenFd) {
+            acceptClient();
+            continue;
+         }
+         auto& client = clients[p.fd];
+         bool open = true;
+         if (p.revents & POLLOUT) open = writeClient(p.fd, client);
+         if (open && (p.revents & (POLLIN | POLLHUP | POLLERR))) open = readClient(p.fd, client);
+         if (!open) {
+            ::close(p.fd);
+            clients.erase(p.fd);
+            if (requestCount) cerr << requestCount << " requests, average latency " << (totalLatency / requestCount) << "us" << endl;
+         }
+      }
+   }
+}
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
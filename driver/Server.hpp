@@ -0,0 +1,78 @@
+#ifndef H_saneql_Server
+#define H_saneql_Server
+//---------------------------------------------------------------------------
+#include "driver/Compiler.hpp"
+#include <optional>
+#include <string>
+#include <unordered_map>
+//---------------------------------------------------------------------------
+// SaneQL
+// (c) 2023 Thomas Neumann
+// SPDX-License-Identifier: BSD-3-Clause
+//---------------------------------------------------------------------------
+namespace saneql {
+//---------------------------------------------------------------------------
+class CompileCache;
+class Schema;
+//---------------------------------------------------------------------------
+/// A long running compile server listening on a Unix domain socket.
+/// A request is the query text terminated by a NUL byte. The response is a
+/// header line "ok <microseconds>" or "error <microseconds>", followed by the
+/// generated SQL or the error message, again terminated by a NUL byte.
+/// Clients can send any number of requests over one connection. All sockets
+/// are non-blocking, responses are buffered until the client accepts them.
+/// Connections that send more than 16MB without completing a request are closed.
+class Server {
+   private:
+   /// A client connection
+   struct Client {
+      /// The pending input
+      std::string input;
+      /// The pending output
+      std::string output;
+   };
+
+   /// The socket path
+   std::string socketPath;
+   /// The compiler. Keeps the schema and the AST memory warm between requests
+   Compiler compiler;
+   /// The placeholder style if literals are lifted into parameters
+   std::optional<SQLWriter::PlaceholderStyle> placeholderStyle;
+   /// The listening socket
+   int listenFd = -1;
+   /// The connected clients
+   std::unordered_map<int, Client> clients;
+   /// The number of processed requests
+   uint64_t requestCount = 0;
+   /// The accumulated latency in microseconds
+   uint64_t totalLatency = 0;
+
+   /// Accept a new client
+   void acceptClient();
+   /// Read from a client. Returns false if the connection is closed
+   bool readClient(int fd, Client& client);
+   /// Send pending output to a client. Returns false if the connection is closed
+   bool writeClient(int fd, Client& client);
+   /// Handle a single request
+   std::string handleRequest(std::string_view query);
+
+   public:
+   /// Constructor
+   Server(const Schema& schema, std::string socketPath, CompileCache* cache = nullptr);
+   /// Destructor
+   ~Server();
+
+   /// Lift literals into parameters. The responses then contain the bindings after the SQL text
+   void setPlaceholderStyle(SQLWriter::PlaceholderStyle style) { placeholderStyle = style; }
+   /// Emit lets that are referenced multiple times as materialized CTEs
+   void setMaterializeCTEs(bool materialize) { compiler.setMaterializeCTEs(materialize); }
+   /// Merge consecutive operators into as few SELECT blocks as possible
+   void setFlatSQL(bool flat) { compiler.setFlatSQL(flat); }
+
+   /// Run the server loop. Does not return unless an error occurs
+   void run();
+};
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
+#endif
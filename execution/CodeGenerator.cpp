@@ -0,0 +1,548 @@
+#include "execution/CodeGenerator.hpp"
+#include <stdexcept>
+//---------------------------------------------------------------------------
+// (c) 2023 Thomas Neumann
+//---------------------------------------------------------------------------
+using namespace std;
+//---------------------------------------------------------------------------
+namespace saneql::execution {
+//---------------------------------------------------------------------------
+/// The runtime of the generated code. Mirrors the semantics of the vectorized evaluation
+static constexpr const char* prelude = R"prelude(// Generated by saneql
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+//---------------------------------------------------------------------------
+using Int128 = __int128;
+//---------------------------------------------------------------------------
+namespace rt {
+//---------------------------------------------------------------------------
+/// A scanned column
+struct Column {
+   const void* data;
+   const uint64_t* offsets;
+   const uint64_t* nulls;
+};
+/// A result value
+struct Value {
+   Int128 number;
+   const char* str;
+   uint64_t length;
+   bool null;
+};
+//---------------------------------------------------------------------------
+/// Report a result that does not fit into its type
+[[noreturn]] static void overflow() { throw std::runtime_error("numeric value out of range"); }
+/// Add, throws on overflow
+template <class T>
+static inline T checkedAdd(T a, T b) {
+   T result;
+   if (__builtin_add_overflow(a, b, &result)) [[unlikely]] overflow();
+   return result;
+}
+/// Subtract, throws on overflow
+template <class T>
+static inline T checkedSub(T a, T b) {
+   T result;
+   if (__builtin_sub_overflow(a, b, &result)) [[unlikely]] overflow();
+   return result;
+}
+/// Multiply, throws on overflow
+template <class T>
+static inline T checkedMul(T a, T b) {
+   T result;
+   if (__builtin_mul_overflow(a, b, &result)) [[unlikely]] overflow();
+   return result;
+}
+/// Convert a number into an integer, throws on overflow
+static inline int64_t checkedInteger(Int128 value) {
+   if ((value < INT64_MIN) || (value > INT64_MAX)) [[unlikely]] overflow();
+   return static_cast<int64_t>(value);
+}
+//---------------------------------------------------------------------------
+/// Divide, rounding half away from zero
+static inline Int128 divideRounded(Int128 a, Int128 b) {
+   Int128 result = a / b, remainder = a % b;
+   if (remainder < 0) remainder = -remainder;
+   Int128 divisor = (b < 0) ? -b : b;
+   if (remainder * 2 >= divisor) result += ((a < 0) != (b < 0)) ? -1 : 1;
+   return result;
+}
+//---------------------------------------------------------------------------
+/// Convert a date into the number of days since 1970-01-01
+static inline int32_t makeDate(int year, unsigned month, unsigned day) {
+   year -= month <= 2;
+   int era = (year >= 0 ? year : year - 399) / 400;
+   unsigned yoe = year - era * 400;
+   unsigned doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+   unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+   return era * 146097 + static_cast<int>(doe) - 719468;
+}
+/// Split a date into year, month, and day
+static inline void splitDate(int32_t date, int& year, unsigned& month, unsigned& day) {
+   int z = date + 719468;
+   int era = (z >= 0 ? z : z - 146096) / 146097;
+   unsigned doe = z - era * 146097;
+   unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+   unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+   unsigned mp = (5 * doy + 2) / 153;
+   day = doy - (153 * mp + 2) / 5 + 1;
+   month = mp < 10 ? mp + 3 : mp - 9;
+   year = static_cast<int>(yoe) + era * 400 + (month <= 2);
+}
+/// Get the number of days of a month
+static inline unsigned daysInMonth(int year, unsigned month) {
+   static constexpr unsigned days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+   bool leap = ((year % 4) == 0) && (((year % 100) != 0) || ((year % 400) == 0));
+   return ((month == 2) && leap) ? 29 : days[month - 1];
+}
+/// Add an interval to a date
+static inline int32_t addInterval(int32_t date, int64_t interval) {
+   if (auto months = static_cast<int32_t>(interval >> 32)) {
+      int year;
+      unsigned month, day;
+      splitDate(date, year, month, day);
+      int total = year * 12 + static_cast<int>(month) - 1 + months;
+      year = (total >= 0) ? (total / 12) : -((11 - total) / 12);
+      month = total - year * 12 + 1;
+      date = makeDate(year, month, std::min(day, daysInMonth(year, month)));
+   }
+   return date + static_cast<int32_t>(interval);
+}
+/// Negate an interval
+static inline int64_t negateInterval(int64_t interval) {
+   int32_t months = -static_cast<int32_t>(interval >> 32), days = -static_cast<int32_t>(interval);
+   return (static_cast<int64_t>(months) << 32) | static_cast<uint32_t>(days);
+}
+/// Extract the parts of a date
+static inline int64_t extractYear(int32_t date) {
+   int year;
+   unsigned month, day;
+   splitDate(date, year, month, day);
+   return year;
+}
+static inline int64_t extractMonth(int32_t date) {
+   int year;
+   unsigned month, day;
+   splitDate(date, year, month, day);
+   return month;
+}
+static inline int64_t extractDay(int32_t date) {
+   int year;
+   unsigned month, day;
+   splitDate(date, year, month, day);
+   return day;
+}
+//---------------------------------------------------------------------------
+/// Match a like pattern
+static inline bool like(std::string_view text, std::string_view pattern) {
+   size_t t = 0, p = 0, starP = std::string_view::npos, starT = 0;
+   while (t < text.size()) {
+      if (p < pattern.size()) {
+         char c = pattern[p];
+         if (c == '%') {
+            starP = ++p;
+            starT = t;
+            continue;
+         }
+         bool escaped = (c == '\\') && (p + 1 < pattern.size());
+         if (escaped) c = pattern[p + 1];
+         if (((c == '_') && (!escaped)) || (c == text[t])) {
+            p += escaped ? 2 : 1;
+            ++t;
+            continue;
+         }
+      }
+      if (starP == std::string_view::npos) return false;
+      p = starP;
+      t = ++starT;
+   }
+   while ((p < pattern.size()) && (pattern[p] == '%')) ++p;
+   return p == pattern.size();
+}
+/// Compute a substring, positions start at 1 and may lie before the string
+static inline std::string_view substr(std::string_view str, int64_t start, bool hasLen, int64_t len) {
+   int64_t end = hasLen ? start + len : INT64_MAX;
+   start = std::max<int64_t>(start, 1);
+   end = std::min<int64_t>(end, static_cast<int64_t>(str.size()) + 1);
+   return (end > start) ? str.substr(start - 1, end - start) : std::string_view();
+}
+//---------------------------------------------------------------------------
+/// The hash of NULL values
+constexpr uint64_t nullHash = 0x5BD1E9955BD1E995ull;
+/// Hash a number
+static inline uint64_t hash(Int128 number) {
+   uint64_t low = static_cast<uint64_t>(number), high = static_cast<uint64_t>(static_cast<unsigned __int128>(number) >> 64);
+   unsigned __int128 product = static_cast<unsigned __int128>(low ^ 0x9E3779B97F4A7C15ull) * (high ^ 0xC2B2AE3D27D4EB4Full);
+   return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+}
+/// Hash a string
+static inline uint64_t hash(std::string_view str) {
+   constexpr uint64_t m = 0xC6A4A7935BD1E995ull;
+   uint64_t result = 0x8445D61A4E774912ull ^ (str.size() * m);
+   auto data = str.data();
+   size_t len = str.size();
+   for (; len >= 8; data += 8, len -= 8) {
+      uint64_t k;
+      __builtin_memcpy(&k, data, 8);
+      k *= m;
+      k ^= k >> 47;
+      result = (result ^ (k * m)) * m;
+   }
+   if (len) {
+      uint64_t k = 0;
+      __builtin_memcpy(&k, data, len);
+      result = (result ^ k) * m;
+   }
+   result ^= result >> 47;
+   result *= m;
+   return result ^ (result >> 47);
+}
+/// Combine two hash values
+static inline uint64_t combineHashes(uint64_t a, uint64_t b) { return (a ^ (b + 0x9E3779B97F4A7C15ull + (a << 6) + (a >> 2))); }
+//---------------------------------------------------------------------------
+/// Create a result value
+static inline Value makeValue(Int128 number, bool null) { return Value{number, nullptr, 0, null}; }
+static inline Value makeValue(std::string_view str, bool null) { return Value{0, str.data(), str.size(), null}; }
+//---------------------------------------------------------------------------
+/// A hash table of groups with linear probing
+template <class Group>
+class GroupTable {
+   /// The groups
+   std::vector<Group> groups;
+   /// The hash values of the groups
+   std::vector<uint64_t> hashes;
+   /// The slots, the group index plus one
+   std::vector<uint32_t> slots;
+   /// The mask for slot positions
+   uint64_t mask = 0;
+
+   /// Double the number of slots
+   void grow() {
+      uint64_t size = std::max<uint64_t>(2 * slots.size(), 1024);
+      slots.assign(size, 0);
+      mask = size - 1;
+      for (uint32_t index = 0; index != groups.size(); ++index) {
+         uint64_t pos = hashes[index] & mask;
+         while (slots[pos]) pos = (pos + 1) & mask;
+         slots[pos] = index + 1;
+      }
+   }
+
+   public:
+   /// Find a group, creating it if needed
+   template <class Equal, class Init>
+   Group& find(uint64_t hash, Equal&& equal, Init&& init) {
+      if (2 * groups.size() >= slots.size()) grow();
+      for (uint64_t pos = hash & mask;; pos = (pos + 1) & mask) {
+         uint32_t slot = slots[pos];
+         if (!slot) {
+            slots[pos] = groups.size() + 1;
+            hashes.push_back(hash);
+            init(groups.emplace_back());
+            return groups.back();
+         }
+         if ((hashes[slot - 1] == hash) && equal(groups[slot - 1])) return groups[slot - 1];
+      }
+   }
+   /// Get the number of groups
+   uint64_t getSize() const { return groups.size(); }
+   /// Get a group
+   const Group& getGroup(uint64_t index) const { return groups[index]; }
+   /// Get the hash value of a group
+   uint64_t getHash(uint64_t index) const { return hashes[index]; }
+};
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
+)prelude";
+//---------------------------------------------------------------------------
+static string makeName(const char* prefix, unsigned index)
+// Build the name of a variable or member
+{
+   return prefix + to_string(index);
+}
+//---------------------------------------------------------------------------
+static const char* getStorageName(PhysicalType storage)
+// Get the C++ type of stored values
+{
+   switch (storage) {
+      case PhysicalType::Bool: return "uint8_t";
+      case PhysicalType::Int32: return "int32_t";
+      case PhysicalType::Int64: return "int64_t";
+      case PhysicalType::Int128: return "Int128";
+      case PhysicalType::String: return "char";
+   }
+   __builtin_unreachable();
+}
+//---------------------------------------------------------------------------
+optional<string> CodeGenerator::generateAggregation(const vector<ValueType>& types, const vector<PhysicalType>& storage, const vector<Step>& steps, const vector<unique_ptr<Evaluator>>& groupBy, const vector<HashAggregation::Aggregate>& aggregates)
+// Generate an aggregation over scanned columns
+{
+   using Op = HashAggregation::Op;
+   // Distinct aggregates need a set of values per group, they remain vectorized
+   for (auto& a : aggregates)
+      if ((a.op == Op::CountDistinct) || (a.op == Op::SumDistinct) || (a.op == Op::AvgDistinct)) return nullopt;
+
+   // The scanned columns are loaded when they are used first
+   RowCode code;
+   string columns;
+   for (unsigned index = 0; index != types.size(); ++index) {
+      auto data = makeName("d", index), nulls = makeName("b", index);
+      RowCode::Variable variable{makeName("a", index), "false"};
+      string load;
+      if (storage[index] == PhysicalType::String) {
+         auto offsets = makeName("o", index), begin = "(row ? " + offsets + "[row - 1] : 0)";
+         columns += "   auto " + data + " = static_cast<const char*>(columns[" + to_string(index) + "].data);\n";
+         columns += "   auto " + offsets + " = columns[" + to_string(index) + "].offsets;\n";
+         load = "      const std::string_view " + variable.value + "(" + data + " + " + begin + ", " + offsets + "[row] - " + begin + ");\n";
+      } else {
+         columns += "   auto " + data + " = static_cast<const " + getStorageName(storage[index]) + "*>(columns[" + to_string(index) + "].data);\n";
+         load = "      const " + RowCode::getType(types[index]) + " " + variable.value + " = " + data + "[row];\n";
+      }
+      if (types[index].isNullable()) {
+         variable.null = makeName("an", index);
+         columns += "   auto " + nulls + " = columns[" + to_string(index) + "].nulls;\n";
+         load += "      const bool " + variable.null + " = (" + nulls + "[row >> 6] >> (row & 63)) & 1;\n";
+      }
+      code.addColumn(move(variable), move(load));
+   }
+
+   // Every operator consumes the row in place
+   for (auto& step : steps) {
+      if (step.condition) {
+         auto condition = step.condition->generate(code);
+         if (!condition) return nullopt;
+         code.append("      if (" + condition->null + " || !" + condition->value + ") continue;\n");
+      }
+      for (auto& c : step.computations) {
+         auto value = c->generate(code);
+         if (!value) return nullopt;
+         code.addColumn(move(*value), {});
+      }
+   }
+   vector<RowCode::Variable> keys, values;
+   for (auto& g : groupBy) {
+      auto key = g->generate(code);
+      if (!key) return nullopt;
+      keys.push_back(move(*key));
+   }
+   for (auto& a : aggregates) {
+      optional<RowCode::Variable> value;
+      if (a.value && (!(value = a.value->generate(code)))) return nullopt;
+      values.push_back(value ? move(*value) : RowCode::Variable{"0", "false"});
+   }
+
+   // The groups hold the keys and the aggregation states
+   string group = "struct Group {\n";
+   for (unsigned index = 0; index != keys.size(); ++index)
+      group += "   " + RowCode::getType(groupBy[index]->getType()) + " " + makeName("k", index) + "{};\n   bool " + makeName("kn", index) + " = false;\n";
+   string update, merge, produce;
+   for (unsigned index = 0; index != aggregates.size(); ++index) {
+      auto& a = aggregates[index];
+      auto c = makeName("c", index), s = makeName("s", index), m = makeName("m", index);
+      auto &v = values[index].value, &n = values[index].null;
+      group += "   int64_t " + c + " = 0;\n";
+      switch (a.op) {
+         case Op::CountStar: update += "      ++g." + c + ";\n"; break;
+         case Op::Count: update += "      g." + c + " += !" + n + ";\n"; break;
+         case Op::Sum:
+         case Op::Avg:
+            group += "   Int128 " + s + " = 0;\n";
+            update += "      if (!" + n + ") g." + s + " = rt::checkedAdd(g." + s + ", Int128(" + v + "));\n      g." + c + " += !" + n + ";\n";
+            merge += "   g." + s + " = rt::checkedAdd(g." + s + ", e." + s + ");\n";
+            break;
+         case Op::Min:
+         case Op::Max: {
+            const char* better = (a.op == Op::Min) ? " < " : " > ";
+            group += "   " + RowCode::getType(a.value->getType()) + " " + m + "{};\n";
+            update += "      if (!" + n + " && (!g." + c + " || (" + v + better + "g." + m + "))) g." + m + " = " + v + ";\n      g." + c + " += !" + n + ";\n";
+            merge += "   if (e." + c + " && (!g." + c + " || (e." + m + better + "g." + m + "))) g." + m + " = e." + m + ";\n";
+            break;
+         }
+         default: return nullopt;
+      }
+      merge += "   g." + c + " += e." + c + ";\n";
+   }
+   group += "};\n";
+
+   // The result rows, the keys followed by the aggregates
+   unsigned keyCount = keys.size();
+   for (unsigned index = 0; index != keyCount; ++index)
+      produce += "      row[" + to_string(index) + "] = rt::makeValue(g." + makeName("k", index) + ", g." + makeName("kn", index) + ");\n";
+   for (unsigned index = 0; index != aggregates.size(); ++index) {
+      auto& a = aggregates[index];
+      auto target = "      row[" + to_string(keyCount + index) + "] = ";
+      auto c = "g." + makeName("c", index), s = "g." + makeName("s", index), m = "g." + makeName("m", index);
+      switch (a.op) {
+         case Op::CountStar:
+         case Op::Count: produce += target + "rt::makeValue(" + c + ", false);\n"; break;
+         case Op::Sum: {
+            // Integer sums must fit into 64 bits
+            string sum = (a.value->getType().getKind() == ValueType::Integer) ? "(" + c + " ? Int128(rt::checkedInteger(" + s + ")) : Int128(0))" : s;
+            produce += target + "rt::makeValue(" + sum + ", !" + c + ");\n";
+            break;
+         }
+         case Op::Avg: {
+            unsigned inputScale = a.value->getType().getScale(), resultScale = HashAggregation::getResultType(a.op, a.value->getType()).getScale();
+            auto factor = RowCode::makeLiteral(ValueType(ValueType::Decimal), execution::Value::makeNumber(values::pow10(resultScale - inputScale)));
+            produce += target + "rt::makeValue(" + c + " ? rt::divideRounded(rt::checkedMul(" + s + ", " + factor + "), " + c + ") : Int128(0), !" + c + ");\n";
+            break;
+         }
+         default: produce += target + "rt::makeValue(" + m + ", !" + c + ");\n"; break;
+      }
+   }
+
+   // Find the group of a row
+   string hash = "0", equal, init;
+   for (unsigned index = 0; index != keyCount; ++index) {
+      auto &v = keys[index].value, &n = keys[index].null;
+      auto k = makeName("k", index), kn = makeName("kn", index);
+      hash = "rt::combineHashes(" + hash + ", " + n + " ? rt::nullHash : rt::hash(" + v + "))";
+      equal += string(equal.empty() ? "" : " && ") + "(e." + kn + " == " + n + ") && (" + n + " || (e." + k + " == " + v + "))";
+      init += "e." + k + " = " + v + "; e." + kn + " = " + n + "; ";
+   }
+
+   // Assemble the module
+   string result = prelude;
+   result += "namespace {\n" + group + "/// The aggregation state\nstruct State {\n";
+   result += keyCount ? "   rt::GroupTable<Group> groups;\n" : "   Group total;\n";
+   result += "};\n}\n//---------------------------------------------------------------------------\n";
+   result += string("extern \"C\" void* ") + createName + "() { return new State(); }\n";
+   result += string("extern \"C\" void ") + destroyName + "(void* state) { delete static_cast<State*>(state); }\n";
+   result += string("extern \"C\" void ") + consumeName + "(void* state, const rt::Column* columns, uint64_t begin, uint64_t end) {\n";
+   result += "   auto& s = *static_cast<State*>(state);\n" + columns;
+   result += keyCount ? "" : "   Group g = s.total;\n";
+   result += "   for (uint64_t row = begin; row != end; ++row) {\n" + code.getCode();
+   if (keyCount) {
+      result += "      const uint64_t hash = " + hash + ";\n";
+      result += "      Group& g = s.groups.find(hash, [&](const Group& e) { return " + equal + "; }, [&](Group& e) { " + init + "});\n";
+   }
+   result += update + "   }\n";
+   result += keyCount ? "" : "   s.total = g;\n";
+   result += "}\n";
+   result += "static void merge(Group& g, const Group& e) {\n" + merge + "}\n";
+   result += string("extern \"C\" void ") + mergeName + "(void* target, void* source) {\n";
+   result += "   auto &t = *static_cast<State*>(target), &s = *static_cast<State*>(source);\n";
+   if (keyCount) {
+      string copy;
+      for (unsigned index = 0; index != keyCount; ++index)
+         copy += "n." + makeName("k", index) + " = e." + makeName("k", index) + "; n." + makeName("kn", index) + " = e." + makeName("kn", index) + "; ";
+      result += "   for (uint64_t index = 0; index != s.groups.getSize(); ++index) {\n";
+      result += "      auto& e = s.groups.getGroup(index);\n";
+      result += "      merge(t.groups.find(s.groups.getHash(index), [&](const Group& n) { return ";
+      for (unsigned index = 0; index != keyCount; ++index) {
+         auto k = makeName("k", index), kn = makeName("kn", index);
+         result += string(index ? " && " : "") + "(n." + kn + " == e." + kn + ") && (e." + kn + " || (n." + k + " == e." + k + "))";
+      }
+      result += "; }, [&](Group& n) { " + copy + "}), e);\n   }\n";
+   } else {
+      result += "   merge(t.total, s.total);\n";
+   }
+   result += "}\n";
+   result += string("extern \"C\" void ") + produceName + "(void* state, void* context, void (*emit)(void* context, const rt::Value* row)) {\n";
+   result += "   auto& s = *static_cast<State*>(state);\n";
+   result += "   rt::Value row[" + to_string(keyCount + aggregates.size() + 1) + "];\n";
+   result += "   auto produce = [&](const Group& g) {\n" + produce + "      emit(context, row);\n   };\n";
+   result += keyCount ? "   for (uint64_t index = 0; index != s.groups.getSize(); ++index)\n      produce(s.groups.getGroup(index));\n" : "   produce(s.total);\n";
+   result += "}\n";
+   return result;
+}
+//---------------------------------------------------------------------------
+/// The number of rows per morsel
+static constexpr uint64_t morselRows = 16 * Batch::maxSize;
+//---------------------------------------------------------------------------
+/// An aggregation state of generated code
+using StatePtr = unique_ptr<void, CodeGenerator::DestroyFunction>;
+//---------------------------------------------------------------------------
+/// The state shared by the instances of a parallel plan
+struct CompiledAggregation::Shared : public SharedState {
+   /// The morsels of the table
+   MorselQueue morsels;
+   /// The aggregation states of the instances
+   vector<StatePtr> states;
+
+   /// Constructor
+   Shared(uint64_t rows, unsigned workerCount, CodeGenerator::DestroyFunction destroy) : morsels(rows, workerCount, morselRows) {
+      for (unsigned index = 0; index != workerCount; ++index)
+         states.emplace_back(nullptr, destroy);
+   }
+};
+//---------------------------------------------------------------------------
+CompiledAggregation::CompiledAggregation(shared_ptr<NativeModule> module, const Table& table, const vector<unsigned>& columns, vector<ValueType> types)
+   : PhysicalOperator(move(types)), module(move(module)), table(table), output(this->types)
+// Constructor
+{
+   create = reinterpret_cast<CodeGenerator::CreateFunction>(this->module->lookup(CodeGenerator::createName));
+   destroy = reinterpret_cast<CodeGenerator::DestroyFunction>(this->module->lookup(CodeGenerator::destroyName));
+   consumeRows = reinterpret_cast<CodeGenerator::ConsumeFunction>(this->module->lookup(CodeGenerator::consumeName));
+   merge = reinterpret_cast<CodeGenerator::MergeFunction>(this->module->lookup(CodeGenerator::mergeName));
+   produceGroups = reinterpret_cast<CodeGenerator::ProduceFunction>(this->module->lookup(CodeGenerator::produceName));
+   for (auto index : columns) {
+      auto& c = table.getColumns()[index];
+      this->columns.push_back({c.getData<byte>(), c.getOffsets(), c.getNulls()});
+   }
+}
+//---------------------------------------------------------------------------
+CompiledAggregation::~CompiledAggregation()
+// Destructor
+{
+}
+//---------------------------------------------------------------------------
+void CompiledAggregation::setWorker(Worker& worker)
+// Make the operator an instance of a parallel plan
+{
+   PhysicalOperator::setWorker(worker);
+   shared = &worker.registerState<Shared>(table.getSize(), worker.getWorkerCount(), destroy);
+}
+//---------------------------------------------------------------------------
+void CompiledAggregation::emit(void* context, const CodeGenerator::Value* row)
+// Append a result row to the output
+{
+   auto& self = *static_cast<CompiledAggregation*>(context);
+   auto& output = self.output;
+   if (!output.size)
+      for (auto& c : output.columns)
+         c.allocate(Batch::maxSize, true);
+   for (unsigned index = 0; index != output.columns.size(); ++index) {
+      auto& v = row[index];
+      output.columns[index].set(output.size, v.null ? Value::makeNull() : ((output.columns[index].getType().getKind() == ValueType::String) ? Value::makeString(string_view(v.str, v.length)) : Value::makeNumber(v.number)));
+   }
+   if (++output.size == Batch::maxSize) {
+      self.push(output);
+      output.size = 0;
+   }
+}
+//---------------------------------------------------------------------------
+void CompiledAggregation::produce()
+// Produce all result batches
+{
+   StatePtr state(create(), destroy);
+   if (!shared) {
+      consumeRows(state.get(), columns.data(), 0, table.getSize());
+   } else {
+      // Aggregate the morsels locally, the leader merges all states
+      unsigned id = worker->getId();
+      uint64_t begin, end;
+      while (shared->morsels.next(id, begin, end))
+         consumeRows(state.get(), columns.data(), begin, end);
+      shared->states[id] = move(state);
+      worker->synchronize();
+      if (!worker->isLeader()) return;
+      state = move(shared->states[id]);
+      for (auto& other : shared->states)
+         if (other) {
+            merge(state.get(), other.get());
+            other.reset();
+         }
+   }
+   output.size = 0;
+   produceGroups(state.get(), this, &emit);
+   if (output.size) push(output);
+   output.size = 0;
+}
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
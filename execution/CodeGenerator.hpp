@@ -0,0 +1,117 @@
+#ifndef H_saneql_execution_CodeGenerator
+#define H_saneql_execution_CodeGenerator
+//---------------------------------------------------------------------------
+#include "execution/NativeCompiler.hpp"
+#include "execution/PhysicalOperator.hpp"
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+//---------------------------------------------------------------------------
+// SaneQL
+// (c) 2023 Thomas Neumann
+// SPDX-License-Identifier: BSD-3-Clause
+//---------------------------------------------------------------------------
+namespace saneql {
+//---------------------------------------------------------------------------
+namespace execution {
+//---------------------------------------------------------------------------
+/// Generates C++ code for pipelines that end in an aggregation. The scan produces one row
+/// after the other and every operator consumes it in place: filters skip the row, maps
+/// compute further values, and the aggregation updates its group. The generated module is
+/// self-contained and interacts with the host only through the declarations below
+class CodeGenerator {
+   public:
+   /// A scanned column as passed to the generated code
+   struct Column {
+      /// The values, the characters for strings
+      const void* data;
+      /// The end offsets of strings
+      const uint64_t* offsets;
+      /// The NULL bitmap (if any)
+      const uint64_t* nulls;
+   };
+   /// A result value as passed from the generated code
+   struct Value {
+      /// The numeric representation
+      Int128 number;
+      /// The characters of strings
+      const char* str;
+      /// The length of strings
+      uint64_t length;
+      /// NULL?
+      bool null;
+   };
+   /// Create an empty aggregation state
+   using CreateFunction = void* (*)();
+   /// Destroy an aggregation state
+   using DestroyFunction = void (*)(void* state);
+   /// Aggregate a range of rows of the scanned columns
+   using ConsumeFunction = void (*)(void* state, const Column* columns, uint64_t begin, uint64_t end);
+   /// Merge the groups of a state into another state. Leaves the source in an unspecified state
+   using MergeFunction = void (*)(void* target, void* source);
+   /// Pass all groups to a callback, the keys followed by the aggregates
+   using ProduceFunction = void (*)(void* state, void* context, void (*emit)(void* context, const Value* row));
+   /// The names of the entry points
+   static constexpr const char* createName = "saneql_create";
+   static constexpr const char* destroyName = "saneql_destroy";
+   static constexpr const char* consumeName = "saneql_consume";
+   static constexpr const char* mergeName = "saneql_merge";
+   static constexpr const char* produceName = "saneql_produce";
+
+   /// An operator of the pipeline between scan and aggregation
+   struct Step {
+      /// The filter condition (if any)
+      std::unique_ptr<Evaluator> condition;
+      /// The computed columns, appended to the row
+      std::vector<std::unique_ptr<Evaluator>> computations;
+   };
+
+   /// Generate an aggregation over scanned columns. The evaluators reference the scanned columns followed by the computed columns of the steps. nullopt if the pipeline cannot be compiled
+   static std::optional<std::string> generateAggregation(const std::vector<ValueType>& types, const std::vector<PhysicalType>& storage, const std::vector<Step>& steps, const std::vector<std::unique_ptr<Evaluator>>& groupBy, const std::vector<HashAggregation::Aggregate>& aggregates);
+};
+//---------------------------------------------------------------------------
+/// An aggregation over a table scan that runs generated code. Every instance aggregates
+/// morsels of the table into a state of its own, the leader merges the states and
+/// produces the groups
+class CompiledAggregation : public PhysicalOperator {
+   /// The state shared by the instances of a parallel plan
+   struct Shared;
+
+   /// The compiled code
+   std::shared_ptr<NativeModule> module;
+   /// The entry points
+   CodeGenerator::CreateFunction create;
+   CodeGenerator::DestroyFunction destroy;
+   CodeGenerator::ConsumeFunction consumeRows;
+   CodeGenerator::MergeFunction merge;
+   CodeGenerator::ProduceFunction produceGroups;
+   /// The table
+   const Table& table;
+   /// The scanned columns
+   std::vector<CodeGenerator::Column> columns;
+   /// The shared state (parallel execution only)
+   Shared* shared = nullptr;
+   /// The output
+   Batch output;
+
+   /// Append a result row to the output
+   static void emit(void* context, const CodeGenerator::Value* row);
+
+   public:
+   /// Constructor. The types are the result types of the generated aggregation
+   CompiledAggregation(std::shared_ptr<NativeModule> module, const Table& table, const std::vector<unsigned>& columns, std::vector<ValueType> types);
+   /// Destructor
+   ~CompiledAggregation();
+
+   /// Make the operator an instance of a parallel plan
+   void setWorker(Worker& worker) override;
+
+   /// Produce all result batches
+   void produce() override;
+};
+//---------------------------------------------------------------------------
+}
+}
+//---------------------------------------------------------------------------
+#endif
@@ -0,0 +1,72 @@
+#include "execution/Database.hpp"
+#include "execution/Loader.hpp"
+#include "execution/TPCHGenerator.hpp"
+#include "infra/Schema.hpp"
+#include <filesystem>
+#include <istream>
+#include <iterator>
+#include <stdexcept>
+//---------------------------------------------------------------------------
+// (c) 2023 Thomas Neumann
+//---------------------------------------------------------------------------
+using namespace std;
+//---------------------------------------------------------------------------
+namespace saneql::execution {
+//---------------------------------------------------------------------------
+Database::Database(const Schema& schema, char delimiter)
+   : schema(schema), delimiter(delimiter)
+// Constructor
+{
+}
+//---------------------------------------------------------------------------
+Database::~Database()
+// Destructor
+{
+}
+//---------------------------------------------------------------------------
+shared_ptr<const Schema::Table> Database::lookupDefinition(const string& name) const
+// Find the definition of a table
+{
+   auto definition = schema.lookupTable(name);
+   if (!definition) throw runtime_error("unknown table '" + name + "'");
+   return definition;
+}
+//---------------------------------------------------------------------------
+void Database::loadTable(const string& name, istream& in)
+// Load the data of a table
+{
+   auto definition = lookupDefinition(name);
+   string text(istreambuf_iterator<char>(in), {});
+   tables[name] = Loader(name, *definition, 1).load(text, Loader::Format::tbl(delimiter));
+}
+//---------------------------------------------------------------------------
+void Database::loadTable(const string& name, const string& file)
+// Load the data file of a table
+{
+   auto definition = lookupDefinition(name);
+   tables[name] = Loader(name, *definition).loadFile(file, Loader::Format::forFile(file, delimiter));
+}
+//---------------------------------------------------------------------------
+const Table& Database::getTable(const string& name)
+// Get the data of a table
+{
+   if (auto iter = tables.find(name); iter != tables.end()) return *iter->second;
+   if (generator) {
+      auto& table = tables[name];
+      table = generator->generate(name, *lookupDefinition(name));
+      return *table;
+   }
+   if (!dataDirectory.empty()) {
+      for (auto extension : {".tbl", ".csv"}) {
+         auto file = filesystem::path(dataDirectory) / (name + extension);
+         if (filesystem::exists(file)) {
+            loadTable(name, file.string());
+            return *tables[name];
+         }
+      }
+   }
+   throw runtime_error("no data for table '" + name + "'");
+}
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
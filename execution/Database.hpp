@@ -0,0 +1,63 @@
+#ifndef H_saneql_execution_Database
+#define H_saneql_execution_Database
+//---------------------------------------------------------------------------
+#include "execution/Table.hpp"
+#include "infra/Schema.hpp"
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <unordered_map>
+//---------------------------------------------------------------------------
+// SaneQL
+// (c) 2023 Thomas Neumann
+// SPDX-License-Identifier: BSD-3-Clause
+//---------------------------------------------------------------------------
+namespace saneql {
+//---------------------------------------------------------------------------
+namespace execution {
+//---------------------------------------------------------------------------
+class TPCHGenerator;
+//---------------------------------------------------------------------------
+/// The data of the tables of a schema, stored in columnar form. The data files contain
+/// one row per line with delimiter separated fields in column order, as produced by the
+/// TPC-H dbgen tool, or are CSV files with a header line. Empty fields are NULL
+class Database {
+   /// The schema
+   const Schema& schema;
+   /// The directory with data files (if any)
+   std::string dataDirectory;
+   /// The field delimiter
+   char delimiter;
+   /// The generator for TPC-H tables (if any)
+   std::shared_ptr<const TPCHGenerator> generator;
+   /// The loaded tables
+   std::unordered_map<std::string, std::unique_ptr<Table>> tables;
+
+   /// Find the definition of a table
+   std::shared_ptr<const Schema::Table> lookupDefinition(const std::string& name) const;
+
+   public:
+   /// Constructor
+   explicit Database(const Schema& schema, char delimiter = '|');
+   /// Destructor
+   ~Database();
+
+   /// Get the schema
+   const Schema& getSchema() const { return schema; }
+   /// Load tables on first use from <table>.tbl or <table>.csv files in a directory
+   void setDataDirectory(std::string directory) { dataDirectory = std::move(directory); }
+   /// Generate the TPC-H tables on first use instead of reading data files
+   void setGenerator(std::shared_ptr<const TPCHGenerator> generator) { this->generator = std::move(generator); }
+
+   /// Load the data of a table
+   void loadTable(const std::string& name, std::istream& in);
+   /// Load the data file of a table. Files ending in .csv are CSV files
+   void loadTable(const std::string& name, const std::string& file);
+   /// Get the data of a table. Throws if there is no data
+   const Table& getTable(const std::string& name);
+};
+//---------------------------------------------------------------------------
+}
+}
+//---------------------------------------------------------------------------
+#endif
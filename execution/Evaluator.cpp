@@ -0,0 +1,1382 @@
+#include "execution/Evaluator.hpp"
+#include "algebra/Expression.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+//---------------------------------------------------------------------------
+// (c) 2023 Thomas Neumann
+//---------------------------------------------------------------------------
+using namespace std;
+//---------------------------------------------------------------------------
+namespace saneql::execution {
+//---------------------------------------------------------------------------
+Evaluator::~Evaluator()
+// Destructor
+{
+}
+//---------------------------------------------------------------------------
+optional<RowCode::Variable> Evaluator::generate(RowCode& /*code*/) const
+// Generate code that computes the expression for a single row
+{
+   return nullopt;
+}
+//---------------------------------------------------------------------------
+ExpressionCompiler::~ExpressionCompiler()
+// Destructor
+{
+}
+//---------------------------------------------------------------------------
+const RowCode::Variable& RowCode::useColumn(unsigned index)
+// Use a column
+{
+   auto& c = columns[index];
+   if (!c.load.empty()) {
+      code += c.load;
+      c.load.clear();
+   }
+   return c.variable;
+}
+//---------------------------------------------------------------------------
+RowCode::Variable RowCode::define(ValueType type, const string& value, const string& null)
+// Define a new variable
+{
+   Variable result{"v" + to_string(variableCount), "n" + to_string(variableCount)};
+   ++variableCount;
+   code += "      const " + getType(type) + " " + result.value + " = " + value + ";\n";
+   code += "      const bool " + result.null + " = " + null + ";\n";
+   return result;
+}
+//---------------------------------------------------------------------------
+string RowCode::getType(ValueType type)
+// Get the C++ type that holds values of a type
+{
+   switch (type.getKind()) {
+      case ValueType::Null:
+      case ValueType::Bool: return "bool";
+      case ValueType::Integer:
+      case ValueType::Interval: return "int64_t";
+      case ValueType::Decimal: return "Int128";
+      case ValueType::Date: return "int32_t";
+      case ValueType::String: return "std::string_view";
+   }
+   __builtin_unreachable();
+}
+//---------------------------------------------------------------------------
+static string makeInt64(int64_t value)
+// Get a C++ literal for a 64 bit integer
+{
+   if (value == numeric_limits<int64_t>::min()) return "(-INT64_C(9223372036854775807) - 1)";
+   return "INT64_C(" + to_string(value) + ")";
+}
+//---------------------------------------------------------------------------
+string RowCode::makeLiteral(ValueType type, const Value& value)
+// Get a C++ literal for a value
+{
+   // NULL values are represented by the zero value of their type
+   Int128 number = value.null ? 0 : value.number;
+   switch (type.getKind()) {
+      case ValueType::Null:
+      case ValueType::Bool: return number ? "true" : "false";
+      case ValueType::Integer:
+      case ValueType::Interval: return makeInt64(static_cast<int64_t>(number));
+      case ValueType::Date: return "int32_t(" + to_string(static_cast<int32_t>(number)) + ")";
+      case ValueType::Decimal: {
+         if ((number >= numeric_limits<int64_t>::min()) && (number <= numeric_limits<int64_t>::max())) return "Int128(" + makeInt64(static_cast<int64_t>(number)) + ")";
+         auto high = static_cast<int64_t>(number >> 64);
+         auto low = static_cast<uint64_t>(number);
+         return "((Int128(" + makeInt64(high) + ") << 64) | Int128(UINT64_C(" + to_string(low) + ")))";
+      }
+      case ValueType::String: {
+         // Octal escapes for everything but plain characters, they never merge with the following character
+         string_view str = value.null ? string_view() : value.str;
+         string result = "std::string_view(\"";
+         for (char c : str) {
+            auto u = static_cast<unsigned char>(c);
+            if ((u >= 32) && (u < 127) && (c != '"') && (c != '\\') && (c != '?')) {
+               result += c;
+            } else {
+               char buffer[8];
+               snprintf(buffer, sizeof(buffer), "\\%03o", u);
+               result += buffer;
+            }
+         }
+         return result + "\", " + to_string(str.size()) + ")";
+      }
+   }
+   __builtin_unreachable();
+}
+//---------------------------------------------------------------------------
+static bool prepareNulls(Vector& result, unsigned count, const Vector& a, const Vector* b = nullptr)
+// Prepare the result of a computation that is NULL if any input is NULL. Returns true if there are NULL values
+{
+   auto na = a.getNulls(), nb = b ? b->getNulls() : nullptr;
+   result.allocate(count, na || nb);
+   auto out = result.getNulls();
+   if (na && nb) {
+      for (unsigned index = 0; index != count; ++index)
+         out[index] = na[index] | nb[index];
+   } else if (na || nb) {
+      memcpy(out, na ? na : nb, count);
+   }
+   return out;
+}
+//---------------------------------------------------------------------------
+static string makePower(unsigned exponent)
+// Get a power of ten as literal
+{
+   return RowCode::makeLiteral(ValueType(ValueType::Decimal), Value::makeNumber(values::pow10(exponent)));
+}
+//---------------------------------------------------------------------------
+static string generateRescale(const string& value, unsigned from, unsigned to)
+// Generate the change of the scale of a decimal
+{
+   if (from == to) return value;
+   if (from < to) return "rt::checkedMul(" + value + ", " + makePower(to - from) + ")";
+   return "rt::divideRounded(" + value + ", " + makePower(from - to) + ")";
+}
+//---------------------------------------------------------------------------
+static string generateChecked(const string& null, const string& zero, const string& value)
+// Generate a computation that raises errors, NULL rows hold arbitrary values and are skipped
+{
+   if (null == "false") return value;
+   return "(" + null + " ? " + zero + " : " + value + ")";
+}
+//---------------------------------------------------------------------------
+namespace {
+//---------------------------------------------------------------------------
+/// A reference to a column of the input batch
+class ColumnEvaluator : public Evaluator {
+   /// The column
+   unsigned index;
+
+   public:
+   /// Constructor
+   ColumnEvaluator(ValueType type, unsigned index) : Evaluator(type), index(index) {}
+
+   /// Evaluate
+   const Vector& evaluate(const Batch& batch) override { return batch.columns[index]; }
+   /// Generate code
+   optional<RowCode::Variable> generate(RowCode& code) const override { return code.useColumn(index); }
+};
+//---------------------------------------------------------------------------
+/// A constant value
+class ConstantEvaluator : public Evaluator {
+   public:
+   /// Constructor
+   ConstantEvaluator(ValueType type, Value value) : Evaluator(type) {
+      result.allocate(Batch::maxSize, value.null);
+      if ((!value.null) && (type.getKind() == ValueType::String)) value.str = result.accessHeap().add(value.str);
+      for (unsigned index = 0; index != Batch::maxSize; ++index)
+         result.set(index, value);
+   }
+
+   /// Is the result the same for all rows?
+   bool isConstant() const override { return true; }
+   /// Evaluate
+   const Vector& evaluate(const Batch&) override { return result; }
+   /// Generate code
+   optional<RowCode::Variable> generate(RowCode&) const override {
+      Value value = result.get(0);
+      return RowCode::Variable{RowCode::makeLiteral(type, value), value.null ? "true" : "false"};
+   }
+};
+//---------------------------------------------------------------------------
+/// A value that is set from outside
+class SlotEvaluator : public Evaluator {
+   /// The slot
+   const ValueSlot& slot;
+
+   public:
+   /// Constructor
+   explicit SlotEvaluator(const ValueSlot& slot) : Evaluator(slot.type), slot(slot) {}
+
+   /// Evaluate
+   const Vector& evaluate(const Batch& batch) override {
+      result.allocate(batch.size, slot.value.null);
+      for (unsigned index = 0; index != batch.size; ++index)
+         result.set(index, slot.value);
+      return result;
+   }
+};
+//---------------------------------------------------------------------------
+/// Base class for computations over other evaluators
+class ComputedEvaluator : public Evaluator {
+   protected:
+   /// The inputs
+   vector<unique_ptr<Evaluator>> inputs;
+
+   public:
+   /// Constructor
+   ComputedEvaluator(ValueType type, vector<unique_ptr<Evaluator>> inputs) : Evaluator(type), inputs(move(inputs)) {}
+
+   /// Set the result type. The result is nullable if any input is
+   void deriveType(ValueType t) {
+      type = t.withNullable(any_of(inputs.begin(), inputs.end(), [](auto& i) { return i->getType().isNullable(); }));
+      result = Vector(type);
+   }
+
+   /// Is the result the same for all rows?
+   bool isConstant() const override {
+      return all_of(inputs.begin(), inputs.end(), [](auto& i) { return i->isConstant(); });
+   }
+   /// Generate the code of all inputs. Returns false if an input cannot be compiled
+   bool generateInputs(RowCode& code, vector<RowCode::Variable>& variables) const {
+      for (auto& i : inputs) {
+         auto v = i->generate(code);
+         if (!v) return false;
+         variables.push_back(move(*v));
+      }
+      return true;
+   }
+   /// Generate the code of all inputs and the expression that is NULL if any input is NULL
+   bool generateInputs(RowCode& code, vector<RowCode::Variable>& variables, string& null) const {
+      if (!generateInputs(code, variables)) return false;
+      null.clear();
+      for (auto& v : variables)
+         null += (null.empty() ? "(" : " || ") + v.null;
+      null += ")";
+      return true;
+   }
+};
+//---------------------------------------------------------------------------
+template <class... T>
+static vector<unique_ptr<Evaluator>> makeInputs(T... inputs)
+// Build a vector of evaluators
+{
+   vector<unique_ptr<Evaluator>> result;
+   (result.push_back(move(inputs)), ...);
+   return result;
+}
+//---------------------------------------------------------------------------
+/// A conversion between types
+class CastEvaluator : public ComputedEvaluator {
+   public:
+   /// Constructor
+   CastEvaluator(unique_ptr<Evaluator> input, ValueType type) : ComputedEvaluator(type, makeInputs(move(input))) { deriveType(type); }
+
+   /// Evaluate
+   const Vector& evaluate(const Batch& batch) override;
+   /// Generate code
+   optional<RowCode::Variable> generate(RowCode& code) const override;
+};
+//---------------------------------------------------------------------------
+const Vector& CastEvaluator::evaluate(const Batch& batch)
+// Evaluate
+{
+   auto& in = inputs[0]->evaluate(batch);
+   ValueType from = inputs[0]->getType();
+   unsigned count = batch.size;
+
+   // A NULL constant
+   if (from.getKind() == ValueType::Null) {
+      result.allocate(count, true);
+      memset(result.getNulls(), 1, count);
+      return result;
+   }
+
+   // Numeric conversions
+   if (from.isNumeric() && type.isNumeric()) {
+      prepareNulls(result, count, in);
+      auto out = (type.getKind() == ValueType::Integer) ? nullptr : result.getData<Int128>();
+      // NULL rows hold arbitrary values that must not raise errors
+      auto nulls = result.getNulls();
+      auto valid = [nulls](unsigned index) { return !(nulls && nulls[index]); };
+      if (from.getKind() == ValueType::Integer) {
+         auto values = in.getData<int64_t>();
+         Int128 factor = values::pow10(type.getScale());
+         if (out) {
+            for (unsigned index = 0; index != count; ++index)
+               out[index] = valid(index) ? values::checkedMul<Int128>(values[index], factor) : 0;
+         } else {
+            memcpy(result.getData<int64_t>(), values, count * sizeof(int64_t));
+         }
+      } else {
+         auto values = in.getData<Int128>();
+         if (out) {
+            if (type.getScale() >= from.getScale()) {
+               Int128 factor = values::pow10(type.getScale() - from.getScale());
+               for (unsigned index = 0; index != count; ++index)
+                  out[index] = valid(index) ? values::checkedMul(values[index], factor) : 0;
+            } else {
+               for (unsigned index = 0; index != count; ++index)
+                  out[index] = values::rescale(values[index], from.getScale(), type.getScale());
+            }
+         } else {
+            auto integers = result.getData<int64_t>();
+            for (unsigned index = 0; index != count; ++index)
+               integers[index] = valid(index) ? values::checkedInteger(values::rescale(values[index], from.getScale(), 0)) : 0;
+         }
+      }
+      return result;
+   }
+
+   // Convert row by row
+   result.allocate(count, in.getNulls());
+   auto& heap = result.accessHeap();
+   for (unsigned index = 0; index != count; ++index)
+      result.set(index, ExpressionCompiler::cast(in.get(index), from, type, heap));
+   return result;
+}
+//---------------------------------------------------------------------------
+optional<RowCode::Variable> CastEvaluator::generate(RowCode& code) const
+// Generate code
+{
+   ValueType from = inputs[0]->getType();
+   if (from.getKind() == ValueType::Null) return RowCode::Variable{RowCode::makeLiteral(type, Value::makeNull()), "true"};
+
+   // Only the numeric conversions, the conversions from and to strings remain vectorized
+   bool numericFrom = from.isNumeric() || (from.getKind() == ValueType::Bool), numericTo = type.isNumeric() || (type.getKind() == ValueType::Bool);
+   if ((!numericFrom) || (!numericTo)) return nullopt;
+   auto in = inputs[0]->generate(code);
+   if (!in) return nullopt;
+   string value;
+   if (type.getKind() == ValueType::Bool)
+      value = "(" + in->value + " != 0)";
+   else if (type.getKind() == ValueType::Integer)
+      value = generateChecked(in->null, "INT64_C(0)", "rt::checkedInteger(" + generateRescale("Int128(" + in->value + ")", from.getScale(), 0) + ")");
+   else
+      value = generateChecked(in->null, "Int128(0)", generateRescale("Int128(" + in->value + ")", from.getScale(), type.getScale()));
+   return code.define(type, value, in->null);
+}
+//---------------------------------------------------------------------------
+/// Arithmetic on integers
+class IntegerArithmetic : public ComputedEvaluator {
+   /// The operation
+   algebra::BinaryExpression::Operation op;
+
+   public:
+   /// Constructor
+   IntegerArithmetic(unique_ptr<Evaluator> left, unique_ptr<Evaluator> right, algebra::BinaryExpression::Operation op) : ComputedEvaluator(ValueType(ValueType::Integer, 0, true), makeInputs(move(left), move(right))), op(op) {}
+
+   /// Evaluate
+   const Vector& evaluate(const Batch& batch) override;
+   /// Generate code
+   optional<RowCode::Variable> generate(RowCode& code) const override;
+};
+//---------------------------------------------------------------------------
+const Vector& IntegerArithmetic::evaluate(const Batch& batch)
+// Evaluate
+{
+   auto &l = inputs[0]->evaluate(batch), &r = inputs[1]->evaluate(batch);
+   unsigned count = batch.size;
+   auto a = l.getData<int64_t>(), b = r.getData<int64_t>();
+   auto out = result.getData<int64_t>();
+   auto loop = [&](auto f) {
+      // NULL rows hold arbitrary values that must not raise errors
+      if (prepareNulls(result, count, l, &r)) {
+         auto nulls = result.getNulls();
+         out = result.getData<int64_t>();
+         for (unsigned index = 0; index != count; ++index)
+            out[index] = nulls[index] ? 0 : f(a[index], b[index]);
+      } else {
+         out = result.getData<int64_t>();
+         for (unsigned index = 0; index != count; ++index)
+            out[index] = f(a[index], b[index]);
+      }
+   };
+   // Results that do not fit raise an error
+   switch (op) {
+      case algebra::BinaryExpression::Plus: loop([](int64_t x, int64_t y) { return values::checkedAdd(x, y); }); break;
+      case algebra::BinaryExpression::Minus: loop([](int64_t x, int64_t y) { return values::checkedSub(x, y); }); break;
+      case algebra::BinaryExpression::Mul: loop([](int64_t x, int64_t y) { return values::checkedMul(x, y); }); break;
+      case algebra::BinaryExpression::Power: loop([](int64_t x, int64_t y) { return values::checkedInteger(values::checkedRound(pow(static_cast<double>(x), static_cast<double>(y)))); }); break;
+      case algebra::BinaryExpression::Div:
+      case algebra::BinaryExpression::Mod: {
+         bool div = op == algebra::BinaryExpression::Div;
+         result.allocate(count, true);
+         out = result.getData<int64_t>();
+         auto nulls = result.getNulls();
+         auto na = l.getNulls(), nb = r.getNulls();
+         for (unsigned index = 0; index != count; ++index) {
+            bool null = (na && na[index]) || (nb && nb[index]) || (!b[index]) || ((b[index] == -1) && (a[index] == numeric_limits<int64_t>::min()));
+            nulls[index] = null;
+            out[index] = null ? 0 : (div ? a[index] / b[index] : a[index] % b[index]);
+         }
+         break;
+      }
+      default: throw runtime_error("unsupported integer operation");
+   }
+   return result;
+}
+//---------------------------------------------------------------------------
+optional<RowCode::Variable> IntegerArithmetic::generate(RowCode& code) const
+// Generate code
+{
+   vector<RowCode::Variable> in;
+   string null;
+   if (!generateInputs(code, in, null)) return nullopt;
+   auto &a = in[0].value, &b = in[1].value;
+   auto checked = [&](const char* f) { return generateChecked(null, "INT64_C(0)", string("rt::") + f + "(" + a + ", " + b + ")"); };
+   switch (op) {
+      case algebra::BinaryExpression::Plus: return code.define(type, checked("checkedAdd"), null);
+      case algebra::BinaryExpression::Minus: return code.define(type, checked("checkedSub"), null);
+      case algebra::BinaryExpression::Mul: return code.define(type, checked("checkedMul"), null);
+      case algebra::BinaryExpression::Div:
+      case algebra::BinaryExpression::Mod: {
+         auto invalid = code.define(ValueType(ValueType::Bool), "(" + null + " || (" + b + " == 0) || ((" + b + " == -1) && (" + a + " == INT64_MIN)))", "false");
+         return code.define(type, invalid.value + " ? INT64_C(0) : (" + a + ((op == algebra::BinaryExpression::Div) ? " / " : " % ") + b + ")", invalid.value);
+      }
+      default: return nullopt;
+   }
+}
+//---------------------------------------------------------------------------
+/// Arithmetic on decimals
+class DecimalArithmetic : public ComputedEvaluator {
+   /// The operation
+   algebra::BinaryExpression::Operation op;
+
+   public:
+   /// Constructor
+   DecimalArithmetic(unique_ptr<Evaluator> left, unique_ptr<Evaluator> right, algebra::BinaryExpression::Operation op, ValueType type) : ComputedEvaluator(type, makeInputs(move(left), move(right))), op(op) {}
+
+   /// Evaluate
+   const Vector& evaluate(const Batch& batch) override;
+   /// Generate code
+   optional<RowCode::Variable> generate(RowCode& code) const override;
+};
+//---------------------------------------------------------------------------
+const Vector& DecimalArithmetic::evaluate(const Batch& batch)
+// Evaluate
+{
+   auto &l = inputs[0]->evaluate(batch), &r = inputs[1]->evaluate(batch);
+   unsigned count = batch.size;
+   unsigned sl = inputs[0]->getType().getScale(), sr = inputs[1]->getType().getScale(), s = type.getScale();
+   auto a = l.getData<Int128>(), b = r.getData<Int128>();
+   auto loop = [&](auto f) {
+      // NULL rows hold arbitrary values that must not raise errors
+      if (prepareNulls(result, count, l, &r)) {
+         auto nulls = result.getNulls();
+         auto out = result.getData<Int128>();
+         for (unsigned index = 0; index != count; ++index)
+            out[index] = nulls[index] ? 0 : f(a[index], b[index]);
+      } else {
+         auto out = result.getData<Int128>();
+         for (unsigned index = 0; index != count; ++index)
+            out[index] = f(a[index], b[index]);
+      }
+   };
+   // Results that do not fit raise an error
+   switch (op) {
+      case algebra::BinaryExpression::Plus: loop([](Int128 x, Int128 y) { return values::checkedAdd(x, y); }); break;
+      case algebra::BinaryExpression::Minus: loop([](Int128 x, Int128 y) { return values::checkedSub(x, y); }); break;
+      case algebra::BinaryExpression::Mul:
+         if (sl + sr == s) {
+            loop([](Int128 x, Int128 y) { return values::checkedMul(x, y); });
+         } else {
+            loop([&](Int128 x, Int128 y) { return values::rescale(values::checkedMul(x, y), sl + sr, s); });
+         }
+         break;
+      case algebra::BinaryExpression::Power:
+         loop([&](Int128 x, Int128 y) {
+            double v = pow(static_cast<double>(x) / static_cast<double>(values::pow10(sl)), static_cast<double>(y) / static_cast<double>(values::pow10(sr)));
+            return values::checkedRound(v * static_cast<double>(values::pow10(s)));
+         });
+         break;
+      case algebra::BinaryExpression::Div:
+      case algebra::BinaryExpression::Mod: {
+         bool div = op == algebra::BinaryExpression::Div;
+         Int128 factor = values::pow10(s - sl + sr);
+         result.allocate(count, true);
+         auto out = result.getData<Int128>();
+         auto nulls = result.getNulls();
+         auto na = l.getNulls(), nb = r.getNulls();
+         for (unsigned index = 0; index != count; ++index) {
+            bool null = (na && na[index]) || (nb && nb[index]) || (!b[index]);
+            nulls[index] = null;
+            out[index] = null ? 0 : (div ? values::divideRounded(values::checkedMul(a[index], factor), b[index]) : a[index] % b[index]);
+         }
+         break;
+      }
+      default: throw runtime_error("unsupported decimal operation");
+   }
+   return result;
+}
+//---------------------------------------------------------------------------
+optional<RowCode::Variable> DecimalArithmetic::generate(RowCode& code) const
+// Generate code
+{
+   vector<RowCode::Variable> in;
+   string null;
+   if (!generateInputs(code, in, null)) return nullopt;
+   unsigned sl = inputs[0]->getType().getScale(), sr = inputs[1]->getType().getScale(), s = type.getScale();
+   auto &a = in[0].value, &b = in[1].value;
+   switch (op) {
+      case algebra::BinaryExpression::Plus: return code.define(type, generateChecked(null, "Int128(0)", "rt::checkedAdd(" + a + ", " + b + ")"), null);
+      case algebra::BinaryExpression::Minus: return code.define(type, generateChecked(null, "Int128(0)", "rt::checkedSub(" + a + ", " + b + ")"), null);
+      case algebra::BinaryExpression::Mul: return code.define(type, generateChecked(null, "Int128(0)", generateRescale("rt::checkedMul(" + a + ", " + b + ")", sl + sr, s)), null);
+      case algebra::BinaryExpression::Div:
+      case algebra::BinaryExpression::Mod: {
+         auto invalid = code.define(ValueType(ValueType::Bool), "(" + null + " || (" + b + " == 0))", "false");
+         string value = (op == algebra::BinaryExpression::Div) ? "rt::divideRounded(rt::checkedMul(" + a + ", " + makePower(s - sl + sr) + "), " + b + ")" : "(" + a + " % " + b + ")";
+         return code.define(type, invalid.value + " ? Int128(0) : " + value, invalid.value);
+      }
+      default: return nullopt;
+   }
+}
+//---------------------------------------------------------------------------
+/// Addition or subtraction of intervals to dates
+class DateArithmetic : public ComputedEvaluator {
+   /// Subtract?
+   bool subtract;
+
+   public:
+   /// Constructor
+   DateArithmetic(unique_ptr<Evaluator> left, unique_ptr<Evaluator> right, bool subtract) : ComputedEvaluator(ValueType::Date, makeInputs(move(left), move(right))), subtract(subtract) { deriveType(ValueType::Date); }
+
+   /// Evaluate
+   const Vector& evaluate(const Batch& batch) override {
+      auto &l = inputs[0]->evaluate(batch), &r = inputs[1]->evaluate(batch);
+      prepareNulls(result, batch.size, l, &r);
+      auto a = l.getData<int32_t>();
+      auto b = r.getData<int64_t>();
+      auto out = result.getData<int32_t>();
+      for (unsigned index = 0; index != batch.size; ++index) {
+         auto interval = b[index];
+         if (subtract) interval = values::makeInterval(-values::getMonths(interval), -values::getDays(interval));
+         out[index] = values::addInterval(a[index], interval);
+      }
+      return result;
+   }
+   /// Generate code
+   optional<RowCode::Variable> generate(RowCode& code) const override {
+      vector<RowCode::Variable> in;
+      string null;
+      if (!generateInputs(code, in, null)) return nullopt;
+      string interval = subtract ? "rt::negateInterval(" + in[1].value + ")" : in[1].value;
+      return code.define(type, "rt::addInterval(" + in[0].value + ", " + interval + ")", null);
+   }
+};
+//---------------------------------------------------------------------------
+/// String concatenation
+class ConcatEvaluator : public ComputedEvaluator {
+   public:
+   /// Constructor
+   ConcatEvaluator(unique_ptr<Evaluator> left, unique_ptr<Evaluator> right) : ComputedEvaluator(ValueType::String, makeInputs(move(left), move(right))) { deriveType(ValueType::String); }
+
+   /// Evaluate
+   const Vector& evaluate(const Batch& batch) override {
+      auto &l = inputs[0]->evaluate(batch), &r = inputs[1]->evaluate(batch);
+      prepareNulls(result, batch.size, l, &r);
+      auto a = l.getData<string_view>(), b = r.getData<string_view>();
+      auto out = result.getData<string_view>();
+      auto& heap = result.accessHeap();
+      for (unsigned index = 0; index != batch.size; ++index) {
+         if (result.isNull(index)) {
+            out[index] = {};
+            continue;
+         }
+         char* target = heap.allocate(a[index].size() + b[index].size());
+         memcpy(target, a[index].data(), a[index].size());
+         memcpy(target + a[index].size(), b[index].data(), b[index].size());
+         out[index] = string_view(target, a[index].size() + b[index].size());
+      }
+      return result;
+   }
+};
+//---------------------------------------------------------------------------
+/// Compare two values of a physical type
+template <class T>
+static int compareValues(const T& a, const T& b) {
+   if constexpr (is_same_v<T, string_view>) {
+      int c = a.compare(b);
+      return (c < 0) ? -1 : (c > 0);
+   } else {
+      return (a < b) ? -1 : (a > b);
+   }
+}
+//---------------------------------------------------------------------------
+/// A comparison of two values of the same type
+class ComparisonEvaluator : public ComputedEvaluator {
+   /// The mode
+   algebra::ComparisonExpression::Mode mode;
+
+   public:
+   /// Constructor
+   ComparisonEvaluator(unique_ptr<Evaluator> left, unique_ptr<Evaluator> right, algebra::ComparisonExpression::Mode mode) : ComputedEvaluator(ValueType::Bool, makeInputs(move(left), move(right))), mode(mode) {
+      deriveType(ValueType::Bool);
+      if ((mode == algebra::ComparisonExpression::Is) || (mode == algebra::ComparisonExpression::IsNot)) type = type.withNullable(false);
+   }
+
+   /// Evaluate
+   const Vector& evaluate(const Batch& batch) override;
+   /// Generate code
+   optional<RowCode::Variable> generate(RowCode& code) const override;
+};
+//---------------------------------------------------------------------------
+const Vector& ComparisonEvaluator::evaluate(const Batch& batch)
+// Evaluate
+{
+   auto &l = inputs[0]->evaluate(batch), &r = inputs[1]->evaluate(batch);
+   unsigned count = batch.size;
+   using Mode = algebra::ComparisonExpression::Mode;
+   bool distinct = (mode == Mode::Is) || (mode == Mode::IsNot);
+   if (distinct)
+      result.allocate(count, false);
+   else
+      prepareNulls(result, count, l, &r);
+   auto out = result.getData<uint8_t>();
+   dispatch(inputs[0]->getType().getPhysicalType(), [&]<class T>(T*) {
+      auto a = l.getData<T>(), b = r.getData<T>();
+      auto loop = [&](auto f) {
+         for (unsigned index = 0; index != count; ++index)
+            out[index] = f(a[index], b[index]);
+      };
+      switch (mode) {
+         case Mode::Equal:
+         case Mode::Is: loop([](const T& x, const T& y) { return x == y; }); break;
+         case Mode::NotEqual:
+         case Mode::IsNot: loop([](const T& x, const T& y) { return x != y; }); break;
+         case Mode::Less: loop([](const T& x, const T& y) { return compareValues(x, y) < 0; }); break;
+         case Mode::LessOrEqual: loop([](const T& x, const T& y) { return compareValues(x, y) <= 0; }); break;
+         case Mode::Greater: loop([](const T& x, const T& y) { return compareValues(x, y) > 0; }); break;
+         case Mode::GreaterOrEqual: loop([](const T& x, const T& y) { return compareValues(x, y) >= 0; }); break;
+         case Mode::Like: break;
+      }
+   });
+
+   // NULL values are equal for is and is not
+   if (distinct && (l.getNulls() || r.getNulls())) {
+      bool equal = mode == Mode::Is;
+      for (unsigned index = 0; index != count; ++index) {
+         bool nl = l.isNull(index), nr = r.isNull(index);
+         if (nl || nr) out[index] = (nl && nr) == equal;
+      }
+   }
+   return result;
+}
+//---------------------------------------------------------------------------
+optional<RowCode::Variable> ComparisonEvaluator::generate(RowCode& code) const
+// Generate code
+{
+   using Mode = algebra::ComparisonExpression::Mode;
+   const char* o;
+   switch (mode) {
+      case Mode::Equal:
+      case Mode::Is: o = " == "; break;
+      case Mode::NotEqual:
+      case Mode::IsNot: o = " != "; break;
+      case Mode::Less: o = " < "; break;
+      case Mode::LessOrEqual: o = " <= "; break;
+      case Mode::Greater: o = " > "; break;
+      case Mode::GreaterOrEqual: o = " >= "; break;
+      default: return nullopt;
+   }
+   vector<RowCode::Variable> in;
+   string null;
+   if (!generateInputs(code, in, null)) return nullopt;
+   string value = "(" + in[0].value + o + in[1].value + ")";
+   if ((mode != Mode::Is) && (mode != Mode::IsNot)) return code.define(type, value, null);
+
+   // NULL values are equal for is and is not
+   auto &nl = in[0].null, &nr = in[1].null;
+   return code.define(type, "(" + null + " ? ((" + nl + " && " + nr + ") == " + ((mode == Mode::Is) ? "true" : "false") + ") : " + value + ")", "false");
+}
+//---------------------------------------------------------------------------
+/// A like pattern
+class LikePattern {
+   /// The shapes with fast paths
+   enum class Shape { Exact, Prefix, Suffix, Contains, General };
+
+   /// The pattern
+   string pattern;
+   /// The shape
+   Shape shape;
+   /// The literal part for the fast paths
+   string literal;
+
+   /// Match the general form
+   bool matchGeneral(string_view text) const;
+
+   public:
+   /// Constructor
+   explicit LikePattern(string_view p);
+
+   /// Generate code that matches a string
+   string generate(const string& text) const;
+   /// Match a string
+   bool match(string_view text) const {
+      switch (shape) {
+         case Shape::Exact: return text == literal;
+         case Shape::Prefix: return text.starts_with(literal);
+         case Shape::Suffix: return text.ends_with(literal);
+         case Shape::Contains: return text.find(literal) != string_view::npos;
+         case Shape::General: return matchGeneral(text);
+      }
+      __builtin_unreachable();
+   }
+};
+//---------------------------------------------------------------------------
+LikePattern::LikePattern(string_view p)
+   : pattern(p), shape(Shape::General)
+// Constructor
+{
+   // Recognize the common shapes without wildcards in the literal part
+   if (p.find_first_of("_\\") != string_view::npos) return;
+   string_view inner = p;
+   bool leading = inner.starts_with('%'), trailing = (inner.size() > leading) && inner.ends_with('%');
+   if (leading) inner.remove_prefix(1);
+   if (trailing) inner.remove_suffix(1);
+   if (inner.find('%') != string_view::npos) return;
+   literal = inner;
+   shape = leading ? (trailing ? Shape::Contains : Shape::Suffix) : (trailing ? Shape::Prefix : Shape::Exact);
+}
+//---------------------------------------------------------------------------
+bool LikePattern::matchGeneral(string_view text) const
+// Match the general form
+{
+   // Greedy matching with backtracking to the last %
+   size_t t = 0, p = 0, starP = string::npos, starT = 0;
+   while (t < text.size()) {
+      if (p < pattern.size()) {
+         char c = pattern[p];
+         if (c == '%') {
+            starP = ++p;
+            starT = t;
+            continue;
+         }
+         bool escaped = (c == '\\') && (p + 1 < pattern.size());
+         if (escaped) c = pattern[p + 1];
+         if (((c == '_') && (!escaped)) || (c == text[t])) {
+            p += escaped ? 2 : 1;
+            ++t;
+            continue;
+         }
+      }
+      if (starP == string::npos) return false;
+      p = starP;
+      t = ++starT;
+   }
+   while ((p < pattern.size()) && (pattern[p] == '%')) ++p;
+   return p == pattern.size();
+}
+//---------------------------------------------------------------------------
+string LikePattern::generate(const string& text) const
+// Generate code that matches a string
+{
+   auto makeString = [](string_view str) { return RowCode::makeLiteral(ValueType(ValueType::String), Value::makeString(str)); };
+   switch (shape) {
+      case Shape::Exact: return "(" + text + " == " + makeString(literal) + ")";
+      case Shape::Prefix: return text + ".starts_with(" + makeString(literal) + ")";
+      case Shape::Suffix: return text + ".ends_with(" + makeString(literal) + ")";
+      case Shape::Contains: return "(" + text + ".find(" + makeString(literal) + ") != std::string_view::npos)";
+      case Shape::General: return "rt::like(" + text + ", " + makeString(pattern) + ")";
+   }
+   __builtin_unreachable();
+}
+//---------------------------------------------------------------------------
+/// A like comparison
+class LikeEvaluator : public ComputedEvaluator {
+   /// The pattern if it is constant
+   optional<LikePattern> pattern;
+
+   public:
+   /// Constructor
+   LikeEvaluator(unique_ptr<Evaluator> left, unique_ptr<Evaluator> right) : ComputedEvaluator(ValueType::Bool, makeInputs(move(left), move(right))) {
+      deriveType(ValueType::Bool);
+      if (inputs[1]->isConstant()) {
+         Batch empty;
+         empty.size = 1;
+         auto value = inputs[1]->evaluate(empty).get(0);
+         if (!value.null) pattern.emplace(value.str);
+      }
+   }
+
+   /// Evaluate
+   const Vector& evaluate(const Batch& batch) override {
+      auto &l = inputs[0]->evaluate(batch), &r = inputs[1]->evaluate(batch);
+      prepareNulls(result, batch.size, l, &r);
+      auto a = l.getData<string_view>(), b = r.getData<string_view>();
+      auto out = result.getData<uint8_t>();
+      if (pattern) {
+         for (unsigned index = 0; index != batch.size; ++index)
+            out[index] = pattern->match(a[index]);
+      } else {
+         for (unsigned index = 0; index != batch.size; ++index)
+            out[index] = result.isNull(index) ? 0 : LikePattern(b[index]).match(a[index]);
+      }
+      return result;
+   }
+   /// Generate code
+   optional<RowCode::Variable> generate(RowCode& code) const override {
+      vector<RowCode::Variable> in;
+      string null;
+      if (!generateInputs(code, in, null)) return nullopt;
+      return code.define(type, pattern ? pattern->generate(in[0].value) : "rt::like(" + in[0].value + ", " + in[1].value + ")", null);
+   }
+};
+//---------------------------------------------------------------------------
+/// A between check
+class BetweenEvaluator : public ComputedEvaluator {
+   public:
+   /// Constructor
+   BetweenEvaluator(unique_ptr<Evaluator> base, unique_ptr<Evaluator> lower, unique_ptr<Evaluator> upper) : ComputedEvaluator(ValueType::Bool, makeInputs(move(base), move(lower), move(upper))) { deriveType(ValueType::Bool); }
+
+   /// Evaluate
+   const Vector& evaluate(const Batch& batch) override {
+      auto &v = inputs[0]->evaluate(batch), &lo = inputs[1]->evaluate(batch), &hi = inputs[2]->evaluate(batch);
+      unsigned count = batch.size;
+      bool nulls = v.getNulls() || lo.getNulls() || hi.getNulls();
+      result.allocate(count, nulls);
+      auto out = result.getData<uint8_t>();
+      dispatch(inputs[0]->getType().getPhysicalType(), [&]<class T>(T*) {
+         auto a = v.getData<T>(), l = lo.getData<T>(), h = hi.getData<T>();
+         if (!nulls) {
+            for (unsigned index = 0; index != count; ++index)
+               out[index] = (compareValues(l[index], a[index]) <= 0) && (compareValues(a[index], h[index]) <= 0);
+            return;
+         }
+         // Three-valued logic, the result is false if one of the bounds fails
+         auto resultNulls = result.getNulls();
+         for (unsigned index = 0; index != count; ++index) {
+            if (v.isNull(index)) {
+               out[index] = 0;
+               resultNulls[index] = 1;
+               continue;
+            }
+            bool lowerNull = lo.isNull(index), upperNull = hi.isNull(index);
+            bool lowerFails = (!lowerNull) && (compareValues(l[index], a[index]) > 0), upperFails = (!upperNull) && (compareValues(a[index], h[index]) > 0);
+            out[index] = (!lowerFails) && (!upperFails) && (!lowerNull) && (!upperNull);
+            resultNulls[index] = (!lowerFails) && (!upperFails) && (lowerNull || upperNull);
+         }
+      });
+      return result;
+   }
+   /// Generate code
+   optional<RowCode::Variable> generate(RowCode& code) const override {
+      vector<RowCode::Variable> in;
+      if (!generateInputs(code, in)) return nullopt;
+      auto &v = in[0], &lo = in[1], &hi = in[2];
+      if (!type.isNullable()) return code.define(type, "((" + lo.value + " <= " + v.value + ") && (" + v.value + " <= " + hi.value + "))", "false");
+      // Three-valued logic, the result is false if one of the bounds fails
+      auto fails = code.define(ValueType(ValueType::Bool), "((!" + lo.null + " && (" + v.value + " < " + lo.value + ")) || (!" + hi.null + " && (" + hi.value + " < " + v.value + ")))", "false");
+      return code.define(type, "(!" + v.null + " && !" + lo.null + " && !" + hi.null + " && !" + fails.value + ")", "(" + v.null + " || (!" + fails.value + " && (" + lo.null + " || " + hi.null + ")))");
+   }
+};
+//---------------------------------------------------------------------------
+/// An in check
+class InEvaluator : public ComputedEvaluator {
+   public:
+   /// Constructor
+   InEvaluator(vector<unique_ptr<Evaluator>> inputs) : ComputedEvaluator(ValueType::Bool, move(inputs)) { deriveType(ValueType::Bool); }
+
+   /// Evaluate
+   const Vector& evaluate(const Batch& batch) override {
+      auto& probe = inputs[0]->evaluate(batch);
+      unsigned count = batch.size;
+      result.allocate(count, type.isNullable());
+      auto out = result.getData<uint8_t>();
+      auto nulls = result.getNulls();
+      memset(out, 0, count);
+      if (nulls) memcpy(nulls, probe.getNulls() ? probe.getNulls() : out, count);
+      dispatch(inputs[0]->getType().getPhysicalType(), [&]<class T>(T*) {
+         auto a = probe.getData<T>();
+         for (unsigned value = 1; value != inputs.size(); ++value) {
+            auto& v = inputs[value]->evaluate(batch);
+            auto b = v.getData<T>();
+            if (!v.getNulls()) {
+               for (unsigned index = 0; index != count; ++index)
+                  out[index] |= a[index] == b[index];
+            } else {
+               // A NULL in the list makes non-matching rows NULL
+               for (unsigned index = 0; index != count; ++index) {
+                  if (v.isNull(index))
+                     nulls[index] = 1;
+                  else
+                     out[index] |= a[index] == b[index];
+               }
+            }
+         }
+      });
+      if (nulls)
+         for (unsigned index = 0; index != count; ++index) {
+            if (probe.isNull(index)) out[index] = 0;
+            if (out[index]) nulls[index] = 0;
+         }
+      return result;
+   }
+   /// Generate code
+   optional<RowCode::Variable> generate(RowCode& code) const override {
+      vector<RowCode::Variable> in;
+      string null;
+      if (!generateInputs(code, in, null)) return nullopt;
+      // A NULL in the list makes non-matching rows NULL
+      string match;
+      for (unsigned index = 1; index != in.size(); ++index)
+         match += (match.empty() ? "(!" : " || (!") + in[index].null + " && (" + in[0].value + " == " + in[index].value + "))";
+      auto found = code.define(ValueType(ValueType::Bool), "(!" + in[0].null + " && (" + match + "))", "false");
+      return code.define(type, found.value, "(!" + found.value + " && " + null + ")");
+   }
+};
+//---------------------------------------------------------------------------
+/// A boolean and or or
+class LogicEvaluator : public ComputedEvaluator {
+   /// And?
+   bool isAnd;
+
+   public:
+   /// Constructor
+   LogicEvaluator(unique_ptr<Evaluator> left, unique_ptr<Evaluator> right, bool isAnd) : ComputedEvaluator(ValueType::Bool, makeInputs(move(left), move(right))), isAnd(isAnd) { deriveType(ValueType::Bool); }
+
+   /// Evaluate
+   const Vector& evaluate(const Batch& batch) override {
+      auto &l = inputs[0]->evaluate(batch), &r = inputs[1]->evaluate(batch);
+      unsigned count = batch.size;
+      auto a = l.getData<uint8_t>(), b = r.getData<uint8_t>();
+      auto na = l.getNulls(), nb = r.getNulls();
+      result.allocate(count, na || nb);
+      auto out = result.getData<uint8_t>();
+      if (!(na || nb)) {
+         if (isAnd) {
+            for (unsigned index = 0; index != count; ++index)
+               out[index] = a[index] & b[index];
+         } else {
+            for (unsigned index = 0; index != count; ++index)
+               out[index] = a[index] | b[index];
+         }
+         return result;
+      }
+      // Three-valued logic. A false input decides and, a true input decides or
+      auto nulls = result.getNulls();
+      for (unsigned index = 0; index != count; ++index) {
+         bool nl = na && na[index], nr = nb && nb[index];
+         bool decided = ((!nl) && (a[index] != isAnd)) || ((!nr) && (b[index] != isAnd));
+         out[index] = decided ? !isAnd : isAnd;
+         nulls[index] = (!decided) && (nl || nr);
+      }
+      return result;
+   }
+   /// Generate code
+   optional<RowCode::Variable> generate(RowCode& code) const override {
+      vector<RowCode::Variable> in;
+      string null;
+      if (!generateInputs(code, in, null)) return nullopt;
+      auto &l = in[0], &r = in[1];
+      if (!type.isNullable()) return code.define(type, "(" + l.value + (isAnd ? " && " : " || ") + r.value + ")", "false");
+      // Three-valued logic. A false input decides and, a true input decides or
+      string test = isAnd ? "!" : "";
+      auto decided = code.define(ValueType(ValueType::Bool), "((!" + l.null + " && " + test + l.value + ") || (!" + r.null + " && " + test + r.value + "))", "false");
+      return code.define(type, test + decided.value, "(!" + decided.value + " && " + null + ")");
+   }
+};
+//---------------------------------------------------------------------------
+/// A unary operation
+class UnaryEvaluator : public ComputedEvaluator {
+   /// The operation
+   algebra::UnaryExpression::Operation op;
+
+   public:
+   /// Constructor
+   UnaryEvaluator(unique_ptr<Evaluator> input, algebra::UnaryExpression::Operation op) : ComputedEvaluator(ValueType(), makeInputs(move(input))), op(op) { deriveType(inputs[0]->getType()); }
+
+   /// Evaluate
+   const Vector& evaluate(const Batch& batch) override {
+      auto& in = inputs[0]->evaluate(batch);
+      prepareNulls(result, batch.size, in);
+      unsigned count = batch.size;
+      switch (type.getKind()) {
+         case ValueType::Bool: {
+            auto a = in.getData<uint8_t>();
+            auto out = result.getData<uint8_t>();
+            for (unsigned index = 0; index != count; ++index)
+               out[index] = !a[index];
+            break;
+         }
+         case ValueType::Integer: {
+            auto a = in.getData<int64_t>();
+            auto out = result.getData<int64_t>();
+            auto nulls = result.getNulls();
+            for (unsigned index = 0; index != count; ++index)
+               out[index] = (nulls && nulls[index]) ? 0 : values::checkedSub<int64_t>(0, a[index]);
+            break;
+         }
+         case ValueType::Decimal: {
+            auto a = in.getData<Int128>();
+            auto out = result.getData<Int128>();
+            auto nulls = result.getNulls();
+            for (unsigned index = 0; index != count; ++index)
+               out[index] = (nulls && nulls[index]) ? 0 : values::checkedSub<Int128>(0, a[index]);
+            break;
+         }
+         case ValueType::Interval: {
+            auto a = in.getData<int64_t>();
+            auto out = result.getData<int64_t>();
+            for (unsigned index = 0; index != count; ++index)
+               out[index] = values::makeInterval(-values::getMonths(a[index]), -values::getDays(a[index]));
+            break;
+         }
+         default: throw runtime_error("unsupported unary operation on " + type.getName());
+      }
+      return result;
+   }
+   /// Generate code
+   optional<RowCode::Variable> generate(RowCode& code) const override {
+      auto in = inputs[0]->generate(code);
+      if (!in) return nullopt;
+      switch (type.getKind()) {
+         case ValueType::Bool: return code.define(type, "!" + in->value, in->null);
+         case ValueType::Integer: return code.define(type, generateChecked(in->null, "INT64_C(0)", "rt::checkedSub(INT64_C(0), " + in->value + ")"), in->null);
+         case ValueType::Decimal: return code.define(type, generateChecked(in->null, "Int128(0)", "rt::checkedSub(Int128(0), " + in->value + ")"), in->null);
+         case ValueType::Interval: return code.define(type, "rt::negateInterval(" + in->value + ")", in->null);
+         default: return nullopt;
+      }
+   }
+};
+//---------------------------------------------------------------------------
+/// An extract of a date part
+class ExtractEvaluator : public ComputedEvaluator {
+   /// The part
+   algebra::ExtractExpression::Part part;
+
+   public:
+   /// Constructor
+   ExtractEvaluator(unique_ptr<Evaluator> input, algebra::ExtractExpression::Part part) : ComputedEvaluator(ValueType::Integer, makeInputs(move(input))), part(part) { deriveType(ValueType::Integer); }
+
+   /// Evaluate
+   const Vector& evaluate(const Batch& batch) override {
+      auto& in = inputs[0]->evaluate(batch);
+      prepareNulls(result, batch.size, in);
+      auto a = in.getData<int32_t>();
+      auto out = result.getData<int64_t>();
+      for (unsigned index = 0; index != batch.size; ++index) {
+         int year;
+         unsigned month, day;
+         values::splitDate(a[index], year, month, day);
+         switch (part) {
+            case algebra::ExtractExpression::Year: out[index] = year; break;
+            case algebra::ExtractExpression::Month: out[index] = month; break;
+            case algebra::ExtractExpression::Day: out[index] = day; break;
+         }
+      }
+      return result;
+   }
+   /// Generate code
+   optional<RowCode::Variable> generate(RowCode& code) const override {
+      auto in = inputs[0]->generate(code);
+      if (!in) return nullopt;
+      const char* function = "";
+      switch (part) {
+         case algebra::ExtractExpression::Year: function = "rt::extractYear("; break;
+         case algebra::ExtractExpression::Month: function = "rt::extractMonth("; break;
+         case algebra::ExtractExpression::Day: function = "rt::extractDay("; break;
+      }
+      return code.define(type, function + in->value + ")", in->null);
+   }
+};
+//---------------------------------------------------------------------------
+/// A substring
+class SubstrEvaluator : public ComputedEvaluator {
+   /// Are from and len given?
+   bool hasFrom, hasLen;
+
+   public:
+   /// Constructor
+   SubstrEvaluator(vector<unique_ptr<Evaluator>> inputs, bool hasFrom, bool hasLen) : ComputedEvaluator(ValueType::String, move(inputs)), hasFrom(hasFrom), hasLen(hasLen) { deriveType(ValueType::String); }
+
+   /// Evaluate
+   const Vector& evaluate(const Batch& batch) override {
+      auto& in = inputs[0]->evaluate(batch);
+      const Vector* from = hasFrom ? &inputs[1]->evaluate(batch) : nullptr;
+      const Vector* len = hasLen ? &inputs[1 + hasFrom]->evaluate(batch) : nullptr;
+      unsigned count = batch.size;
+      result.allocate(count, type.isNullable());
+      auto a = in.getData<string_view>();
+      auto out = result.getData<string_view>();
+      for (unsigned index = 0; index != count; ++index) {
+         if (in.isNull(index) || (from && from->isNull(index)) || (len && len->isNull(index))) {
+            result.set(index, Value::makeNull());
+            continue;
+         }
+         // The SQL semantics, positions start at 1 and may lie before the string
+         int64_t start = from ? from->getData<int64_t>()[index] : 1;
+         int64_t end = len ? start + len->getData<int64_t>()[index] : numeric_limits<int64_t>::max();
+         start = max<int64_t>(start, 1);
+         end = min<int64_t>(end, static_cast<int64_t>(a[index].size()) + 1);
+         if (result.getNulls()) result.getNulls()[index] = 0;
+         out[index] = (end > start) ? a[index].substr(start - 1, end - start) : string_view();
+      }
+      return result;
+   }
+   /// Generate code
+   optional<RowCode::Variable> generate(RowCode& code) const override {
+      vector<RowCode::Variable> in;
+      string null;
+      if (!generateInputs(code, in, null)) return nullopt;
+      string from = hasFrom ? in[1].value : "INT64_C(1)", len = hasLen ? in[1 + hasFrom].value : "INT64_C(0)";
+      return code.define(type, "rt::substr(" + in[0].value + ", " + from + ", " + (hasLen ? "true" : "false") + ", " + len + ")", null);
+   }
+};
+//---------------------------------------------------------------------------
+/// A case expression. The simple form compares a value with the cases, the searched form checks conditions
+class CaseEvaluator : public ComputedEvaluator {
+   /// The number of cases
+   unsigned caseCount;
+   /// Simple case?
+   bool simple;
+
+   public:
+   /// Constructor. The inputs are [value,] case1, result1, ..., default
+   CaseEvaluator(ValueType type, vector<unique_ptr<Evaluator>> inputs, unsigned caseCount, bool simple) : ComputedEvaluator(type, move(inputs)), caseCount(caseCount), simple(simple) {}
+
+   /// Evaluate
+   const Vector& evaluate(const Batch& batch) override {
+      unsigned count = batch.size;
+      const Vector* value = simple ? &inputs[0]->evaluate(batch) : nullptr;
+      vector<const Vector*> results;
+      for (auto& i : inputs)
+         results.push_back(&i->evaluate(batch));
+      result.allocate(count, type.isNullable());
+      ValueType caseType = inputs[simple]->getType();
+      for (unsigned index = 0; index != count; ++index) {
+         unsigned chosen = inputs.size() - 1;
+         for (unsigned c = 0; c != caseCount; ++c) {
+            auto& cond = *results[simple + 2 * c];
+            if (cond.isNull(index)) continue;
+            bool match = simple ? ((!value->isNull(index)) && (!values::compare(caseType, value->get(index), cond.get(index)))) : cond.getData<uint8_t>()[index];
+            if (match) {
+               chosen = simple + 2 * c + 1;
+               break;
+            }
+         }
+         result.set(index, results[chosen]->get(index));
+      }
+      return result;
+   }
+   /// Generate code
+   optional<RowCode::Variable> generate(RowCode& code) const override {
+      vector<RowCode::Variable> in;
+      if (!generateInputs(code, in)) return nullopt;
+      // Choose the first matching case, starting with the default
+      string value = in.back().value, null = in.back().null;
+      for (unsigned c = caseCount; c-- > 0;) {
+         auto &cond = in[simple + 2 * c], &then = in[simple + 2 * c + 1];
+         string match = simple ? "(!" + in[0].null + " && !" + cond.null + " && (" + in[0].value + " == " + cond.value + "))" : "(!" + cond.null + " && " + cond.value + ")";
+         auto m = code.define(ValueType(ValueType::Bool), match, "false");
+         value = "(" + m.value + " ? " + then.value + " : " + value + ")";
+         null = "(" + m.value + " ? " + then.null + " : " + null + ")";
+      }
+      return code.define(type, value, null);
+   }
+};
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
+unique_ptr<Evaluator> ExpressionCompiler::makeColumn(ValueType type, unsigned index)
+// Create a reference to a column of the evaluated batches
+{
+   return make_unique<ColumnEvaluator>(type, index);
+}
+//---------------------------------------------------------------------------
+unique_ptr<Evaluator> ExpressionCompiler::makeConstant(ValueType type, const Value& value)
+// Create a constant
+{
+   return make_unique<ConstantEvaluator>(type, value);
+}
+//---------------------------------------------------------------------------
+unique_ptr<Evaluator> ExpressionCompiler::makeSlot(const ValueSlot& slot)
+// Create a reference to a value slot
+{
+   return make_unique<SlotEvaluator>(slot);
+}
+//---------------------------------------------------------------------------
+static unique_ptr<Evaluator> fold(unique_ptr<Evaluator> evaluator)
+// Replace a computation over constants by its result
+{
+   if ((!evaluator->isConstant()) || dynamic_cast<ConstantEvaluator*>(evaluator.get())) return evaluator;
+   Batch empty;
+   empty.size = 1;
+   return ExpressionCompiler::makeConstant(evaluator->getType(), evaluator->evaluate(empty).get(0));
+}
+//---------------------------------------------------------------------------
+unique_ptr<Evaluator> ExpressionCompiler::makeCast(unique_ptr<Evaluator> input, ValueType type)
+// Convert the result of an evaluator into another type
+{
+   if (input->getType().sameValues(type)) return input;
+   return fold(make_unique<CastEvaluator>(move(input), type));
+}
+//---------------------------------------------------------------------------
+unique_ptr<Evaluator> ExpressionCompiler::makeAnd(unique_ptr<Evaluator> left, unique_ptr<Evaluator> right)
+// Combine two boolean evaluators with a logical and
+{
+   return fold(make_unique<LogicEvaluator>(move(left), move(right), true));
+}
+//---------------------------------------------------------------------------
+Value ExpressionCompiler::cast(const Value& value, ValueType from, ValueType to, StringHeap& heap)
+// Convert a value into another type
+{
+   if (value.null) return value;
+   if (from.sameValues(to)) return value;
+   if (to.getKind() == ValueType::String) return Value::makeString(heap.add(values::format(from, value)));
+   if (from.getKind() == ValueType::String) {
+      Value result = values::parse(to, value.str);
+      if (result.str.data()) result.str = heap.add(result.str);
+      return result;
+   }
+   if (from.isNumeric() && to.isNumeric()) return Value::makeNumber(values::rescale(value.number, from.getScale(), to.getScale()));
+   if ((from.getKind() == ValueType::Bool) && to.isNumeric()) return Value::makeNumber(value.number * values::pow10(to.getScale()));
+   if (from.isNumeric() && (to.getKind() == ValueType::Bool)) return Value::makeNumber(value.number != 0);
+   throw runtime_error("cannot cast " + from.getName() + " to " + to.getName());
+}
+//---------------------------------------------------------------------------
+unique_ptr<Evaluator> ExpressionCompiler::compile(algebra::Expression& expression, ValueType type)
+// Compile an expression and convert the result into a type
+{
+   return makeCast(compile(expression), type);
+}
+//---------------------------------------------------------------------------
+static ValueType unifyAll(const vector<unique_ptr<Evaluator>>& inputs, unsigned from, unsigned step)
+// Unify the types of every step-th evaluator
+{
+   ValueType result;
+   for (unsigned index = from; index < inputs.size(); index += step)
+      result = ValueType::unify(result, inputs[index]->getType());
+   return result;
+}
+//---------------------------------------------------------------------------
+unique_ptr<Evaluator> ExpressionCompiler::compile(algebra::Expression& expression)
+// Compile an expression
+{
+   using namespace algebra;
+   if (auto ref = dynamic_cast<IURef*>(&expression)) {
+      return compileIU(ref->getIU());
+   } else if (auto c = dynamic_cast<ConstExpression*>(&expression)) {
+      auto type = ValueType::fromType(c->getType());
+      if (c->isNull()) return makeConstant(type.withNullable(true), Value::makeNull());
+      // Decimal literals keep their own scale
+      if (type.getKind() == ValueType::Decimal) {
+         auto& v = c->getValue();
+         auto dot = v.find('.');
+         type = ValueType(ValueType::Decimal, (dot == string::npos) ? 0 : min<unsigned>(v.size() - dot - 1, ValueType::maxScale));
+      }
+      return makeConstant(type, values::parse(type, c->getValue()));
+   } else if (auto p = dynamic_cast<ParameterExpression*>(&expression)) {
+      auto type = ValueType::fromType(p->getType());
+      auto value = getParameter(p->getSlot());
+      if (!value) return makeConstant(type.withNullable(true), Value::makeNull());
+      return makeConstant(type, values::parse(type, *value));
+   } else if (auto cast = dynamic_cast<CastExpression*>(&expression)) {
+      auto target = ValueType::fromType(cast->getType());
+      auto input = compile(*cast->getInput());
+      // Casts between decimals only change the declared precision, keep the scale of the value
+      if ((target.getKind() == ValueType::Decimal) && (input->getType().getKind() == ValueType::Decimal) && (input->getType().getScale() > target.getScale())) target = input->getType();
+      return makeCast(move(input), target);
+   } else if (auto c = dynamic_cast<ComparisonExpression*>(&expression)) {
+      auto left = compile(*c->left), right = compile(*c->right);
+      if (c->mode == ComparisonExpression::Like) {
+         auto stringType = ValueType(ValueType::String);
+         return fold(make_unique<LikeEvaluator>(makeCast(move(left), stringType), makeCast(move(right), stringType)));
+      }
+      auto type = ValueType::unify(left->getType(), right->getType());
+      left = makeCast(move(left), type);
+      right = makeCast(move(right), type);
+      return fold(make_unique<ComparisonEvaluator>(move(left), move(right), c->mode));
+   } else if (auto b = dynamic_cast<BetweenExpression*>(&expression)) {
+      auto base = compile(*b->base), lower = compile(*b->lower), upper = compile(*b->upper);
+      auto type = ValueType::unify(ValueType::unify(base->getType(), lower->getType()), upper->getType());
+      return fold(make_unique<BetweenEvaluator>(makeCast(move(base), type), makeCast(move(lower), type), makeCast(move(upper), type)));
+   } else if (auto in = dynamic_cast<InExpression*>(&expression)) {
+      vector<unique_ptr<Evaluator>> inputs;
+      inputs.push_back(compile(*in->probe));
+      for (auto& v : in->values)
+         inputs.push_back(compile(*v));
+      auto type = unifyAll(inputs, 0, 1);
+      for (auto& i : inputs)
+         i = makeCast(move(i), type);
+      return fold(make_unique<InEvaluator>(move(inputs)));
+   } else if (auto b = dynamic_cast<BinaryExpression*>(&expression)) {
+      auto left = compile(*b->left), right = compile(*b->right);
+      auto lt = left->getType(), rt = right->getType();
+      bool nullable = lt.isNullable() || rt.isNullable();
+      switch (b->op) {
+         case BinaryExpression::And:
+         case BinaryExpression::Or: {
+            auto boolType = ValueType(ValueType::Bool);
+            return fold(make_unique<LogicEvaluator>(makeCast(move(left), boolType.withNullable(lt.isNullable())), makeCast(move(right), boolType.withNullable(rt.isNullable())), b->op == BinaryExpression::And));
+         }
+         case BinaryExpression::Concat: {
+            auto stringType = ValueType(ValueType::String);
+            return fold(make_unique<ConcatEvaluator>(makeCast(move(left), stringType.withNullable(lt.isNullable())), makeCast(move(right), stringType.withNullable(rt.isNullable()))));
+         }
+         default: break;
+      }
+      if ((lt.getKind() == ValueType::Date) && (rt.getKind() == ValueType::Interval)) return fold(make_unique<DateArithmetic>(move(left), move(right), b->op == BinaryExpression::Minus));
+      if ((lt.getKind() == ValueType::Null) || (rt.getKind() == ValueType::Null)) {
+         // Arithmetic with NULL constants
+         auto type = ValueType::fromType(b->getType()).withNullable(true);
+         return makeConstant(type.getKind() == ValueType::Decimal ? ValueType(ValueType::Decimal, 0, true) : type, Value::makeNull());
+      }
+      if ((!lt.isNumeric()) || (!rt.isNumeric())) throw runtime_error("unsupported operation on " + lt.getName() + " and " + rt.getName());
+      if ((lt.getKind() == ValueType::Integer) && (rt.getKind() == ValueType::Integer)) {
+         auto result = make_unique<IntegerArithmetic>(move(left), move(right), b->op);
+         return fold(makeCast(move(result), ValueType(ValueType::Integer, 0, nullable || (b->op == BinaryExpression::Div) || (b->op == BinaryExpression::Mod))));
+      }
+
+      // Decimal arithmetic. The result scale follows from the input scales
+      unsigned sl = lt.getScale(), sr = rt.getScale(), scale;
+      switch (b->op) {
+         case BinaryExpression::Mul: scale = min(sl + sr, ValueType::maxScale); break;
+         case BinaryExpression::Div:
+         case BinaryExpression::Power: scale = max({sl, sr, 6u}); break;
+         default: scale = max(sl, sr); break;
+      }
+      if ((b->op == BinaryExpression::Plus) || (b->op == BinaryExpression::Minus) || (b->op == BinaryExpression::Mod)) sl = sr = scale;
+      left = makeCast(move(left), ValueType(ValueType::Decimal, sl, lt.isNullable()));
+      right = makeCast(move(right), ValueType(ValueType::Decimal, sr, rt.isNullable()));
+      bool mayBeNull = nullable || (b->op == BinaryExpression::Div) || (b->op == BinaryExpression::Mod);
+      return fold(make_unique<DecimalArithmetic>(move(left), move(right), b->op, ValueType(ValueType::Decimal, scale, mayBeNull)));
+   } else if (auto u = dynamic_cast<UnaryExpression*>(&expression)) {
+      auto input = compile(*u->input);
+      if (u->op == UnaryExpression::Plus) return input;
+      return fold(make_unique<UnaryEvaluator>(move(input), u->op));
+   } else if (auto e = dynamic_cast<ExtractExpression*>(&expression)) {
+      return fold(make_unique<ExtractEvaluator>(compile(*e->input), e->part));
+   } else if (auto s = dynamic_cast<SubstrExpression*>(&expression)) {
+      vector<unique_ptr<Evaluator>> inputs;
+      auto value = compile(*s->value);
+      inputs.push_back(makeCast(move(value), ValueType::String));
+      for (auto& e : {s->from.get(), s->len.get()})
+         if (e) {
+            auto i = compile(*e);
+            inputs.push_back(makeCast(move(i), ValueType::Integer));
+         }
+      return fold(make_unique<SubstrEvaluator>(move(inputs), !!s->from, !!s->len));
+   } else if (auto c = dynamic_cast<SimpleCaseExpression*>(&expression)) {
+      vector<unique_ptr<Evaluator>> inputs;
+      inputs.push_back(compile(*c->value));
+      for (auto& e : c->cases) {
+         inputs.push_back(compile(*e.first));
+         inputs.push_back(compile(*e.second));
+      }
+      inputs.push_back(compile(*c->defaultValue));
+      // Unify the compared values and the results separately
+      auto valueType = ValueType::unify(inputs[0]->getType(), unifyAll(inputs, 1, 2).withNullable(false));
+      auto resultType = ValueType::unify(unifyAll(inputs, 2, 2), inputs.back()->getType());
+      for (unsigned index = 0; index != inputs.size(); ++index) {
+         bool isResult = (index == inputs.size() - 1) || (index && !(index & 1));
+         inputs[index] = makeCast(move(inputs[index]), isResult ? resultType : valueType);
+      }
+      return fold(make_unique<CaseEvaluator>(resultType, move(inputs), c->cases.size(), true));
+   } else if (auto c = dynamic_cast<SearchedCaseExpression*>(&expression)) {
+      vector<unique_ptr<Evaluator>> inputs;
+      for (auto& e : c->cases) {
+         inputs.push_back(compile(*e.first));
+         inputs.push_back(compile(*e.second));
+      }
+      inputs.push_back(compile(*c->defaultValue));
+      auto resultType = ValueType::unify(unifyAll(inputs, 1, 2), inputs.back()->getType());
+      for (unsigned index = 1; index < inputs.size(); index += 2)
+         inputs[index] = makeCast(move(inputs[index]), resultType);
+      inputs.back() = makeCast(move(inputs.back()), resultType);
+      return fold(make_unique<CaseEvaluator>(resultType, move(inputs), c->cases.size(), false));
+   } else if (auto a = dynamic_cast<Aggregate*>(&expression)) {
+      return compileAggregate(*a);
+   } else if (dynamic_cast<ForeignCall*>(&expression)) {
+      throw runtime_error("foreign function calls cannot be executed");
+   }
+   throw runtime_error("unsupported expression");
+}
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
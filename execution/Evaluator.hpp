@@ -0,0 +1,144 @@
+#ifndef H_saneql_execution_Evaluator
+#define H_saneql_execution_Evaluator
+//---------------------------------------------------------------------------
+#include "execution/Vector.hpp"
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+//---------------------------------------------------------------------------
+// SaneQL
+// (c) 2023 Thomas Neumann
+// SPDX-License-Identifier: BSD-3-Clause
+//---------------------------------------------------------------------------
+namespace saneql {
+//---------------------------------------------------------------------------
+namespace algebra {
+class Aggregate;
+class Expression;
+class IU;
+}
+//---------------------------------------------------------------------------
+namespace execution {
+//---------------------------------------------------------------------------
+/// C++ code that evaluates expressions for one row at a time, used by compiled plans.
+/// Every value is held in a local variable together with its NULL flag. Columns are
+/// loaded when they are used first, code after a filter loads only qualifying rows.
+/// The code may call the runtime functions in namespace rt of the generated module
+class RowCode {
+   public:
+   /// A value within the generated code
+   struct Variable {
+      /// The expression for the value
+      std::string value;
+      /// The expression for the NULL flag
+      std::string null;
+   };
+
+   private:
+   /// A column of the rows
+   struct Column {
+      /// The variable
+      Variable variable;
+      /// The statements that load the column. Empty once loaded
+      std::string load;
+   };
+
+   /// The statements
+   std::string code;
+   /// The columns
+   std::vector<Column> columns;
+   /// The number of defined variables
+   unsigned variableCount = 0;
+
+   public:
+   /// Add a column. The load statements are emitted when the column is used first
+   void addColumn(Variable variable, std::string load) { columns.push_back({std::move(variable), std::move(load)}); }
+   /// Use a column
+   const Variable& useColumn(unsigned index);
+   /// Define a new variable
+   Variable define(ValueType type, const std::string& value, const std::string& null);
+   /// Append statements
+   void append(const std::string& statements) { code += statements; }
+   /// Get the statements
+   const std::string& getCode() const { return code; }
+
+   /// Get the C++ type that holds values of a type
+   static std::string getType(ValueType type);
+   /// Get a C++ literal for a value
+   static std::string makeLiteral(ValueType type, const Value& value);
+};
+//---------------------------------------------------------------------------
+/// A compiled scalar expression that is evaluated a batch at a time. All inputs of an
+/// expression are evaluated for all rows, division by zero therefore yields NULL instead
+/// of an error
+class Evaluator {
+   protected:
+   /// The result type
+   ValueType type;
+   /// The result
+   Vector result;
+
+   public:
+   /// Constructor
+   explicit Evaluator(ValueType type) : type(type), result(type) {}
+   /// Destructor
+   virtual ~Evaluator();
+
+   /// Get the result type
+   ValueType getType() const { return type; }
+   /// Is the result the same for all rows?
+   virtual bool isConstant() const { return false; }
+   /// Evaluate the expression for a batch. The result stays valid until the next call or until the batch changes
+   virtual const Vector& evaluate(const Batch& batch) = 0;
+   /// Generate code that computes the expression for a single row. nullopt if the expression cannot be compiled
+   virtual std::optional<RowCode::Variable> generate(RowCode& code) const;
+};
+//---------------------------------------------------------------------------
+/// A value that is set from outside of the evaluated batches, for example the current
+/// value of an outer column in a correlated subquery
+struct ValueSlot {
+   /// The type
+   ValueType type;
+   /// The value
+   Value value;
+};
+//---------------------------------------------------------------------------
+/// Translates algebra expressions into evaluators. The derived classes resolve the
+/// referenced IUs and the subqueries
+class ExpressionCompiler {
+   protected:
+   /// Compile an IU reference
+   virtual std::unique_ptr<Evaluator> compileIU(const algebra::IU* iu) = 0;
+   /// Compile a scalar subquery
+   virtual std::unique_ptr<Evaluator> compileAggregate(algebra::Aggregate& aggregate) = 0;
+   /// Get the value of a parameter. nullopt if the parameter is NULL
+   virtual std::optional<std::string> getParameter(unsigned slot) = 0;
+
+   public:
+   /// Destructor
+   virtual ~ExpressionCompiler();
+
+   /// Compile an expression
+   std::unique_ptr<Evaluator> compile(algebra::Expression& expression);
+   /// Compile an expression and convert the result into a type
+   std::unique_ptr<Evaluator> compile(algebra::Expression& expression, ValueType type);
+
+   /// Create a reference to a column of the evaluated batches
+   static std::unique_ptr<Evaluator> makeColumn(ValueType type, unsigned index);
+   /// Create a constant
+   static std::unique_ptr<Evaluator> makeConstant(ValueType type, const Value& value);
+   /// Create a reference to a value slot
+   static std::unique_ptr<Evaluator> makeSlot(const ValueSlot& slot);
+   /// Convert the result of an evaluator into another type
+   static std::unique_ptr<Evaluator> makeCast(std::unique_ptr<Evaluator> input, ValueType type);
+   /// Combine two boolean evaluators with a logical and
+   static std::unique_ptr<Evaluator> makeAnd(std::unique_ptr<Evaluator> left, std::unique_ptr<Evaluator> right);
+   /// Convert a value into another type. Strings are allocated in the heap
+   static Value cast(const Value& value, ValueType from, ValueType to, StringHeap& heap);
+};
+//---------------------------------------------------------------------------
+}
+}
+//---------------------------------------------------------------------------
+#endif
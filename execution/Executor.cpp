@@ -0,0 +1,707 @@
+#include "execution/Executor.hpp"
+#include "algebra/CardinalityEstimator.hpp"
+#include "algebra/Operator.hpp"
+#include "algebra/Ordering.hpp"
+#include "execution/CodeGenerator.hpp"
+#include "execution/Database.hpp"
+#include "execution/PhysicalOperator.hpp"
+#include "execution/Scheduler.hpp"
+#include "infra/Schema.hpp"
+#include <algorithm>
+#include <ostream>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+//---------------------------------------------------------------------------
+// (c) 2023 Thomas Neumann
+//---------------------------------------------------------------------------
+using namespace std;
+//---------------------------------------------------------------------------
+namespace saneql::execution {
+//---------------------------------------------------------------------------
+void Result::print(ostream& out) const
+// Print the result as tab separated text with a header line
+{
+   for (unsigned index = 0; index != names.size(); ++index)
+      out << (index ? "\t" : "") << names[index];
+   out << '\n';
+   auto& types = rows->getTypes();
+   string line;
+   for (auto& chunk : rows->getChunks()) {
+      for (unsigned row = 0; row != chunk->size; ++row) {
+         line.clear();
+         for (unsigned index = 0; index != types.size(); ++index) {
+            if (index) line += '\t';
+            Value v = chunk->columns[index].get(row);
+            if (v.null)
+               line += "NULL";
+            else
+               values::format(line, types[index], v);
+         }
+         out << line << '\n';
+      }
+   }
+}
+//---------------------------------------------------------------------------
+namespace {
+//---------------------------------------------------------------------------
+/// The state that is shared by all plans of a query
+struct QueryContext {
+   /// The database
+   Database& database;
+   /// The parameter values
+   const vector<optional<string>>& parameters;
+   /// The number of worker threads
+   unsigned threadCount;
+   /// The compiler for generated code (if any)
+   NativeCompiler* compiler;
+   /// The materialized CTEs
+   unordered_map<const algebra::CTE*, pair<unique_ptr<Relation>, vector<const algebra::IU*>>> ctes;
+};
+//---------------------------------------------------------------------------
+/// A physical plan together with the IUs of its columns
+struct Plan {
+   /// The root operator
+   unique_ptr<PhysicalOperator> op;
+   /// The produced IUs
+   vector<const algebra::IU*> ius;
+};
+//---------------------------------------------------------------------------
+/// The columns that expressions are evaluated on
+struct Layout {
+   /// The IUs
+   vector<const algebra::IU*> ius;
+   /// The types
+   vector<ValueType> types;
+
+   /// Constructor
+   Layout() = default;
+   /// Constructor
+   explicit Layout(const Plan& plan) : ius(plan.ius), types(plan.op->getTypes()) {}
+};
+//---------------------------------------------------------------------------
+/// A dependency of a subquery on a value of the enclosing query
+struct Correlation {
+   /// The value in the enclosing query
+   unique_ptr<Evaluator> outer;
+   /// The slot that provides the value to the subquery
+   unique_ptr<ValueSlot> slot;
+};
+//---------------------------------------------------------------------------
+/// A scalar subquery. Executed once per distinct combination of correlated values
+class SubqueryEvaluator : public Evaluator {
+   /// The plan
+   unique_ptr<Collect> plan;
+   /// The correlations
+   vector<Correlation> correlations;
+   /// The computation of the result from the aggregates
+   unique_ptr<Evaluator> computation;
+   /// The known results
+   unordered_map<string, Value> results;
+   /// The strings of the known results
+   StringHeap strings;
+
+   /// Execute the plan
+   Value run();
+
+   public:
+   /// Constructor
+   SubqueryEvaluator(unique_ptr<Collect> plan, vector<Correlation> correlations, unique_ptr<Evaluator> computation) : Evaluator(computation->getType().withNullable(true)), plan(move(plan)), correlations(move(correlations)), computation(move(computation)) {}
+
+   /// Evaluate
+   const Vector& evaluate(const Batch& batch) override;
+};
+//---------------------------------------------------------------------------
+Value SubqueryEvaluator::run()
+// Execute the plan
+{
+   plan->produce();
+   auto& rows = plan->accessResult();
+   if (rows.getSize() != 1) throw runtime_error("scalar subquery produced " + to_string(rows.getSize()) + " rows");
+   Value result = computation->evaluate(*rows.getChunks().front()).get(0);
+   if ((!result.null) && (type.getKind() == ValueType::String)) result.str = strings.add(result.str);
+   return result;
+}
+//---------------------------------------------------------------------------
+const Vector& SubqueryEvaluator::evaluate(const Batch& batch)
+// Evaluate
+{
+   vector<const Vector*> outer;
+   for (auto& c : correlations)
+      outer.push_back(&c.outer->evaluate(batch));
+   result.allocate(batch.size, true);
+   string key;
+   for (unsigned row = 0; row != batch.size; ++row) {
+      // Encode the correlated values to find earlier results
+      key.clear();
+      for (unsigned index = 0; index != correlations.size(); ++index) {
+         Value v = outer[index]->get(row);
+         correlations[index].slot->value = v;
+         if (v.null) {
+            key += 'N';
+         } else if (correlations[index].slot->type.getKind() == ValueType::String) {
+            uint64_t len = v.str.size();
+            key.append(reinterpret_cast<const char*>(&len), sizeof(len));
+            key += v.str;
+         } else {
+            key += 'V';
+            key.append(reinterpret_cast<const char*>(&v.number), sizeof(v.number));
+         }
+      }
+      auto iter = results.find(key);
+      if (iter == results.end()) iter = results.emplace(key, run()).first;
+      result.set(row, iter->second);
+   }
+   return result;
+}
+//---------------------------------------------------------------------------
+/// Translates algebra trees into physical plans
+class PlanBuilder : public ExpressionCompiler {
+   /// The query context
+   QueryContext& context;
+   /// The builder of the enclosing query (if any)
+   PlanBuilder* outer;
+   /// The worker that executes the plan (if parallel)
+   Worker* worker;
+   /// The correlations with the enclosing query
+   vector<Correlation> correlations;
+   /// The layout that expressions are compiled for
+   const Layout* layout = nullptr;
+
+   /// Compile an IU reference
+   unique_ptr<Evaluator> compileIU(const algebra::IU* iu) override;
+   /// Compile a scalar subquery
+   unique_ptr<Evaluator> compileAggregate(algebra::Aggregate& aggregate) override;
+   /// Get the value of a parameter
+   optional<string> getParameter(unsigned slot) override;
+
+   /// Compile an expression over a layout
+   unique_ptr<Evaluator> compileFor(const Layout& l, algebra::Expression& expression);
+   /// Compile sort keys
+   vector<SortKey> compileOrder(const Layout& l, const vector<algebra::Sort::Entry>& order);
+
+   /// Translate an aggregation over a table scan into generated code. nullopt if the pipeline cannot be compiled
+   optional<Plan> translateCompiled(algebra::Operator& input, const vector<algebra::AggregationLike::Entry>& groupBy, const vector<algebra::AggregationLike::Aggregation>& aggregates);
+   /// Translate a join
+   Plan translateJoin(algebra::Join& join);
+   /// Translate an inline table
+   Plan translateInlineTable(algebra::InlineTable& table);
+   /// Translate a CTE reference
+   Plan translateCTERef(algebra::CTERef& ref);
+   /// Translate an operator
+   Plan translateOperator(algebra::Operator& op);
+
+   public:
+   /// Constructor
+   PlanBuilder(QueryContext& context, PlanBuilder* outer, Worker* worker = nullptr) : context(context), outer(outer), worker(worker) {}
+
+   /// Translate an operator tree
+   Plan translate(algebra::Operator& op);
+   /// Compile a scalar expression without input columns
+   unique_ptr<Evaluator> compileScalar(algebra::Expression& expression) { return compileFor(Layout(), expression); }
+};
+//---------------------------------------------------------------------------
+static pair<unique_ptr<Relation>, vector<const algebra::IU*>> materialize(QueryContext& context, algebra::Operator& op)
+// Execute an operator tree with all workers and materialize the result
+{
+   // Every worker runs its own instance of the plan
+   Scheduler scheduler(context.threadCount);
+   vector<Worker> workers;
+   workers.reserve(scheduler.getThreadCount());
+   vector<unique_ptr<Collect>> instances;
+   vector<const algebra::IU*> ius;
+   for (unsigned id = 0; id != scheduler.getThreadCount(); ++id) {
+      workers.emplace_back(scheduler, id);
+      PlanBuilder builder(context, nullptr, &workers.back());
+      auto plan = builder.translate(op);
+      ius = move(plan.ius);
+      instances.push_back(make_unique<Collect>(move(plan.op)));
+   }
+   scheduler.run([&](unsigned id) { instances[id]->produce(); });
+
+   // Concatenate the results in worker order
+   if (instances.size() == 1) return {make_unique<Relation>(move(instances.front()->accessResult())), move(ius)};
+   auto result = make_unique<Relation>(instances.front()->accessResult().getTypes());
+   for (auto& instance : instances)
+      for (auto& chunk : instance->accessResult().getChunks())
+         result->append(*chunk);
+   return {move(result), move(ius)};
+}
+//---------------------------------------------------------------------------
+unique_ptr<Evaluator> PlanBuilder::compileIU(const algebra::IU* iu)
+// Compile an IU reference
+{
+   if (layout) {
+      auto iter = find(layout->ius.begin(), layout->ius.end(), iu);
+      if (iter != layout->ius.end()) {
+         unsigned index = iter - layout->ius.begin();
+         return makeColumn(layout->types[index], index);
+      }
+   }
+
+   // A correlated value, provided by the enclosing query
+   if (!outer) throw runtime_error("unknown column in execution plan");
+   auto value = outer->compileIU(iu);
+   auto slot = make_unique<ValueSlot>(ValueSlot{value->getType(), Value::makeNull()});
+   auto result = makeSlot(*slot);
+   correlations.push_back({move(value), move(slot)});
+   return result;
+}
+//---------------------------------------------------------------------------
+unique_ptr<Evaluator> PlanBuilder::compileAggregate(algebra::Aggregate& aggregate)
+// Compile a scalar subquery
+{
+   // The subquery is an aggregation without group by, the computation derives the result from the aggregates
+   PlanBuilder builder(context, this);
+   auto compiled = builder.translateCompiled(*aggregate.accessInput(), {}, aggregate.getAggregates());
+   Plan plan;
+   if (compiled) {
+      plan = move(*compiled);
+   } else {
+      auto input = builder.translate(*aggregate.accessInput());
+      Layout inputLayout(input);
+      vector<HashAggregation::Aggregate> aggregates;
+      for (auto& a : aggregate.getAggregates()) {
+         aggregates.push_back({a.op, a.value ? builder.compileFor(inputLayout, *a.value) : nullptr});
+         plan.ius.push_back(a.iu.get());
+      }
+      plan.op = make_unique<HashAggregation>(move(input.op), vector<unique_ptr<Evaluator>>(), move(aggregates));
+   }
+   auto computation = builder.compileFor(Layout(plan), *aggregate.getComputation());
+   return make_unique<SubqueryEvaluator>(make_unique<Collect>(move(plan.op)), move(builder.correlations), move(computation));
+}
+//---------------------------------------------------------------------------
+optional<string> PlanBuilder::getParameter(unsigned slot)
+// Get the value of a parameter
+{
+   if (slot < context.parameters.size()) return context.parameters[slot];
+   return nullopt;
+}
+//---------------------------------------------------------------------------
+unique_ptr<Evaluator> PlanBuilder::compileFor(const Layout& l, algebra::Expression& expression)
+// Compile an expression over a layout
+{
+   auto saved = layout;
+   layout = &l;
+   auto result = compile(expression);
+   layout = saved;
+   return result;
+}
+//---------------------------------------------------------------------------
+vector<SortKey> PlanBuilder::compileOrder(const Layout& l, const vector<algebra::Sort::Entry>& order)
+// Compile sort keys
+{
+   vector<SortKey> result;
+   for (auto& o : order)
+      result.push_back({compileFor(l, *o.value), o.descending});
+   return result;
+}
+//---------------------------------------------------------------------------
+static void splitConjuncts(algebra::Expression* expression, vector<algebra::Expression*>& conjuncts)
+// Split a condition into its conjuncts
+{
+   auto b = dynamic_cast<algebra::BinaryExpression*>(expression);
+   if (b && (b->op == algebra::BinaryExpression::And)) {
+      splitConjuncts(b->left.get(), conjuncts);
+      splitConjuncts(b->right.get(), conjuncts);
+   } else {
+      conjuncts.push_back(expression);
+   }
+}
+//---------------------------------------------------------------------------
+static unsigned getSide(algebra::Expression& expression, const vector<const algebra::IU*>& left, const vector<const algebra::IU*>& right)
+// Determine the input that an expression depends on. 1 for left, 2 for right, 0 otherwise
+{
+   algebra::IUUsage usage;
+   expression.collectUsage(usage);
+   if (usage.used.empty() || (!usage.subqueries.empty())) return 0;
+   bool onlyLeft = true, onlyRight = true;
+   for (auto iu : usage.used) {
+      onlyLeft &= find(left.begin(), left.end(), iu) != left.end();
+      onlyRight &= find(right.begin(), right.end(), iu) != right.end();
+   }
+   return onlyLeft ? 1 : (onlyRight ? 2 : 0);
+}
+//---------------------------------------------------------------------------
+static vector<unsigned> resolveColumns(Database& database, algebra::TableScan& scan)
+// Find the stored columns of a table scan
+{
+   auto definition = database.getSchema().lookupTable(scan.getName());
+   vector<unsigned> columns;
+   for (auto& c : scan.getColumns()) {
+      auto index = definition ? definition->findColumn(c.name) : nullopt;
+      if (!index) throw runtime_error("unknown column '" + c.name + "' in table '" + scan.getName() + "'");
+      columns.push_back(*index);
+   }
+   return columns;
+}
+//---------------------------------------------------------------------------
+optional<Plan> PlanBuilder::translateCompiled(algebra::Operator& input, const vector<algebra::AggregationLike::Entry>& groupBy, const vector<algebra::AggregationLike::Aggregation>& aggregates)
+// Translate an aggregation over a table scan into generated code
+{
+   using namespace algebra;
+   if (!context.compiler) return nullopt;
+
+   // The pipeline consists of selections and maps over a table scan
+   vector<Operator*> steps;
+   Operator* current = &input;
+   while (true) {
+      if (auto ref = dynamic_cast<CTERef*>(current); ref && (ref->getCTE().useCount == 1) && ref->getColumns().empty()) {
+         current = ref->getCTE().op.get();
+         continue;
+      }
+      Operator* next = nullptr;
+      if (auto select = dynamic_cast<Select*>(current))
+         next = select->accessInput().get();
+      else if (auto map = dynamic_cast<algebra::Map*>(current))
+         next = map->accessInput().get();
+      if (!next) break;
+      steps.push_back(current);
+      current = next;
+   }
+   auto scan = dynamic_cast<algebra::TableScan*>(current);
+   if (!scan) return nullopt;
+   reverse(steps.begin(), steps.end());
+
+   // All values must stem from the pipeline, correlated values and subqueries remain vectorized
+   IUUsage usage;
+   unordered_set<const IU*> produced;
+   for (auto& c : scan->getColumns())
+      produced.insert(c.iu.get());
+   for (auto step : steps) {
+      if (auto select = dynamic_cast<Select*>(step)) {
+         select->accessCondition()->collectUsage(usage);
+      } else {
+         for (auto& c : static_cast<algebra::Map*>(step)->getComputations()) {
+            c.value->collectUsage(usage);
+            produced.insert(c.iu.get());
+         }
+      }
+   }
+   for (auto& g : groupBy)
+      g.value->collectUsage(usage);
+   for (auto& a : aggregates)
+      if (a.value) a.value->collectUsage(usage);
+   if ((!usage.subqueries.empty()) || any_of(usage.used.begin(), usage.used.end(), [&](const IU* iu) { return !produced.contains(iu); })) return nullopt;
+
+   // Compile the expressions as for vectorized execution, then generate code from them
+   auto& table = context.database.getTable(scan->getName());
+   auto columns = resolveColumns(context.database, *scan);
+   Layout layout;
+   vector<PhysicalType> storage;
+   for (unsigned index = 0; index != columns.size(); ++index) {
+      auto& column = table.getColumns()[columns[index]];
+      layout.ius.push_back(scan->getColumns()[index].iu.get());
+      layout.types.push_back(column.getType());
+      storage.push_back(column.getStorageType());
+   }
+   auto scanTypes = layout.types;
+   vector<CodeGenerator::Step> compiledSteps;
+   for (auto step : steps) {
+      CodeGenerator::Step compiled;
+      if (auto select = dynamic_cast<Select*>(step)) {
+         compiled.condition = makeCast(compileFor(layout, *select->accessCondition()), ValueType(ValueType::Bool, 0, true));
+      } else {
+         auto& computations = static_cast<algebra::Map*>(step)->getComputations();
+         for (auto& c : computations)
+            compiled.computations.push_back(compileFor(layout, *c.value));
+         for (unsigned index = 0; index != computations.size(); ++index) {
+            layout.ius.push_back(computations[index].iu.get());
+            layout.types.push_back(compiled.computations[index]->getType());
+         }
+      }
+      compiledSteps.push_back(move(compiled));
+   }
+   Plan result;
+   vector<unique_ptr<Evaluator>> keys;
+   vector<ValueType> types;
+   for (auto& g : groupBy) {
+      keys.push_back(compileFor(layout, *g.value));
+      types.push_back(keys.back()->getType());
+      result.ius.push_back(g.iu.get());
+   }
+   vector<HashAggregation::Aggregate> compiledAggregates;
+   for (auto& a : aggregates) {
+      compiledAggregates.push_back({a.op, a.value ? compileFor(layout, *a.value) : nullptr});
+      types.push_back(HashAggregation::getResultType(a.op, a.value ? compiledAggregates.back().value->getType() : ValueType()));
+      result.ius.push_back(a.iu.get());
+   }
+   auto code = CodeGenerator::generateAggregation(scanTypes, storage, compiledSteps, keys, compiledAggregates);
+   if (!code) return nullopt;
+   result.op = make_unique<CompiledAggregation>(context.compiler->compile(*code), table, columns, move(types));
+   return result;
+}
+//---------------------------------------------------------------------------
+Plan PlanBuilder::translateJoin(algebra::Join& join)
+// Translate a join
+{
+   using JoinType = algebra::Join::JoinType;
+   auto left = translate(*join.accessLeft()), right = translate(*join.accessRight());
+   Layout leftLayout(left), rightLayout(right), pairLayout;
+   pairLayout.ius = leftLayout.ius;
+   pairLayout.ius.insert(pairLayout.ius.end(), rightLayout.ius.begin(), rightLayout.ius.end());
+   pairLayout.types = leftLayout.types;
+   pairLayout.types.insert(pairLayout.types.end(), rightLayout.types.begin(), rightLayout.types.end());
+
+   // Equality comparisons between both sides become hash keys, all other conjuncts are checked on the candidate pairs
+   vector<algebra::Expression*> conjuncts;
+   splitConjuncts(join.accessCondition().get(), conjuncts);
+   vector<unique_ptr<Evaluator>> leftKeys, rightKeys;
+   unique_ptr<Evaluator> residual;
+   for (auto c : conjuncts) {
+      if (auto comparison = dynamic_cast<algebra::ComparisonExpression*>(c); comparison && (comparison->mode == algebra::ComparisonExpression::Equal)) {
+         unsigned l = getSide(*comparison->left, left.ius, right.ius), r = getSide(*comparison->right, left.ius, right.ius);
+         if (l && r && (l != r)) {
+            auto& leftSide = (l == 1) ? comparison->left : comparison->right;
+            auto& rightSide = (l == 1) ? comparison->right : comparison->left;
+            auto leftKey = compileFor(leftLayout, *leftSide), rightKey = compileFor(rightLayout, *rightSide);
+            auto type = ValueType::unify(leftKey->getType(), rightKey->getType());
+            leftKeys.push_back(makeCast(move(leftKey), type));
+            rightKeys.push_back(makeCast(move(rightKey), type));
+            continue;
+         }
+      }
+      // Constant true conditions are no restriction
+      if (auto constant = dynamic_cast<algebra::ConstExpression*>(c); constant && (!constant->isNull()) && (constant->getType().getType() == Type::Bool) && (constant->getValue() == "true")) continue;
+      auto condition = makeCast(compileFor(pairLayout, *c), ValueType(ValueType::Bool, 0, true));
+      residual = residual ? makeAnd(move(residual), move(condition)) : move(condition);
+   }
+
+   // Build the hash table on the smaller input
+   algebra::CardinalityEstimator estimator;
+   bool buildLeft = estimator.estimate(*join.accessLeft()) < estimator.estimate(*join.accessRight());
+
+   Plan result;
+   auto joinType = join.getJoinType();
+   if ((joinType != JoinType::RightSemi) && (joinType != JoinType::RightAnti)) result.ius = left.ius;
+   if ((joinType != JoinType::LeftSemi) && (joinType != JoinType::LeftAnti)) result.ius.insert(result.ius.end(), right.ius.begin(), right.ius.end());
+   result.op = make_unique<HashJoin>(move(left.op), move(right.op), joinType, move(leftKeys), move(rightKeys), move(residual), buildLeft);
+   return result;
+}
+//---------------------------------------------------------------------------
+Plan PlanBuilder::translateInlineTable(algebra::InlineTable& table)
+// Translate an inline table
+{
+   // Evaluate the values and convert each column to a common type
+   unsigned columnCount = table.columns.size();
+   vector<unique_ptr<Evaluator>> values;
+   for (auto& v : table.values)
+      values.push_back(compileScalar(*v));
+   vector<ValueType> types(columnCount);
+   for (unsigned index = 0; index != values.size(); ++index)
+      types[index % columnCount] = ValueType::unify(types[index % columnCount], values[index]->getType());
+   auto relation = make_unique<Relation>(types);
+   Batch empty;
+   empty.size = 1;
+   StringHeap strings;
+   vector<Value> row(columnCount);
+   for (unsigned r = 0; r != table.rowCount; ++r) {
+      for (unsigned c = 0; c != columnCount; ++c) {
+         auto& v = values[r * columnCount + c];
+         row[c] = ExpressionCompiler::cast(v->evaluate(empty).get(0), v->getType(), types[c], strings);
+      }
+      relation->append(row);
+   }
+
+   Plan result;
+   vector<unsigned> columns;
+   for (unsigned index = 0; index != columnCount; ++index) {
+      columns.push_back(index);
+      result.ius.push_back(table.columns[index].get());
+   }
+   result.op = make_unique<Scan>(move(relation), move(columns));
+   return result;
+}
+//---------------------------------------------------------------------------
+Plan PlanBuilder::translateCTERef(algebra::CTERef& ref)
+// Translate a CTE reference
+{
+   // A CTE that is used only once is executed in place
+   auto& cte = ref.getCTE();
+   if ((cte.useCount == 1) && ref.getColumns().empty()) return translate(*cte.op);
+
+   // Other CTEs are materialized once per query
+   auto iter = context.ctes.find(&cte);
+   if (iter == context.ctes.end()) iter = context.ctes.emplace(&cte, materialize(context, *cte.op)).first;
+   auto& relation = *iter->second.first;
+   auto& ius = iter->second.second;
+
+   Plan result;
+   vector<unsigned> columns;
+   auto addColumn = [&](const algebra::IU* source, const algebra::IU* produced) {
+      auto pos = find(ius.begin(), ius.end(), source);
+      if (pos == ius.end()) throw runtime_error("unknown CTE column in execution plan");
+      columns.push_back(pos - ius.begin());
+      result.ius.push_back(produced);
+   };
+   if (ref.getColumns().empty()) {
+      for (auto iu : cte.columns)
+         addColumn(iu, iu);
+   } else {
+      for (unsigned index = 0; index != ref.getColumns().size(); ++index)
+         addColumn(ref.getSources()[index], ref.getColumns()[index].get());
+   }
+   result.op = make_unique<Scan>(relation, move(columns));
+   return result;
+}
+//---------------------------------------------------------------------------
+Plan PlanBuilder::translate(algebra::Operator& op)
+// Translate an operator tree
+{
+   // All instances of a parallel plan register their operators in the same order
+   auto result = translateOperator(op);
+   if (worker) result.op->setWorker(*worker);
+   return result;
+}
+//---------------------------------------------------------------------------
+Plan PlanBuilder::translateOperator(algebra::Operator& op)
+// Translate an operator
+{
+   using namespace algebra;
+   if (auto scan = dynamic_cast<algebra::TableScan*>(&op)) {
+      auto& table = context.database.getTable(scan->getName());
+      Plan result;
+      for (auto& c : scan->getColumns())
+         result.ius.push_back(c.iu.get());
+      result.op = make_unique<execution::TableScan>(table, resolveColumns(context.database, *scan));
+      return result;
+   } else if (auto select = dynamic_cast<Select*>(&op)) {
+      auto input = translate(*select->accessInput());
+      auto condition = compileFor(Layout(input), *select->accessCondition());
+      input.op = make_unique<Filter>(move(input.op), makeCast(move(condition), ValueType(ValueType::Bool, 0, true)));
+      return input;
+   } else if (auto map = dynamic_cast<algebra::Map*>(&op)) {
+      auto input = translate(*map->accessInput());
+      Layout l(input);
+      vector<unique_ptr<Evaluator>> computations;
+      for (auto& c : map->getComputations()) {
+         computations.push_back(compileFor(l, *c.value));
+         input.ius.push_back(c.iu.get());
+      }
+      input.op = make_unique<execution::Map>(move(input.op), move(computations));
+      return input;
+   } else if (auto join = dynamic_cast<Join*>(&op)) {
+      return translateJoin(*join);
+   } else if (auto groupBy = dynamic_cast<GroupBy*>(&op)) {
+      // Aggregations over table scans run as generated code if possible
+      if (auto compiled = translateCompiled(*groupBy->accessInput(), groupBy->getGroupBy(), groupBy->accessAggregates())) return move(*compiled);
+      auto input = translate(*groupBy->accessInput());
+      Layout l(input);
+      Plan result;
+      vector<unique_ptr<Evaluator>> keys;
+      Ordering::IUSet keyIUs;
+      bool ordered = !groupBy->getGroupBy().empty();
+      for (auto& g : groupBy->getGroupBy()) {
+         keys.push_back(compileFor(l, *g.value));
+         result.ius.push_back(g.iu.get());
+         if (auto ref = dynamic_cast<IURef*>(g.value.get()))
+            keyIUs.insert(ref->getIU());
+         else
+            ordered = false;
+      }
+      vector<HashAggregation::Aggregate> aggregates;
+      for (auto& a : groupBy->accessAggregates()) {
+         aggregates.push_back({a.op, a.value ? compileFor(l, *a.value) : nullptr});
+         result.ius.push_back(a.iu.get());
+      }
+      // Input that is ordered on the group keys is aggregated one group after the other
+      ordered = ordered && Ordering::derive(*groupBy->accessInput()).isGrouped(keyIUs);
+      result.op = make_unique<HashAggregation>(move(input.op), move(keys), move(aggregates), ordered);
+      return result;
+   } else if (auto sort = dynamic_cast<algebra::Sort*>(&op)) {
+      auto input = translate(*sort->input);
+      auto order = compileOrder(Layout(input), sort->order);
+      input.op = make_unique<execution::Sort>(move(input.op), move(order), sort->limit, sort->offset);
+      return input;
+   } else if (auto window = dynamic_cast<algebra::Window*>(&op)) {
+      auto input = translate(*window->accessInput());
+      Layout l(input);
+      vector<unique_ptr<Evaluator>> partitionBy;
+      for (auto& p : window->getPartitionBy())
+         partitionBy.push_back(compileFor(l, *p));
+      auto orderBy = compileOrder(l, window->getOrderBy());
+      vector<execution::Window::Aggregate> aggregates;
+      for (auto& a : window->getAggregates()) {
+         execution::Window::Aggregate aggregate{static_cast<execution::Window::Op>(a.op), a.value ? compileFor(l, *a.value) : nullptr, {}};
+         for (auto& p : a.parameters)
+            aggregate.parameters.push_back(compileFor(l, *p));
+         if ((aggregate.op == execution::Window::Op::Lead) || (aggregate.op == execution::Window::Op::Lag)) {
+            // The offset is an integer, the default value has the type of the result
+            auto type = ValueType::unify(aggregate.value->getType(), aggregate.parameters[1]->getType());
+            aggregate.value = makeCast(move(aggregate.value), type.withNullable(true));
+            aggregate.parameters[0] = makeCast(move(aggregate.parameters[0]), ValueType(ValueType::Integer, 0, true));
+            aggregate.parameters[1] = makeCast(move(aggregate.parameters[1]), type.withNullable(true));
+         }
+         aggregates.push_back(move(aggregate));
+         input.ius.push_back(a.iu.get());
+      }
+      input.op = make_unique<execution::Window>(move(input.op), move(partitionBy), move(orderBy), move(aggregates));
+      return input;
+   } else if (auto setOperation = dynamic_cast<algebra::SetOperation*>(&op)) {
+      auto left = translate(*setOperation->accessLeft()), right = translate(*setOperation->accessRight());
+      Layout leftLayout(left), rightLayout(right);
+      vector<unique_ptr<Evaluator>> leftColumns, rightColumns;
+      for (unsigned index = 0; index != setOperation->getLeftColumns().size(); ++index) {
+         auto l = compileFor(leftLayout, *setOperation->getLeftColumns()[index]), r = compileFor(rightLayout, *setOperation->getRightColumns()[index]);
+         auto type = ValueType::unify(l->getType(), r->getType()).withNullable(l->getType().isNullable() || r->getType().isNullable());
+         leftColumns.push_back(makeCast(move(l), type));
+         rightColumns.push_back(makeCast(move(r), type));
+      }
+      Plan result;
+      for (auto& c : setOperation->getResultColumns())
+         result.ius.push_back(c.get());
+      result.op = make_unique<execution::SetOperation>(move(left.op), move(right.op), move(leftColumns), move(rightColumns), setOperation->getOp());
+      return result;
+   } else if (auto inlineTable = dynamic_cast<InlineTable*>(&op)) {
+      return translateInlineTable(*inlineTable);
+   } else if (auto ref = dynamic_cast<CTERef*>(&op)) {
+      return translateCTERef(*ref);
+   }
+   throw runtime_error("unsupported operator in execution plan");
+}
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
+Result Executor::execute(SemanticAnalysis::ExpressionResult& query, const vector<optional<string>>& parameters)
+// Execute an analyzed and optimized query
+{
+   QueryContext context{database, parameters, threadCount, compiler, {}};
+   PlanBuilder builder(context, nullptr);
+   Result result;
+
+   // A scalar query produces a single value
+   if (query.isScalar()) {
+      auto evaluator = builder.compileScalar(*query.scalar());
+      Batch empty;
+      empty.size = 1;
+      result.names.push_back("?column?");
+      result.rows = make_unique<Relation>(vector<ValueType>{evaluator->getType().withNullable(true)});
+      result.rows->append(vector<Value>{evaluator->evaluate(empty).get(0)});
+      return result;
+   }
+
+   // Materialize the result and pick the visible columns
+   auto [rows, ius] = materialize(context, *query.table());
+   vector<unsigned> columns;
+   vector<ValueType> types;
+   for (auto& c : query.getBinding().getColumns()) {
+      auto pos = find(ius.begin(), ius.end(), c.iu);
+      if (pos == ius.end()) throw runtime_error("unknown result column '" + c.name + "'");
+      columns.push_back(pos - ius.begin());
+      types.push_back(rows->getTypes()[columns.back()]);
+      result.names.push_back(c.name);
+   }
+   result.rows = make_unique<Relation>(types);
+   Batch batch;
+   batch.columns.resize(columns.size());
+   for (auto& chunk : rows->getChunks()) {
+      for (unsigned index = 0; index != columns.size(); ++index)
+         batch.columns[index].reference(chunk->columns[columns[index]]);
+      batch.size = chunk->size;
+      result.rows->append(batch);
+   }
+   return result;
+}
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
@@ -0,0 +1,58 @@
+#ifndef H_saneql_execution_Executor
+#define H_saneql_execution_Executor
+//---------------------------------------------------------------------------
+#include "execution/Vector.hpp"
+#include "semana/SemanticAnalysis.hpp"
+#include <iosfwd>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+//---------------------------------------------------------------------------
+// SaneQL
+// (c) 2023 Thomas Neumann
+// SPDX-License-Identifier: BSD-3-Clause
+//---------------------------------------------------------------------------
+namespace saneql {
+//---------------------------------------------------------------------------
+namespace execution {
+//---------------------------------------------------------------------------
+class Database;
+class NativeCompiler;
+//---------------------------------------------------------------------------
+/// The result of a query
+class Result {
+   public:
+   /// The column names
+   std::vector<std::string> names;
+   /// The rows
+   std::unique_ptr<Relation> rows;
+
+   /// Print the result as tab separated text with a header line
+   void print(std::ostream& out) const;
+};
+//---------------------------------------------------------------------------
+/// Executes analyzed queries on the data of a database. The algebra trees are translated
+/// into vectorized physical operators that process batches of rows. Every worker thread
+/// runs its own instance of the plan on morsels of the input. With a native compiler,
+/// aggregations over table scans run as generated code instead
+class Executor {
+   /// The database
+   Database& database;
+   /// The number of worker threads
+   unsigned threadCount;
+   /// The compiler for generated code (if any)
+   NativeCompiler* compiler;
+
+   public:
+   /// Constructor. A thread count of 0 uses all available cores
+   explicit Executor(Database& database, unsigned threadCount = 0, NativeCompiler* compiler = nullptr) : database(database), threadCount(threadCount), compiler(compiler) {}
+
+   /// Execute an analyzed and optimized query. Missing parameter values are NULL
+   Result execute(SemanticAnalysis::ExpressionResult& query, const std::vector<std::optional<std::string>>& parameters = {});
+};
+//---------------------------------------------------------------------------
+}
+}
+//---------------------------------------------------------------------------
+#endif
@@ -0,0 +1,353 @@
+#include "execution/Loader.hpp"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+//---------------------------------------------------------------------------
+// (c) 2023 Thomas Neumann
+//---------------------------------------------------------------------------
+using namespace std;
+//---------------------------------------------------------------------------
+namespace saneql::execution {
+//---------------------------------------------------------------------------
+namespace {
+//---------------------------------------------------------------------------
+/// A read-only memory mapped file
+class MappedFile {
+   /// The data
+   const char* data = nullptr;
+   /// The size
+   uint64_t size = 0;
+
+   public:
+   /// Constructor
+   explicit MappedFile(const string& file);
+   /// Destructor
+   ~MappedFile();
+
+   /// Get the contents
+   string_view getContents() const { return string_view(data, size); }
+};
+//---------------------------------------------------------------------------
+MappedFile::MappedFile(const string& file)
+// Constructor
+{
+   int fd = open(file.c_str(), O_RDONLY);
+   if (fd < 0) throw runtime_error("unable to read " + file);
+   struct stat info;
+   if (fstat(fd, &info) < 0) {
+      close(fd);
+      throw runtime_error("unable to read " + file);
+   }
+   size = info.st_size;
+   if (size) {
+      void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (mapping == MAP_FAILED) {
+         close(fd);
+         throw runtime_error("unable to map " + file);
+      }
+      madvise(mapping, size, MADV_SEQUENTIAL);
+      madvise(mapping, size, MADV_WILLNEED);
+      data = static_cast<const char*>(mapping);
+   }
+   close(fd);
+}
+//---------------------------------------------------------------------------
+MappedFile::~MappedFile()
+// Destructor
+{
+   if (data) munmap(const_cast<char*>(data), size);
+}
+//---------------------------------------------------------------------------
+/// Finds the delimiters and line breaks within a text, 64 bytes at a time
+class SeparatorScanner {
+   /// The current block
+   const char* block;
+   /// The end of the text
+   const char* end;
+   /// The separators within the current block that were not returned yet
+   uint64_t mask = 0;
+   /// The delimiter
+   char delimiter;
+
+   /// Compute the separator mask of the current block
+   void computeMask();
+
+   public:
+   /// Constructor
+   SeparatorScanner(const char* begin, const char* end, char delimiter) : block(begin), end(end), delimiter(delimiter) { computeMask(); }
+
+   /// Find the next separator. Returns the end of the text if there is none
+   const char* next() {
+      while (!mask) {
+         if (end - block <= 64) return end;
+         block += 64;
+         computeMask();
+      }
+      const char* result = block + countr_zero(mask);
+      mask &= mask - 1;
+      return result;
+   }
+   /// Continue the search at a position
+   void skipTo(const char* pos) {
+      block = pos;
+      computeMask();
+   }
+};
+//---------------------------------------------------------------------------
+void SeparatorScanner::computeMask()
+// Compute the separator mask of the current block
+{
+   mask = 0;
+   uint64_t len = end - block;
+#if defined(__AVX2__)
+   if (len >= 64) {
+      __m256i d = _mm256_set1_epi8(delimiter), n = _mm256_set1_epi8('\n');
+      for (unsigned offset = 0; offset != 64; offset += 32) {
+         __m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + offset));
+         uint32_t bits = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(data, d), _mm256_cmpeq_epi8(data, n)));
+         mask |= static_cast<uint64_t>(bits) << offset;
+      }
+      return;
+   }
+#elif defined(__SSE2__)
+   if (len >= 64) {
+      __m128i d = _mm_set1_epi8(delimiter), n = _mm_set1_epi8('\n');
+      for (unsigned offset = 0; offset != 64; offset += 16) {
+         __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + offset));
+         uint32_t bits = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(data, d), _mm_cmpeq_epi8(data, n)));
+         mask |= static_cast<uint64_t>(bits) << offset;
+      }
+      return;
+   }
+#endif
+   for (uint64_t index = 0, limit = min<uint64_t>(len, 64); index != limit; ++index)
+      if ((block[index] == delimiter) || (block[index] == '\n')) mask |= 1ull << index;
+}
+//---------------------------------------------------------------------------
+/// The result of parsing one chunk
+struct Chunk {
+   /// The text
+   string_view text;
+   /// The parsed rows
+   unique_ptr<Table> table;
+   /// The number of lines
+   uint64_t lines = 0;
+   /// The error (if any)
+   optional<string> error;
+};
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
+Loader::Format Loader::Format::forFile(string_view file, char delimiter)
+// Derive the format from the file name
+{
+   if (file.ends_with(".csv")) return csv();
+   return tbl(delimiter);
+}
+//---------------------------------------------------------------------------
+Loader::Loader(string name, const Schema::Table& definition, unsigned threadCount)
+   : name(move(name)), definition(definition), threadCount(threadCount ? threadCount : max(thread::hardware_concurrency(), 1u))
+// Constructor
+{
+}
+//---------------------------------------------------------------------------
+static bool fitsColumn(Type type, string_view field)
+// Check the length of strings and the scale of decimals, parsing alone would accept and round them
+{
+   switch (type.getType()) {
+      case Type::Char:
+      case Type::Varchar: {
+         // Count characters instead of bytes, excess trailing spaces are allowed
+         uint64_t length = count_if(field.begin(), field.end(), [](char c) { return (c & 0xC0) != 0x80; });
+         while ((length > type.getLength()) && field.ends_with(' ')) {
+            field.remove_suffix(1);
+            --length;
+         }
+         return length <= type.getLength();
+      }
+      case Type::Decimal: {
+         auto dot = field.find('.');
+         return (dot == string_view::npos) || (field.size() - dot - 1 <= type.getScale());
+      }
+      default: return true;
+   }
+}
+//---------------------------------------------------------------------------
+static void parseChunk(const Schema::Table& definition, Loader::Format format, Chunk& chunk)
+// Parse the rows of a chunk
+{
+   chunk.table = make_unique<Table>(definition);
+   chunk.table->reserve(count(chunk.text.begin(), chunk.text.end(), '\n') + 1);
+   auto types = chunk.table->getTypes();
+   unsigned columnCount = types.size();
+   vector<Value> row(columnCount);
+   vector<string> unescaped(columnCount);
+   auto fail = [&](const string& message) { throw runtime_error(message); };
+   auto expectFields = [&]() { fail("expected " + to_string(columnCount) + " fields"); };
+
+   const char *pos = chunk.text.data(), *stop = pos + chunk.text.size();
+   SeparatorScanner scanner(pos, stop, format.delimiter);
+   while (pos < stop) {
+      ++chunk.lines;
+      // Ignore empty lines
+      if ((*pos == '\n') || ((*pos == '\r') && (pos + 1 < stop) && (pos[1] == '\n'))) {
+         pos = scanner.next() + 1;
+         continue;
+      }
+
+      for (unsigned index = 0; index != columnCount; ++index) {
+         const char* sep;
+         string_view field;
+         bool quoted = format.quoted && (pos < stop) && (*pos == '"');
+         if (quoted) {
+            // A quoted field, two double quotes represent one. Chunks are split at line breaks, quoted values must not contain them
+            auto& buffer = unescaped[index];
+            buffer.clear();
+            const char* current = pos + 1;
+            while (true) {
+               auto close = static_cast<const char*>(memchr(current, '"', stop - current));
+               if (!close) fail("unterminated quoted value in column " + definition.columns[index].name);
+               if (memchr(current, '\n', close - current)) fail("line break in quoted value in column " + definition.columns[index].name);
+               buffer.append(current, close);
+               current = close + 1;
+               if ((current < stop) && (*current == '"')) {
+                  buffer += '"';
+                  ++current;
+               } else {
+                  break;
+               }
+            }
+            scanner.skipTo(current);
+            sep = scanner.next();
+            if ((sep != current) && (string_view(current, sep - current) != "\r")) fail("invalid quoted value in column " + definition.columns[index].name);
+            field = buffer;
+         } else {
+            sep = scanner.next();
+            field = string_view(pos, sep - pos);
+         }
+
+         bool lineEnd = (sep == stop) || (*sep == '\n');
+         if (index + 1 != columnCount) {
+            if (lineEnd) expectFields();
+         } else {
+            if (!lineEnd) {
+               // A trailing delimiter is allowed
+               auto after = scanner.next();
+               string_view rest(sep + 1, after - sep - 1);
+               if ((!rest.empty()) && (rest != "\r")) expectFields();
+               sep = after;
+            }
+            if ((!quoted) && field.ends_with('\r')) field.remove_suffix(1);
+         }
+
+         auto type = types[index];
+         if (field.empty() && type.isNullable() && !quoted) {
+            row[index] = Value::makeNull();
+         } else if ((!values::tryParse(type, field, row[index])) || (!fitsColumn(definition.columns[index].type, field))) {
+            fail("invalid " + type.getName() + " value '" + string(field) + "' in column " + definition.columns[index].name);
+         }
+         pos = sep + 1;
+      }
+      chunk.table->append(row);
+   }
+}
+//---------------------------------------------------------------------------
+unique_ptr<Table> Loader::loadFile(const string& file, Format format, Statistics* statistics) const
+// Load a file
+{
+   auto start = chrono::steady_clock::now();
+   MappedFile mapping(file);
+   auto result = load(mapping.getContents(), format, statistics);
+   if (statistics) statistics->seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+   return result;
+}
+//---------------------------------------------------------------------------
+unique_ptr<Table> Loader::load(string_view text, Format format, Statistics* statistics) const
+// Load text that is already in memory
+{
+   auto start = chrono::steady_clock::now();
+   uint64_t skippedLines = 0;
+   if (format.header) {
+      auto lineEnd = text.find('\n');
+      text = (lineEnd == string_view::npos) ? string_view() : text.substr(lineEnd + 1);
+      skippedLines = 1;
+   }
+
+   // Split the text at line boundaries. Several chunks per thread balance the load
+   constexpr uint64_t minChunkSize = 1 << 20;
+   uint64_t chunkSize = max<uint64_t>(minChunkSize, text.size() / (threadCount * 4) + 1);
+   vector<Chunk> chunks;
+   for (uint64_t begin = 0; begin < text.size();) {
+      uint64_t end = min<uint64_t>(begin + chunkSize, text.size());
+      if (end < text.size()) {
+         auto lineEnd = text.find('\n', end - 1);
+         end = (lineEnd == string_view::npos) ? text.size() : lineEnd + 1;
+      }
+      chunks.push_back({text.substr(begin, end - begin), nullptr, 0, nullopt});
+      begin = end;
+   }
+
+   // Parse the chunks in parallel
+   atomic<size_t> nextChunk = 0;
+   auto worker = [&]() {
+      while (true) {
+         size_t index = nextChunk++;
+         if (index >= chunks.size()) break;
+         try {
+            parseChunk(definition, format, chunks[index]);
+         } catch (const exception& e) {
+            chunks[index].error = e.what();
+         }
+      }
+   };
+   unsigned workers = min<size_t>(threadCount, chunks.size());
+   if (workers <= 1) {
+      worker();
+   } else {
+      vector<thread> threads;
+      for (unsigned index = 0; index != workers; ++index)
+         threads.emplace_back(worker);
+      for (auto& t : threads)
+         t.join();
+   }
+
+   // Concatenate the chunks in input order, a single chunk is used directly
+   auto finish = [&](unique_ptr<Table> result) {
+      if (statistics) {
+         statistics->rows = result->getSize();
+         statistics->bytes = text.size();
+         statistics->seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+      }
+      return result;
+   };
+   uint64_t lines = skippedLines, rows = 0;
+   for (auto& chunk : chunks) {
+      if (chunk.error) throw runtime_error(name + " row " + to_string(lines + chunk.lines) + ": " + *chunk.error);
+      lines += chunk.lines;
+      rows += chunk.table->getSize();
+   }
+   if (chunks.size() == 1) return finish(move(chunks.front().table));
+   auto result = make_unique<Table>(definition);
+   result->reserve(rows);
+   for (auto& chunk : chunks) {
+      result->append(*chunk.table);
+      chunk.table.reset();
+   }
+   return finish(move(result));
+}
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
@@ -0,0 +1,74 @@
+#ifndef H_saneql_execution_Loader
+#define H_saneql_execution_Loader
+//---------------------------------------------------------------------------
+#include "execution/Table.hpp"
+#include "infra/Schema.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+//---------------------------------------------------------------------------
+// SaneQL
+// (c) 2023 Thomas Neumann
+// SPDX-License-Identifier: BSD-3-Clause
+//---------------------------------------------------------------------------
+namespace saneql {
+//---------------------------------------------------------------------------
+namespace execution {
+//---------------------------------------------------------------------------
+/// Loads delimiter separated text files into tables. The file is memory mapped and split
+/// into chunks at line boundaries that are parsed in parallel, delimiters and line breaks
+/// are found with SIMD instructions. Empty fields of nullable columns are NULL
+class Loader {
+   public:
+   /// The format of the input
+   struct Format {
+      /// The field delimiter
+      char delimiter = '|';
+      /// Can fields be enclosed in double quotes? Quoted fields must not contain line breaks
+      bool quoted = false;
+      /// Does the input start with a header line?
+      bool header = false;
+
+      /// The format of TPC-H .tbl files. Every row ends with a delimiter
+      static Format tbl(char delimiter = '|') { return {delimiter, false, false}; }
+      /// The format of CSV files with a header line
+      static Format csv() { return {',', true, true}; }
+      /// Derive the format from the file name. Files ending in .csv are CSV files
+      static Format forFile(std::string_view file, char delimiter = '|');
+   };
+   /// Statistics about a load
+   struct Statistics {
+      /// The number of rows
+      uint64_t rows = 0;
+      /// The number of bytes
+      uint64_t bytes = 0;
+      /// The elapsed time
+      double seconds = 0;
+
+      /// Get the throughput
+      double getRowsPerSecond() const { return seconds > 0 ? rows / seconds : 0; }
+   };
+
+   private:
+   /// The table name (for error reporting)
+   std::string name;
+   /// The table definition
+   const Schema::Table& definition;
+   /// The number of worker threads
+   unsigned threadCount;
+
+   public:
+   /// Constructor. A thread count of 0 uses all available cores
+   Loader(std::string name, const Schema::Table& definition, unsigned threadCount = 0);
+
+   /// Load a file
+   std::unique_ptr<Table> loadFile(const std::string& file, Format format, Statistics* statistics = nullptr) const;
+   /// Load text that is already in memory
+   std::unique_ptr<Table> load(std::string_view text, Format format, Statistics* statistics = nullptr) const;
+};
+//---------------------------------------------------------------------------
+}
+}
+//---------------------------------------------------------------------------
+#endif
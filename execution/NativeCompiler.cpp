@@ -0,0 +1,171 @@
+#include "execution/NativeCompiler.hpp"
+#include "execution/Value.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <dlfcn.h>
+#include <unistd.h>
+//---------------------------------------------------------------------------
+// (c) 2023 Thomas Neumann
+//---------------------------------------------------------------------------
+using namespace std;
+//---------------------------------------------------------------------------
+namespace saneql::execution {
+//---------------------------------------------------------------------------
+/// The compiler flags
+static constexpr string_view compileFlags = "-std=c++20 -O3 -march=native -fPIC -shared -w";
+//---------------------------------------------------------------------------
+NativeModule::NativeModule(const string& fileName)
+   : handle(dlopen(fileName.c_str(), RTLD_NOW | RTLD_LOCAL))
+// Constructor
+{
+   if (!handle) throw runtime_error("unable to load compiled code: " + string(dlerror()));
+}
+//---------------------------------------------------------------------------
+NativeModule::~NativeModule()
+// Destructor
+{
+   dlclose(handle);
+}
+//---------------------------------------------------------------------------
+void* NativeModule::lookup(const char* name) const
+// Find a function
+{
+   void* result = dlsym(handle, name);
+   if (!result) throw runtime_error("compiled code lacks function '" + string(name) + "'");
+   return result;
+}
+//---------------------------------------------------------------------------
+NativeCompiler::NativeCompiler(string directory)
+   : directory(move(directory))
+// Constructor
+{
+   auto cxx = getenv("CXX");
+   command = (cxx && *cxx) ? cxx : "c++";
+   if (!this->directory.empty()) filesystem::create_directories(this->directory);
+}
+//---------------------------------------------------------------------------
+NativeCompiler::~NativeCompiler()
+// Destructor
+{
+   modules.clear();
+   if (temporary) {
+      error_code ec;
+      filesystem::remove_all(directory, ec);
+   }
+}
+//---------------------------------------------------------------------------
+void NativeCompiler::determineTarget()
+// Determine the target CPU
+{
+   // The predefined macros name the instruction sets that -march=native enables. Machines sharing a cache directory must not load code built for another CPU
+   string macros;
+   if (auto pipe = popen((command + " -march=native -dM -E -x c++ /dev/null 2>/dev/null").c_str(), "r")) {
+      char buffer[4096];
+      while (auto got = fread(buffer, 1, sizeof(buffer), pipe))
+         macros.append(buffer, got);
+      pclose(pipe);
+   }
+   char name[32];
+   snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(values::hashString(macros)));
+   target = name;
+}
+//---------------------------------------------------------------------------
+string NativeCompiler::getFileName(uint64_t key) const
+// Get the base file name of a module
+{
+   char name[32];
+   snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+   return directory + "/" + name;
+}
+//---------------------------------------------------------------------------
+static optional<string> readFile(const string& fileName)
+// Read a whole file
+{
+   ifstream in(fileName, ios::binary);
+   if (!in.is_open()) return nullopt;
+   ostringstream buffer;
+   buffer << in.rdbuf();
+   return buffer.str();
+}
+//---------------------------------------------------------------------------
+shared_ptr<NativeModule> NativeCompiler::lookupDisk(uint64_t key, const string& code)
+// Load a module from the cache directory
+{
+   // The stored code identifies the shared object, both are replaced atomically
+   auto fileName = getFileName(key);
+   auto stored = readFile(fileName + ".cpp");
+   if ((!stored) || (*stored != code)) return nullptr;
+   try {
+      return make_shared<NativeModule>(fileName + ".so");
+   } catch (const runtime_error&) {
+      return nullptr;
+   }
+}
+//---------------------------------------------------------------------------
+shared_ptr<NativeModule> NativeCompiler::build(uint64_t key, const string& code)
+// Compile code into the cache directory
+{
+   if (directory.empty()) {
+      string pattern = (filesystem::temp_directory_path() / "saneql-XXXXXX").string();
+      if (!mkdtemp(pattern.data())) throw runtime_error("unable to create a directory for compiled code");
+      directory = move(pattern);
+      temporary = true;
+   }
+
+   // Compile into files of our own first to never expose partial results
+   auto fileName = getFileName(key);
+   auto tempName = fileName + "." + to_string(getpid()) + "." + to_string(compilations++);
+   {
+      ofstream out(tempName + ".cpp", ios::binary);
+      out << code;
+      if (!out.good()) throw runtime_error("unable to write " + tempName + ".cpp");
+   }
+   string call = command + " " + string(compileFlags) + " -o '" + tempName + ".so' '" + tempName + ".cpp' 2>'" + tempName + ".log'";
+   int status = system(call.c_str());
+   auto log = readFile(tempName + ".log");
+   error_code ec;
+   filesystem::remove(tempName + ".log", ec);
+   if (status) {
+      filesystem::remove(tempName + ".cpp", ec);
+      filesystem::remove(tempName + ".so", ec);
+      string message = log ? log->substr(0, 4096) : string();
+      throw runtime_error("compilation of generated code failed: " + call + "\n" + message);
+   }
+   // The code is renamed last, it validates the shared object
+   filesystem::rename(tempName + ".so", fileName + ".so");
+   filesystem::rename(tempName + ".cpp", fileName + ".cpp");
+   return make_shared<NativeModule>(fileName + ".so");
+}
+//---------------------------------------------------------------------------
+shared_ptr<NativeModule> NativeCompiler::compile(const string& code)
+// Get a module for code, compiling it if needed
+{
+   // The compiler, its flags, and the target CPU are part of the key
+   unique_lock lock(latch);
+   if (target.empty()) determineTarget();
+   string source = "// " + command + " " + string(compileFlags) + " target " + target + "\n" + code;
+   uint64_t key = values::hashString(source);
+   auto range = modules.equal_range(key);
+   for (auto iter = range.first; iter != range.second; ++iter)
+      if (iter->second.first == source) return iter->second.second;
+   shared_ptr<NativeModule> module;
+   if (!directory.empty()) module = lookupDisk(key, source);
+   if (!module) module = build(key, source);
+   modules.emplace(key, pair{move(source), module});
+   return module;
+}
+//---------------------------------------------------------------------------
+unsigned NativeCompiler::getCompilations()
+// Get the number of compilations
+{
+   unique_lock lock(latch);
+   return compilations;
+}
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
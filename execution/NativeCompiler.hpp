@@ -0,0 +1,82 @@
+#ifndef H_saneql_execution_NativeCompiler
+#define H_saneql_execution_NativeCompiler
+//---------------------------------------------------------------------------
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+//---------------------------------------------------------------------------
+// SaneQL
+// (c) 2023 Thomas Neumann
+// SPDX-License-Identifier: BSD-3-Clause
+//---------------------------------------------------------------------------
+namespace saneql {
+//---------------------------------------------------------------------------
+namespace execution {
+//---------------------------------------------------------------------------
+/// A loaded shared object with generated code
+class NativeModule {
+   /// The handle
+   void* handle;
+
+   public:
+   /// Constructor. Loads a shared object, throws on failure
+   explicit NativeModule(const std::string& fileName);
+   /// Destructor
+   ~NativeModule();
+
+   NativeModule(const NativeModule&) = delete;
+   NativeModule& operator=(const NativeModule&) = delete;
+
+   /// Find a function. Throws if it does not exist
+   void* lookup(const char* name) const;
+};
+//---------------------------------------------------------------------------
+/// Compiles generated C++ code into shared objects with the system compiler and loads
+/// them. The modules are cached in memory and optionally in a directory, keyed by the
+/// hash of the code, the compiler flags, and the target CPU. The code describes the compiled plan
+/// completely, hits are verified by comparing it. Can be shared between threads
+class NativeCompiler {
+   /// The cache directory. A private temporary directory if none is given
+   std::string directory;
+   /// Do we remove the directory at the end?
+   bool temporary = false;
+   /// The compiler command
+   std::string command;
+   /// The target CPU selected by -march=native, determined on first use
+   std::string target;
+   /// The loaded modules with their code
+   std::unordered_multimap<uint64_t, std::pair<std::string, std::shared_ptr<NativeModule>>> modules;
+   /// The number of compilations
+   unsigned compilations = 0;
+   /// The latch
+   std::mutex latch;
+
+   /// Determine the target CPU
+   void determineTarget();
+   /// Get the base file name of a module
+   std::string getFileName(uint64_t key) const;
+   /// Load a module from the cache directory. nullptr if it does not exist
+   std::shared_ptr<NativeModule> lookupDisk(uint64_t key, const std::string& code);
+   /// Compile code into the cache directory
+   std::shared_ptr<NativeModule> build(uint64_t key, const std::string& code);
+
+   public:
+   /// Constructor. The compiler is taken from $CXX if set
+   explicit NativeCompiler(std::string directory = {});
+   /// Destructor
+   ~NativeCompiler();
+
+   /// Get a module for code, compiling it if needed. Throws if compilation fails
+   std::shared_ptr<NativeModule> compile(const std::string& code);
+   /// Get the number of compilations, cache hits excluded
+   unsigned getCompilations();
+};
+//---------------------------------------------------------------------------
+}
+}
+//---------------------------------------------------------------------------
+#endif
@@ -0,0 +1,1857 @@
+#include "execution/PhysicalOperator.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_set>
+//---------------------------------------------------------------------------
+// (c) 2023 Thomas Neumann
+//---------------------------------------------------------------------------
+using namespace std;
+//---------------------------------------------------------------------------
+namespace saneql::execution {
+//---------------------------------------------------------------------------
+/// The number of rows of a morsel
+static constexpr uint64_t morselRows = 16 * Batch::maxSize;
+/// The number of chunks of a morsel of a materialized relation
+static constexpr uint64_t morselChunks = 16;
+//---------------------------------------------------------------------------
+static vector<ValueType> makeNullable(vector<ValueType> types)
+// Make all types nullable. Used for materialized data, which might contain NULL values from outer joins
+{
+   for (auto& t : types)
+      t = t.withNullable(true);
+   return types;
+}
+//---------------------------------------------------------------------------
+static vector<ValueType> concat(vector<ValueType> a, const vector<ValueType>& b)
+// Concatenate two type lists
+{
+   a.insert(a.end(), b.begin(), b.end());
+   return a;
+}
+//---------------------------------------------------------------------------
+static vector<ValueType> getTypes(const vector<unique_ptr<Evaluator>>& evaluators)
+// Get the result types of evaluators
+{
+   vector<ValueType> result;
+   for (auto& e : evaluators)
+      result.push_back(e->getType());
+   return result;
+}
+//---------------------------------------------------------------------------
+static bool equalValues(const Vector& a, unsigned ra, const Vector& b, unsigned rb)
+// Compare two values of the same type. NULL values are equal
+{
+   bool na = a.isNull(ra), nb = b.isNull(rb);
+   if (na || nb) return na && nb;
+   return dispatch(a.getType().getPhysicalType(), [&]<class T>(T*) { return a.getData<T>()[ra] == b.getData<T>()[rb]; });
+}
+//---------------------------------------------------------------------------
+static int compareWithNulls(ValueType type, const Value& a, const Value& b)
+// Compare two values, NULL values are larger than all other values
+{
+   if (a.null || b.null) return static_cast<int>(a.null) - static_cast<int>(b.null);
+   return values::compare(type, a, b);
+}
+//---------------------------------------------------------------------------
+static Value makeSum(ValueType type, Int128 sum)
+// Build the result of a sum, integer sums must fit into 64 bits
+{
+   if (type.getKind() == ValueType::Integer) values::checkedInteger(sum);
+   return Value::makeNumber(sum);
+}
+//---------------------------------------------------------------------------
+static void appendColumns(Batch& target, const Batch& batch, const vector<unique_ptr<Evaluator>>& evaluators)
+// Build a batch with the columns of a batch followed by the results of evaluators
+{
+   target.columns.resize(batch.columns.size() + evaluators.size());
+   for (unsigned index = 0; index != batch.columns.size(); ++index)
+      target.columns[index].reference(batch.columns[index]);
+   for (unsigned index = 0; index != evaluators.size(); ++index)
+      target.columns[batch.columns.size() + index].reference(evaluators[index]->evaluate(batch));
+   target.size = batch.size;
+}
+//---------------------------------------------------------------------------
+PhysicalOperator::~PhysicalOperator()
+// Destructor
+{
+}
+//---------------------------------------------------------------------------
+void PhysicalOperator::consume(const Batch&, unsigned)
+// Consume a batch of an input
+{
+   throw runtime_error("operator has no inputs");
+}
+//---------------------------------------------------------------------------
+GroupTable::GroupTable(vector<ValueType> types)
+   : values(makeNullable(types)), row(makeNullable(types))
+// Constructor
+{
+   clear();
+}
+//---------------------------------------------------------------------------
+void GroupTable::clear()
+// Remove all entries
+{
+   values.clear();
+   hashes.clear();
+   next.clear();
+   directory.assign(1024, notFound);
+}
+//---------------------------------------------------------------------------
+void GroupTable::hashValues(const vector<const Vector*>& keys, unsigned count, uint64_t* hashes)
+// Compute the hash values of a batch of values
+{
+   fill(hashes, hashes + count, 0);
+   for (auto key : keys) {
+      dispatch(key->getType().getPhysicalType(), [&]<class T>(T*) {
+         auto data = key->getData<T>();
+         for (unsigned index = 0; index != count; ++index) {
+            uint64_t h;
+            if (key->isNull(index))
+               h = values::nullHash;
+            else if constexpr (is_same_v<T, string_view>)
+               h = values::hashString(data[index]);
+            else
+               h = values::hashNumber(data[index]);
+            hashes[index] = values::combineHashes(hashes[index], h);
+         }
+      });
+   }
+}
+//---------------------------------------------------------------------------
+uint64_t GroupTable::find(const vector<const Vector*>& keys, unsigned index, uint64_t hash) const
+// Find an entry
+{
+   for (uint64_t entry = directory[hash & (directory.size() - 1)]; entry != notFound; entry = next[entry]) {
+      if (hashes[entry] != hash) continue;
+      bool equal = true;
+      for (unsigned column = 0; (column != keys.size()) && equal; ++column)
+         equal = equalValues(*keys[column], index, values.getColumn(column, entry), entry % Batch::maxSize);
+      if (equal) return entry;
+   }
+   return notFound;
+}
+//---------------------------------------------------------------------------
+void GroupTable::insert(const vector<const Vector*>& keys, unsigned count, uint64_t* entries, uint8_t* isNew)
+// Find the entries of a batch of values, inserting missing entries
+{
+   uint64_t batchHashes[Batch::maxSize];
+   hashValues(keys, count, batchHashes);
+   for (unsigned index = 0; index != count; ++index) {
+      uint64_t hash = batchHashes[index];
+      uint64_t entry = find(keys, index, hash);
+      if (isNew) isNew[index] = entry == notFound;
+      if (entry == notFound) {
+         // Grow the directory to keep the chains short
+         entry = values.getSize();
+         if (2 * (entry + 1) > directory.size()) {
+            directory.assign(2 * directory.size(), notFound);
+            for (uint64_t other = 0; other != entry; ++other) {
+               auto& slot = directory[hashes[other] & (directory.size() - 1)];
+               next[other] = slot;
+               slot = other;
+            }
+         }
+         for (unsigned column = 0; column != keys.size(); ++column)
+            row.columns[column].reference(*keys[column]);
+         uint32_t rowIndex = index;
+         values.append(row, &rowIndex, 1);
+         auto& slot = directory[hash & (directory.size() - 1)];
+         hashes.push_back(hash);
+         next.push_back(slot);
+         slot = entry;
+      }
+      entries[index] = entry;
+   }
+}
+//---------------------------------------------------------------------------
+void GroupTable::lookup(const vector<const Vector*>& keys, unsigned count, uint64_t* entries) const
+// Find the entries of a batch of values
+{
+   uint64_t batchHashes[Batch::maxSize];
+   hashValues(keys, count, batchHashes);
+   for (unsigned index = 0; index != count; ++index)
+      entries[index] = find(keys, index, batchHashes[index]);
+}
+//---------------------------------------------------------------------------
+static vector<ValueType> selectTypes(const vector<ValueType>& types, const vector<unsigned>& columns)
+// Select types
+{
+   vector<ValueType> result;
+   for (auto c : columns)
+      result.push_back(types[c]);
+   return result;
+}
+//---------------------------------------------------------------------------
+Scan::Scan(const Relation& relation, vector<unsigned> columns)
+   : PhysicalOperator(selectTypes(relation.getTypes(), columns)), relation(relation), columns(move(columns)), output(types)
+// Constructor
+{
+}
+//---------------------------------------------------------------------------
+Scan::Scan(unique_ptr<Relation> relation, vector<unsigned> columns)
+   : Scan(*relation, move(columns))
+// Constructor for an owned relation
+{
+   ownedRelation = move(relation);
+}
+//---------------------------------------------------------------------------
+void Scan::setWorker(Worker& worker)
+// Make the operator an instance of a parallel plan
+{
+   PhysicalOperator::setWorker(worker);
+   morsels = &worker.registerState<MorselQueue>(relation.getChunks().size(), worker.getWorkerCount(), morselChunks);
+}
+//---------------------------------------------------------------------------
+void Scan::produce()
+// Produce all result batches
+{
+   // Reference the stored values directly
+   auto produceChunks = [&](uint64_t begin, uint64_t end) {
+      for (uint64_t pos = begin; pos != end; ++pos) {
+         auto& chunk = relation.getChunks()[pos];
+         for (unsigned index = 0; index != columns.size(); ++index)
+            output.columns[index].reference(chunk->columns[columns[index]]);
+         output.size = chunk->size;
+         push(output);
+      }
+   };
+   if (!morsels) {
+      produceChunks(0, relation.getChunks().size());
+      return;
+   }
+   uint64_t begin, end;
+   while (morsels->next(worker->getId(), begin, end))
+      produceChunks(begin, end);
+}
+//---------------------------------------------------------------------------
+TableScan::TableScan(const Table& table, vector<unsigned> columns)
+   : PhysicalOperator(selectTypes(table.getTypes(), columns)), table(table), columns(move(columns)), output(types)
+// Constructor
+{
+}
+//---------------------------------------------------------------------------
+void TableScan::setWorker(Worker& worker)
+// Make the operator an instance of a parallel plan
+{
+   PhysicalOperator::setWorker(worker);
+   morsels = &worker.registerState<MorselQueue>(table.getSize(), worker.getWorkerCount(), morselRows);
+}
+//---------------------------------------------------------------------------
+void TableScan::produce()
+// Produce all result batches
+{
+   auto produceRows = [&](uint64_t begin, uint64_t end) {
+      for (uint64_t from = begin; from < end; from += Batch::maxSize) {
+         unsigned count = min<uint64_t>(end - from, Batch::maxSize);
+         for (unsigned index = 0; index != columns.size(); ++index)
+            table.getColumns()[columns[index]].read(from, count, output.columns[index]);
+         output.size = count;
+         push(output);
+      }
+   };
+   if (!morsels) {
+      produceRows(0, table.getSize());
+      return;
+   }
+   uint64_t begin, end;
+   while (morsels->next(worker->getId(), begin, end))
+      produceRows(begin, end);
+}
+//---------------------------------------------------------------------------
+Filter::Filter(unique_ptr<PhysicalOperator> input, unique_ptr<Evaluator> condition)
+   : PhysicalOperator(input->getTypes()), input(move(input)), condition(move(condition)), selection(Batch::maxSize), output(types)
+// Constructor
+{
+   attach(*this->input, 0);
+}
+//---------------------------------------------------------------------------
+void Filter::produce()
+// Produce all result batches
+{
+   input->produce();
+}
+//---------------------------------------------------------------------------
+void Filter::consume(const Batch& batch, unsigned)
+// Consume a batch of an input
+{
+   auto& result = condition->evaluate(batch);
+   auto values = result.getData<uint8_t>();
+   auto nulls = result.getNulls();
+   unsigned count = 0;
+   for (unsigned index = 0; index != batch.size; ++index) {
+      selection[count] = index;
+      count += values[index] && !(nulls && nulls[index]);
+   }
+
+   // Pass the batch on unchanged if possible
+   if (!count) return;
+   if (count == batch.size) {
+      push(batch);
+      return;
+   }
+   for (unsigned index = 0; index != batch.columns.size(); ++index)
+      output.columns[index].gather(batch.columns[index], selection.data(), count);
+   output.size = count;
+   push(output);
+}
+//---------------------------------------------------------------------------
+Map::Map(unique_ptr<PhysicalOperator> input, vector<unique_ptr<Evaluator>> computations)
+   : PhysicalOperator(concat(input->getTypes(), execution::getTypes(computations))), input(move(input)), computations(move(computations))
+// Constructor
+{
+   attach(*this->input, 0);
+}
+//---------------------------------------------------------------------------
+void Map::produce()
+// Produce all result batches
+{
+   input->produce();
+}
+//---------------------------------------------------------------------------
+void Map::consume(const Batch& batch, unsigned)
+// Consume a batch of an input
+{
+   appendColumns(output, batch, computations);
+   push(output);
+}
+//---------------------------------------------------------------------------
+static vector<ValueType> getJoinTypes(const PhysicalOperator& left, const PhysicalOperator& right, HashJoin::JoinType joinType)
+// Get the result types of a join
+{
+   using JoinType = HashJoin::JoinType;
+   switch (joinType) {
+      case JoinType::Inner: return concat(left.getTypes(), right.getTypes());
+      case JoinType::LeftOuter: return concat(left.getTypes(), makeNullable(right.getTypes()));
+      case JoinType::RightOuter: return concat(makeNullable(left.getTypes()), right.getTypes());
+      case JoinType::FullOuter: return concat(makeNullable(left.getTypes()), makeNullable(right.getTypes()));
+      case JoinType::LeftSemi:
+      case JoinType::LeftAnti: return left.getTypes();
+      case JoinType::RightSemi:
+      case JoinType::RightAnti: return right.getTypes();
+   }
+   __builtin_unreachable();
+}
+//---------------------------------------------------------------------------
+/// The number of build rows that fit into the cache together with their hash table
+static constexpr uint64_t cacheRows = 1 << 15;
+/// The number of build rows per partition of a partitioned hash table
+static constexpr uint64_t partitionRows = 1 << 12;
+/// The maximum number of radix bits. More partitions would thrash the TLB while partitioning
+static constexpr unsigned maxRadixBits = 12;
+//---------------------------------------------------------------------------
+/// The state shared by the instances of a parallel plan
+struct HashJoin::Shared : public SharedState {
+   /// The build sides of the instances
+   vector<unique_ptr<Relation>> builds;
+   /// The hash values of the build sides
+   vector<vector<uint64_t>> hashes;
+   /// The first chunk of each build side within the hash table
+   vector<uint64_t> firstChunk;
+   /// The partition sizes of each instance, then its scatter positions
+   vector<vector<uint64_t>> histograms;
+   /// The hash table
+   HashTable table;
+   /// The morsels of partitions and entries
+   MorselQueue partitions, entries;
+
+   /// Constructor
+   explicit Shared(unsigned workerCount) : builds(workerCount), hashes(workerCount), firstChunk(workerCount), histograms(workerCount) {}
+};
+//---------------------------------------------------------------------------
+static void setFlag(uint8_t& flag)
+// Set a flag that other workers might set concurrently
+{
+   atomic_ref<uint8_t>(flag).store(1, memory_order_relaxed);
+}
+//---------------------------------------------------------------------------
+HashJoin::HashJoin(unique_ptr<PhysicalOperator> left, unique_ptr<PhysicalOperator> right, JoinType joinType, vector<unique_ptr<Evaluator>> leftKeys, vector<unique_ptr<Evaluator>> rightKeys, unique_ptr<Evaluator> residual, bool buildLeft)
+   : PhysicalOperator(getJoinTypes(*left, *right, joinType)), left(move(left)), right(move(right)), leftKeys(move(leftKeys)), rightKeys(move(rightKeys)), residual(move(residual)), joinType(joinType), buildLeft(buildLeft), pairs(concat(this->left->getTypes(), this->right->getTypes())), output(types)
+// Constructor
+{
+   leftWidth = this->left->getTypes().size();
+   rightWidth = this->right->getTypes().size();
+   attach(*this->left, 0);
+   attach(*this->right, 1);
+   probeMatched.resize(Batch::maxSize);
+   probeChains.resize(Batch::maxSize);
+   probeHashes.resize(Batch::maxSize);
+   selection.resize(Batch::maxSize);
+   ownedShared = make_unique<Shared>(1);
+   shared = ownedShared.get();
+}
+//---------------------------------------------------------------------------
+HashJoin::~HashJoin()
+// Destructor
+{
+}
+//---------------------------------------------------------------------------
+void HashJoin::setWorker(Worker& worker)
+// Make the operator an instance of a parallel plan
+{
+   PhysicalOperator::setWorker(worker);
+   shared = &worker.registerState<Shared>(worker.getWorkerCount());
+   ownedShared.reset();
+}
+//---------------------------------------------------------------------------
+bool HashJoin::keepsUnmatched(bool leftSide) const
+// Does the join produce the unmatched rows of a side?
+{
+   if (joinType == JoinType::FullOuter) return true;
+   if (leftSide) return (joinType == JoinType::LeftOuter) || (joinType == JoinType::LeftAnti);
+   return (joinType == JoinType::RightOuter) || (joinType == JoinType::RightAnti);
+}
+//---------------------------------------------------------------------------
+bool HashJoin::keepsMatched(bool leftSide) const
+// Does the join produce the matched rows of a side only?
+{
+   return joinType == (leftSide ? JoinType::LeftSemi : JoinType::RightSemi);
+}
+//---------------------------------------------------------------------------
+void HashJoin::produce()
+// Produce all result batches
+{
+   auto& buildInput = buildLeft ? *left : *right;
+   auto& probeInput = buildLeft ? *right : *left;
+   build = make_unique<Relation>(concat(makeNullable(buildInput.getTypes()), makeNullable(execution::getTypes(buildLeft ? leftKeys : rightKeys))));
+   buildHashes.clear();
+   buildInput.produce();
+   finishBuild();
+   probeInput.produce();
+
+   // Produce the build rows that depend on the matches once all instances have probed
+   if (keepsUnmatched(buildLeft) || keepsMatched(buildLeft)) {
+      if (worker) worker->synchronize();
+      uint64_t begin, end;
+      while (shared->entries.next(worker ? worker->getId() : 0, begin, end))
+         produceBuildRows(begin, end);
+   }
+   if (ownedShared) {
+      ownedShared = make_unique<Shared>(1);
+      shared = ownedShared.get();
+   }
+}
+//---------------------------------------------------------------------------
+void HashJoin::produceBuildRows(uint64_t begin, uint64_t end)
+// Produce the build rows that depend on the matches within a range of entries
+{
+   auto& table = shared->table;
+   uint8_t wanted = keepsMatched(buildLeft);
+   vector<uint64_t> entries;
+   for (uint64_t entry = begin; entry != end; ++entry) {
+      if (table.matched[entry] != wanted) continue;
+      entries.push_back(entry);
+      if (entries.size() == Batch::maxSize) {
+         produceSide(nullptr, entries);
+         entries.clear();
+      }
+   }
+   if (!entries.empty()) produceSide(nullptr, entries);
+}
+//---------------------------------------------------------------------------
+void HashJoin::consume(const Batch& batch, unsigned input)
+// Consume a batch of an input
+{
+   if (isBuild(input))
+      addBuild(batch);
+   else
+      probe(batch);
+}
+//---------------------------------------------------------------------------
+void HashJoin::addBuild(const Batch& batch)
+// Add a build batch
+{
+   auto& keys = buildLeft ? leftKeys : rightKeys;
+   Batch combined;
+   appendColumns(combined, batch, keys);
+   build->append(combined);
+
+   vector<const Vector*> keyValues;
+   for (unsigned index = 0; index != keys.size(); ++index)
+      keyValues.push_back(&combined.columns[batch.columns.size() + index]);
+   auto first = buildHashes.size();
+   buildHashes.resize(first + batch.size);
+   GroupTable::hashValues(keyValues, batch.size, buildHashes.data() + first);
+}
+//---------------------------------------------------------------------------
+void HashJoin::finishBuild()
+// Build the hash table over the build sides of all instances
+{
+   // The build sides stay in place, the table references their chunks. A serial plan acts as the only instance
+   unsigned id = worker ? worker->getId() : 0, instanceCount = shared->builds.size();
+   bool leader = !id;
+   auto synchronize = [&]() {
+      if (worker) worker->synchronize();
+   };
+   auto& table = shared->table;
+   shared->builds[id] = move(build);
+   shared->hashes[id] = move(buildHashes);
+   synchronize();
+
+   // Choose the number of partitions. A build side that fits into the cache uses a single partition
+   if (leader) {
+      table = HashTable();
+      table.types = shared->builds.front()->getTypes();
+      uint64_t size = 0;
+      for (unsigned index = 0; index != instanceCount; ++index) {
+         auto& rows = *shared->builds[index];
+         shared->firstChunk[index] = table.chunks.size();
+         for (auto& chunk : rows.getChunks())
+            table.chunks.push_back(chunk.get());
+         size += rows.getSize();
+      }
+      table.radixBits = (size <= cacheRows) ? 0 : min<unsigned>(bit_width((size - 1) / partitionRows), maxRadixBits);
+   }
+   synchronize();
+
+   // Count the rows per partition
+   uint64_t partitionCount = uint64_t(1) << table.radixBits;
+   auto& hashes = shared->hashes[id];
+   auto& histogram = shared->histograms[id];
+   histogram.assign(partitionCount, 0);
+   for (auto hash : hashes)
+      ++histogram[table.getPartition(hash)];
+   synchronize();
+
+   // Compute the partition bounds and the positions of the instances within each partition
+   if (leader) {
+      table.partitionBegin.resize(partitionCount + 1);
+      table.directoryBegin.resize(partitionCount + 1);
+      uint64_t entryCount = 0, slotCount = 0;
+      for (uint64_t partition = 0; partition != partitionCount; ++partition) {
+         table.partitionBegin[partition] = entryCount;
+         for (auto& h : shared->histograms) {
+            uint64_t count = h[partition];
+            h[partition] = entryCount;
+            entryCount += count;
+         }
+         table.directoryBegin[partition] = slotCount;
+         slotCount += bit_ceil(max<uint64_t>(2 * (entryCount - table.partitionBegin[partition]), 16));
+      }
+      table.partitionBegin[partitionCount] = entryCount;
+      table.directoryBegin[partitionCount] = slotCount;
+      table.entries.resize(entryCount);
+      table.next.resize(entryCount);
+      table.matched.assign(entryCount, 0);
+      table.directory.assign(slotCount, GroupTable::notFound);
+      shared->partitions.reset(partitionCount, instanceCount, 1);
+      shared->entries.reset(entryCount, instanceCount, morselRows);
+   }
+   synchronize();
+
+   // Scatter the rows into their partitions
+   uint64_t firstRow = shared->firstChunk[id] * Batch::maxSize;
+   for (uint64_t row = 0, size = hashes.size(); row != size; ++row) {
+      uint64_t hash = hashes[row];
+      table.entries[histogram[table.getPartition(hash)]++] = {hash, firstRow + row};
+   }
+   synchronize();
+
+   // Build the directories
+   uint64_t begin, end;
+   while (shared->partitions.next(id, begin, end))
+      for (uint64_t partition = begin; partition != end; ++partition)
+         buildPartition(partition);
+   synchronize();
+}
+//---------------------------------------------------------------------------
+void HashJoin::buildPartition(uint64_t partition)
+// Build the directory of a partition
+{
+   auto& table = shared->table;
+   unsigned width = buildLeft ? leftWidth : rightWidth, keyCount = leftKeys.size();
+   for (uint64_t entry = table.partitionBegin[partition], end = table.partitionBegin[partition + 1]; entry != end; ++entry) {
+      // NULL keys never find a join partner
+      uint64_t row = table.entries[entry].row;
+      auto& chunk = table.getChunk(row);
+      bool hasNull = false;
+      for (unsigned key = 0; (key != keyCount) && (!hasNull); ++key)
+         hasNull = chunk.columns[width + key].isNull(row % Batch::maxSize);
+      if (hasNull) continue;
+      auto& slot = table.directory[table.getSlot(table.entries[entry].hash)];
+      table.next[entry] = slot;
+      slot = entry;
+   }
+}
+//---------------------------------------------------------------------------
+void HashJoin::gatherBuild(unsigned column, const uint64_t* entries, unsigned count, Vector& target) const
+// Copy the values of a build column for a list of entries into a vector
+{
+   auto& table = shared->table;
+   target.allocate(count, table.types[column].isNullable());
+   dispatch(table.types[column].getPhysicalType(), [&]<class T>(T*) {
+      auto out = target.getData<T>();
+      for (unsigned index = 0; index != count; ++index) {
+         uint64_t row = table.entries[entries[index]].row;
+         out[index] = table.getChunk(row).columns[column].getData<T>()[row % Batch::maxSize];
+      }
+   });
+   if (auto nulls = target.getNulls())
+      for (unsigned index = 0; index != count; ++index) {
+         uint64_t row = table.entries[entries[index]].row;
+         nulls[index] = table.getChunk(row).columns[column].isNull(row % Batch::maxSize);
+      }
+}
+//---------------------------------------------------------------------------
+void HashJoin::probe(const Batch& batch)
+// Probe a batch
+{
+   auto& keys = buildLeft ? rightKeys : leftKeys;
+   vector<const Vector*> keyValues;
+   for (auto& k : keys)
+      keyValues.push_back(&k->evaluate(batch));
+   GroupTable::hashValues(keyValues, batch.size, probeHashes.data());
+   fill(probeMatched.begin(), probeMatched.begin() + batch.size, 0);
+
+   // Without residual condition semi and anti joins do not need the pairs
+   bool probeIsLeft = !buildLeft;
+   bool probeChecksOnly = (!residual) && (keepsMatched(probeIsLeft) || (joinType == (probeIsLeft ? JoinType::LeftAnti : JoinType::RightAnti)));
+   bool buildChecksOnly = (!residual) && (!producesPairs()) && (!probeChecksOnly);
+   unsigned width = buildLeft ? leftWidth : rightWidth;
+   auto& table = shared->table;
+
+   // Locate the chains of the whole batch first. The directory slots and the first entries are prefetched
+   // one pass before they are accessed, which overlaps the cache misses of different rows
+   for (unsigned row = 0; row != batch.size; ++row) {
+      probeChains[row] = table.getSlot(probeHashes[row]);
+      __builtin_prefetch(table.directory.data() + probeChains[row]);
+   }
+   for (unsigned row = 0; row != batch.size; ++row) {
+      bool hasNull = false;
+      for (auto k : keyValues)
+         hasNull |= k->isNull(row);
+      probeChains[row] = hasNull ? GroupTable::notFound : table.directory[probeChains[row]];
+      if (probeChains[row] != GroupTable::notFound) __builtin_prefetch(table.entries.data() + probeChains[row]);
+   }
+   for (unsigned row = 0; row != batch.size; ++row) {
+      uint64_t hash = probeHashes[row];
+      for (uint64_t entry = probeChains[row]; entry != GroupTable::notFound; entry = table.next[entry]) {
+         if (table.entries[entry].hash != hash) continue;
+         uint64_t buildRow = table.entries[entry].row;
+         auto& chunk = table.getChunk(buildRow);
+         bool equal = true;
+         for (unsigned key = 0; (key != keyValues.size()) && equal; ++key)
+            equal = equalValues(*keyValues[key], row, chunk.columns[width + key], buildRow % Batch::maxSize);
+         if (!equal) continue;
+         if (probeChecksOnly) {
+            probeMatched[row] = 1;
+            break;
+         }
+         if (buildChecksOnly) {
+            setFlag(table.matched[entry]);
+            continue;
+         }
+         pairProbe.push_back(row);
+         pairBuild.push_back(entry);
+         if (pairProbe.size() == Batch::maxSize) processPairs(batch);
+      }
+   }
+   if (!pairProbe.empty()) processPairs(batch);
+
+   // Produce the probe rows that depend on the matches
+   if (keepsUnmatched(probeIsLeft) || keepsMatched(probeIsLeft)) {
+      uint8_t wanted = keepsMatched(probeIsLeft);
+      vector<uint64_t> rows;
+      for (unsigned row = 0; row != batch.size; ++row)
+         if (probeMatched[row] == wanted) rows.push_back(row);
+      if (!rows.empty()) produceSide(&batch, rows);
+   }
+}
+//---------------------------------------------------------------------------
+void HashJoin::processPairs(const Batch& batch)
+// Process candidate pairs
+{
+   unsigned count = pairProbe.size();
+   for (unsigned index = 0; index != leftWidth + rightWidth; ++index) {
+      bool isLeft = index < leftWidth;
+      unsigned column = isLeft ? index : index - leftWidth;
+      if (isLeft == buildLeft)
+         gatherBuild(column, pairBuild.data(), count, pairs.columns[index]);
+      else
+         pairs.columns[index].gather(batch.columns[column], pairProbe.data(), count);
+   }
+   pairs.size = count;
+
+   // Check the residual condition
+   unsigned selected = 0;
+   if (residual) {
+      auto& result = residual->evaluate(pairs);
+      auto values = result.getData<uint8_t>();
+      auto nulls = result.getNulls();
+      for (unsigned index = 0; index != count; ++index) {
+         selection[selected] = index;
+         selected += values[index] && !(nulls && nulls[index]);
+      }
+   } else {
+      iota(selection.begin(), selection.begin() + count, 0);
+      selected = count;
+   }
+   for (unsigned index = 0; index != selected; ++index) {
+      probeMatched[pairProbe[selection[index]]] = 1;
+      setFlag(shared->table.matched[pairBuild[selection[index]]]);
+   }
+   pairProbe.clear();
+   pairBuild.clear();
+   if ((!producesPairs()) || (!selected)) return;
+   if (selected == count) {
+      push(pairs);
+      return;
+   }
+   for (unsigned index = 0; index != pairs.columns.size(); ++index)
+      output.columns[index].gather(pairs.columns[index], selection.data(), selected);
+   output.size = selected;
+   push(output);
+}
+//---------------------------------------------------------------------------
+void HashJoin::produceSide(const Batch* probeBatch, const vector<uint64_t>& rows)
+// Produce rows of one side, padded with NULL values if needed
+{
+   bool isLeft = probeBatch ? !buildLeft : buildLeft;
+   unsigned count = rows.size();
+   unsigned offset = (producesPairs() && (!isLeft)) ? leftWidth : 0, width = isLeft ? leftWidth : rightWidth;
+   if (probeBatch) {
+      for (unsigned index = 0; index != count; ++index)
+         selection[index] = rows[index];
+      for (unsigned index = 0; index != width; ++index)
+         output.columns[offset + index].gather(probeBatch->columns[index], selection.data(), count);
+   } else {
+      for (unsigned index = 0; index != width; ++index)
+         gatherBuild(index, rows.data(), count, output.columns[offset + index]);
+   }
+
+   // Pad the other side for outer joins
+   if (producesPairs()) {
+      unsigned otherOffset = isLeft ? leftWidth : 0, otherWidth = isLeft ? rightWidth : leftWidth;
+      for (unsigned index = 0; index != otherWidth; ++index) {
+         auto& column = output.columns[otherOffset + index];
+         column.allocate(count, true);
+         memset(column.getData<std::byte>(), 0, static_cast<size_t>(count) * column.getType().getWidth());
+         memset(column.getNulls(), 1, count);
+      }
+   }
+   output.size = count;
+   push(output);
+}
+//---------------------------------------------------------------------------
+static bool isDistinct(HashAggregation::Op op)
+// Is an aggregate a distinct aggregate?
+{
+   using Op = HashAggregation::Op;
+   return (op == Op::CountDistinct) || (op == Op::SumDistinct) || (op == Op::AvgDistinct);
+}
+//---------------------------------------------------------------------------
+static vector<ValueType> getAggregationTypes(const vector<unique_ptr<Evaluator>>& groupBy, const vector<HashAggregation::Aggregate>& aggregates)
+// Get the result types of an aggregation
+{
+   auto result = getTypes(groupBy);
+   for (auto& a : aggregates)
+      result.push_back(HashAggregation::getResultType(a.op, a.value ? a.value->getType() : ValueType()));
+   return result;
+}
+//---------------------------------------------------------------------------
+static vector<ValueType> getSpillTypes(const vector<unique_ptr<Evaluator>>& groupBy, const vector<HashAggregation::Aggregate>& aggregates)
+// Get the column types of spilled groups. The keys are followed by the count of each aggregate, the sum of sums and averages, and the value of minima and maxima
+{
+   using Op = HashAggregation::Op;
+   auto result = makeNullable(getTypes(groupBy));
+   for (auto& a : aggregates) {
+      if (isDistinct(a.op)) continue;
+      result.push_back(ValueType(ValueType::Integer));
+      if ((a.op == Op::Sum) || (a.op == Op::Avg)) result.push_back(ValueType(ValueType::Decimal));
+      if ((a.op == Op::Min) || (a.op == Op::Max)) result.push_back(a.value->getType().withNullable(true));
+   }
+   return result;
+}
+//---------------------------------------------------------------------------
+/// The number of groups of a pre-aggregation table
+static constexpr uint64_t preaggregationGroups = 1 << 14;
+/// The minimal reduction of the input by the pre-aggregation. Input that is reduced less bypasses it
+static constexpr uint64_t minReduction = 2;
+/// The number of groups of ordered input that are emitted together
+static constexpr uint64_t orderedGroups = Batch::maxSize;
+/// The number of spilled groups up to which a partition is merged with a hash table. Larger partitions are sorted
+static constexpr uint64_t hashMergeGroups = 1 << 16;
+//---------------------------------------------------------------------------
+/// The state shared by the instances of a parallel plan
+struct HashAggregation::Shared : public SharedState {
+   /// The instances
+   vector<HashAggregation*> instances;
+   /// The morsels of partitions
+   MorselQueue partitions;
+
+   /// Constructor
+   explicit Shared(unsigned workerCount) : instances(workerCount) {}
+};
+//---------------------------------------------------------------------------
+HashAggregation::HashAggregation(unique_ptr<PhysicalOperator> input, vector<unique_ptr<Evaluator>> groupBy, vector<Aggregate> aggregates, bool ordered)
+   : PhysicalOperator(getAggregationTypes(groupBy, aggregates)), input(move(input)), groupBy(move(groupBy)), aggregates(move(aggregates)), ordered(ordered), spillTypes(getSpillTypes(this->groupBy, this->aggregates)), local(execution::getTypes(this->groupBy)), rowGroups(Batch::maxSize), hashes(Batch::maxSize), partitionOrder(Batch::maxSize), spillRows(spillTypes), distinctEntries(Batch::maxSize), isNew(Batch::maxSize), groupIds(ValueType(ValueType::Integer)), output(types)
+// Constructor
+{
+   attach(*this->input, 0);
+   ownedShared = make_unique<Shared>(1);
+   shared = ownedShared.get();
+}
+//---------------------------------------------------------------------------
+HashAggregation::~HashAggregation()
+// Destructor
+{
+}
+//---------------------------------------------------------------------------
+void HashAggregation::setWorker(Worker& worker)
+// Make the operator an instance of a parallel plan
+{
+   PhysicalOperator::setWorker(worker);
+   shared = &worker.registerState<Shared>(worker.getWorkerCount());
+   ownedShared.reset();
+}
+//---------------------------------------------------------------------------
+ValueType HashAggregation::getResultType(Op op, ValueType input)
+// Get the result type of an aggregate
+{
+   switch (op) {
+      case Op::CountStar:
+      case Op::Count:
+      case Op::CountDistinct: return ValueType(ValueType::Integer);
+      case Op::Sum:
+      case Op::SumDistinct:
+         if (!input.isNumeric()) throw runtime_error("cannot sum " + input.getName());
+         return input.withNullable(true);
+      case Op::Avg:
+      case Op::AvgDistinct:
+         if (!input.isNumeric()) throw runtime_error("cannot average " + input.getName());
+         return ValueType(ValueType::Decimal, max(input.getScale(), 6u), true);
+      case Op::Min:
+      case Op::Max: return input.withNullable(true);
+   }
+   __builtin_unreachable();
+}
+//---------------------------------------------------------------------------
+void HashAggregation::produce()
+// Produce all result batches
+{
+   unsigned id = worker ? worker->getId() : 0, instanceCount = shared->instances.size();
+   reset(local);
+   spills.clear();
+   spills.resize(max<uint64_t>(bit_ceil(4ull * instanceCount), 16));
+   for (auto& spill : spills) {
+      spill.groups = make_unique<Relation>(spillTypes);
+      spill.distinct.resize(aggregates.size());
+      for (unsigned index = 0; index != aggregates.size(); ++index)
+         if (isDistinct(aggregates[index].op)) spill.distinct[index] = make_unique<Relation>(concat(makeNullable(execution::getTypes(groupBy)), {aggregates[index].value->getType().withNullable(true)}));
+   }
+   partitionBounds.assign(spills.size() + 1, 0);
+   spilled = false;
+   sortBased = false;
+   consumedRows = 0;
+
+   // Without group by there is always exactly one group
+   if (groupBy.empty()) local.groups.insert({}, 1, rowGroups.data());
+   input->produce();
+
+   // A single instance without overflow has the final result already. So has every instance with
+   // ordered input: only sorts produce ordered rows, and they produce all of them in one instance
+   if (ordered || ((instanceCount == 1) && (!spilled))) {
+      produceResults(local, 0, local.groups.getSize());
+      return;
+   }
+
+   // Otherwise all instances spill their groups, then the partitions are merged in parallel
+   spill();
+   shared->instances[id] = this;
+   if (worker) worker->synchronize();
+   if (!id) shared->partitions.reset(spills.size(), instanceCount, 1);
+   if (worker) worker->synchronize();
+   Table merged(execution::getTypes(groupBy));
+   bool sortable = none_of(aggregates.begin(), aggregates.end(), [](const Aggregate& a) { return isDistinct(a.op); });
+   uint64_t begin, end;
+   while (shared->partitions.next(id, begin, end))
+      for (uint64_t partition = begin; partition != end; ++partition) {
+         // The hash table of a large partition would not fit into the cache, sorting handles the groups in small portions
+         uint64_t size = 0;
+         for (auto instance : shared->instances)
+            size += instance->spills[partition].groups->getSize();
+         if (sortable && (size > hashMergeGroups)) {
+            mergeSorted(partition, merged);
+            continue;
+         }
+         mergePartition(partition, merged);
+         produceResults(merged, 0, merged.groups.getSize());
+      }
+   if (!worker) spills.clear();
+}
+//---------------------------------------------------------------------------
+void HashAggregation::consume(const Batch& batch, unsigned)
+// Consume a batch of an input
+{
+   if (sortBased) {
+      spillInput(batch);
+      return;
+   }
+   if (groupBy.empty()) {
+      fill(rowGroups.begin(), rowGroups.begin() + batch.size, 0);
+   } else {
+      vector<const Vector*> keys;
+      for (auto& g : groupBy)
+         keys.push_back(&g->evaluate(batch));
+      // The groups of ordered input are complete once the next group starts, a full table is emitted then
+      if (ordered && (local.groups.getSize() >= orderedGroups) && batch.size && startsGroup(keys)) {
+         produceResults(local, 0, local.groups.getSize());
+         reset(local);
+      }
+      local.groups.insert(keys, batch.size, rowGroups.data());
+   }
+   for (unsigned index = 0; index != aggregates.size(); ++index)
+      update(aggregates[index], local.states[index], batch);
+   consumedRows += batch.size;
+   if ((!ordered) && (local.groups.getSize() >= preaggregationGroups)) {
+      // The pre-aggregation only pays off if it combines rows, otherwise the remaining input bypasses it
+      if (consumedRows < minReduction * local.groups.getSize()) sortBased = true;
+      spill();
+   }
+}
+//---------------------------------------------------------------------------
+bool HashAggregation::startsGroup(const vector<const Vector*>& keys) const
+// Does a batch of ordered input start a new group?
+{
+   auto& values = local.groups.getValues();
+   uint64_t last = values.getSize() - 1;
+   auto& chunk = *values.getChunks()[last / Batch::maxSize];
+   for (unsigned index = 0; index != keys.size(); ++index)
+      if (!equalValues(*keys[index], 0, chunk.columns[index], last % Batch::maxSize)) return true;
+   return false;
+}
+//---------------------------------------------------------------------------
+void HashAggregation::reset(Table& table)
+// Remove all groups of a table
+{
+   table.groups.clear();
+   table.states.clear();
+   table.states.resize(aggregates.size());
+   for (unsigned index = 0; index != aggregates.size(); ++index)
+      if (isDistinct(aggregates[index].op)) table.states[index].distinct = make_unique<GroupTable>(vector<ValueType>{ValueType(ValueType::Integer), aggregates[index].value->getType()});
+}
+//---------------------------------------------------------------------------
+void HashAggregation::resize(const Aggregate& aggregate, State& state, uint64_t groupCount)
+// Make room for the state of all groups
+{
+   if (state.counts.size() < groupCount) {
+      state.counts.resize(groupCount);
+      if ((aggregate.op == Op::Min) || (aggregate.op == Op::Max))
+         state.values.resize(groupCount);
+      else if (aggregate.op != Op::CountStar)
+         state.sums.resize(groupCount);
+   }
+}
+//---------------------------------------------------------------------------
+void HashAggregation::update(Aggregate& aggregate, State& state, const Batch& batch)
+// Update an aggregate
+{
+   resize(aggregate, state, local.groups.getSize());
+   unsigned count = batch.size;
+   auto g = rowGroups.data();
+   if (aggregate.op == Op::CountStar) {
+      for (unsigned index = 0; index != count; ++index)
+         ++state.counts[g[index]];
+      return;
+   }
+
+   // Determine the relevant rows. Aggregates ignore NULL values, distinct aggregates ignore duplicates
+   auto& values = aggregate.value->evaluate(batch);
+   auto nulls = values.getNulls();
+   const uint8_t* skip = nulls;
+   if (state.distinct) {
+      groupIds.allocate(count, false);
+      auto ids = groupIds.getData<int64_t>();
+      for (unsigned index = 0; index != count; ++index)
+         ids[index] = g[index];
+      state.distinct->insert({&groupIds, &values}, count, distinctEntries.data(), isNew.data());
+      for (unsigned index = 0; index != count; ++index)
+         isNew[index] = !(isNew[index] && !(nulls && nulls[index]));
+      skip = isNew.data();
+   }
+
+   ValueType type = aggregate.value->getType();
+   switch (aggregate.op) {
+      case Op::CountStar: break;
+      case Op::Count:
+      case Op::CountDistinct:
+         for (unsigned index = 0; index != count; ++index)
+            state.counts[g[index]] += !(skip && skip[index]);
+         break;
+      case Op::Sum:
+      case Op::SumDistinct:
+      case Op::Avg:
+      case Op::AvgDistinct:
+         dispatch(type.getPhysicalType(), [&]<class T>(T*) {
+            if constexpr (is_same_v<T, int64_t> || is_same_v<T, Int128>) {
+               auto v = values.getData<T>();
+               for (unsigned index = 0; index != count; ++index) {
+                  if (skip && skip[index]) continue;
+                  state.sums[g[index]] = values::checkedAdd<Int128>(state.sums[g[index]], v[index]);
+                  ++state.counts[g[index]];
+               }
+            }
+         });
+         break;
+      case Op::Min:
+      case Op::Max: {
+         bool isMin = aggregate.op == Op::Min;
+         for (unsigned index = 0; index != count; ++index) {
+            if (skip && skip[index]) continue;
+            auto& current = state.values[g[index]];
+            auto& c = state.counts[g[index]];
+            Value v = values.get(index);
+            if (c) {
+               int cmp = values::compare(type, v, current);
+               if (isMin ? (cmp >= 0) : (cmp <= 0)) continue;
+            }
+            if (type.getKind() == ValueType::String) v.str = state.strings.add(v.str);
+            current = v;
+            c = 1;
+         }
+         break;
+      }
+   }
+}
+//---------------------------------------------------------------------------
+void HashAggregation::scatter(const Batch& batch, const vector<const Vector*>& keys, optional<unsigned> distinct)
+// Append the rows of a batch to the partitions of their keys
+{
+   unsigned radixShift = 64 - countr_zero(spills.size());
+   auto& bounds = partitionBounds;
+   GroupTable::hashValues(keys, batch.size, hashes.data());
+   fill(bounds.begin(), bounds.end(), 0);
+   for (unsigned row = 0; row != batch.size; ++row)
+      ++bounds[(hashes[row] >> radixShift) + 1];
+   for (unsigned partition = 1; partition != bounds.size(); ++partition)
+      bounds[partition] += bounds[partition - 1];
+   for (unsigned row = 0; row != batch.size; ++row)
+      partitionOrder[bounds[hashes[row] >> radixShift]++] = row;
+   for (unsigned partition = 0, begin = 0; partition != spills.size(); ++partition) {
+      unsigned end = bounds[partition];
+      auto& target = distinct ? *spills[partition].distinct[*distinct] : *spills[partition].groups;
+      if (begin != end) target.append(batch, partitionOrder.data() + begin, end - begin);
+      begin = end;
+   }
+}
+//---------------------------------------------------------------------------
+void HashAggregation::spill()
+// Spill the pre-aggregated groups into the partitions
+{
+   auto& keys = local.groups.getValues();
+   unsigned keyCount = groupBy.size();
+
+   // Spill the groups with their partial states. Averages are spilled as sum and count
+   auto& batch = spillRows;
+   vector<const Vector*> keyValues(keyCount);
+   uint64_t first = 0;
+   for (auto& chunk : keys.getChunks()) {
+      unsigned count = chunk->size, column = keyCount;
+      for (unsigned index = 0; index != keyCount; ++index) {
+         batch.columns[index].reference(chunk->columns[index]);
+         keyValues[index] = &batch.columns[index];
+      }
+      for (unsigned index = 0; index != aggregates.size(); ++index) {
+         auto& a = aggregates[index];
+         auto& state = local.states[index];
+         if (isDistinct(a.op)) continue;
+         auto& counts = batch.columns[column++];
+         counts.allocate(count, false);
+         for (unsigned row = 0; row != count; ++row)
+            counts.getData<int64_t>()[row] = (first + row < state.counts.size()) ? state.counts[first + row] : 0;
+         if ((a.op == Op::Sum) || (a.op == Op::Avg)) {
+            auto& sums = batch.columns[column++];
+            sums.allocate(count, false);
+            for (unsigned row = 0; row != count; ++row)
+               sums.getData<Int128>()[row] = (first + row < state.sums.size()) ? state.sums[first + row] : 0;
+         } else if ((a.op == Op::Min) || (a.op == Op::Max)) {
+            auto& values = batch.columns[column++];
+            values.allocate(count, true);
+            for (unsigned row = 0; row != count; ++row)
+               values.set(row, ((first + row < state.counts.size()) && state.counts[first + row]) ? state.values[first + row] : Value::makeNull());
+         }
+      }
+      batch.size = count;
+      scatter(batch, keyValues, nullopt);
+      first += count;
+   }
+
+   // Spill the seen values of distinct aggregates together with their groups
+   for (unsigned index = 0; index != aggregates.size(); ++index) {
+      auto& state = local.states[index];
+      if (!state.distinct) continue;
+      Batch values;
+      values.columns.resize(keyCount + 1);
+      for (unsigned column = 0; column != keyCount; ++column)
+         values.columns[column].setType(keys.getTypes()[column]);
+      for (auto& chunk : state.distinct->getValues().getChunks()) {
+         auto ids = chunk->columns[0].getData<int64_t>();
+         vector<uint64_t> groups(ids, ids + chunk->size);
+         for (unsigned column = 0; column != keyCount; ++column) {
+            keys.gather(column, groups.data(), chunk->size, values.columns[column]);
+            keyValues[column] = &values.columns[column];
+         }
+         values.columns[keyCount].reference(chunk->columns[1]);
+         values.size = chunk->size;
+         scatter(values, keyValues, index);
+      }
+   }
+
+   reset(local);
+   spilled = true;
+   consumedRows = 0;
+}
+//---------------------------------------------------------------------------
+void HashAggregation::spillInput(const Batch& batch)
+// Spill input rows as groups of their own
+{
+   unsigned keyCount = groupBy.size(), count = batch.size, column = keyCount;
+   vector<const Vector*> keys(keyCount);
+   for (unsigned index = 0; index != keyCount; ++index) {
+      spillRows.columns[index].reference(groupBy[index]->evaluate(batch));
+      keys[index] = &spillRows.columns[index];
+   }
+
+   // Every row forms the partial state of its group
+   for (unsigned index = 0; index != aggregates.size(); ++index) {
+      auto& a = aggregates[index];
+      if (isDistinct(a.op)) continue;
+      auto& counts = spillRows.columns[column++];
+      counts.allocate(count, false);
+      auto c = counts.getData<int64_t>();
+      if (a.op == Op::CountStar) {
+         fill(c, c + count, 1);
+         continue;
+      }
+      auto& values = a.value->evaluate(batch);
+      for (unsigned row = 0; row != count; ++row)
+         c[row] = !values.isNull(row);
+      if ((a.op == Op::Sum) || (a.op == Op::Avg)) {
+         auto& sums = spillRows.columns[column++];
+         sums.allocate(count, false);
+         auto out = sums.getData<Int128>();
+         dispatch(a.value->getType().getPhysicalType(), [&]<class T>(T*) {
+            if constexpr (is_same_v<T, int64_t> || is_same_v<T, Int128>) {
+               auto v = values.getData<T>();
+               for (unsigned row = 0; row != count; ++row)
+                  out[row] = c[row] ? Int128(v[row]) : Int128(0);
+            }
+         });
+      } else if ((a.op == Op::Min) || (a.op == Op::Max)) {
+         auto& target = spillRows.columns[column++];
+         target.allocate(count, true);
+         target.copy(0, values, 0, count, nullptr);
+      }
+   }
+   spillRows.size = count;
+   scatter(spillRows, keys, nullopt);
+
+   // Distinct aggregates spill their values together with the keys
+   for (unsigned index = 0; index != aggregates.size(); ++index) {
+      if (!isDistinct(aggregates[index].op)) continue;
+      Batch values;
+      values.columns.resize(keyCount + 1);
+      for (unsigned column = 0; column != keyCount; ++column)
+         values.columns[column].reference(*keys[column]);
+      values.columns[keyCount].reference(aggregates[index].value->evaluate(batch));
+      values.size = count;
+      scatter(values, keys, index);
+   }
+}
+//---------------------------------------------------------------------------
+void HashAggregation::mergeGroups(Table& table, const Batch& groups)
+// Combine a batch of spilled groups with a table
+{
+   unsigned keyCount = groupBy.size(), count = groups.size, column = keyCount;
+   vector<const Vector*> keys(keyCount);
+   for (unsigned index = 0; index != keyCount; ++index)
+      keys[index] = &groups.columns[index];
+   table.groups.insert(keys, count, rowGroups.data());
+   for (unsigned index = 0; index != aggregates.size(); ++index) {
+      auto& a = aggregates[index];
+      auto& state = table.states[index];
+      if (isDistinct(a.op)) continue;
+      resize(a, state, table.groups.getSize());
+      auto counts = groups.columns[column++].getData<int64_t>();
+      if ((a.op == Op::CountStar) || (a.op == Op::Count)) {
+         for (unsigned row = 0; row != count; ++row)
+            state.counts[rowGroups[row]] += counts[row];
+      } else if ((a.op == Op::Sum) || (a.op == Op::Avg)) {
+         auto sums = groups.columns[column++].getData<Int128>();
+         for (unsigned row = 0; row != count; ++row) {
+            state.counts[rowGroups[row]] += counts[row];
+            state.sums[rowGroups[row]] = values::checkedAdd(state.sums[rowGroups[row]], sums[row]);
+         }
+      } else {
+         auto& values = groups.columns[column++];
+         ValueType type = a.value->getType();
+         for (unsigned row = 0; row != count; ++row) {
+            if (!counts[row]) continue;
+            auto& current = state.values[rowGroups[row]];
+            auto& c = state.counts[rowGroups[row]];
+            Value v = values.get(row);
+            if (c) {
+               int cmp = values::compare(type, v, current);
+               if ((a.op == Op::Min) ? (cmp >= 0) : (cmp <= 0)) continue;
+            }
+            if (type.getKind() == ValueType::String) v.str = state.strings.add(v.str);
+            current = v;
+            c = 1;
+         }
+      }
+   }
+}
+//---------------------------------------------------------------------------
+void HashAggregation::mergePartition(uint64_t partition, Table& table)
+// Merge the spilled groups of all instances within a partition
+{
+   reset(table);
+   unsigned keyCount = groupBy.size();
+   vector<const Vector*> keys(keyCount);
+   for (auto instance : shared->instances) {
+      auto& spill = instance->spills[partition];
+
+      // Combine the partial states
+      for (auto& chunk : spill.groups->getChunks())
+         mergeGroups(table, *chunk);
+
+      // Distinct aggregates add the values that are new for their group
+      for (unsigned index = 0; index != aggregates.size(); ++index) {
+         auto& a = aggregates[index];
+         auto& state = table.states[index];
+         if (!state.distinct) continue;
+         ValueType type = a.value->getType();
+         for (auto& chunk : spill.distinct[index]->getChunks()) {
+            unsigned count = chunk->size;
+            for (unsigned column = 0; column != keyCount; ++column)
+               keys[column] = &chunk->columns[column];
+            table.groups.insert(keys, count, rowGroups.data());
+            resize(a, state, table.groups.getSize());
+            auto& values = chunk->columns[keyCount];
+            groupIds.allocate(count, false);
+            auto ids = groupIds.getData<int64_t>();
+            for (unsigned row = 0; row != count; ++row)
+               ids[row] = rowGroups[row];
+            state.distinct->insert({&groupIds, &values}, count, distinctEntries.data(), isNew.data());
+            for (unsigned row = 0; row != count; ++row) {
+               if ((!isNew[row]) || values.isNull(row)) continue;
+               ++state.counts[ids[row]];
+               if (a.op == Op::CountDistinct) continue;
+               dispatch(type.getPhysicalType(), [&]<class T>(T*) {
+                  if constexpr (is_same_v<T, int64_t> || is_same_v<T, Int128>) state.sums[ids[row]] = values::checkedAdd<Int128>(state.sums[ids[row]], values.getData<T>()[row]);
+               });
+            }
+         }
+      }
+   }
+}
+//---------------------------------------------------------------------------
+void HashAggregation::mergeSorted(uint64_t partition, Table& table)
+// Merge and produce the spilled groups of all instances within a partition by sorting them
+{
+   Relation rows(spillTypes);
+   for (auto instance : shared->instances)
+      for (auto& chunk : instance->spills[partition].groups->getChunks())
+         rows.append(*chunk);
+
+   // Sort the rows by the hash of their keys, which makes the rows of a group adjacent
+   unsigned keyCount = groupBy.size();
+   vector<const Vector*> keys(keyCount);
+   vector<pair<uint64_t, uint64_t>> order;
+   order.reserve(rows.getSize());
+   for (auto& chunk : rows.getChunks()) {
+      for (unsigned index = 0; index != keyCount; ++index)
+         keys[index] = &chunk->columns[index];
+      GroupTable::hashValues(keys, chunk->size, hashes.data());
+      for (unsigned row = 0; row != chunk->size; ++row)
+         order.emplace_back(hashes[row], order.size());
+   }
+   sort(order.begin(), order.end());
+
+   // Merge the groups in sorted order. A full table is emitted when the hash changes, its groups are complete then
+   reset(table);
+   Batch batch(spillTypes);
+   vector<uint64_t> ids(Batch::maxSize);
+   for (uint64_t pos = 0; pos < order.size(); pos += Batch::maxSize) {
+      unsigned count = min<uint64_t>(order.size() - pos, Batch::maxSize);
+      if ((table.groups.getSize() >= preaggregationGroups) && (order[pos].first != order[pos - 1].first)) {
+         produceResults(table, 0, table.groups.getSize());
+         reset(table);
+      }
+      for (unsigned row = 0; row != count; ++row)
+         ids[row] = order[pos + row].second;
+      for (unsigned column = 0; column != spillTypes.size(); ++column)
+         rows.gather(column, ids.data(), count, batch.columns[column]);
+      batch.size = count;
+      mergeGroups(table, batch);
+   }
+   produceResults(table, 0, table.groups.getSize());
+}
+//---------------------------------------------------------------------------
+void HashAggregation::produceResults(const Table& table, uint64_t from, uint64_t to)
+// Produce the aggregation results of a range of groups
+{
+   auto& keys = table.groups.getValues();
+   unsigned keyCount = groupBy.size();
+   for (uint64_t begin = from; begin < to; begin += Batch::maxSize) {
+      unsigned count = min<uint64_t>(to - begin, Batch::maxSize);
+      auto& chunk = *keys.getChunks()[begin / Batch::maxSize];
+      for (unsigned index = 0; index != keyCount; ++index)
+         output.columns[index].reference(chunk.columns[index]);
+      for (unsigned index = 0; index != aggregates.size(); ++index) {
+         auto& a = aggregates[index];
+         auto& state = table.states[index];
+         auto& column = output.columns[keyCount + index];
+         column.allocate(count, true);
+         unsigned inputScale = a.value ? a.value->getType().getScale() : 0, resultScale = column.getType().getScale();
+         for (unsigned row = 0; row != count; ++row) {
+            uint64_t g = begin + row;
+            int64_t c = (g < state.counts.size()) ? state.counts[g] : 0;
+            switch (a.op) {
+               case Op::CountStar:
+               case Op::Count:
+               case Op::CountDistinct: column.set(row, Value::makeNumber(c)); break;
+               case Op::Sum:
+               case Op::SumDistinct: column.set(row, c ? makeSum(column.getType(), state.sums[g]) : Value::makeNull()); break;
+               case Op::Avg:
+               case Op::AvgDistinct: column.set(row, c ? Value::makeNumber(values::divideRounded(values::checkedMul(state.sums[g], values::pow10(resultScale - inputScale)), c)) : Value::makeNull()); break;
+               case Op::Min:
+               case Op::Max: column.set(row, c ? state.values[g] : Value::makeNull()); break;
+            }
+         }
+      }
+      output.size = count;
+      push(output);
+   }
+}
+//---------------------------------------------------------------------------
+/// The state shared by the instances of a parallel plan
+struct Sort::Shared : public SharedState {
+   /// The materialized inputs of the instances
+   vector<unique_ptr<Relation>> runs;
+
+   /// Constructor
+   explicit Shared(unsigned workerCount) : runs(workerCount) {}
+};
+//---------------------------------------------------------------------------
+Sort::Sort(unique_ptr<PhysicalOperator> input, vector<SortKey> order, optional<uint64_t> limit, optional<uint64_t> offset)
+   : PhysicalOperator(input->getTypes()), input(move(input)), order(move(order)), limit(limit), offset(offset), output(types)
+// Constructor
+{
+   attach(*this->input, 0);
+}
+//---------------------------------------------------------------------------
+Sort::~Sort()
+// Destructor
+{
+}
+//---------------------------------------------------------------------------
+void Sort::setWorker(Worker& worker)
+// Make the operator an instance of a parallel plan
+{
+   PhysicalOperator::setWorker(worker);
+   shared = &worker.registerState<Shared>(worker.getWorkerCount());
+}
+//---------------------------------------------------------------------------
+static vector<vector<Value>> extractKeys(const Relation& rows, unsigned first, unsigned count)
+// Extract the values of sort keys from a materialized relation
+{
+   vector<vector<Value>> result(count);
+   for (unsigned key = 0; key != count; ++key) {
+      result[key].resize(rows.getSize());
+      for (uint64_t row = 0; row != rows.getSize(); ++row)
+         result[key][row] = rows.get(first + key, row);
+   }
+   return result;
+}
+//---------------------------------------------------------------------------
+void Sort::produce()
+// Produce all result batches
+{
+   vector<ValueType> keyTypes;
+   for (auto& o : order)
+      keyTypes.push_back(o.value->getType());
+   rows = make_unique<Relation>(concat(makeNullable(types), makeNullable(keyTypes)));
+   input->produce();
+   if (shared) {
+      // The leader processes the rows of all instances and produces the whole result, which keeps the order intact
+      shared->runs[worker->getId()] = move(rows);
+      worker->synchronize();
+      if (!worker->isLeader()) return;
+      rows = make_unique<Relation>(shared->runs.front()->getTypes());
+      for (auto& run : shared->runs) {
+         for (auto& chunk : run->getChunks())
+            rows->append(*chunk);
+         run.reset();
+      }
+   }
+
+   // Sort the row ids, ties are broken by the input order
+   uint64_t size = rows->getSize();
+   unsigned width = types.size();
+   auto keys = extractKeys(*rows, width, order.size());
+   vector<uint64_t> ids(size);
+   iota(ids.begin(), ids.end(), 0);
+   auto less = [&](uint64_t a, uint64_t b) {
+      for (unsigned key = 0; key != order.size(); ++key) {
+         int c = compareWithNulls(keyTypes[key], keys[key][a], keys[key][b]);
+         if (c) return order[key].descending ? (c > 0) : (c < 0);
+      }
+      return a < b;
+   };
+   uint64_t begin = min(offset.value_or(0), size), end = limit ? min(size, begin + *limit) : size;
+   if (!order.empty()) {
+      if (end < size)
+         partial_sort(ids.begin(), ids.begin() + end, ids.end(), less);
+      else
+         sort(ids.begin(), ids.end(), less);
+   }
+
+   // Produce the result
+   for (uint64_t pos = begin; pos < end; pos += Batch::maxSize) {
+      unsigned count = min<uint64_t>(end - pos, Batch::maxSize);
+      for (unsigned index = 0; index != width; ++index)
+         rows->gather(index, ids.data() + pos, count, output.columns[index]);
+      output.size = count;
+      push(output);
+   }
+   rows.reset();
+}
+//---------------------------------------------------------------------------
+void Sort::consume(const Batch& batch, unsigned)
+// Consume a batch of an input
+{
+   Batch combined;
+   combined.columns.resize(batch.columns.size() + order.size());
+   for (unsigned index = 0; index != batch.columns.size(); ++index)
+      combined.columns[index].reference(batch.columns[index]);
+   for (unsigned index = 0; index != order.size(); ++index)
+      combined.columns[batch.columns.size() + index].reference(order[index].value->evaluate(batch));
+   combined.size = batch.size;
+   rows->append(combined);
+}
+//---------------------------------------------------------------------------
+static vector<ValueType> getWindowTypes(const PhysicalOperator& input, const vector<Window::Aggregate>& aggregates)
+// Get the result types of a window operator
+{
+   auto result = input.getTypes();
+   for (auto& a : aggregates)
+      result.push_back(Window::getResultType(a.op, a.value ? a.value->getType() : ValueType(), (a.parameters.size() > 1) ? a.parameters[1]->getType() : ValueType()));
+   return result;
+}
+//---------------------------------------------------------------------------
+/// The state shared by the instances of a parallel plan
+struct Window::Shared : public SharedState {
+   /// The materialized inputs of the instances
+   vector<unique_ptr<Relation>> runs;
+
+   /// Constructor
+   explicit Shared(unsigned workerCount) : runs(workerCount) {}
+};
+//---------------------------------------------------------------------------
+Window::Window(unique_ptr<PhysicalOperator> input, vector<unique_ptr<Evaluator>> partitionBy, vector<SortKey> orderBy, vector<Aggregate> aggregates)
+   : PhysicalOperator(getWindowTypes(*input, aggregates)), input(move(input)), partitionBy(move(partitionBy)), orderBy(move(orderBy)), aggregates(move(aggregates)), output(types)
+// Constructor
+{
+   attach(*this->input, 0);
+   inputWidth = this->input->getTypes().size();
+   unsigned column = inputWidth + this->partitionBy.size() + this->orderBy.size();
+   for (auto& a : this->aggregates) {
+      aggregateColumns.push_back(column);
+      column += (a.value ? 1 : 0) + a.parameters.size();
+   }
+}
+//---------------------------------------------------------------------------
+Window::~Window()
+// Destructor
+{
+}
+//---------------------------------------------------------------------------
+void Window::setWorker(Worker& worker)
+// Make the operator an instance of a parallel plan
+{
+   PhysicalOperator::setWorker(worker);
+   shared = &worker.registerState<Shared>(worker.getWorkerCount());
+}
+//---------------------------------------------------------------------------
+ValueType Window::getResultType(Op op, ValueType input, ValueType defaultValue)
+// Get the result type of a window aggregate
+{
+   switch (op) {
+      case Op::CountStar:
+      case Op::Count:
+      case Op::CountDistinct:
+      case Op::RowNumber:
+      case Op::Rank:
+      case Op::DenseRank: return ValueType(ValueType::Integer);
+      case Op::NTile: return ValueType(ValueType::Integer, 0, true);
+      case Op::Sum:
+      case Op::SumDistinct:
+      case Op::Avg:
+      case Op::AvgDistinct:
+      case Op::Min:
+      case Op::Max: return HashAggregation::getResultType(static_cast<HashAggregation::Op>(op), input);
+      case Op::Lead:
+      case Op::Lag: return ValueType::unify(input, defaultValue).withNullable(true);
+      case Op::FirstValue:
+      case Op::LastValue: return input.withNullable(true);
+   }
+   __builtin_unreachable();
+}
+//---------------------------------------------------------------------------
+void Window::consume(const Batch& batch, unsigned)
+// Consume a batch of an input
+{
+   Batch combined;
+   combined.columns.resize(rows->getTypes().size());
+   unsigned column = 0;
+   for (auto& c : batch.columns)
+      combined.columns[column++].reference(c);
+   for (auto& p : partitionBy)
+      combined.columns[column++].reference(p->evaluate(batch));
+   for (auto& o : orderBy)
+      combined.columns[column++].reference(o.value->evaluate(batch));
+   for (auto& a : aggregates) {
+      if (a.value) combined.columns[column++].reference(a.value->evaluate(batch));
+      for (auto& p : a.parameters)
+         combined.columns[column++].reference(p->evaluate(batch));
+   }
+   combined.size = batch.size;
+   rows->append(combined);
+}
+//---------------------------------------------------------------------------
+void Window::produce()
+// Produce all result batches
+{
+   vector<ValueType> materialized(types.begin(), types.begin() + inputWidth);
+   vector<ValueType> partitionTypes, orderTypes;
+   for (auto& p : partitionBy)
+      partitionTypes.push_back(p->getType());
+   for (auto& o : orderBy)
+      orderTypes.push_back(o.value->getType());
+   materialized = concat(concat(materialized, partitionTypes), orderTypes);
+   for (auto& a : aggregates) {
+      if (a.value) materialized.push_back(a.value->getType());
+      for (auto& p : a.parameters)
+         materialized.push_back(p->getType());
+   }
+   rows = make_unique<Relation>(makeNullable(materialized));
+   input->produce();
+   if (shared) {
+      // The leader processes the rows of all instances and produces the whole result, which keeps the order intact
+      shared->runs[worker->getId()] = move(rows);
+      worker->synchronize();
+      if (!worker->isLeader()) return;
+      rows = make_unique<Relation>(shared->runs.front()->getTypes());
+      for (auto& run : shared->runs) {
+         for (auto& chunk : run->getChunks())
+            rows->append(*chunk);
+         run.reset();
+      }
+   }
+
+   // Sort by partition and order
+   uint64_t size = rows->getSize();
+   auto partitionKeys = extractKeys(*rows, inputWidth, partitionBy.size());
+   auto orderKeys = extractKeys(*rows, inputWidth + partitionBy.size(), orderBy.size());
+   auto comparePartition = [&](uint64_t a, uint64_t b) {
+      for (unsigned key = 0; key != partitionKeys.size(); ++key)
+         if (int c = compareWithNulls(partitionTypes[key], partitionKeys[key][a], partitionKeys[key][b])) return c;
+      return 0;
+   };
+   auto compareOrder = [&](uint64_t a, uint64_t b) {
+      for (unsigned key = 0; key != orderKeys.size(); ++key)
+         if (int c = compareWithNulls(orderTypes[key], orderKeys[key][a], orderKeys[key][b])) return orderBy[key].descending ? -c : c;
+      return 0;
+   };
+   vector<uint64_t> ids(size);
+   iota(ids.begin(), ids.end(), 0);
+   sort(ids.begin(), ids.end(), [&](uint64_t a, uint64_t b) {
+      if (int c = comparePartition(a, b)) return c < 0;
+      if (int c = compareOrder(a, b)) return c < 0;
+      return a < b;
+   });
+
+   // Find the peer groups. Without order all rows of a partition are peers
+   vector<uint64_t> peerEnds(size);
+   for (uint64_t pos = size; pos > 0; --pos) {
+      uint64_t p = pos - 1;
+      bool samePeers = (pos < size) && (!comparePartition(ids[p], ids[pos])) && (!compareOrder(ids[p], ids[pos]));
+      peerEnds[p] = samePeers ? peerEnds[pos] : pos;
+   }
+
+   // Compute the aggregates per partition
+   vector<vector<Value>> results(aggregates.size(), vector<Value>(size));
+   for (uint64_t begin = 0; begin < size;) {
+      uint64_t end = begin + 1;
+      while ((end < size) && (!comparePartition(ids[begin], ids[end]))) ++end;
+      for (unsigned index = 0; index != aggregates.size(); ++index)
+         computePartition(index, ids, begin, end, peerEnds, results[index]);
+      begin = end;
+   }
+
+   // Produce the result
+   for (uint64_t pos = 0; pos < size; pos += Batch::maxSize) {
+      unsigned count = min<uint64_t>(size - pos, Batch::maxSize);
+      for (unsigned index = 0; index != inputWidth; ++index)
+         rows->gather(index, ids.data() + pos, count, output.columns[index]);
+      for (unsigned index = 0; index != aggregates.size(); ++index) {
+         auto& column = output.columns[inputWidth + index];
+         column.allocate(count, true);
+         for (unsigned row = 0; row != count; ++row)
+            column.set(row, results[index][pos + row]);
+      }
+      output.size = count;
+      push(output);
+   }
+   rows.reset();
+}
+//---------------------------------------------------------------------------
+void Window::computePartition(unsigned aggregate, const vector<uint64_t>& order, uint64_t begin, uint64_t end, const vector<uint64_t>& peerEnds, vector<Value>& results) const
+// Compute an aggregate for a partition
+{
+   auto& a = aggregates[aggregate];
+   unsigned column = aggregateColumns[aggregate];
+   ValueType type = a.value ? a.value->getType() : ValueType();
+   auto valueAt = [&](uint64_t pos) { return rows->get(column, order[pos]); };
+   switch (a.op) {
+      case Op::RowNumber:
+         for (uint64_t pos = begin; pos != end; ++pos)
+            results[pos] = Value::makeNumber(pos - begin + 1);
+         return;
+      case Op::Rank:
+      case Op::DenseRank: {
+         uint64_t rank = 0;
+         for (uint64_t pos = begin; pos != end; pos = peerEnds[pos]) {
+            rank = (a.op == Op::Rank) ? (pos - begin + 1) : (rank + 1);
+            for (uint64_t peer = pos; peer != peerEnds[pos]; ++peer)
+               results[peer] = Value::makeNumber(rank);
+         }
+         return;
+      }
+      case Op::NTile: {
+         // The first size % buckets buckets get one additional row
+         uint64_t size = end - begin;
+         for (uint64_t pos = begin; pos != end; ++pos) {
+            Value buckets = valueAt(pos);
+            if (buckets.null) {
+               results[pos] = buckets;
+               continue;
+            }
+            if (buckets.number <= 0) throw runtime_error("argument of ntile must be greater than zero");
+            uint64_t n = buckets.number, perBucket = size / n, larger = size % n, k = pos - begin;
+            uint64_t bucket = (k < larger * (perBucket + 1)) ? (k / (perBucket + 1)) : (larger + (k - larger * (perBucket + 1)) / perBucket);
+            results[pos] = Value::makeNumber(bucket + 1);
+         }
+         return;
+      }
+      case Op::Lead:
+      case Op::Lag:
+         for (uint64_t pos = begin; pos != end; ++pos) {
+            Value offset = rows->get(column + 1, order[pos]);
+            if (offset.null) {
+               results[pos] = offset;
+               continue;
+            }
+            Int128 target = static_cast<Int128>(pos) + ((a.op == Op::Lead) ? offset.number : -offset.number);
+            results[pos] = ((target >= static_cast<Int128>(begin)) && (target < static_cast<Int128>(end))) ? valueAt(static_cast<uint64_t>(target)) : rows->get(column + 2, order[pos]);
+         }
+         return;
+      case Op::FirstValue:
+         for (uint64_t pos = begin; pos != end; ++pos)
+            results[pos] = valueAt(begin);
+         return;
+      case Op::LastValue:
+         for (uint64_t pos = begin; pos != end; ++pos)
+            results[pos] = valueAt(peerEnds[pos] - 1);
+         return;
+      default: break;
+   }
+
+   // Aggregates over the rows up to the current peer group
+   bool distinct = (a.op == Op::CountDistinct) || (a.op == Op::SumDistinct) || (a.op == Op::AvgDistinct);
+   unordered_set<string> seen;
+   int64_t count = 0;
+   Int128 sum = 0;
+   Value best;
+   unsigned resultScale = getResultType(a.op, type, ValueType()).getScale();
+   for (uint64_t pos = begin; pos != end; pos = peerEnds[pos]) {
+      for (uint64_t peer = pos; peer != peerEnds[pos]; ++peer) {
+         if (a.op == Op::CountStar) {
+            ++count;
+            continue;
+         }
+         Value v = valueAt(peer);
+         if (v.null) continue;
+         if (distinct && (!seen.insert(values::format(type, v)).second)) continue;
+         if ((a.op == Op::Min) || (a.op == Op::Max)) {
+            int c = count ? values::compare(type, v, best) : 0;
+            if ((!count) || ((a.op == Op::Min) ? (c < 0) : (c > 0))) best = v;
+         }
+         sum = values::checkedAdd(sum, v.number);
+         ++count;
+      }
+      Value result;
+      switch (a.op) {
+         case Op::CountStar:
+         case Op::Count:
+         case Op::CountDistinct: result = Value::makeNumber(count); break;
+         case Op::Sum:
+         case Op::SumDistinct: result = count ? makeSum(type, sum) : Value::makeNull(); break;
+         case Op::Avg:
+         case Op::AvgDistinct: result = count ? Value::makeNumber(values::divideRounded(values::checkedMul(sum, values::pow10(resultScale - type.getScale())), count)) : Value::makeNull(); break;
+         case Op::Min:
+         case Op::Max: result = count ? best : Value::makeNull(); break;
+         default: break;
+      }
+      for (uint64_t peer = pos; peer != peerEnds[pos]; ++peer)
+         results[peer] = result;
+   }
+}
+//---------------------------------------------------------------------------
+/// The state shared by the instances of a parallel plan
+struct SetOperation::Shared : public SharedState {
+   /// The materialized inputs of the instances
+   vector<array<unique_ptr<Relation>, 2>> runs;
+
+   /// Constructor
+   explicit Shared(unsigned workerCount) : runs(workerCount) {}
+};
+//---------------------------------------------------------------------------
+SetOperation::SetOperation(unique_ptr<PhysicalOperator> left, unique_ptr<PhysicalOperator> right, vector<unique_ptr<Evaluator>> leftColumns, vector<unique_ptr<Evaluator>> rightColumns, Op op)
+   : PhysicalOperator(execution::getTypes(leftColumns)), left(move(left)), right(move(right)), leftColumns(move(leftColumns)), rightColumns(move(rightColumns)), op(op), seen(types), produced(types), entries(Batch::maxSize), producedEntries(Batch::maxSize), isNew(Batch::maxSize), selection(Batch::maxSize), values(types), output(types)
+// Constructor
+{
+   attach(*this->left, 0);
+   attach(*this->right, 1);
+}
+//---------------------------------------------------------------------------
+SetOperation::~SetOperation()
+// Destructor
+{
+}
+//---------------------------------------------------------------------------
+void SetOperation::setWorker(Worker& worker)
+// Make the operator an instance of a parallel plan
+{
+   PhysicalOperator::setWorker(worker);
+   shared = &worker.registerState<Shared>(worker.getWorkerCount());
+}
+//---------------------------------------------------------------------------
+void SetOperation::produce()
+// Produce all result batches
+{
+   seen.clear();
+   produced.clear();
+   counts.clear();
+   if ((!shared) || (op == Op::UnionAll)) {
+      right->produce();
+      left->produce();
+      return;
+   }
+
+   // Materialize the inputs, the leader then processes the inputs of all instances
+   inputs[0] = make_unique<Relation>(makeNullable(left->getTypes()));
+   inputs[1] = make_unique<Relation>(makeNullable(right->getTypes()));
+   right->produce();
+   left->produce();
+   auto& run = shared->runs[worker->getId()];
+   run[0] = move(inputs[0]);
+   run[1] = move(inputs[1]);
+   worker->synchronize();
+   if (!worker->isLeader()) return;
+   for (unsigned input : {1u, 0u})
+      for (auto& r : shared->runs) {
+         for (auto& chunk : r[input]->getChunks())
+            consume(*chunk, input);
+         r[input].reset();
+      }
+}
+//---------------------------------------------------------------------------
+void SetOperation::consume(const Batch& batch, unsigned input)
+// Consume a batch of an input
+{
+   if (inputs[input]) {
+      inputs[input]->append(batch);
+      return;
+   }
+   auto& columns = input ? rightColumns : leftColumns;
+   vector<const Vector*> keys;
+   for (unsigned index = 0; index != columns.size(); ++index) {
+      keys.push_back(&columns[index]->evaluate(batch));
+      values.columns[index].reference(*keys.back());
+   }
+   values.size = batch.size;
+   unsigned count = batch.size, selected = 0;
+   switch (op) {
+      case Op::UnionAll: push(values); return;
+      case Op::Union:
+         seen.insert(keys, count, entries.data(), isNew.data());
+         for (unsigned index = 0; index != count; ++index) {
+            selection[selected] = index;
+            selected += isNew[index];
+         }
+         break;
+      default:
+         // Remember the right side, then check the left side against it
+         if (input) {
+            seen.insert(keys, count, entries.data());
+            counts.resize(seen.getSize());
+            for (unsigned index = 0; index != count; ++index)
+               ++counts[entries[index]];
+            return;
+         }
+         seen.lookup(keys, count, entries.data());
+         if ((op == Op::Except) || (op == Op::Intersect)) produced.insert(keys, count, producedEntries.data(), isNew.data());
+         for (unsigned index = 0; index != count; ++index) {
+            bool found = entries[index] != GroupTable::notFound, keep;
+            switch (op) {
+               case Op::Except: keep = (!found) && isNew[index]; break;
+               case Op::Intersect: keep = found && isNew[index]; break;
+               case Op::ExceptAll: keep = !(found && (counts[entries[index]] > 0)); break;
+               default: keep = found && (counts[entries[index]] > 0); break;
+            }
+            if (found && (counts[entries[index]] > 0) && ((op == Op::ExceptAll) || (op == Op::IntersectAll))) --counts[entries[index]];
+            selection[selected] = index;
+            selected += keep;
+         }
+         break;
+   }
+   if (!selected) return;
+   if (selected == count) {
+      push(values);
+      return;
+   }
+   for (unsigned index = 0; index != values.columns.size(); ++index)
+      output.columns[index].gather(values.columns[index], selection.data(), selected);
+   output.size = selected;
+   push(output);
+}
+//---------------------------------------------------------------------------
+Collect::Collect(unique_ptr<PhysicalOperator> input)
+   : PhysicalOperator(input->getTypes()), input(move(input)), result(makeNullable(types))
+// Constructor
+{
+   attach(*this->input, 0);
+}
+//---------------------------------------------------------------------------
+void Collect::produce()
+// Produce all result batches
+{
+   result.clear();
+   input->produce();
+}
+//---------------------------------------------------------------------------
+void Collect::consume(const Batch& batch, unsigned)
+// Consume a batch of an input
+{
+   result.append(batch);
+}
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
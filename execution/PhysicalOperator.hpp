@@ -0,0 +1,615 @@
+#ifndef H_saneql_execution_PhysicalOperator
+#define H_saneql_execution_PhysicalOperator
+//---------------------------------------------------------------------------
+#include "algebra/Operator.hpp"
+#include "execution/Evaluator.hpp"
+#include "execution/Scheduler.hpp"
+#include "execution/Table.hpp"
+#include <memory>
+#include <optional>
+#include <vector>
+//---------------------------------------------------------------------------
+// SaneQL
+// (c) 2023 Thomas Neumann
+// SPDX-License-Identifier: BSD-3-Clause
+//---------------------------------------------------------------------------
+namespace saneql {
+//---------------------------------------------------------------------------
+namespace execution {
+//---------------------------------------------------------------------------
+/// Base class for physical operators. Execution is push based: produce() runs the
+/// operator, which passes its result batches to the consume() function of its parent.
+/// Operators reset their state in produce(), a plan can therefore be executed repeatedly.
+/// For parallel execution every worker runs its own instance of the plan, which is executed once
+class PhysicalOperator {
+   protected:
+   /// The parent
+   PhysicalOperator* parent = nullptr;
+   /// The input index within the parent
+   unsigned inputIndex = 0;
+   /// The result types
+   std::vector<ValueType> types;
+   /// The worker that runs this instance of a parallel plan (if any)
+   Worker* worker = nullptr;
+
+   /// Pass a batch to the parent
+   void push(const Batch& batch) { parent->consume(batch, inputIndex); }
+   /// Make an operator an input of this operator
+   void attach(PhysicalOperator& input, unsigned index) {
+      input.parent = this;
+      input.inputIndex = index;
+   }
+
+   public:
+   /// Constructor
+   explicit PhysicalOperator(std::vector<ValueType> types) : types(std::move(types)) {}
+   /// Destructor
+   virtual ~PhysicalOperator();
+
+   /// Get the result types
+   const std::vector<ValueType>& getTypes() const { return types; }
+   /// Make the operator an instance of a parallel plan. Called bottom-up in the same order for all instances
+   virtual void setWorker(Worker& worker) { this->worker = &worker; }
+
+   /// Produce all result batches
+   virtual void produce() = 0;
+   /// Consume a batch of an input
+   virtual void consume(const Batch& batch, unsigned input);
+};
+//---------------------------------------------------------------------------
+/// A hash table of distinct value combinations. NULL values are considered equal
+class GroupTable {
+   /// The distinct values
+   Relation values;
+   /// The hash values
+   std::vector<uint64_t> hashes;
+   /// The collision chains
+   std::vector<uint64_t> next;
+   /// The hash directory
+   std::vector<uint64_t> directory;
+   /// The row buffer for inserts
+   Batch row;
+
+   /// Find an entry. Returns the entry or ~0
+   uint64_t find(const std::vector<const Vector*>& keys, unsigned index, uint64_t hash) const;
+
+   public:
+   /// Marker for missing entries
+   static constexpr uint64_t notFound = ~0ull;
+
+   /// Constructor
+   explicit GroupTable(std::vector<ValueType> types);
+
+   /// Remove all entries
+   void clear();
+   /// Get the number of entries
+   uint64_t getSize() const { return values.getSize(); }
+   /// Get the distinct values
+   const Relation& getValues() const { return values; }
+
+   /// Find the entries of a batch of values, inserting missing entries. Optionally marks rows that created a new entry
+   void insert(const std::vector<const Vector*>& keys, unsigned count, uint64_t* entries, uint8_t* isNew = nullptr);
+   /// Find the entries of a batch of values. Missing entries are reported as notFound
+   void lookup(const std::vector<const Vector*>& keys, unsigned count, uint64_t* entries) const;
+
+   /// Compute the hash values of a batch of values
+   static void hashValues(const std::vector<const Vector*>& keys, unsigned count, uint64_t* hashes);
+};
+//---------------------------------------------------------------------------
+/// A scan over a materialized relation
+class Scan : public PhysicalOperator {
+   /// The relation
+   const Relation& relation;
+   /// The produced columns
+   std::vector<unsigned> columns;
+   /// The relation if owned by the scan
+   std::unique_ptr<Relation> ownedRelation;
+   /// The morsels of chunks (parallel execution only)
+   MorselQueue* morsels = nullptr;
+   /// The output
+   Batch output;
+
+   public:
+   /// Constructor
+   Scan(const Relation& relation, std::vector<unsigned> columns);
+   /// Constructor for an owned relation
+   Scan(std::unique_ptr<Relation> relation, std::vector<unsigned> columns);
+
+   /// Make the operator an instance of a parallel plan
+   void setWorker(Worker& worker) override;
+
+   /// Produce all result batches
+   void produce() override;
+};
+//---------------------------------------------------------------------------
+/// A scan over a stored table
+class TableScan : public PhysicalOperator {
+   /// The table
+   const Table& table;
+   /// The produced columns
+   std::vector<unsigned> columns;
+   /// The morsels of rows (parallel execution only)
+   MorselQueue* morsels = nullptr;
+   /// The output
+   Batch output;
+
+   public:
+   /// Constructor
+   TableScan(const Table& table, std::vector<unsigned> columns);
+
+   /// Make the operator an instance of a parallel plan
+   void setWorker(Worker& worker) override;
+
+   /// Produce all result batches
+   void produce() override;
+};
+//---------------------------------------------------------------------------
+/// A filter
+class Filter : public PhysicalOperator {
+   /// The input
+   std::unique_ptr<PhysicalOperator> input;
+   /// The condition
+   std::unique_ptr<Evaluator> condition;
+   /// The selected rows
+   std::vector<uint32_t> selection;
+   /// The output
+   Batch output;
+
+   public:
+   /// Constructor
+   Filter(std::unique_ptr<PhysicalOperator> input, std::unique_ptr<Evaluator> condition);
+
+   /// Produce all result batches
+   void produce() override;
+   /// Consume a batch of an input
+   void consume(const Batch& batch, unsigned input) override;
+};
+//---------------------------------------------------------------------------
+/// Computation of additional columns
+class Map : public PhysicalOperator {
+   /// The input
+   std::unique_ptr<PhysicalOperator> input;
+   /// The computations
+   std::vector<std::unique_ptr<Evaluator>> computations;
+   /// The output
+   Batch output;
+
+   public:
+   /// Constructor
+   Map(std::unique_ptr<PhysicalOperator> input, std::vector<std::unique_ptr<Evaluator>> computations);
+
+   /// Produce all result batches
+   void produce() override;
+   /// Consume a batch of an input
+   void consume(const Batch& batch, unsigned input) override;
+};
+//---------------------------------------------------------------------------
+/// A hash join. Equi-join keys are used for the hash table, the residual condition is evaluated
+/// on candidate pairs, which consist of the left columns followed by the right columns. All join
+/// types are supported with either side as build side. Large build sides are radix partitioned
+/// by their hash values, such that the hash table of each partition fits into the cache
+class HashJoin : public PhysicalOperator {
+   public:
+   using JoinType = algebra::Join::JoinType;
+
+   private:
+   /// A build row within the hash table
+   struct Entry {
+      /// The hash value
+      uint64_t hash;
+      /// The row. Chunk number times the batch size plus the position within the chunk
+      uint64_t row;
+   };
+   /// The partitioned hash table over the build sides of all instances
+   struct HashTable {
+      /// The column types of the build side, followed by the keys
+      std::vector<ValueType> types;
+      /// The chunks of the build sides
+      std::vector<const Batch*> chunks;
+      /// The number of radix bits. 0 for a single partition
+      unsigned radixBits = 0;
+      /// The entries, grouped by partition
+      std::vector<Entry> entries;
+      /// The first entry of each partition, followed by the number of entries
+      std::vector<uint64_t> partitionBegin;
+      /// The first directory slot of each partition, followed by the number of slots
+      std::vector<uint64_t> directoryBegin;
+      /// The hash directories of all partitions
+      std::vector<uint64_t> directory;
+      /// The collision chains
+      std::vector<uint64_t> next;
+      /// Entries with a join partner
+      std::vector<uint8_t> matched;
+
+      /// Get the partition of a hash value
+      uint64_t getPartition(uint64_t hash) const { return radixBits ? (hash >> (64 - radixBits)) : 0; }
+      /// Get the directory slot of a hash value
+      uint64_t getSlot(uint64_t hash) const {
+         auto partition = getPartition(hash);
+         return directoryBegin[partition] + (hash & (directoryBegin[partition + 1] - directoryBegin[partition] - 1));
+      }
+      /// Get the chunk that contains a row
+      const Batch& getChunk(uint64_t row) const { return *chunks[row / Batch::maxSize]; }
+   };
+   /// The state shared by the instances of a parallel plan
+   struct Shared;
+
+   /// The inputs
+   std::unique_ptr<PhysicalOperator> left, right;
+   /// The keys
+   std::vector<std::unique_ptr<Evaluator>> leftKeys, rightKeys;
+   /// The residual condition (if any)
+   std::unique_ptr<Evaluator> residual;
+   /// The join type
+   JoinType joinType;
+   /// Build the hash table on the left side?
+   bool buildLeft;
+   /// The input widths
+   unsigned leftWidth, rightWidth;
+
+   /// The materialized build side of this instance, followed by the keys
+   std::unique_ptr<Relation> build;
+   /// The hash values of the build side
+   std::vector<uint64_t> buildHashes;
+   /// The shared state. A serial plan owns a state for one instance
+   Shared* shared = nullptr;
+   /// The state of a serial plan
+   std::unique_ptr<Shared> ownedShared;
+   /// Probe rows of the current batch with a join partner
+   std::vector<uint8_t> probeMatched;
+   /// The directory slots and then the chains of the current probe batch
+   std::vector<uint64_t> probeChains;
+   /// The candidate pairs
+   std::vector<uint32_t> pairProbe;
+   /// The candidate pairs
+   std::vector<uint64_t> pairBuild;
+   /// The probe hashes
+   std::vector<uint64_t> probeHashes;
+   /// The selected rows
+   std::vector<uint32_t> selection;
+   /// Buffers for results
+   Batch pairs, output;
+
+   /// Is the build side an input index?
+   bool isBuild(unsigned input) const { return (input == 0) == buildLeft; }
+   /// Does the join produce the pairs?
+   bool producesPairs() const { return joinType <= JoinType::FullOuter; }
+   /// Does the join produce the unmatched rows of a side?
+   bool keepsUnmatched(bool leftSide) const;
+   /// Does the join produce the matched rows of a side only?
+   bool keepsMatched(bool leftSide) const;
+
+   /// Add a build batch
+   void addBuild(const Batch& batch);
+   /// Build the hash table over the build sides of all instances
+   void finishBuild();
+   /// Build the directory of a partition
+   void buildPartition(uint64_t partition);
+   /// Copy the values of a build column for a list of entries into a vector
+   void gatherBuild(unsigned column, const uint64_t* entries, unsigned count, Vector& target) const;
+   /// Produce the build rows that depend on the matches within a range of entries
+   void produceBuildRows(uint64_t begin, uint64_t end);
+   /// Probe a batch
+   void probe(const Batch& batch);
+   /// Process candidate pairs
+   void processPairs(const Batch& batch);
+   /// Produce rows of one side, padded with NULL values if needed. Build rows are given as hash table entries
+   void produceSide(const Batch* probeBatch, const std::vector<uint64_t>& rows);
+
+   public:
+   /// Constructor
+   HashJoin(std::unique_ptr<PhysicalOperator> left, std::unique_ptr<PhysicalOperator> right, JoinType joinType, std::vector<std::unique_ptr<Evaluator>> leftKeys, std::vector<std::unique_ptr<Evaluator>> rightKeys, std::unique_ptr<Evaluator> residual, bool buildLeft);
+   /// Destructor
+   ~HashJoin();
+
+   /// Make the operator an instance of a parallel plan
+   void setWorker(Worker& worker) override;
+
+   /// Produce all result batches
+   void produce() override;
+   /// Consume a batch of an input
+   void consume(const Batch& batch, unsigned input) override;
+};
+//---------------------------------------------------------------------------
+/// A hash based aggregation in two phases. Every instance pre-aggregates into a table of fixed
+/// capacity, which spills its groups into hash partitions when it is full. The partitions of all
+/// instances are then merged in parallel, partition by partition. The aggregation adapts to its
+/// input: ordered input is aggregated one group after the other, input that the pre-aggregation
+/// hardly reduces bypasses it, and large partitions are aggregated by sorting
+class HashAggregation : public PhysicalOperator {
+   public:
+   using Op = algebra::AggregationLike::Op;
+   /// An aggregate
+   struct Aggregate {
+      /// The operation
+      Op op;
+      /// The input (if any)
+      std::unique_ptr<Evaluator> value;
+   };
+
+   private:
+   /// The state of an aggregate
+   struct State {
+      /// The counts
+      std::vector<int64_t> counts;
+      /// The sums
+      std::vector<Int128> sums;
+      /// The minimum or maximum
+      std::vector<Value> values;
+      /// The strings of min and max
+      StringHeap strings;
+      /// The seen values of distinct aggregates, a hash set per group
+      std::unique_ptr<GroupTable> distinct;
+   };
+   /// Groups together with their aggregation states
+   struct Table {
+      /// The groups
+      GroupTable groups;
+      /// The aggregation states
+      std::vector<State> states;
+
+      /// Constructor
+      explicit Table(std::vector<ValueType> keyTypes) : groups(std::move(keyTypes)) {}
+   };
+   /// The groups that an instance spilled into a partition
+   struct Spill {
+      /// The groups, followed by their partial aggregation states
+      std::unique_ptr<Relation> groups;
+      /// The groups, followed by a seen value of a distinct aggregate. One relation per aggregate
+      std::vector<std::unique_ptr<Relation>> distinct;
+   };
+   /// The state shared by the instances of a parallel plan
+   struct Shared;
+
+   /// The input
+   std::unique_ptr<PhysicalOperator> input;
+   /// The group by expressions
+   std::vector<std::unique_ptr<Evaluator>> groupBy;
+   /// The aggregates
+   std::vector<Aggregate> aggregates;
+   /// Is the input ordered on the group keys? Then every group is complete once the next one starts
+   bool ordered;
+   /// The column types of spilled groups
+   std::vector<ValueType> spillTypes;
+   /// The pre-aggregation table
+   Table local;
+   /// The spilled groups of each partition
+   std::vector<Spill> spills;
+   /// Did the pre-aggregation table overflow?
+   bool spilled = false;
+   /// Did the pre-aggregation reduce its input too little? Then the input rows are spilled directly and large partitions are aggregated by sorting
+   bool sortBased = false;
+   /// The number of input rows since the last spill
+   uint64_t consumedRows = 0;
+   /// The group of each row
+   std::vector<uint64_t> rowGroups;
+   /// Buffers for partitioning
+   std::vector<uint64_t> hashes;
+   std::vector<uint32_t> partitionOrder;
+   std::vector<unsigned> partitionBounds;
+   /// The rows to spill
+   Batch spillRows;
+   /// Buffers for distinct aggregates
+   std::vector<uint64_t> distinctEntries;
+   std::vector<uint8_t> isNew;
+   /// The group ids as vector
+   Vector groupIds;
+   /// The shared state. A serial plan owns a state for one instance
+   Shared* shared = nullptr;
+   /// The state of a serial plan
+   std::unique_ptr<Shared> ownedShared;
+   /// The output
+   Batch output;
+
+   /// Remove all groups of a table
+   void reset(Table& table);
+   /// Make room for the state of all groups
+   void resize(const Aggregate& aggregate, State& state, uint64_t groupCount);
+   /// Update an aggregate
+   void update(Aggregate& aggregate, State& state, const Batch& batch);
+   /// Does a batch of ordered input start a new group?
+   bool startsGroup(const std::vector<const Vector*>& keys) const;
+   /// Append the rows of a batch to the partitions of their keys. Into the spilled groups or into the values of a distinct aggregate
+   void scatter(const Batch& batch, const std::vector<const Vector*>& keys, std::optional<unsigned> distinct);
+   /// Spill the pre-aggregated groups into the partitions
+   void spill();
+   /// Spill input rows as groups of their own, bypassing the pre-aggregation
+   void spillInput(const Batch& batch);
+   /// Combine a batch of spilled groups with a table
+   void mergeGroups(Table& table, const Batch& groups);
+   /// Merge the spilled groups of all instances within a partition
+   void mergePartition(uint64_t partition, Table& table);
+   /// Merge and produce the spilled groups of all instances within a partition by sorting them
+   void mergeSorted(uint64_t partition, Table& table);
+   /// Produce the aggregation results of a range of groups
+   void produceResults(const Table& table, uint64_t from, uint64_t to);
+
+   public:
+   /// Constructor
+   HashAggregation(std::unique_ptr<PhysicalOperator> input, std::vector<std::unique_ptr<Evaluator>> groupBy, std::vector<Aggregate> aggregates, bool ordered = false);
+   /// Destructor
+   ~HashAggregation();
+
+   /// Get the result type of an aggregate
+   static ValueType getResultType(Op op, ValueType input);
+
+   /// Make the operator an instance of a parallel plan
+   void setWorker(Worker& worker) override;
+
+   /// Produce all result batches
+   void produce() override;
+   /// Consume a batch of an input
+   void consume(const Batch& batch, unsigned input) override;
+};
+//---------------------------------------------------------------------------
+/// A sort key
+struct SortKey {
+   /// The value
+   std::unique_ptr<Evaluator> value;
+   /// Descending?
+   bool descending;
+};
+//---------------------------------------------------------------------------
+/// A sort with optional limit and offset. NULL values are sorted last in ascending order
+class Sort : public PhysicalOperator {
+   /// The state shared by the instances of a parallel plan
+   struct Shared;
+
+   /// The input
+   std::unique_ptr<PhysicalOperator> input;
+   /// The order
+   std::vector<SortKey> order;
+   /// The limit and offset
+   std::optional<uint64_t> limit, offset;
+   /// The materialized input, followed by the sort keys
+   std::unique_ptr<Relation> rows;
+   /// The shared state (parallel execution only)
+   Shared* shared = nullptr;
+   /// The output
+   Batch output;
+
+   public:
+   /// Constructor
+   Sort(std::unique_ptr<PhysicalOperator> input, std::vector<SortKey> order, std::optional<uint64_t> limit, std::optional<uint64_t> offset);
+   /// Destructor
+   ~Sort();
+
+   /// Make the operator an instance of a parallel plan
+   void setWorker(Worker& worker) override;
+
+   /// Produce all result batches
+   void produce() override;
+   /// Consume a batch of an input
+   void consume(const Batch& batch, unsigned input) override;
+};
+//---------------------------------------------------------------------------
+/// A window computation. Aggregates are computed over the rows up to the last peer of the
+/// current row if there is an order, and over the whole partition otherwise
+class Window : public PhysicalOperator {
+   public:
+   using Op = algebra::AggregationLike::WindowOp;
+   /// A window aggregate
+   struct Aggregate {
+      /// The operation
+      Op op;
+      /// The input (if any)
+      std::unique_ptr<Evaluator> value;
+      /// The parameters
+      std::vector<std::unique_ptr<Evaluator>> parameters;
+   };
+
+   private:
+   /// The state shared by the instances of a parallel plan
+   struct Shared;
+
+   /// The input
+   std::unique_ptr<PhysicalOperator> input;
+   /// The partition by expressions
+   std::vector<std::unique_ptr<Evaluator>> partitionBy;
+   /// The order
+   std::vector<SortKey> orderBy;
+   /// The aggregates
+   std::vector<Aggregate> aggregates;
+   /// The materialized input, followed by the partition keys, the order keys, and the aggregate inputs
+   std::unique_ptr<Relation> rows;
+   /// The input width
+   unsigned inputWidth;
+   /// The first materialized column of each aggregate
+   std::vector<unsigned> aggregateColumns;
+   /// The shared state (parallel execution only)
+   Shared* shared = nullptr;
+   /// The output
+   Batch output;
+
+   /// Compute an aggregate for a partition
+   void computePartition(unsigned aggregate, const std::vector<uint64_t>& order, uint64_t begin, uint64_t end, const std::vector<uint64_t>& peerEnds, std::vector<Value>& results) const;
+
+   public:
+   /// Constructor
+   Window(std::unique_ptr<PhysicalOperator> input, std::vector<std::unique_ptr<Evaluator>> partitionBy, std::vector<SortKey> orderBy, std::vector<Aggregate> aggregates);
+   /// Destructor
+   ~Window();
+
+   /// Get the result type of a window aggregate
+   static ValueType getResultType(Op op, ValueType input, ValueType defaultValue);
+
+   /// Make the operator an instance of a parallel plan
+   void setWorker(Worker& worker) override;
+
+   /// Produce all result batches
+   void produce() override;
+   /// Consume a batch of an input
+   void consume(const Batch& batch, unsigned input) override;
+};
+//---------------------------------------------------------------------------
+/// A set operation. The columns of both sides must have the same types
+class SetOperation : public PhysicalOperator {
+   public:
+   using Op = algebra::SetOperation::Op;
+
+   private:
+   /// The state shared by the instances of a parallel plan
+   struct Shared;
+
+   /// The inputs
+   std::unique_ptr<PhysicalOperator> left, right;
+   /// The input columns
+   std::vector<std::unique_ptr<Evaluator>> leftColumns, rightColumns;
+   /// The operation
+   Op op;
+   /// The values of the right side
+   GroupTable seen;
+   /// The produced values
+   GroupTable produced;
+   /// The counts of the right side
+   std::vector<int64_t> counts;
+   /// Buffers
+   std::vector<uint64_t> entries, producedEntries;
+   std::vector<uint8_t> isNew;
+   std::vector<uint32_t> selection;
+   /// The materialized inputs of this instance (parallel execution only)
+   std::unique_ptr<Relation> inputs[2];
+   /// The shared state (parallel execution only)
+   Shared* shared = nullptr;
+   /// The output
+   Batch values, output;
+
+   public:
+   /// Constructor
+   SetOperation(std::unique_ptr<PhysicalOperator> left, std::unique_ptr<PhysicalOperator> right, std::vector<std::unique_ptr<Evaluator>> leftColumns, std::vector<std::unique_ptr<Evaluator>> rightColumns, Op op);
+   /// Destructor
+   ~SetOperation();
+
+   /// Make the operator an instance of a parallel plan
+   void setWorker(Worker& worker) override;
+
+   /// Produce all result batches
+   void produce() override;
+   /// Consume a batch of an input
+   void consume(const Batch& batch, unsigned input) override;
+};
+//---------------------------------------------------------------------------
+/// A sink that materializes the result of a plan
+class Collect : public PhysicalOperator {
+   /// The input
+   std::unique_ptr<PhysicalOperator> input;
+   /// The result
+   Relation result;
+
+   public:
+   /// Constructor
+   explicit Collect(std::unique_ptr<PhysicalOperator> input);
+
+   /// Access the result
+   Relation& accessResult() { return result; }
+
+   /// Produce all result batches
+   void produce() override;
+   /// Consume a batch of an input
+   void consume(const Batch& batch, unsigned input) override;
+};
+//---------------------------------------------------------------------------
+}
+}
+//---------------------------------------------------------------------------
+#endif
@@ -0,0 +1,118 @@
+#include "execution/Scheduler.hpp"
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+//---------------------------------------------------------------------------
+// (c) 2023 Thomas Neumann
+//---------------------------------------------------------------------------
+using namespace std;
+//---------------------------------------------------------------------------
+namespace saneql::execution {
+//---------------------------------------------------------------------------
+SharedState::~SharedState()
+// Destructor
+{
+}
+//---------------------------------------------------------------------------
+void MorselQueue::reset(uint64_t size, unsigned workerCount, uint64_t morselSize)
+// Distribute a new range
+{
+   if (partCount != workerCount) {
+      parts = make_unique<Part[]>(workerCount);
+      partCount = workerCount;
+   }
+   this->morselSize = max<uint64_t>(morselSize, 1);
+
+   // Split the range into contiguous parts that consist of whole morsels
+   uint64_t morsels = (size + this->morselSize - 1) / this->morselSize;
+   for (unsigned index = 0; index != workerCount; ++index) {
+      uint64_t begin = min(size, morsels * index / workerCount * this->morselSize), end = min(size, morsels * (index + 1) / workerCount * this->morselSize);
+      parts[index].next.store(begin, memory_order_relaxed);
+      parts[index].end = end;
+   }
+}
+//---------------------------------------------------------------------------
+bool MorselQueue::next(unsigned worker, uint64_t& begin, uint64_t& end)
+// Get the next morsel of a worker
+{
+   // Take from the own part first, then steal from the others
+   for (unsigned offset = 0; offset != partCount; ++offset) {
+      auto& part = parts[(worker + offset) % partCount];
+      if (part.next.load(memory_order_relaxed) >= part.end) continue;
+      uint64_t pos = part.next.fetch_add(morselSize, memory_order_relaxed);
+      if (pos >= part.end) continue;
+      begin = pos;
+      end = min(pos + morselSize, part.end);
+      return true;
+   }
+   return false;
+}
+//---------------------------------------------------------------------------
+Scheduler::Scheduler(unsigned threadCount)
+   : threadCount(threadCount ? threadCount : max(thread::hardware_concurrency(), 1u))
+// Constructor
+{
+}
+//---------------------------------------------------------------------------
+Scheduler::~Scheduler()
+// Destructor
+{
+}
+//---------------------------------------------------------------------------
+void Scheduler::synchronize()
+// Wait until all workers arrived
+{
+   unique_lock lock(mutex);
+   if (aborted) throw runtime_error("query aborted");
+   if (++waiting == threadCount) {
+      waiting = 0;
+      ++generation;
+      condition.notify_all();
+      return;
+   }
+   uint64_t current = generation;
+   condition.wait(lock, [&]() { return (generation != current) || aborted; });
+   if (generation == current) throw runtime_error("query aborted");
+}
+//---------------------------------------------------------------------------
+void Scheduler::abort()
+// Release all waiting workers after a failure
+{
+   lock_guard lock(mutex);
+   aborted = true;
+   condition.notify_all();
+}
+//---------------------------------------------------------------------------
+void Scheduler::run(const function<void(unsigned worker)>& task)
+// Run a task on all workers and wait for completion
+{
+   // The first failure is the original one, the others are caused by the abort
+   exception_ptr failure;
+   std::mutex failureMutex;
+   auto worker = [&](unsigned id) {
+      try {
+         task(id);
+      } catch (...) {
+         {
+            lock_guard lock(failureMutex);
+            if (!failure) failure = current_exception();
+         }
+         abort();
+      }
+   };
+   if (threadCount == 1) {
+      worker(0);
+   } else {
+      vector<thread> threads;
+      for (unsigned index = 1; index != threadCount; ++index)
+         threads.emplace_back(worker, index);
+      worker(0);
+      for (auto& t : threads)
+         t.join();
+   }
+   if (failure) rethrow_exception(failure);
+}
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
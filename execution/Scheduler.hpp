@@ -0,0 +1,131 @@
+#ifndef H_saneql_execution_Scheduler
+#define H_saneql_execution_Scheduler
+//---------------------------------------------------------------------------
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+//---------------------------------------------------------------------------
+// SaneQL
+// (c) 2023 Thomas Neumann
+// SPDX-License-Identifier: BSD-3-Clause
+//---------------------------------------------------------------------------
+namespace saneql {
+//---------------------------------------------------------------------------
+namespace execution {
+//---------------------------------------------------------------------------
+/// Operator state that is shared by the instances of a parallel plan
+class SharedState {
+   public:
+   /// Destructor
+   virtual ~SharedState();
+};
+//---------------------------------------------------------------------------
+/// Hands out morsels of a range of work units to workers. Every worker starts with its own
+/// contiguous part of the range and steals morsels from the other parts when it runs out
+class MorselQueue : public SharedState {
+   /// The part of a worker
+   struct alignas(64) Part {
+      /// The next unit
+      std::atomic<uint64_t> next;
+      /// The end of the part
+      uint64_t end;
+   };
+
+   /// The parts
+   std::unique_ptr<Part[]> parts;
+   /// The number of parts
+   unsigned partCount = 0;
+   /// The morsel size
+   uint64_t morselSize = 1;
+
+   public:
+   /// Constructor
+   MorselQueue() = default;
+   /// Constructor
+   MorselQueue(uint64_t size, unsigned workerCount, uint64_t morselSize) { reset(size, workerCount, morselSize); }
+
+   /// Distribute a new range. Must not be called while workers take morsels
+   void reset(uint64_t size, unsigned workerCount, uint64_t morselSize);
+   /// Get the next morsel of a worker. Returns false if the range is exhausted
+   bool next(unsigned worker, uint64_t& begin, uint64_t& end);
+};
+//---------------------------------------------------------------------------
+class Worker;
+//---------------------------------------------------------------------------
+/// Executes a plan with several worker threads. Every worker runs its own instance of the
+/// physical plan, the instances share their operator state through the scheduler: sources
+/// hand out morsels of their input, and pipeline breakers merge the state of all instances
+/// once their input is exhausted
+class Scheduler {
+   /// The number of worker threads
+   unsigned threadCount;
+   /// The shared operator states in registration order
+   std::vector<std::unique_ptr<SharedState>> states;
+   /// The barrier
+   std::mutex mutex;
+   std::condition_variable condition;
+   /// The number of workers waiting at the barrier
+   unsigned waiting = 0;
+   /// The barrier generation
+   uint64_t generation = 0;
+   /// Did a worker fail?
+   bool aborted = false;
+
+   friend class Worker;
+
+   /// Wait until all workers arrived
+   void synchronize();
+   /// Release all waiting workers after a failure
+   void abort();
+
+   public:
+   /// Constructor. A thread count of 0 uses all available cores
+   explicit Scheduler(unsigned threadCount = 0);
+   /// Destructor
+   ~Scheduler();
+
+   /// Get the number of worker threads
+   unsigned getThreadCount() const { return threadCount; }
+   /// Run a task on all workers and wait for completion. Rethrows the first failure
+   void run(const std::function<void(unsigned worker)>& task);
+};
+//---------------------------------------------------------------------------
+/// The view of one worker on a scheduler, used by the operators of its plan instance
+class Worker {
+   /// The scheduler
+   Scheduler& scheduler;
+   /// The worker id
+   unsigned id;
+   /// The next state to register
+   unsigned nextState = 0;
+
+   public:
+   /// Constructor
+   Worker(Scheduler& scheduler, unsigned id) : scheduler(scheduler), id(id) {}
+
+   /// Get the worker id
+   unsigned getId() const { return id; }
+   /// Get the number of workers
+   unsigned getWorkerCount() const { return scheduler.threadCount; }
+   /// Is this the worker that merges shared state?
+   bool isLeader() const { return !id; }
+
+   /// Get the shared state of the next operator, creating it if needed. All instances must register their operators in the same order
+   template <class T, class... Args>
+   T& registerState(Args&&... args) {
+      unsigned index = nextState++;
+      if (index == scheduler.states.size()) scheduler.states.push_back(std::make_unique<T>(std::forward<Args>(args)...));
+      return static_cast<T&>(*scheduler.states[index]);
+   }
+   /// Wait until all workers arrived. Throws if another worker failed
+   void synchronize() { scheduler.synchronize(); }
+};
+//---------------------------------------------------------------------------
+}
+}
+//---------------------------------------------------------------------------
+#endif
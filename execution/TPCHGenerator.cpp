@@ -0,0 +1,455 @@
+#include "execution/TPCHGenerator.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <ostream>
+#include <stdexcept>
+#include <thread>
+//---------------------------------------------------------------------------
+// (c) 2023 Thomas Neumann
+//---------------------------------------------------------------------------
+using namespace std;
+//---------------------------------------------------------------------------
+namespace saneql::execution {
+//---------------------------------------------------------------------------
+namespace {
+//---------------------------------------------------------------------------
+/// A random number generator (splitmix64). Every row uses its own stream
+class Random {
+   /// The state
+   uint64_t state;
+
+   public:
+   /// Constructor
+   Random(TPCHGenerator::TableId table, uint64_t row) : state((static_cast<uint64_t>(table) << 56) ^ (row * 0xD1B54A32D192ED03ull)) {}
+
+   /// Get the next random number
+   uint64_t next() {
+      uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+      return z ^ (z >> 31);
+   }
+   /// Get a uniformly distributed number within [min, max]
+   int64_t range(int64_t min, int64_t max) { return min + static_cast<int64_t>(next() % static_cast<uint64_t>(max - min + 1)); }
+   /// Pick a random entry
+   template <class T, size_t n>
+   const T& pick(const T (&values)[n]) { return values[next() % n]; }
+};
+//---------------------------------------------------------------------------
+/// A generated row. The strings are owned by the row
+class Row {
+   /// The values
+   vector<Value> values;
+   /// The string contents
+   vector<string> strings;
+   /// The string columns
+   vector<unsigned> stringColumns;
+
+   public:
+   /// Constructor
+   explicit Row(const vector<ValueType>& types) : values(types.size()), strings(types.size()) {
+      for (unsigned index = 0; index != types.size(); ++index)
+         if (types[index].getKind() == ValueType::String) stringColumns.push_back(index);
+   }
+
+   /// Set a numerical value
+   void set(unsigned column, Int128 value) { values[column] = Value::makeNumber(value); }
+   /// Access the string of a column, it must be overwritten
+   string& text(unsigned column) { return strings[column]; }
+   /// Get the values
+   const vector<Value>& finish() {
+      for (auto column : stringColumns)
+         values[column] = Value::makeString(strings[column]);
+      return values;
+   }
+};
+//---------------------------------------------------------------------------
+/// The table names in the order of TableId
+const vector<string> tableNames = {"part", "supplier", "partsupp", "customer", "orders", "lineitem", "nation", "region"};
+/// The number of columns in the order of TableId
+constexpr unsigned columnCounts[] = {9, 7, 5, 8, 9, 16, 4, 3};
+//---------------------------------------------------------------------------
+/// The nations with their regions
+constexpr pair<string_view, unsigned> nations[] = {{"ALGERIA", 0}, {"ARGENTINA", 1}, {"BRAZIL", 1}, {"CANADA", 1}, {"EGYPT", 4}, {"ETHIOPIA", 0}, {"FRANCE", 3}, {"GERMANY", 3}, {"INDIA", 2}, {"INDONESIA", 2}, {"IRAN", 4}, {"IRAQ", 4}, {"JAPAN", 2}, {"JORDAN", 4}, {"KENYA", 0}, {"MOROCCO", 0}, {"MOZAMBIQUE", 0}, {"PERU", 1}, {"CHINA", 2}, {"ROMANIA", 3}, {"SAUDI ARABIA", 4}, {"VIETNAM", 2}, {"RUSSIA", 3}, {"UNITED KINGDOM", 3}, {"UNITED STATES", 1}};
+/// The regions
+constexpr string_view regions[] = {"AFRICA", "AMERICA", "ASIA", "EUROPE", "MIDDLE EAST"};
+/// The colors that make up part names
+constexpr string_view colors[] = {"almond", "antique", "aquamarine", "azure", "beige", "bisque", "black", "blanched", "blue", "blush", "brown", "burlywood", "burnished", "chartreuse", "chiffon", "chocolate", "coral", "cornflower", "cornsilk", "cream", "cyan", "dark", "deep", "dim", "dodger", "drab", "firebrick", "floral", "forest", "frosted", "gainsboro", "ghost", "goldenrod", "green", "grey", "honeydew", "hot", "indian", "ivory", "khaki", "lace", "lavender", "lawn", "lemon", "light", "lime", "linen", "magenta", "maroon", "medium", "metallic", "midnight", "mint", "misty", "moccasin", "navajo", "navy", "olive", "orange", "orchid", "pale", "papaya", "peach", "peru", "pink", "plum", "powder", "puff", "purple", "red", "rose", "rosy", "royal", "saddle", "salmon", "sandy", "seashell", "sienna", "sky", "slate", "smoke", "snow", "spring", "steel", "tan", "thistle", "tomato", "turquoise", "violet", "wheat", "white", "yellow"};
+/// The syllables of part types
+constexpr string_view typeSyllables1[] = {"STANDARD", "SMALL", "MEDIUM", "LARGE", "ECONOMY", "PROMO"};
+constexpr string_view typeSyllables2[] = {"ANODIZED", "BURNISHED", "PLATED", "POLISHED", "BRUSHED"};
+constexpr string_view typeSyllables3[] = {"TIN", "NICKEL", "BRASS", "STEEL", "COPPER"};
+/// The syllables of containers
+constexpr string_view containerSyllables1[] = {"SM", "LG", "MED", "JUMBO", "WRAP"};
+constexpr string_view containerSyllables2[] = {"CASE", "BOX", "BAG", "JAR", "PKG", "PACK", "CAN", "DRUM"};
+/// The market segments
+constexpr string_view segments[] = {"AUTOMOBILE", "BUILDING", "FURNITURE", "MACHINERY", "HOUSEHOLD"};
+/// The order priorities
+constexpr string_view priorities[] = {"1-URGENT", "2-HIGH", "3-MEDIUM", "4-NOT SPECIFIED", "5-LOW"};
+/// The shipping instructions
+constexpr string_view instructions[] = {"DELIVER IN PERSON", "COLLECT COD", "NONE", "TAKE BACK RETURN"};
+/// The shipping modes
+constexpr string_view modes[] = {"REG AIR", "AIR", "RAIL", "SHIP", "TRUCK", "MAIL", "FOB"};
+/// The words of comments
+constexpr string_view words[] = {"foxes", "ideas", "theodolites", "pinto", "beans", "instructions", "dependencies", "excuses", "platelets", "asymptotes", "courts", "dolphins", "multipliers", "sauternes", "warthogs", "frets", "dinos", "attainments", "somas", "Tiresias'", "patterns", "forges", "braids", "hockey", "players", "frays", "warhorses", "dugouts", "notornis", "epitaphs", "pearls", "tithes", "waters", "orbits", "gifts", "sheaves", "depths", "sentiments", "decoys", "realms", "pains", "grouches", "escapades", "packages", "requests", "accounts", "deposits", "sleep", "wake", "are", "cajole", "haggle", "nag", "use", "boost", "affix", "detect", "integrate", "maintain", "nod", "was", "lose", "sublate", "solve", "thrash", "promise", "engage", "hinder", "print", "x-ray", "breach", "eat", "grow", "impress", "mold", "poach", "serve", "run", "dazzle", "snooze", "doze", "unwind", "kindle", "play", "hang", "believe", "doubt", "furious", "sly", "careful", "blithe", "quick", "fluffy", "slow", "quiet", "ruthless", "thin", "close", "dogged", "daring", "brave", "stealthy", "permanent", "enticing", "idle", "busy", "regular", "final", "ironic", "even", "bold", "silent", "special", "pending", "unusual", "express", "sometimes", "always", "never", "furiously", "slyly", "carefully", "blithely", "quickly", "fluffily", "slowly", "quietly", "ruthlessly", "thinly", "closely", "doggedly", "daringly", "bravely", "stealthily", "permanently", "enticingly", "idly", "busily", "regularly", "finally", "ironically", "evenly", "boldly", "silently", "about", "above", "according", "to", "across", "after", "against", "along", "alongside", "of", "among", "around", "at", "atop", "before", "behind", "beneath", "beside", "besides", "between", "beyond", "by", "despite", "during", "except", "for", "from", "in", "place", "inside", "instead", "into", "near", "on", "outside", "over", "past", "since", "through", "throughout", "toward", "under", "until", "up", "upon", "without", "with", "within"};
+/// The characters of addresses
+constexpr string_view addressCharacters = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ,";
+//---------------------------------------------------------------------------
+/// The number of units per chunk
+constexpr uint64_t chunkSize = 10000;
+/// The first order date
+const int32_t startDate = values::makeDate(1992, 1, 1);
+/// The last order date
+const int32_t endDate = values::makeDate(1998, 12, 31) - 151;
+/// The current date that determines the line status and return flags
+const int32_t currentDate = values::makeDate(1995, 6, 17);
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
+static void generateText(Random& random, string& out, unsigned minLength, unsigned maxLength)
+// Generate a comment out of random words
+{
+   unsigned length = random.range(minLength, maxLength);
+   out.clear();
+   while (out.size() < length) {
+      if (!out.empty()) out += ' ';
+      out += random.pick(words);
+   }
+   out.resize(length);
+   if (out.back() == ' ') out.back() = '.';
+}
+//---------------------------------------------------------------------------
+static void generateAddress(Random& random, string& out)
+// Generate a random address
+{
+   unsigned length = random.range(10, 40);
+   out.clear();
+   for (unsigned index = 0; index != length; ++index)
+      out += addressCharacters[random.next() % addressCharacters.size()];
+}
+//---------------------------------------------------------------------------
+static void generatePhone(Random& random, string& out, uint64_t nation)
+// Generate a phone number, the country code is derived from the nation
+{
+   char buffer[32];
+   snprintf(buffer, sizeof(buffer), "%02u-%03u-%03u-%04u", static_cast<unsigned>(nation + 10), static_cast<unsigned>(random.range(100, 999)), static_cast<unsigned>(random.range(100, 999)), static_cast<unsigned>(random.range(1000, 9999)));
+   out = buffer;
+}
+//---------------------------------------------------------------------------
+static void generateName(string& out, string_view prefix, uint64_t key)
+// Generate a name with a zero padded key
+{
+   char buffer[32];
+   snprintf(buffer, sizeof(buffer), "%09llu", static_cast<unsigned long long>(key));
+   out = prefix;
+   out += buffer;
+}
+//---------------------------------------------------------------------------
+static int64_t getRetailPrice(uint64_t partKey)
+// Get the retail price of a part in cents
+{
+   return 90000 + ((partKey / 10) % 20001) + 100 * (partKey % 1000);
+}
+//---------------------------------------------------------------------------
+static uint64_t getPartSupplier(uint64_t partKey, unsigned index, uint64_t supplierCount)
+// Get one of the four suppliers of a part
+{
+   return (partKey + index * (supplierCount / 4)) % supplierCount + 1;
+}
+//---------------------------------------------------------------------------
+TPCHGenerator::TPCHGenerator(double scaleFactor, unsigned threadCount)
+   : scaleFactor(scaleFactor), threadCount(threadCount ? threadCount : max(thread::hardware_concurrency(), 1u))
+// Constructor
+{
+   if (!(scaleFactor > 0)) throw runtime_error("invalid scale factor");
+   auto scale = [&](double base, uint64_t minimum) { return max<uint64_t>(llround(base * scaleFactor), minimum); };
+   partCount = scale(200000, 1);
+   // Four distinct suppliers per part
+   supplierCount = scale(10000, 4);
+   customerCount = scale(150000, 1);
+   orderCount = scale(1500000, 1);
+   clerkCount = scale(1000, 1);
+}
+//---------------------------------------------------------------------------
+const vector<string>& TPCHGenerator::getTableNames()
+// Get the table names
+{
+   return tableNames;
+}
+//---------------------------------------------------------------------------
+TPCHGenerator::TableId TPCHGenerator::checkDefinition(const string& name, const Schema::Table& definition)
+// Find the table and check that the definition matches
+{
+   auto iter = find(tableNames.begin(), tableNames.end(), name);
+   if (iter == tableNames.end()) throw runtime_error("'" + name + "' is not a TPC-H table");
+   unsigned index = iter - tableNames.begin();
+   if (definition.columns.size() != columnCounts[index]) throw runtime_error("the definition of '" + name + "' does not match TPC-H");
+   return static_cast<TableId>(index);
+}
+//---------------------------------------------------------------------------
+uint64_t TPCHGenerator::getUnitCount(TableId table) const
+// Get the number of units of a table
+{
+   switch (table) {
+      case TableId::Part: return partCount;
+      case TableId::Supplier: return supplierCount;
+      case TableId::PartSupp: return partCount * 4;
+      case TableId::Customer: return customerCount;
+      case TableId::Orders:
+      case TableId::LineItem: return orderCount;
+      case TableId::Nation: return size(nations);
+      case TableId::Region: return size(regions);
+   }
+   return 0;
+}
+//---------------------------------------------------------------------------
+void TPCHGenerator::generateRows(TableId table, uint64_t begin, uint64_t end, const vector<ValueType>& types, const RowConsumer& consumer) const
+// Generate the rows of a range of units
+{
+   Row row(types);
+   string scratch;
+   for (uint64_t index = begin; index != end; ++index) {
+      Random random(table == TableId::LineItem ? TableId::Orders : table, index);
+      switch (table) {
+         case TableId::Part: {
+            uint64_t key = index + 1;
+            row.set(0, key);
+            // Five distinct colors
+            unsigned picked[5];
+            auto& name = row.text(1);
+            name.clear();
+            for (unsigned color = 0; color != 5; ++color) {
+               unsigned candidate;
+               do {
+                  candidate = random.next() % size(colors);
+               } while (find(picked, picked + color, candidate) != picked + color);
+               picked[color] = candidate;
+               if (color) name += ' ';
+               name += colors[candidate];
+            }
+            auto manufacturer = random.range(1, 5);
+            row.text(2) = "Manufacturer#" + to_string(manufacturer);
+            row.text(3) = "Brand#" + to_string(manufacturer) + to_string(random.range(1, 5));
+            auto& type = row.text(4);
+            type = random.pick(typeSyllables1);
+            type += ' ';
+            type += random.pick(typeSyllables2);
+            type += ' ';
+            type += random.pick(typeSyllables3);
+            row.set(5, random.range(1, 50));
+            auto& container = row.text(6);
+            container = random.pick(containerSyllables1);
+            container += ' ';
+            container += random.pick(containerSyllables2);
+            row.set(7, getRetailPrice(key));
+            generateText(random, row.text(8), 5, 22);
+            break;
+         }
+         case TableId::Supplier: {
+            uint64_t key = index + 1, nation = random.range(0, size(nations) - 1);
+            row.set(0, key);
+            generateName(row.text(1), "Supplier#", key);
+            generateAddress(random, row.text(2));
+            row.set(3, nation);
+            generatePhone(random, row.text(4), nation);
+            row.set(5, random.range(-99999, 999999));
+            auto& comment = row.text(6);
+            generateText(random, comment, 25, 100);
+            // A few suppliers have customer complaints or recommendations
+            auto special = random.range(0, 9999);
+            if (special < 10) {
+               unsigned pos = random.range(0, comment.size() - 20);
+               comment.replace(pos, 9, "Customer ");
+               comment.replace(pos + 10, 10, (special < 5) ? "Complaints" : "Recommends");
+            }
+            break;
+         }
+         case TableId::PartSupp: {
+            uint64_t partKey = index / 4 + 1;
+            row.set(0, partKey);
+            row.set(1, getPartSupplier(partKey, index % 4, supplierCount));
+            row.set(2, random.range(1, 9999));
+            row.set(3, random.range(100, 100000));
+            generateText(random, row.text(4), 49, 198);
+            break;
+         }
+         case TableId::Customer: {
+            uint64_t key = index + 1, nation = random.range(0, size(nations) - 1);
+            row.set(0, key);
+            generateName(row.text(1), "Customer#", key);
+            generateAddress(random, row.text(2));
+            row.set(3, nation);
+            generatePhone(random, row.text(4), nation);
+            row.set(5, random.range(-99999, 999999));
+            row.text(6) = random.pick(segments);
+            generateText(random, row.text(7), 29, 116);
+            break;
+         }
+         case TableId::Orders:
+         case TableId::LineItem: {
+            // Orders and line items are generated together, the total price and status of an order depend on its line items
+            // The keys are sparse, only the first 8 of every 32 keys are used
+            uint64_t key = (index / 8) * 32 + (index % 8) + 1;
+            // Every third customer has no orders
+            uint64_t customer = random.range(1, customerCount);
+            if ((customer % 3 == 0) && (customerCount > 1)) customer += (customer < customerCount) ? 1 : -1;
+            int32_t orderDate = random.range(startDate, endDate);
+            auto priority = random.pick(priorities);
+            auto clerk = random.range(1, clerkCount);
+            unsigned lineCount = random.range(1, 7), shipped = 0;
+            Int128 totalPrice = 0;
+            for (unsigned line = 0; line != lineCount; ++line) {
+               uint64_t partKey = random.range(1, partCount);
+               uint64_t supplier = getPartSupplier(partKey, random.range(0, 3), supplierCount);
+               int64_t quantity = random.range(1, 50), discount = random.range(0, 10), tax = random.range(0, 8);
+               int64_t extendedPrice = quantity * getRetailPrice(partKey);
+               int32_t shipDate = orderDate + random.range(1, 121), commitDate = orderDate + random.range(30, 90), receiptDate = shipDate + random.range(1, 30);
+               bool returned = random.range(0, 1);
+               auto instruction = random.pick(instructions);
+               auto mode = random.pick(modes);
+               totalPrice += (static_cast<Int128>(extendedPrice) * (100 + tax) * (100 - discount) + 5000) / 10000;
+               if (shipDate <= currentDate) ++shipped;
+               if (table == TableId::LineItem) {
+                  row.set(0, key);
+                  row.set(1, partKey);
+                  row.set(2, supplier);
+                  row.set(3, line + 1);
+                  row.set(4, quantity * 100);
+                  row.set(5, extendedPrice);
+                  row.set(6, discount);
+                  row.set(7, tax);
+                  row.text(8) = (receiptDate <= currentDate) ? (returned ? "R" : "A") : "N";
+                  row.text(9) = (shipDate > currentDate) ? "O" : "F";
+                  row.set(10, shipDate);
+                  row.set(11, commitDate);
+                  row.set(12, receiptDate);
+                  row.text(13) = instruction;
+                  row.text(14) = mode;
+                  generateText(random, row.text(15), 10, 43);
+                  consumer(row.finish());
+               } else {
+                  // Consume the same random numbers as for the line item table
+                  generateText(random, scratch, 10, 43);
+               }
+            }
+            if (table == TableId::LineItem) continue;
+            row.set(0, key);
+            row.set(1, customer);
+            row.text(2) = (shipped == lineCount) ? "F" : (shipped ? "P" : "O");
+            row.set(3, totalPrice);
+            row.set(4, orderDate);
+            row.text(5) = priority;
+            generateName(row.text(6), "Clerk#", clerk);
+            row.set(7, 0);
+            generateText(random, row.text(8), 19, 78);
+            break;
+         }
+         case TableId::Nation:
+            row.set(0, index);
+            row.text(1) = nations[index].first;
+            row.set(2, nations[index].second);
+            generateText(random, row.text(3), 31, 114);
+            break;
+         case TableId::Region:
+            row.set(0, index);
+            row.text(1) = regions[index];
+            generateText(random, row.text(2), 31, 115);
+            break;
+      }
+      consumer(row.finish());
+   }
+}
+//---------------------------------------------------------------------------
+void TPCHGenerator::generateChunks(TableId table, const function<void(uint64_t chunk, uint64_t begin, uint64_t end)>& produce, const function<void(uint64_t chunk)>& consume) const
+// Generate a table in parallel chunks
+{
+   // The chunks are produced in rounds of a few chunks per thread, which bounds the memory of unconsumed chunks
+   uint64_t units = getUnitCount(table), chunkCount = (units + chunkSize - 1) / chunkSize;
+   uint64_t roundSize = threadCount * 4;
+   for (uint64_t roundBegin = 0; roundBegin < chunkCount; roundBegin += roundSize) {
+      uint64_t roundEnd = min(roundBegin + roundSize, chunkCount);
+      atomic<uint64_t> nextChunk = roundBegin;
+      auto worker = [&]() {
+         while (true) {
+            uint64_t chunk = nextChunk++;
+            if (chunk >= roundEnd) break;
+            produce(chunk, chunk * chunkSize, min(chunk * chunkSize + chunkSize, units));
+         }
+      };
+      unsigned workers = min<uint64_t>(threadCount, roundEnd - roundBegin);
+      if (workers <= 1) {
+         worker();
+      } else {
+         vector<thread> threads;
+         for (unsigned index = 0; index != workers; ++index)
+            threads.emplace_back(worker);
+         for (auto& t : threads)
+            t.join();
+      }
+      for (uint64_t chunk = roundBegin; chunk != roundEnd; ++chunk)
+         consume(chunk);
+   }
+}
+//---------------------------------------------------------------------------
+unique_ptr<Table> TPCHGenerator::generate(const string& name, const Schema::Table& definition) const
+// Generate a table into the columnar store
+{
+   auto table = checkDefinition(name, definition);
+   auto result = make_unique<Table>(definition);
+   auto types = result->getTypes();
+   uint64_t units = getUnitCount(table);
+   result->reserve(table == TableId::LineItem ? units * 4 : units);
+
+   vector<unique_ptr<Table>> chunks((units + chunkSize - 1) / chunkSize);
+   generateChunks(
+      table, [&](uint64_t chunk, uint64_t begin, uint64_t end) {
+         auto& target = chunks[chunk];
+         target = make_unique<Table>(definition);
+         target->reserve(table == TableId::LineItem ? (end - begin) * 7 : end - begin);
+         generateRows(table, begin, end, types, [&](const vector<Value>& row) { target->append(row); });
+      },
+      [&](uint64_t chunk) {
+         result->append(*chunks[chunk]);
+         chunks[chunk].reset();
+      });
+   return result;
+}
+//---------------------------------------------------------------------------
+uint64_t TPCHGenerator::write(const string& name, const Schema::Table& definition, ostream& out) const
+// Write a table in the .tbl format of dbgen
+{
+   auto table = checkDefinition(name, definition);
+   vector<ValueType> types;
+   for (auto& c : definition.columns)
+      types.push_back(ValueType::fromType(c.type));
+   uint64_t units = getUnitCount(table);
+
+   // Every row ends with a delimiter
+   vector<string> chunks((units + chunkSize - 1) / chunkSize);
+   vector<uint64_t> rowCounts(chunks.size());
+   uint64_t rows = 0;
+   generateChunks(
+      table, [&](uint64_t chunk, uint64_t begin, uint64_t end) {
+         auto& text = chunks[chunk];
+         generateRows(table, begin, end, types, [&](const vector<Value>& row) {
+            for (unsigned index = 0; index != row.size(); ++index) {
+               values::format(text, types[index], row[index]);
+               text += '|';
+            }
+            text += '\n';
+            ++rowCounts[chunk];
+         });
+      },
+      [&](uint64_t chunk) {
+         out.write(chunks[chunk].data(), chunks[chunk].size());
+         string().swap(chunks[chunk]);
+         rows += rowCounts[chunk];
+      });
+   if (!out) throw runtime_error("unable to write " + name);
+   return rows;
+}
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
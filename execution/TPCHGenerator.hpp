@@ -0,0 +1,67 @@
+#ifndef H_saneql_execution_TPCHGenerator
+#define H_saneql_execution_TPCHGenerator
+//---------------------------------------------------------------------------
+#include "execution/Table.hpp"
+#include "infra/Schema.hpp"
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+//---------------------------------------------------------------------------
+// SaneQL
+// (c) 2023 Thomas Neumann
+// SPDX-License-Identifier: BSD-3-Clause
+//---------------------------------------------------------------------------
+namespace saneql {
+//---------------------------------------------------------------------------
+namespace execution {
+//---------------------------------------------------------------------------
+/// Generates the tables of the TPC-H benchmark for an arbitrary scale factor, following
+/// the cardinalities, key relationships, and value domains of the specification. Every row
+/// (every order for orders and lineitem) is derived from its own random stream, thus the
+/// data is the same for any number of threads
+class TPCHGenerator {
+   public:
+   /// The tables
+   enum class TableId : unsigned { Part, Supplier, PartSupp, Customer, Orders, LineItem, Nation, Region };
+   /// A generated row. Valid until the next row is produced
+   using RowConsumer = std::function<void(const std::vector<Value>&)>;
+
+   private:
+   /// The scale factor
+   double scaleFactor;
+   /// The number of worker threads
+   unsigned threadCount;
+   /// The number of parts, suppliers, customers, orders, and clerks
+   uint64_t partCount, supplierCount, customerCount, orderCount, clerkCount;
+
+   /// Get the number of units of a table. Orders for lineitem, rows otherwise
+   uint64_t getUnitCount(TableId table) const;
+   /// Generate the rows of a range of units
+   void generateRows(TableId table, uint64_t begin, uint64_t end, const std::vector<ValueType>& types, const RowConsumer& consumer) const;
+   /// Generate a table in parallel chunks. The chunks are handed to the consumer in order
+   void generateChunks(TableId table, const std::function<void(uint64_t chunk, uint64_t begin, uint64_t end)>& produce, const std::function<void(uint64_t chunk)>& consume) const;
+   /// Find the table and check that the definition matches
+   static TableId checkDefinition(const std::string& name, const Schema::Table& definition);
+
+   public:
+   /// Constructor. A thread count of 0 uses all available cores
+   explicit TPCHGenerator(double scaleFactor, unsigned threadCount = 0);
+
+   /// Get the scale factor
+   double getScaleFactor() const { return scaleFactor; }
+   /// Get the table names
+   static const std::vector<std::string>& getTableNames();
+
+   /// Generate a table into the columnar store. The definition must be the TPC-H definition
+   std::unique_ptr<Table> generate(const std::string& name, const Schema::Table& definition) const;
+   /// Write a table in the .tbl format of dbgen. Returns the number of rows
+   uint64_t write(const std::string& name, const Schema::Table& definition, std::ostream& out) const;
+};
+//---------------------------------------------------------------------------
+}
+}
+//---------------------------------------------------------------------------
+#endif
@@ -0,0 +1,168 @@
+#include "execution/Table.hpp"
+#include "execution/Vector.hpp"
+#include <cstring>
+#include <stdexcept>
+//---------------------------------------------------------------------------
+// (c) 2023 Thomas Neumann
+//---------------------------------------------------------------------------
+using namespace std;
+//---------------------------------------------------------------------------
+namespace saneql::execution {
+//---------------------------------------------------------------------------
+Column::Column(Type type)
+   : type(ValueType::fromType(type)), storage(getStorageType(type))
+// Constructor
+{
+}
+//---------------------------------------------------------------------------
+PhysicalType Column::getStorageType(Type type)
+// Get the storage representation of an SQL type
+{
+   // Decimals with up to 18 digits fit into 64 bits
+   if ((type.getType() == Type::Decimal) && (type.getPrecision() <= 18)) return PhysicalType::Int64;
+   return ValueType::fromType(type).getPhysicalType();
+}
+//---------------------------------------------------------------------------
+Value Column::get(uint64_t row) const
+// Get a value
+{
+   if (isNull(row)) return Value::makeNull();
+   return dispatch(storage, [&]<class T>(T*) {
+      if constexpr (is_same_v<T, string_view>)
+         return Value::makeString(getString(row));
+      else
+         return Value::makeNumber(getData<T>()[row]);
+   });
+}
+//---------------------------------------------------------------------------
+void Column::reserve(uint64_t rows)
+// Reserve space for a number of rows
+{
+   dispatch(storage, [&]<class T>(T*) {
+      if constexpr (is_same_v<T, string_view>)
+         offsets.reserve(rows);
+      else
+         values.reserve(rows * sizeof(T));
+   });
+   if (type.isNullable()) nulls.reserve((rows + 63) / 64);
+}
+//---------------------------------------------------------------------------
+void Column::append(const Value& value)
+// Append a value
+{
+   if (type.isNullable()) {
+      if (!(size % 64)) nulls.push_back(0);
+      if (value.null) nulls.back() |= 1ull << (size % 64);
+   } else if (value.null) {
+      throw runtime_error("NULL value in a non-nullable column");
+   }
+   dispatch(storage, [&]<class T>(T*) {
+      if constexpr (is_same_v<T, string_view>) {
+         if (!value.null) values.insert(values.end(), reinterpret_cast<const byte*>(value.str.data()), reinterpret_cast<const byte*>(value.str.data() + value.str.size()));
+         offsets.push_back(values.size());
+      } else {
+         T v = value.null ? T() : static_cast<T>(value.number);
+         values.resize(values.size() + sizeof(T));
+         memcpy(values.data() + values.size() - sizeof(T), &v, sizeof(T));
+      }
+   });
+   ++size;
+}
+//---------------------------------------------------------------------------
+void Column::append(const Column& other)
+// Append all values of another column of the same type
+{
+   if (storage == PhysicalType::String) {
+      uint64_t base = values.size();
+      for (auto o : other.offsets)
+         offsets.push_back(base + o);
+   }
+   values.insert(values.end(), other.values.begin(), other.values.end());
+   if (type.isNullable()) {
+      // Shift the NULL bits of the other column behind the existing bits
+      unsigned shift = size % 64;
+      nulls.resize((size + 63) / 64);
+      for (uint64_t index = 0; index != other.nulls.size(); ++index) {
+         uint64_t word = other.nulls[index];
+         if (!shift) {
+            nulls.push_back(word);
+         } else {
+            nulls.back() |= word << shift;
+            if (index * 64 + 64 - shift < other.size) nulls.push_back(word >> (64 - shift));
+         }
+      }
+   }
+   size += other.size;
+}
+//---------------------------------------------------------------------------
+void Column::read(uint64_t from, unsigned count, Vector& target) const
+// Provide the values of a range of rows as vector
+{
+   target.allocate(count, type.isNullable());
+   if (type.isNullable()) {
+      uint8_t* targetNulls = target.getNulls();
+      for (unsigned index = 0; index != count; ++index) {
+         uint64_t row = from + index;
+         targetNulls[index] = (nulls[row / 64] >> (row % 64)) & 1;
+      }
+   }
+
+   // Numerical values are referenced directly if the representation matches, otherwise they are converted
+   if (storage == type.getPhysicalType()) {
+      if (storage == PhysicalType::String) {
+         auto targetValues = target.getData<string_view>();
+         for (unsigned index = 0; index != count; ++index)
+            targetValues[index] = getString(from + index);
+      } else {
+         target.reference(values.data() + from * type.getWidth(), target.getNulls());
+      }
+   } else {
+      auto sourceValues = getData<int64_t>() + from;
+      auto targetValues = target.getData<Int128>();
+      for (unsigned index = 0; index != count; ++index)
+         targetValues[index] = sourceValues[index];
+   }
+}
+//---------------------------------------------------------------------------
+Table::Table(const Schema::Table& definition)
+// Constructor
+{
+   columns.reserve(definition.columns.size());
+   for (auto& c : definition.columns)
+      columns.emplace_back(c.type);
+}
+//---------------------------------------------------------------------------
+vector<ValueType> Table::getTypes() const
+// Get the value types of the columns
+{
+   vector<ValueType> result;
+   for (auto& c : columns)
+      result.push_back(c.getType());
+   return result;
+}
+//---------------------------------------------------------------------------
+void Table::reserve(uint64_t rows)
+// Reserve space for a number of rows
+{
+   for (auto& c : columns)
+      c.reserve(rows);
+}
+//---------------------------------------------------------------------------
+void Table::append(const vector<Value>& row)
+// Append a row
+{
+   for (unsigned index = 0; index != columns.size(); ++index)
+      columns[index].append(row[index]);
+   ++size;
+}
+//---------------------------------------------------------------------------
+void Table::append(const Table& other)
+// Append all rows of another table with the same columns
+{
+   for (unsigned index = 0; index != columns.size(); ++index)
+      columns[index].append(other.columns[index]);
+   size += other.size;
+}
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
@@ -0,0 +1,108 @@
+#ifndef H_saneql_execution_Table
+#define H_saneql_execution_Table
+//---------------------------------------------------------------------------
+#include "execution/Value.hpp"
+#include "infra/Schema.hpp"
+#include <cstddef>
+#include <string_view>
+#include <vector>
+//---------------------------------------------------------------------------
+// SaneQL
+// (c) 2023 Thomas Neumann
+// SPDX-License-Identifier: BSD-3-Clause
+//---------------------------------------------------------------------------
+namespace saneql {
+//---------------------------------------------------------------------------
+namespace execution {
+//---------------------------------------------------------------------------
+class Vector;
+//---------------------------------------------------------------------------
+/// A column of a stored table. The values are stored contiguously in a type specific
+/// representation: integers as int64, decimals as scaled int64 (up to 18 digits) or
+/// int128, dates as int32 days, and strings as offsets into one character buffer.
+/// Only nullable columns have a NULL bitmap, NULL entries hold the value zero
+class Column {
+   /// The type of the values
+   ValueType type;
+   /// The storage representation
+   PhysicalType storage;
+   /// The values. The string contents for string columns
+   std::vector<std::byte> values;
+   /// The end offsets of the strings
+   std::vector<uint64_t> offsets;
+   /// The NULL bitmap, one bit per row. Only for nullable columns
+   std::vector<uint64_t> nulls;
+   /// The number of rows
+   uint64_t size = 0;
+
+   public:
+   /// Constructor
+   explicit Column(Type type);
+
+   /// Get the storage representation of an SQL type
+   static PhysicalType getStorageType(Type type);
+
+   /// Get the type of the values
+   ValueType getType() const { return type; }
+   /// Get the storage representation
+   PhysicalType getStorageType() const { return storage; }
+   /// Get the number of rows
+   uint64_t getSize() const { return size; }
+
+   /// Access the values of a numerical column
+   template <class T>
+   const T* getData() const { return reinterpret_cast<const T*>(values.data()); }
+   /// Get a string
+   std::string_view getString(uint64_t row) const {
+      uint64_t begin = row ? offsets[row - 1] : 0;
+      return std::string_view(reinterpret_cast<const char*>(values.data()) + begin, offsets[row] - begin);
+   }
+   /// Access the end offsets of a string column
+   const uint64_t* getOffsets() const { return offsets.data(); }
+   /// Access the NULL bitmap. nullptr for non-nullable columns
+   const uint64_t* getNulls() const { return nulls.empty() ? nullptr : nulls.data(); }
+   /// Is a value NULL?
+   bool isNull(uint64_t row) const { return (!nulls.empty()) && ((nulls[row / 64] >> (row % 64)) & 1); }
+   /// Get a value
+   Value get(uint64_t row) const;
+
+   /// Reserve space for a number of rows
+   void reserve(uint64_t rows);
+   /// Append a value. NULL values require a nullable column
+   void append(const Value& value);
+   /// Append all values of another column of the same type
+   void append(const Column& other);
+   /// Provide the values of a range of rows as vector. References the stored values if the representations match
+   void read(uint64_t from, unsigned count, Vector& target) const;
+};
+//---------------------------------------------------------------------------
+/// The stored data of a table in columnar form, with the column types of the schema
+class Table {
+   /// The columns
+   std::vector<Column> columns;
+   /// The number of rows
+   uint64_t size = 0;
+
+   public:
+   /// Constructor
+   explicit Table(const Schema::Table& definition);
+
+   /// Get the number of rows
+   uint64_t getSize() const { return size; }
+   /// Get the columns
+   const std::vector<Column>& getColumns() const { return columns; }
+   /// Get the value types of the columns
+   std::vector<ValueType> getTypes() const;
+
+   /// Reserve space for a number of rows
+   void reserve(uint64_t rows);
+   /// Append a row
+   void append(const std::vector<Value>& row);
+   /// Append all rows of another table with the same columns
+   void append(const Table& other);
+};
+//---------------------------------------------------------------------------
+}
+}
+//---------------------------------------------------------------------------
+#endif
@@ -0,0 +1,465 @@
+#include "execution/Value.hpp"
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+//---------------------------------------------------------------------------
+// (c) 2023 Thomas Neumann
+//---------------------------------------------------------------------------
+using namespace std;
+//---------------------------------------------------------------------------
+namespace saneql::execution {
+//---------------------------------------------------------------------------
+ValueType ValueType::fromType(Type type)
+// Derive the value type of an SQL type
+{
+   bool n = type.isNullable();
+   switch (type.getType()) {
+      case Type::Unknown: return ValueType(Null);
+      case Type::Bool: return ValueType(Bool, 0, n);
+      case Type::Integer: return ValueType(Integer, 0, n);
+      case Type::Decimal: return ValueType(Decimal, min(type.getScale(), maxScale), n);
+      case Type::Char:
+      case Type::Varchar:
+      case Type::Text: return ValueType(String, 0, n);
+      case Type::Date: return ValueType(Date, 0, n);
+      case Type::Interval: return ValueType(Interval, 0, n);
+   }
+   __builtin_unreachable();
+}
+//---------------------------------------------------------------------------
+PhysicalType ValueType::getPhysicalType() const
+// Get the physical representation
+{
+   switch (kind) {
+      case Null:
+      case Bool: return PhysicalType::Bool;
+      case Integer:
+      case Interval: return PhysicalType::Int64;
+      case Decimal: return PhysicalType::Int128;
+      case Date: return PhysicalType::Int32;
+      case String: return PhysicalType::String;
+   }
+   __builtin_unreachable();
+}
+//---------------------------------------------------------------------------
+unsigned ValueType::getWidth() const
+// Get the size of a value in bytes
+{
+   switch (getPhysicalType()) {
+      case PhysicalType::Bool: return 1;
+      case PhysicalType::Int32: return 4;
+      case PhysicalType::Int64: return 8;
+      case PhysicalType::Int128: return 16;
+      case PhysicalType::String: return sizeof(string_view);
+   }
+   __builtin_unreachable();
+}
+//---------------------------------------------------------------------------
+string ValueType::getName() const
+// Get the name (for error reporting)
+{
+   switch (kind) {
+      case Null: return "unknown";
+      case Bool: return "boolean";
+      case Integer: return "integer";
+      case Decimal: return "decimal(" + to_string(scale) + ")";
+      case Date: return "date";
+      case Interval: return "interval";
+      case String: return "text";
+   }
+   __builtin_unreachable();
+}
+//---------------------------------------------------------------------------
+ValueType ValueType::unify(ValueType a, ValueType b)
+// Find the type that two types are converted to in comparisons
+{
+   bool n = a.isNullable() || b.isNullable();
+   if (a.kind == Null) return b.withNullable(true);
+   if (b.kind == Null) return a.withNullable(true);
+   if (a.isNumeric() && b.isNumeric()) {
+      if ((a.kind == Integer) && (b.kind == Integer)) return ValueType(Integer, 0, n);
+      return ValueType(Decimal, max(a.scale, b.scale), n);
+   }
+   if (a.kind != b.kind) throw runtime_error("cannot combine '" + a.getName() + "' and '" + b.getName() + "'");
+   return a.withNullable(n);
+}
+//---------------------------------------------------------------------------
+namespace values {
+//---------------------------------------------------------------------------
+Int128 pow10(unsigned exponent)
+// Get a power of ten
+{
+   static const auto powers = []() {
+      array<Int128, 39> result;
+      result[0] = 1;
+      for (unsigned index = 1; index != result.size(); ++index)
+         result[index] = result[index - 1] * 10;
+      return result;
+   }();
+   if (exponent >= powers.size()) overflow();
+   return powers[exponent];
+}
+//---------------------------------------------------------------------------
+void overflow()
+// Report a result that does not fit into its type
+{
+   throw runtime_error("numeric value out of range");
+}
+//---------------------------------------------------------------------------
+Int128 checkedRound(double value)
+// Round a floating point number into a number, throws on overflow
+{
+   // 2^127 is exactly representable, every smaller double fits
+   constexpr double limit = 170141183460469231731687303715884105728.0;
+   value = round(value);
+   if (!((value >= -limit) && (value < limit))) overflow();
+   return static_cast<Int128>(value);
+}
+//---------------------------------------------------------------------------
+Int128 divideRounded(Int128 a, Int128 b)
+// Divide, rounding half away from zero
+{
+   Int128 result = a / b, remainder = a % b;
+   if (remainder < 0) remainder = -remainder;
+   Int128 divisor = (b < 0) ? -b : b;
+   if (remainder * 2 >= divisor) result += ((a < 0) != (b < 0)) ? -1 : 1;
+   return result;
+}
+//---------------------------------------------------------------------------
+Int128 rescale(Int128 value, unsigned from, unsigned to)
+// Change the scale of a decimal, rounding half away from zero
+{
+   if (from == to) return value;
+   if (from < to) return checkedMul(value, pow10(to - from));
+   return divideRounded(value, pow10(from - to));
+}
+//---------------------------------------------------------------------------
+int32_t makeDate(int year, unsigned month, unsigned day)
+// Convert a date into the number of days since 1970-01-01
+{
+   // The days from civil algorithm by Howard Hinnant
+   year -= month <= 2;
+   int era = (year >= 0 ? year : year - 399) / 400;
+   unsigned yoe = year - era * 400;
+   unsigned doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+   unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+   return era * 146097 + static_cast<int>(doe) - 719468;
+}
+//---------------------------------------------------------------------------
+void splitDate(int32_t date, int& year, unsigned& month, unsigned& day)
+// Split a date into year, month, and day
+{
+   // The civil from days algorithm by Howard Hinnant
+   int z = date + 719468;
+   int era = (z >= 0 ? z : z - 146096) / 146097;
+   unsigned doe = z - era * 146097;
+   unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+   unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+   unsigned mp = (5 * doy + 2) / 153;
+   day = doy - (153 * mp + 2) / 5 + 1;
+   month = mp < 10 ? mp + 3 : mp - 9;
+   year = static_cast<int>(yoe) + era * 400 + (month <= 2);
+}
+//---------------------------------------------------------------------------
+static unsigned daysInMonth(int year, unsigned month)
+// Get the number of days of a month
+{
+   static constexpr unsigned days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+   bool leap = ((year % 4) == 0) && (((year % 100) != 0) || ((year % 400) == 0));
+   return ((month == 2) && leap) ? 29 : days[month - 1];
+}
+//---------------------------------------------------------------------------
+int32_t addInterval(int32_t date, int64_t interval)
+// Add an interval to a date
+{
+   if (auto months = getMonths(interval)) {
+      int year;
+      unsigned month, day;
+      splitDate(date, year, month, day);
+      int total = year * 12 + static_cast<int>(month) - 1 + months;
+      year = (total >= 0) ? (total / 12) : -((11 - total) / 12);
+      month = total - year * 12 + 1;
+      date = makeDate(year, month, min(day, daysInMonth(year, month)));
+   }
+   return date + getDays(interval);
+}
+//---------------------------------------------------------------------------
+template <class T>
+static bool parseInteger(string_view text, T& result)
+// Parse an integer, requiring the whole string to be consumed
+{
+   if ((!text.empty()) && (text.front() == '+')) text.remove_prefix(1);
+   auto [ptr, ec] = from_chars(text.data(), text.data() + text.size(), result);
+   return (ec == errc()) && (ptr == text.data() + text.size()) && (!text.empty());
+}
+//---------------------------------------------------------------------------
+static bool parseDecimal(string_view text, unsigned scale, Int128& result)
+// Parse a decimal number
+{
+   bool negative = false;
+   if ((!text.empty()) && ((text.front() == '-') || (text.front() == '+'))) {
+      negative = text.front() == '-';
+      text.remove_prefix(1);
+   }
+   Int128 value = 0;
+   unsigned fraction = 0, digits = 0, extra = 0;
+   bool dot = false, roundUp = false;
+   for (char c : text) {
+      if (c == '.') {
+         if (dot) return false;
+         dot = true;
+      } else if ((c >= '0') && (c <= '9')) {
+         ++digits;
+         if (dot && (fraction == scale)) {
+            // Round at the first digit beyond the scale
+            if (!(extra++)) roundUp = c >= '5';
+            continue;
+         }
+         if (value > pow10(36)) return false;
+         value = value * 10 + (c - '0');
+         if (dot) ++fraction;
+      } else {
+         return false;
+      }
+   }
+   if (!digits) return false;
+   value *= pow10(scale - fraction);
+   if (roundUp) ++value;
+   result = negative ? -value : value;
+   return true;
+}
+//---------------------------------------------------------------------------
+static bool parseDate(string_view text, int32_t& result)
+// Parse a date in the form YYYY-MM-DD
+{
+   int year;
+   unsigned month, day;
+   auto parse = [&](unsigned from, unsigned len, auto& value) {
+      auto [ptr, ec] = from_chars(text.data() + from, text.data() + from + len, value);
+      return (ec == errc()) && (ptr == text.data() + from + len);
+   };
+   if ((text.size() != 10) || (text[4] != '-') || (text[7] != '-') || (!parse(0, 4, year)) || (!parse(5, 2, month)) || (!parse(8, 2, day))) return false;
+   if ((month < 1) || (month > 12) || (day < 1) || (day > daysInMonth(year, month))) return false;
+   result = makeDate(year, month, day);
+   return true;
+}
+//---------------------------------------------------------------------------
+static bool parseInterval(string_view text, int64_t& result)
+// Parse an interval like '1 year 2 months 3 days'
+{
+   int64_t months = 0, days = 0;
+   auto skipSpaces = [&]() {
+      while ((!text.empty()) && (text.front() == ' ')) text.remove_prefix(1);
+   };
+   skipSpaces();
+   if (text.empty()) return false;
+   while (!text.empty()) {
+      // The quantity
+      size_t len = 0;
+      while ((len < text.size()) && ((text[len] == '-') || (text[len] == '+') || ((text[len] >= '0') && (text[len] <= '9')))) ++len;
+      int64_t quantity;
+      if (!parseInteger(text.substr(0, len), quantity)) return false;
+      text.remove_prefix(len);
+      skipSpaces();
+
+      // The unit
+      len = 0;
+      while ((len < text.size()) && (text[len] != ' ')) ++len;
+      string unit;
+      for (char c : text.substr(0, len))
+         unit += static_cast<char>(tolower(c));
+      text.remove_prefix(len);
+      skipSpaces();
+      if ((unit == "year") || (unit == "years")) {
+         months += quantity * 12;
+      } else if ((unit == "month") || (unit == "months") || (unit == "mon") || (unit == "mons")) {
+         months += quantity;
+      } else if ((unit == "week") || (unit == "weeks")) {
+         days += quantity * 7;
+      } else if ((unit == "day") || (unit == "days")) {
+         days += quantity;
+      } else {
+         return false;
+      }
+   }
+   result = makeInterval(months, days);
+   return true;
+}
+//---------------------------------------------------------------------------
+bool tryParse(ValueType type, string_view text, Value& result)
+// Parse the text form of a value
+{
+   result.null = false;
+   switch (type.getKind()) {
+      case ValueType::Null: result.null = true; return true;
+      case ValueType::Bool: {
+         string lower;
+         for (char c : text)
+            lower += static_cast<char>(tolower(c));
+         if ((lower == "true") || (lower == "t") || (lower == "1") || (lower == "yes")) {
+            result.number = 1;
+         } else if ((lower == "false") || (lower == "f") || (lower == "0") || (lower == "no")) {
+            result.number = 0;
+         } else {
+            return false;
+         }
+         return true;
+      }
+      case ValueType::Integer: {
+         int64_t value;
+         if (!parseInteger(text, value)) return false;
+         result.number = value;
+         return true;
+      }
+      case ValueType::Decimal: return parseDecimal(text, type.getScale(), result.number);
+      case ValueType::Date: {
+         int32_t value;
+         if (!parseDate(text, value)) return false;
+         result.number = value;
+         return true;
+      }
+      case ValueType::Interval: {
+         int64_t value;
+         if (!parseInterval(text, value)) return false;
+         result.number = value;
+         return true;
+      }
+      case ValueType::String: result.str = text; return true;
+   }
+   __builtin_unreachable();
+}
+//---------------------------------------------------------------------------
+Value parse(ValueType type, string_view text)
+// Parse the text form of a value. Throws on malformed values
+{
+   Value result;
+   if (!tryParse(type, text, result)) throw runtime_error("invalid " + type.getName() + " value '" + string(text) + "'");
+   return result;
+}
+//---------------------------------------------------------------------------
+static void formatInteger(string& out, Int128 value)
+// Format an integer
+{
+   if (value < 0) {
+      out += '-';
+      value = -value;
+   }
+   char buffer[48];
+   char* pos = buffer + sizeof(buffer);
+   do {
+      *(--pos) = '0' + static_cast<char>(value % 10);
+      value /= 10;
+   } while (value);
+   out.append(pos, buffer + sizeof(buffer));
+}
+//---------------------------------------------------------------------------
+void format(string& out, ValueType type, const Value& value)
+// Format a value in its text form
+{
+   if (value.null) {
+      out += "NULL";
+      return;
+   }
+   switch (type.getKind()) {
+      case ValueType::Null: out += "NULL"; return;
+      case ValueType::Bool: out += value.number ? "true" : "false"; return;
+      case ValueType::Integer: formatInteger(out, value.number); return;
+      case ValueType::Decimal: {
+         Int128 v = value.number;
+         if (v < 0) {
+            out += '-';
+            v = -v;
+         }
+         auto factor = pow10(type.getScale());
+         formatInteger(out, v / factor);
+         if (type.getScale()) {
+            string fraction;
+            formatInteger(fraction, v % factor);
+            out += '.';
+            out.append(type.getScale() - fraction.size(), '0');
+            out += fraction;
+         }
+         return;
+      }
+      case ValueType::Date: {
+         int year;
+         unsigned month, day;
+         splitDate(static_cast<int32_t>(value.number), year, month, day);
+         char buffer[32];
+         snprintf(buffer, sizeof(buffer), "%04d-%02u-%02u", year, month, day);
+         out += buffer;
+         return;
+      }
+      case ValueType::Interval: {
+         int64_t interval = static_cast<int64_t>(value.number);
+         int32_t months = getMonths(interval), days = getDays(interval);
+         bool first = true;
+         auto part = [&](int64_t quantity, const char* singular, const char* plural) {
+            if (!quantity) return;
+            if (!first) out += ' ';
+            first = false;
+            formatInteger(out, quantity);
+            out += ' ';
+            out += ((quantity == 1) || (quantity == -1)) ? singular : plural;
+         };
+         if ((!months) && (!days)) {
+            out += "0 days";
+            return;
+         }
+         part(months / 12, "year", "years");
+         part(months % 12, "mon", "mons");
+         part(days, "day", "days");
+         return;
+      }
+      case ValueType::String: out += value.str; return;
+   }
+}
+//---------------------------------------------------------------------------
+string format(ValueType type, const Value& value)
+// Format a value in its text form
+{
+   string result;
+   format(result, type, value);
+   return result;
+}
+//---------------------------------------------------------------------------
+int compare(ValueType type, const Value& a, const Value& b)
+// Compare two non-NULL values of the same type
+{
+   if (type.getKind() == ValueType::String) {
+      int c = a.str.compare(b.str);
+      return (c < 0) ? -1 : (c > 0);
+   }
+   return (a.number < b.number) ? -1 : (a.number > b.number);
+}
+//---------------------------------------------------------------------------
+uint64_t hashString(string_view str)
+// Hash a string
+{
+   constexpr uint64_t m = 0xC6A4A7935BD1E995ull;
+   uint64_t result = 0x8445D61A4E774912ull ^ (str.size() * m);
+   auto data = str.data();
+   size_t len = str.size();
+   for (; len >= 8; data += 8, len -= 8) {
+      uint64_t k;
+      memcpy(&k, data, 8);
+      k *= m;
+      k ^= k >> 47;
+      result = (result ^ (k * m)) * m;
+   }
+   if (len) {
+      uint64_t k = 0;
+      memcpy(&k, data, len);
+      result = (result ^ k) * m;
+   }
+   result ^= result >> 47;
+   result *= m;
+   return result ^ (result >> 47);
+}
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
@@ -0,0 +1,198 @@
+#ifndef H_saneql_execution_Value
+#define H_saneql_execution_Value
+//---------------------------------------------------------------------------
+#include "infra/Schema.hpp"
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+//---------------------------------------------------------------------------
+// SaneQL
+// (c) 2023 Thomas Neumann
+// SPDX-License-Identifier: BSD-3-Clause
+//---------------------------------------------------------------------------
+namespace saneql {
+//---------------------------------------------------------------------------
+namespace execution {
+//---------------------------------------------------------------------------
+/// A 128 bit integer, used for decimals and for row wise processing
+using Int128 = __int128;
+//---------------------------------------------------------------------------
+/// The physical representation of values
+enum class PhysicalType : uint8_t {
+   Bool,
+   Int32,
+   Int64,
+   Int128,
+   String
+};
+//---------------------------------------------------------------------------
+/// The type of values within the execution engine. Derived from the SQL types, but
+/// decimals carry the scale that the computation actually produces
+class ValueType {
+   public:
+   /// Known kinds
+   enum Kind : uint8_t {
+      Null,
+      Bool,
+      Integer,
+      Decimal,
+      Date,
+      Interval,
+      String
+   };
+   /// The largest decimal scale. Results with larger scales are rounded
+   static constexpr unsigned maxScale = 18;
+
+   private:
+   /// The kind
+   Kind kind;
+   /// The decimal scale
+   uint8_t scale;
+   /// Nullable?
+   bool nullable;
+
+   public:
+   /// Constructor
+   constexpr ValueType(Kind kind = Null, unsigned scale = 0, bool nullable = false) : kind(kind), scale(scale), nullable(nullable || (kind == Null)) {}
+
+   /// Derive the value type of an SQL type
+   static ValueType fromType(Type type);
+
+   /// Get the kind
+   constexpr Kind getKind() const { return kind; }
+   /// Get the decimal scale
+   constexpr unsigned getScale() const { return scale; }
+   /// Is the type nullable?
+   constexpr bool isNullable() const { return nullable; }
+   /// Change the nullability
+   constexpr ValueType withNullable(bool n) const { return ValueType(kind, scale, n); }
+   /// Is the type numeric?
+   constexpr bool isNumeric() const { return (kind == Integer) || (kind == Decimal); }
+   /// Get the physical representation
+   PhysicalType getPhysicalType() const;
+   /// Get the size of a value in bytes
+   unsigned getWidth() const;
+   /// Get the name (for error reporting)
+   std::string getName() const;
+
+   /// Comparison, ignoring the nullability
+   constexpr bool sameValues(const ValueType& o) const { return (kind == o.kind) && (scale == o.scale); }
+   /// Comparison
+   constexpr bool operator==(const ValueType& o) const { return (kind == o.kind) && (scale == o.scale) && (nullable == o.nullable); }
+
+   /// Find the type that two types are converted to in comparisons. Throws if the types are not comparable
+   static ValueType unify(ValueType a, ValueType b);
+};
+//---------------------------------------------------------------------------
+/// A single value. Used for constants and for row wise processing
+struct Value {
+   /// The numeric representation of booleans, integers, decimals, dates, and intervals
+   Int128 number = 0;
+   /// The string representation
+   std::string_view str;
+   /// NULL?
+   bool null = true;
+
+   /// Create a NULL value
+   static Value makeNull() { return Value(); }
+   /// Create a numeric value
+   static Value makeNumber(Int128 number) { return Value{number, {}, false}; }
+   /// Create a string value
+   static Value makeString(std::string_view str) { return Value{0, str, false}; }
+};
+//---------------------------------------------------------------------------
+/// Call a function with a null pointer to the C++ type that represents a physical type
+template <class F>
+decltype(auto) dispatch(PhysicalType type, F&& f) {
+   switch (type) {
+      case PhysicalType::Bool: return f(static_cast<uint8_t*>(nullptr));
+      case PhysicalType::Int32: return f(static_cast<int32_t*>(nullptr));
+      case PhysicalType::Int64: return f(static_cast<int64_t*>(nullptr));
+      case PhysicalType::Int128: return f(static_cast<Int128*>(nullptr));
+      case PhysicalType::String: return f(static_cast<std::string_view*>(nullptr));
+   }
+   __builtin_unreachable();
+}
+//---------------------------------------------------------------------------
+/// Helper functions for values
+namespace values {
+/// Report a result that does not fit into its type
+[[noreturn]] void overflow();
+/// Add, throws on overflow
+template <class T>
+T checkedAdd(T a, T b) {
+   T result;
+   if (__builtin_add_overflow(a, b, &result)) [[unlikely]] overflow();
+   return result;
+}
+/// Subtract, throws on overflow
+template <class T>
+T checkedSub(T a, T b) {
+   T result;
+   if (__builtin_sub_overflow(a, b, &result)) [[unlikely]] overflow();
+   return result;
+}
+/// Multiply, throws on overflow
+template <class T>
+T checkedMul(T a, T b) {
+   T result;
+   if (__builtin_mul_overflow(a, b, &result)) [[unlikely]] overflow();
+   return result;
+}
+/// Convert a number into an integer, throws on overflow
+inline int64_t checkedInteger(Int128 value) {
+   if ((value < std::numeric_limits<int64_t>::min()) || (value > std::numeric_limits<int64_t>::max())) [[unlikely]] overflow();
+   return static_cast<int64_t>(value);
+}
+/// Round a floating point number into a number, throws on overflow
+Int128 checkedRound(double value);
+/// Get a power of ten
+Int128 pow10(unsigned exponent);
+/// Change the scale of a decimal, rounding half away from zero
+Int128 rescale(Int128 value, unsigned from, unsigned to);
+/// Divide, rounding half away from zero
+Int128 divideRounded(Int128 a, Int128 b);
+/// Convert a date into the number of days since 1970-01-01
+int32_t makeDate(int year, unsigned month, unsigned day);
+/// Split a date into year, month, and day
+void splitDate(int32_t date, int& year, unsigned& month, unsigned& day);
+/// Create an interval from months and days
+inline int64_t makeInterval(int32_t months, int32_t days) { return (static_cast<int64_t>(months) << 32) | static_cast<uint32_t>(days); }
+/// Get the months of an interval
+inline int32_t getMonths(int64_t interval) { return static_cast<int32_t>(interval >> 32); }
+/// Get the days of an interval
+inline int32_t getDays(int64_t interval) { return static_cast<int32_t>(interval); }
+/// Add an interval to a date
+int32_t addInterval(int32_t date, int64_t interval);
+
+/// Parse the text form of a value. Throws on malformed values
+Value parse(ValueType type, std::string_view text);
+/// Parse the text form of a value. Returns false on malformed values
+bool tryParse(ValueType type, std::string_view text, Value& result);
+/// Format a value in its text form
+void format(std::string& out, ValueType type, const Value& value);
+/// Format a value in its text form
+std::string format(ValueType type, const Value& value);
+/// Compare two non-NULL values of the same type
+int compare(ValueType type, const Value& a, const Value& b);
+/// Hash a string
+uint64_t hashString(std::string_view str);
+/// Hash a number
+inline uint64_t hashNumber(Int128 number) {
+   uint64_t low = static_cast<uint64_t>(number), high = static_cast<uint64_t>(static_cast<unsigned __int128>(number) >> 64);
+   unsigned __int128 product = static_cast<unsigned __int128>(low ^ 0x9E3779B97F4A7C15ull) * (high ^ 0xC2B2AE3D27D4EB4Full);
+   return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+}
+/// Combine two hash values
+inline uint64_t combineHashes(uint64_t a, uint64_t b) { return (a ^ (b + 0x9E3779B97F4A7C15ull + (a << 6) + (a >> 2))); }
+/// Hash a non-NULL value
+inline uint64_t hash(ValueType type, const Value& value) { return (type.getKind() == ValueType::String) ? hashString(value.str) : hashNumber(value.number); }
+/// The hash of NULL values
+constexpr uint64_t nullHash = 0x5BD1E9955BD1E995ull;
+}
+//---------------------------------------------------------------------------
+}
+}
+//---------------------------------------------------------------------------
+#endif
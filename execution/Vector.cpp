@@ -0,0 +1,245 @@
+#include "execution/Vector.hpp"
+#include <algorithm>
+#include <cstring>
+//---------------------------------------------------------------------------
+// (c) 2023 Thomas Neumann
+//---------------------------------------------------------------------------
+using namespace std;
+//---------------------------------------------------------------------------
+namespace saneql::execution {
+//---------------------------------------------------------------------------
+char* StringHeap::allocate(size_t len)
+// Allocate space for a string
+{
+   if (len > remaining) {
+      size_t size = max(len, chunkSize);
+      chunks.push_back(make_unique<char[]>(size));
+      pos = chunks.back().get();
+      remaining = size;
+   }
+   char* result = pos;
+   pos += len;
+   remaining -= len;
+   return result;
+}
+//---------------------------------------------------------------------------
+string_view StringHeap::add(string_view str)
+// Copy a string into the heap
+{
+   if (str.empty()) return {};
+   char* result = allocate(str.size());
+   memcpy(result, str.data(), str.size());
+   return {result, str.size()};
+}
+//---------------------------------------------------------------------------
+void StringHeap::clear()
+// Release all strings
+{
+   // Keep the first chunk for reuse
+   if (chunks.empty()) return;
+   chunks.resize(1);
+   pos = chunks.front().get();
+   remaining = chunkSize;
+}
+//---------------------------------------------------------------------------
+void Vector::setType(ValueType newType)
+// Change the type
+{
+   type = newType;
+   data = nullptr;
+   nulls = nullptr;
+   valueBuffer.reset();
+   capacity = 0;
+}
+//---------------------------------------------------------------------------
+void Vector::allocate(unsigned count, bool withNulls)
+// Prepare the owned buffers for a number of values
+{
+   if ((count > capacity) || (!valueBuffer)) {
+      capacity = max(count, capacity);
+      valueBuffer = make_unique<std::byte[]>(static_cast<size_t>(capacity) * type.getWidth());
+      nullBuffer.reset();
+   }
+   data = valueBuffer.get();
+   if (withNulls) {
+      if (!nullBuffer) nullBuffer = make_unique<uint8_t[]>(capacity);
+      nulls = nullBuffer.get();
+   } else {
+      nulls = nullptr;
+   }
+   if (heap) heap->clear();
+}
+//---------------------------------------------------------------------------
+void Vector::reference(const Vector& other)
+// Reference the values of another vector
+{
+   type = other.type;
+   data = other.data;
+   nulls = other.nulls;
+}
+//---------------------------------------------------------------------------
+void Vector::reference(const void* values, const uint8_t* nullFlags)
+// Reference external values
+{
+   data = const_cast<void*>(values);
+   nulls = const_cast<uint8_t*>(nullFlags);
+}
+//---------------------------------------------------------------------------
+StringHeap& Vector::accessHeap()
+// Access the string heap for computed strings
+{
+   if (!heap) heap = make_unique<StringHeap>();
+   return *heap;
+}
+//---------------------------------------------------------------------------
+Value Vector::get(unsigned row) const
+// Get a value
+{
+   if (isNull(row)) return Value::makeNull();
+   return dispatch(type.getPhysicalType(), [&]<class T>(T*) {
+      if constexpr (is_same_v<T, string_view>)
+         return Value::makeString(getData<string_view>()[row]);
+      else
+         return Value::makeNumber(getData<T>()[row]);
+   });
+}
+//---------------------------------------------------------------------------
+void Vector::set(unsigned row, const Value& value)
+// Set a value
+{
+   // NULL entries hold a valid value, too. Computations do not have to check for NULL
+   if (nulls) nulls[row] = value.null;
+   dispatch(type.getPhysicalType(), [&]<class T>(T*) {
+      if (value.null)
+         getData<T>()[row] = T();
+      else if constexpr (is_same_v<T, string_view>)
+         getData<string_view>()[row] = value.str;
+      else
+         getData<T>()[row] = static_cast<T>(value.number);
+   });
+}
+//---------------------------------------------------------------------------
+void Vector::gather(const Vector& source, const uint32_t* rows, unsigned count)
+// Copy the selected values of another vector
+{
+   allocate(count, source.nulls);
+   dispatch(type.getPhysicalType(), [&]<class T>(T*) {
+      auto in = source.getData<T>();
+      auto out = getData<T>();
+      for (unsigned index = 0; index != count; ++index)
+         out[index] = in[rows[index]];
+   });
+   if (source.nulls)
+      for (unsigned index = 0; index != count; ++index)
+         nulls[index] = source.nulls[rows[index]];
+}
+//---------------------------------------------------------------------------
+void Vector::copy(unsigned to, const Vector& source, unsigned from, unsigned count, StringHeap* strings)
+// Copy a range of values of another vector
+{
+   if (type.getPhysicalType() == PhysicalType::String) {
+      auto in = source.getData<string_view>() + from;
+      auto out = getData<string_view>() + to;
+      for (unsigned index = 0; index != count; ++index)
+         out[index] = strings ? strings->add(in[index]) : in[index];
+   } else {
+      unsigned width = type.getWidth();
+      memcpy(static_cast<std::byte*>(data) + static_cast<size_t>(to) * width, static_cast<const std::byte*>(source.data) + static_cast<size_t>(from) * width, static_cast<size_t>(count) * width);
+   }
+   if (nulls) {
+      if (source.nulls)
+         memcpy(nulls + to, source.nulls + from, count);
+      else
+         memset(nulls + to, 0, count);
+   }
+}
+//---------------------------------------------------------------------------
+Batch::Batch(const vector<ValueType>& types)
+// Constructor
+{
+   columns.reserve(types.size());
+   for (auto t : types)
+      columns.emplace_back(t);
+}
+//---------------------------------------------------------------------------
+Relation::Relation(vector<ValueType> types)
+   : types(move(types))
+// Constructor
+{
+}
+//---------------------------------------------------------------------------
+Batch& Relation::addChunk()
+// Add an empty chunk
+{
+   auto chunk = make_unique<Batch>(types);
+   for (auto& c : chunk->columns)
+      c.allocate(Batch::maxSize, c.getType().isNullable());
+   chunks.push_back(move(chunk));
+   return *chunks.back();
+}
+//---------------------------------------------------------------------------
+void Relation::append(const Batch& batch)
+// Append all rows of a batch
+{
+   for (unsigned done = 0; done < batch.size;) {
+      Batch& chunk = ((!chunks.empty()) && (chunks.back()->size < Batch::maxSize)) ? *chunks.back() : addChunk();
+      unsigned count = min(batch.size - done, Batch::maxSize - chunk.size);
+      for (unsigned index = 0; index != types.size(); ++index)
+         chunk.columns[index].copy(chunk.size, batch.columns[index], done, count, &strings);
+      chunk.size += count;
+      done += count;
+   }
+   size += batch.size;
+}
+//---------------------------------------------------------------------------
+void Relation::append(const Batch& batch, const uint32_t* rows, unsigned count)
+// Append selected rows of a batch
+{
+   for (unsigned index = 0; index != count; ++index) {
+      Batch& chunk = ((!chunks.empty()) && (chunks.back()->size < Batch::maxSize)) ? *chunks.back() : addChunk();
+      for (unsigned column = 0; column != types.size(); ++column)
+         chunk.columns[column].copy(chunk.size, batch.columns[column], rows[index], 1, &strings);
+      ++chunk.size;
+   }
+   size += count;
+}
+//---------------------------------------------------------------------------
+void Relation::append(const vector<Value>& row)
+// Append a row of values
+{
+   Batch& chunk = ((!chunks.empty()) && (chunks.back()->size < Batch::maxSize)) ? *chunks.back() : addChunk();
+   for (unsigned index = 0; index != types.size(); ++index) {
+      Value v = row[index];
+      if ((!v.null) && (types[index].getKind() == ValueType::String)) v.str = strings.add(v.str);
+      chunk.columns[index].set(chunk.size, v);
+   }
+   ++chunk.size;
+   ++size;
+}
+//---------------------------------------------------------------------------
+void Relation::clear()
+// Remove all rows
+{
+   chunks.clear();
+   strings.clear();
+   size = 0;
+}
+//---------------------------------------------------------------------------
+void Relation::gather(unsigned column, const uint64_t* rows, unsigned count, Vector& target) const
+// Copy the values of a column for a list of rows into a vector
+{
+   target.allocate(count, types[column].isNullable());
+   dispatch(types[column].getPhysicalType(), [&]<class T>(T*) {
+      auto out = target.getData<T>();
+      for (unsigned index = 0; index != count; ++index) {
+         auto& source = chunks[rows[index] / Batch::maxSize]->columns[column];
+         out[index] = source.getData<T>()[rows[index] % Batch::maxSize];
+      }
+   });
+   if (auto nulls = target.getNulls())
+      for (unsigned index = 0; index != count; ++index)
+         nulls[index] = chunks[rows[index] / Batch::maxSize]->columns[column].isNull(rows[index] % Batch::maxSize);
+}
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
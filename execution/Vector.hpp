@@ -0,0 +1,159 @@
+#ifndef H_saneql_execution_Vector
+#define H_saneql_execution_Vector
+//---------------------------------------------------------------------------
+#include "execution/Value.hpp"
+#include <memory>
+#include <string_view>
+#include <vector>
+//---------------------------------------------------------------------------
+// SaneQL
+// (c) 2023 Thomas Neumann
+// SPDX-License-Identifier: BSD-3-Clause
+//---------------------------------------------------------------------------
+namespace saneql {
+//---------------------------------------------------------------------------
+namespace execution {
+//---------------------------------------------------------------------------
+/// Storage for string contents
+class StringHeap {
+   /// The chunk size
+   static constexpr size_t chunkSize = 64 * 1024;
+
+   /// The chunks
+   std::vector<std::unique_ptr<char[]>> chunks;
+   /// The free space in the current chunk
+   char* pos = nullptr;
+   /// The remaining space in the current chunk
+   size_t remaining = 0;
+
+   public:
+   /// Allocate space for a string
+   char* allocate(size_t len);
+   /// Copy a string into the heap
+   std::string_view add(std::string_view str);
+   /// Release all strings
+   void clear();
+};
+//---------------------------------------------------------------------------
+/// A column of values within a batch. Either owns its values or references the values of
+/// another vector or of a table. NULL flags are stored as one byte per value, a vector
+/// without NULL flags contains no NULL values. The values of NULL entries are valid but
+/// arbitrary, for strings they are empty
+class Vector {
+   /// The type
+   ValueType type;
+   /// The values
+   void* data = nullptr;
+   /// The NULL flags (if any)
+   uint8_t* nulls = nullptr;
+   /// The owned values
+   std::unique_ptr<std::byte[]> valueBuffer;
+   /// The owned NULL flags
+   std::unique_ptr<uint8_t[]> nullBuffer;
+   /// The capacity of the owned buffers
+   unsigned capacity = 0;
+   /// The strings that were computed for the vector
+   std::unique_ptr<StringHeap> heap;
+
+   public:
+   /// Constructor
+   explicit Vector(ValueType type = ValueType()) : type(type) {}
+   /// Move constructor
+   Vector(Vector&&) = default;
+   /// Move assignment
+   Vector& operator=(Vector&&) = default;
+
+   /// Get the type
+   ValueType getType() const { return type; }
+   /// Change the type. Releases the owned values
+   void setType(ValueType newType);
+
+   /// Prepare the owned buffers for a number of values. Allocates NULL flags if requested
+   void allocate(unsigned count, bool withNulls);
+   /// Reference the values of another vector
+   void reference(const Vector& other);
+   /// Reference external values
+   void reference(const void* values, const uint8_t* nullFlags);
+
+   /// Access the values
+   template <class T>
+   T* getData() const { return static_cast<T*>(data); }
+   /// Access the NULL flags. nullptr if there are no NULL values
+   uint8_t* getNulls() const { return nulls; }
+   /// Is a value NULL?
+   bool isNull(unsigned row) const { return nulls && nulls[row]; }
+   /// Access the string heap for computed strings
+   StringHeap& accessHeap();
+
+   /// Get a value
+   Value get(unsigned row) const;
+   /// Set a value. NULL values require NULL flags
+   void set(unsigned row, const Value& value);
+   /// Copy the selected values of another vector of the same type into the owned buffers
+   void gather(const Vector& source, const uint32_t* rows, unsigned count);
+   /// Copy a range of values of another vector of the same type. The buffers must be allocated
+   void copy(unsigned to, const Vector& source, unsigned from, unsigned count, StringHeap* strings);
+};
+//---------------------------------------------------------------------------
+/// A batch of rows that is processed at once
+class Batch {
+   public:
+   /// The maximum number of rows
+   static constexpr unsigned maxSize = 1024;
+
+   /// The columns
+   std::vector<Vector> columns;
+   /// The number of rows
+   unsigned size = 0;
+
+   /// Constructor
+   Batch() = default;
+   /// Constructor
+   explicit Batch(const std::vector<ValueType>& types);
+};
+//---------------------------------------------------------------------------
+/// A materialized relation. Stores the rows as sequence of full batches that own their values
+class Relation {
+   /// The column types
+   std::vector<ValueType> types;
+   /// The chunks
+   std::vector<std::unique_ptr<Batch>> chunks;
+   /// The string contents
+   StringHeap strings;
+   /// The number of rows
+   uint64_t size = 0;
+
+   /// Add an empty chunk
+   Batch& addChunk();
+
+   public:
+   /// Constructor
+   explicit Relation(std::vector<ValueType> types);
+
+   /// Get the column types
+   const std::vector<ValueType>& getTypes() const { return types; }
+   /// Get the number of rows
+   uint64_t getSize() const { return size; }
+   /// Get the chunks
+   const std::vector<std::unique_ptr<Batch>>& getChunks() const { return chunks; }
+
+   /// Append all rows of a batch
+   void append(const Batch& batch);
+   /// Append selected rows of a batch
+   void append(const Batch& batch, const uint32_t* rows, unsigned count);
+   /// Append a row of values
+   void append(const std::vector<Value>& row);
+   /// Remove all rows
+   void clear();
+   /// Copy the values of a column for a list of rows into a vector
+   void gather(unsigned column, const uint64_t* rows, unsigned count, Vector& target) const;
+   /// Get a value
+   Value get(unsigned column, uint64_t row) const { return chunks[row / Batch::maxSize]->columns[column].get(row % Batch::maxSize); }
+   /// Get a column vector for a row
+   const Vector& getColumn(unsigned column, uint64_t row) const { return chunks[row / Batch::maxSize]->columns[column]; }
+};
+//---------------------------------------------------------------------------
+}
+}
+//---------------------------------------------------------------------------
+#endif
@@ -1,4 +1,17 @@
 #include "infra/Schema.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 //---------------------------------------------------------------------------
 // (c) 2023 Thomas Neumann
 //---------------------------------------------------------------------------
@@ -6,6 +19,149 @@ using namespace std;
 //---------------------------------------------------------------------------
 namespace saneql {
 //---------------------------------------------------------------------------
+/// The first line of a statistics file
+static constexpr string_view statisticsHeader = "saneql-statistics 1";
+/// The magic bytes at the start of a snapshot
+static constexpr string_view snapshotMagic = "SQLSNAP2";
+//---------------------------------------------------------------------------
+static optional<double> parseNumber(string_view str)
+// Parse a number, requiring the whole string to be consumed
+{
+   double result;
+   auto [ptr, ec] = from_chars(str.data(), str.data() + str.size(), result);
+   if ((ec != errc()) || (ptr != str.data() + str.size())) return {};
+   return result;
+}
+//---------------------------------------------------------------------------
+static optional<double> parseDate(string_view str)
+// Parse a date in the form YYYY-MM-DD into the number of days since 1970-01-01
+{
+   int year, month, day;
+   auto parse = [&](unsigned from, unsigned len, int& value) {
+      if (str.size() < from + len) return false;
+      auto [ptr, ec] = from_chars(str.data() + from, str.data() + from + len, value);
+      return (ec == errc()) && (ptr == str.data() + from + len);
+   };
+   if ((str.size() != 10) || (str[4] != '-') || (str[7] != '-') || (!parse(0, 4, year)) || (!parse(5, 2, month)) || (!parse(8, 2, day))) return {};
+
+   // The days from civil algorithm by Howard Hinnant
+   year -= month <= 2;
+   int era = (year >= 0 ? year : year - 399) / 400;
+   unsigned yoe = year - era * 400;
+   unsigned doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+   unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+   return era * 146097 + static_cast<int>(doe) - 719468;
+}
+//---------------------------------------------------------------------------
+static string formatNumber(double value)
+// Format a number such that it can be read back without loss
+{
+   char buffer[64];
+   auto [ptr, ec] = to_chars(buffer, buffer + sizeof(buffer), value);
+   return string(buffer, ptr);
+}
+//---------------------------------------------------------------------------
+static void writeValue(ostream& out, const optional<string>& value)
+// Write a value of a statistics file. Missing values are written as \N
+{
+   out << '\t';
+   if (!value) {
+      out << "\\N";
+      return;
+   }
+   for (char c : *value) {
+      switch (c) {
+         case '\t': out << "\\t"; break;
+         case '\n': out << "\\n"; break;
+         case '\\': out << "\\\\"; break;
+         default: out << c; break;
+      }
+   }
+}
+//---------------------------------------------------------------------------
+static optional<string> readValue(string_view field)
+// Read a value of a statistics file
+{
+   if (field == "\\N") return {};
+   string result;
+   for (size_t index = 0; index != field.size(); ++index) {
+      char c = field[index];
+      if ((c == '\\') && (index + 1 < field.size())) {
+         c = field[++index];
+         if (c == 't') c = '\t';
+         if (c == 'n') c = '\n';
+      }
+      result += c;
+   }
+   return result;
+}
+//---------------------------------------------------------------------------
+namespace {
+//---------------------------------------------------------------------------
+/// A token of SQL DDL
+struct DDLToken {
+   /// The text. Unquoted identifiers and keywords are lower case
+   string text;
+   /// The line
+   unsigned line;
+   /// Quoted identifier or string literal?
+   bool quoted;
+
+   /// Check for a keyword or punctuation
+   bool is(string_view str) const { return (!quoted) && (text == str); }
+};
+//---------------------------------------------------------------------------
+static vector<DDLToken> tokenizeDDL(string_view ddl)
+// Split SQL DDL into tokens. Skips comments
+{
+   vector<DDLToken> result;
+   unsigned line = 1;
+   for (size_t index = 0; index < ddl.size();) {
+      char c = ddl[index];
+      if (c == '\n') {
+         ++line;
+         ++index;
+      } else if (isspace(static_cast<unsigned char>(c))) {
+         ++index;
+      } else if (ddl.substr(index, 2) == "--") {
+         index = ddl.find('\n', index);
+      } else if (ddl.substr(index, 2) == "/*") {
+         size_t end = ddl.find("*/", index + 2);
+         line += count(ddl.begin() + index, (end == string_view::npos) ? ddl.end() : (ddl.begin() + end), '\n');
+         index = (end == string_view::npos) ? end : (end + 2);
+      } else if ((c == '"') || (c == '\'')) {
+         // Quoted identifier or string literal, doubled quotes escape the quote
+         string text;
+         unsigned startLine = line;
+         for (++index;; ++index) {
+            if (index >= ddl.size()) throw runtime_error("schema line " + to_string(startLine) + ": unterminated quote");
+            if (ddl[index] == c) {
+               if ((index + 1 < ddl.size()) && (ddl[index + 1] == c)) {
+                  ++index;
+               } else {
+                  ++index;
+                  break;
+               }
+            }
+            if (ddl[index] == '\n') ++line;
+            text += ddl[index];
+         }
+         result.push_back({move(text), startLine, true});
+      } else if (isalnum(static_cast<unsigned char>(c)) || (c == '_')) {
+         string text;
+         for (; (index < ddl.size()) && (isalnum(static_cast<unsigned char>(ddl[index])) || (ddl[index] == '_') || (ddl[index] == '$')); ++index)
+            text += tolower(static_cast<unsigned char>(ddl[index]));
+         result.push_back({move(text), line, false});
+      } else {
+         result.push_back({string(1, c), line, false});
+         ++index;
+      }
+   }
+   return result;
+}
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
 string Type::getName() const
 // Get the name (for error reporting)
 {
@@ -23,24 +179,447 @@ string Type::getName() const
    __builtin_unreachable();
 }
 //---------------------------------------------------------------------------
-void Schema::createTable(std::string name, std::initializer_list<Column> columns)
+/// A memory mapped schema snapshot. The layout in native byte order is
+///   header:  magic (8 bytes), schema version (8 bytes), table count n (8 bytes)
+///   index:   n entries of (name offset, name length, data offset, data length), 8 bytes each, sorted by name
+///   data:    the table names and the serialized table definitions
+class Schema::Snapshot : public Provider {
+   public:
+   /// The size of the header
+   static constexpr uint64_t headerSize = 24;
+   /// The size of an index entry
+   static constexpr uint64_t entrySize = 32;
+
+   private:
+   /// The mapped file
+   const char* data;
+   /// The size of the file
+   uint64_t size;
+
+   /// Read a number from the mapped file
+   uint64_t readWord(uint64_t offset) const {
+      uint64_t result;
+      memcpy(&result, data + offset, sizeof(result));
+      return result;
+   }
+   /// Report a corrupt snapshot
+   [[noreturn]] static void reportCorrupt() { throw runtime_error("corrupt schema snapshot"); }
+   /// Get a slice of the file
+   string_view getSlice(uint64_t offset, uint64_t length) const {
+      if ((offset > size) || (length > size - offset)) reportCorrupt();
+      return string_view(data + offset, length);
+   }
+
+   public:
+   /// Constructor
+   Snapshot(const char* data, uint64_t size) : data(data), size(size) {
+      if ((size < headerSize) || (string_view(data, snapshotMagic.size()) != snapshotMagic) || (getTableCount() > (size - headerSize) / entrySize)) reportCorrupt();
+   }
+   /// Destructor
+   ~Snapshot() { munmap(const_cast<char*>(data), size); }
+
+   /// Get the number of tables
+   uint64_t getTableCount() const { return readWord(16); }
+   /// Get the name of a table
+   string_view getName(uint64_t index) const { return getSlice(readWord(headerSize + index * entrySize), readWord(headerSize + index * entrySize + 8)); }
+
+   /// Load a table
+   optional<Table> loadTable(string_view name) const override;
+   /// Get the names of all tables
+   vector<string> getTableNames() const override;
+   /// Get the catalog version
+   uint64_t getVersion() const override { return readWord(8); }
+
+   /// Map a snapshot file
+   static unique_ptr<Snapshot> map(const string& file);
+   /// Serialize a table definition
+   static void writeTable(string& out, const Table& table);
+   /// Deserialize a table definition
+   static Table readTable(string_view in);
+};
+//---------------------------------------------------------------------------
+optional<Schema::Table> Schema::Snapshot::loadTable(string_view name) const
+// Load a table
+{
+   uint64_t lower = 0, upper = getTableCount();
+   while (lower < upper) {
+      uint64_t middle = lower + (upper - lower) / 2;
+      auto n = getName(middle);
+      if (n < name) {
+         lower = middle + 1;
+      } else if (n > name) {
+         upper = middle;
+      } else {
+         uint64_t entry = headerSize + middle * entrySize;
+         return readTable(getSlice(readWord(entry + 16), readWord(entry + 24)));
+      }
+   }
+   return {};
+}
+//---------------------------------------------------------------------------
+vector<string> Schema::Snapshot::getTableNames() const
+// Get the names of all tables
+{
+   vector<string> result;
+   for (uint64_t index = 0, count = getTableCount(); index != count; ++index)
+      result.emplace_back(getName(index));
+   return result;
+}
+//---------------------------------------------------------------------------
+unique_ptr<Schema::Snapshot> Schema::Snapshot::map(const string& file)
+// Map a snapshot file
+{
+   int fd = open(file.c_str(), O_RDONLY);
+   if (fd < 0) throw runtime_error("unable to read " + file);
+   struct stat info;
+   if (fstat(fd, &info) < 0) {
+      close(fd);
+      throw runtime_error("unable to read " + file);
+   }
+   uint64_t size = info.st_size;
+   void* data = size ? mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+   close(fd);
+   if (data == MAP_FAILED) throw runtime_error("unable to map " + file);
+   try {
+      return make_unique<Snapshot>(static_cast<const char*>(data), size);
+   } catch (...) {
+      munmap(data, size);
+      throw;
+   }
+}
+//---------------------------------------------------------------------------
+void Schema::Snapshot::writeTable(string& out, const Table& table)
+// Serialize a table definition
+{
+   auto writeWord = [&](uint64_t value) { out.append(reinterpret_cast<const char*>(&value), sizeof(value)); };
+   auto writeDouble = [&](double value) { out.append(reinterpret_cast<const char*>(&value), sizeof(value)); };
+   auto writeString = [&](string_view str) {
+      writeWord(str.size());
+      out.append(str);
+   };
+
+   writeWord(table.cardinality);
+   writeWord(table.columns.size());
+   for (auto& c : table.columns) {
+      writeString(c.name);
+      writeWord(c.type.getType());
+      writeWord(c.type.getModifier());
+      auto& stats = c.statistics;
+      writeDouble(stats.distinctValues);
+      writeDouble(stats.nullFraction);
+      writeWord((stats.min ? 1 : 0) | (stats.max ? 2 : 0));
+      if (stats.min) writeString(*stats.min);
+      if (stats.max) writeString(*stats.max);
+      writeWord(stats.histogram.size());
+      for (auto& v : stats.histogram)
+         writeString(v);
+   }
+   auto writeColumns = [&](const vector<unsigned>& columns) {
+      writeWord(columns.size());
+      for (auto c : columns)
+         writeWord(c);
+   };
+   writeColumns(table.primaryKey);
+   writeWord(table.uniqueKeys.size());
+   for (auto& k : table.uniqueKeys)
+      writeColumns(k);
+   writeWord(table.foreignKeys.size());
+   for (auto& f : table.foreignKeys) {
+      writeColumns(f.columns);
+      writeString(f.table);
+      writeWord(f.referencedColumns.size());
+      for (auto& c : f.referencedColumns)
+         writeString(c);
+   }
+}
+//---------------------------------------------------------------------------
+Schema::Table Schema::Snapshot::readTable(string_view in)
+// Deserialize a table definition
+{
+   auto readWord = [&]() {
+      if (in.size() < sizeof(uint64_t)) reportCorrupt();
+      uint64_t result;
+      memcpy(&result, in.data(), sizeof(result));
+      in.remove_prefix(sizeof(result));
+      return result;
+   };
+   auto readDouble = [&]() {
+      uint64_t bits = readWord();
+      double result;
+      memcpy(&result, &bits, sizeof(result));
+      return result;
+   };
+   auto readString = [&]() {
+      uint64_t length = readWord();
+      if (length > in.size()) reportCorrupt();
+      string result(in.substr(0, length));
+      in.remove_prefix(length);
+      return result;
+   };
+
+   Table result;
+   result.cardinality = readWord();
+   uint64_t columnCount = readWord();
+   if (columnCount > in.size()) reportCorrupt();
+   result.columns.reserve(columnCount);
+   for (uint64_t index = 0; index != columnCount; ++index) {
+      auto& c = result.columns.emplace_back(Column{readString(), Type::getUnknown()});
+      uint64_t tag = readWord();
+      if (tag > Type::Interval) reportCorrupt();
+      c.type = Type::fromRaw(static_cast<Type::Tag>(tag), readWord());
+      auto& stats = c.statistics;
+      stats.distinctValues = readDouble();
+      stats.nullFraction = readDouble();
+      uint64_t flags = readWord();
+      if (flags & 1) stats.min = readString();
+      if (flags & 2) stats.max = readString();
+      uint64_t histogramSize = readWord();
+      if (histogramSize > in.size()) reportCorrupt();
+      for (uint64_t bound = 0; bound != histogramSize; ++bound)
+         stats.histogram.push_back(readString());
+   }
+   auto readColumns = [&]() {
+      uint64_t count = readWord();
+      if (count > in.size()) reportCorrupt();
+      vector<unsigned> columns;
+      for (uint64_t index = 0; index != count; ++index) {
+         uint64_t column = readWord();
+         if (column >= columnCount) reportCorrupt();
+         columns.push_back(column);
+      }
+      return columns;
+   };
+   result.primaryKey = readColumns();
+   uint64_t uniqueCount = readWord();
+   if (uniqueCount > in.size()) reportCorrupt();
+   for (uint64_t index = 0; index != uniqueCount; ++index)
+      result.uniqueKeys.push_back(readColumns());
+   uint64_t foreignCount = readWord();
+   if (foreignCount > in.size()) reportCorrupt();
+   for (uint64_t index = 0; index != foreignCount; ++index) {
+      auto& f = result.foreignKeys.emplace_back();
+      f.columns = readColumns();
+      f.table = readString();
+      uint64_t referencedCount = readWord();
+      if (referencedCount > in.size()) reportCorrupt();
+      for (uint64_t column = 0; column != referencedCount; ++column)
+         f.referencedColumns.push_back(readString());
+   }
+   return result;
+}
+//---------------------------------------------------------------------------
+Schema::Schema()
+// Constructor
+{
+}
+//---------------------------------------------------------------------------
+Schema::~Schema()
+// Destructor
+{
+}
+//---------------------------------------------------------------------------
+Schema::Provider::~Provider()
+// Destructor
+{
+}
+//---------------------------------------------------------------------------
+optional<double> Schema::ColumnStatistics::toNumber(Type type, string_view value)
+// Convert a value into a number that preserves the value order
+{
+   switch (type.getType()) {
+      case Type::Bool:
+         if (value == "true") return 1;
+         if (value == "false") return 0;
+         return {};
+      case Type::Integer:
+      case Type::Decimal: return parseNumber(value);
+      case Type::Date: return parseDate(value);
+      default: return {};
+   }
+}
+//---------------------------------------------------------------------------
+bool Schema::ColumnStatistics::less(Type type, string_view a, string_view b)
+// Compare two values of a type
+{
+   auto na = toNumber(type, a), nb = toNumber(type, b);
+   if (na && nb) return *na < *nb;
+   return a < b;
+}
+//---------------------------------------------------------------------------
+optional<double> Schema::ColumnStatistics::estimateLess(Type type, string_view value) const
+// Estimate the fraction of non-NULL values that are less than a value
+{
+   // The fraction of a range [lower, upper] that is below the value. Assumes uniformly distributed values
+   auto interpolate = [&](string_view lower, string_view upper) -> optional<double> {
+      auto l = toNumber(type, lower), u = toNumber(type, upper), v = toNumber(type, value);
+      if ((!l) || (!u) || (!v)) return {};
+      if (*u <= *l) return 0.5;
+      return clamp((*v - *l) / (*u - *l), 0.0, 1.0);
+   };
+
+   if (histogram.size() >= 2) {
+      auto iter = lower_bound(histogram.begin(), histogram.end(), value, [&](const string& a, string_view b) { return less(type, a, b); });
+      if (iter == histogram.begin()) return 0;
+      if (iter == histogram.end()) return 1;
+      double bucket = (iter - histogram.begin()) - 1;
+      return (bucket + interpolate(iter[-1], iter[0]).value_or(0.5)) / (histogram.size() - 1);
+   }
+   if (min && max) {
+      if (less(type, value, *min)) return 0;
+      if (!less(type, value, *max)) return 1;
+      return interpolate(*min, *max);
+   }
+   return {};
+}
+//---------------------------------------------------------------------------
+vector<vector<unsigned>> Schema::Table::getKeys() const
+// Get all unique keys, the primary key first
+{
+   vector<vector<unsigned>> result;
+   if (!primaryKey.empty()) result.push_back(primaryKey);
+   result.insert(result.end(), uniqueKeys.begin(), uniqueKeys.end());
+   return result;
+}
+//---------------------------------------------------------------------------
+optional<unsigned> Schema::Table::findColumn(string_view name) const
+// Find a column by name
+{
+   for (unsigned index = 0; index != columns.size(); ++index)
+      if (columns[index].name == name) return index;
+   return {};
+}
+//---------------------------------------------------------------------------
+vector<unsigned> Schema::Table::resolveReference(const ForeignKey& foreignKey) const
+// Get the positions of the columns referenced by a foreign key
+{
+   if (foreignKey.referencedColumns.empty()) return (primaryKey.size() == foreignKey.columns.size()) ? primaryKey : vector<unsigned>();
+   vector<unsigned> result;
+   for (auto& c : foreignKey.referencedColumns) {
+      auto pos = findColumn(c);
+      if (!pos) return {};
+      result.push_back(*pos);
+   }
+   return (result.size() == foreignKey.columns.size()) ? result : vector<unsigned>();
+}
+//---------------------------------------------------------------------------
+uint64_t Schema::hashTable(const string& name, const Table& table)
+// Compute the fingerprint of a table definition
+{
+   auto hashString = [](uint64_t hash, string_view str) {
+      for (char c : str) {
+         hash ^= static_cast<unsigned char>(c);
+         hash *= 0x100000001b3;
+      }
+      return (hash ^ 0xFF) * 0x100000001b3;
+   };
+   uint64_t hash = hashString(0xcbf29ce484222325, name);
+   for (auto& c : table.columns) {
+      hash = hashString(hash, c.name);
+      hash = hashString(hash, c.type.getName() + to_string(c.type.getLength()) + (c.type.isNullable() ? "?" : ""));
+   }
+   // The statistics influence the generated SQL, too
+   hash = hashString(hash, to_string(table.cardinality));
+   for (auto& c : table.columns) {
+      auto& stats = c.statistics;
+      hash = hashString(hash, formatNumber(stats.distinctValues) + " " + formatNumber(stats.nullFraction));
+      for (auto& v : {stats.min, stats.max})
+         hash = hashString(hash, v ? ("=" + *v) : "");
+      for (auto& v : stats.histogram)
+         hash = hashString(hash, v);
+   }
+   // And so do the keys
+   auto hashColumns = [&](const vector<unsigned>& columns) {
+      string str;
+      for (auto c : columns)
+         str += to_string(c) + ",";
+      hash = hashString(hash, str);
+   };
+   hashColumns(table.primaryKey);
+   for (auto& k : table.uniqueKeys)
+      hashColumns(k);
+   for (auto& f : table.foreignKeys) {
+      hashColumns(f.columns);
+      hash = hashString(hash, f.table);
+      for (auto& c : f.referencedColumns)
+         hash = hashString(hash, c);
+   }
+   return hash;
+}
+//---------------------------------------------------------------------------
+void Schema::createTable(string name, Table table)
 // Create a table
 {
-   auto& t = tables[name];
-   t.columns.assign(columns.begin(), columns.end());
+   if (auto old = lookupTable(name)) version -= hashTable(name, *old);
+   auto t = make_shared<Table>(move(table));
+   // Combine the tables in an order independent way
+   version += hashTable(name, *t);
+   tables[name] = move(t);
+}
+//---------------------------------------------------------------------------
+void Schema::createTable(string name, vector<Column> columns, uint64_t cardinality)
+// Create a table
+{
+   createTable(move(name), Table{move(columns), cardinality});
+}
+//---------------------------------------------------------------------------
+void Schema::modifyTable(const string& name, const function<void(Table&)>& modify)
+// Modify a copy of a table
+{
+   auto table = lookupTable(name);
+   if (!table) throw runtime_error("unknown table '" + name + "'");
+
+   // Modify a copy, the table might be in use by compiled queries. The copy overrides the provider
+   auto t = make_shared<Table>(*table);
+   modify(*t);
+   version -= hashTable(name, *table);
+   version += hashTable(name, *t);
+   tables[name] = move(t);
+}
+//---------------------------------------------------------------------------
+vector<unsigned> Schema::resolveColumns(const string& name, const Table& table, const vector<string>& columns)
+// Resolve column names into positions
+{
+   vector<unsigned> result;
+   for (auto& c : columns) {
+      auto pos = table.findColumn(c);
+      if (!pos) throw runtime_error("unknown column '" + c + "' in table '" + name + "'");
+      result.push_back(*pos);
+   }
+   return result;
 }
 //---------------------------------------------------------------------------
 void Schema::createTPCH()
 // Create the TPC-H schema for experiments
 {
-   createTable("part", {{"p_partkey", Type::getInteger()}, {"p_name", Type::getVarchar(55)}, {"p_mfgr", Type::getChar(25)}, {"p_brand", Type::getChar(10)}, {"p_type", Type::getVarchar(25)}, {"p_size", Type::getInteger()}, {"p_container", Type::getChar(10)}, {"p_retailprice", Type::getDecimal(12, 2)}, {"p_comment", Type::getVarchar(23)}});
-   createTable("region", {{"r_regionkey", Type::getInteger()}, {"r_name", Type::getChar(25)}, {"r_comment", Type::getVarchar(152)}});
-   createTable("nation", {{"n_nationkey", Type::getInteger()}, {"n_name", Type::getChar(25)}, {"n_regionkey", Type::getInteger()}, {"n_comment", Type::getVarchar(152)}});
-   createTable("supplier", {{"s_suppkey", Type::getInteger()}, {"s_name", Type::getChar(25)}, {"s_address", Type::getVarchar(40)}, {"s_nationkey", Type::getInteger()}, {"s_phone", Type::getChar(15)}, {"s_acctbal", Type::getDecimal(12, 2)}, {"s_comment", Type::getVarchar(101)}});
-   createTable("partsupp", {{"ps_partkey", Type::getInteger()}, {"ps_suppkey", Type::getInteger()}, {"ps_availqty", Type::getInteger()}, {"ps_supplycost", Type::getDecimal(12, 2)}, {"ps_comment", Type::getVarchar(199)}});
-   createTable("customer", {{"c_custkey", Type::getInteger()}, {"c_name", Type::getVarchar(25)}, {"c_address", Type::getVarchar(40)}, {"c_nationkey", Type::getInteger()}, {"c_phone", Type::getChar(15)}, {"c_acctbal", Type::getDecimal(12, 2)}, {"c_mktsegment", Type::getChar(10)}, {"c_comment", Type::getVarchar(117)}});
-   createTable("orders", {{"o_orderkey", Type::getInteger()}, {"o_custkey", Type::getInteger()}, {"o_orderstatus", Type::getChar(1)}, {"o_totalprice", Type::getDecimal(12, 2)}, {"o_orderdate", Type::getDate()}, {"o_orderpriority", Type::getChar(15)}, {"o_clerk", Type::getChar(15)}, {"o_shippriority", Type::getInteger()}, {"o_comment", Type::getVarchar(79)}});
-   createTable("lineitem", {{"l_orderkey", Type::getInteger()}, {"l_partkey", Type::getInteger()}, {"l_suppkey", Type::getInteger()}, {"l_linenumber", Type::getInteger()}, {"l_quantity", Type::getDecimal(12, 2)}, {"l_extendedprice", Type::getDecimal(12, 2)}, {"l_discount", Type::getDecimal(12, 2)}, {"l_tax", Type::getDecimal(12, 2)}, {"l_returnflag", Type::getChar(1)}, {"l_linestatus", Type::getChar(1)}, {"l_shipdate", Type::getDate()}, {"l_commitdate", Type::getDate()}, {"l_receiptdate", Type::getDate()}, {"l_shipinstruct", Type::getChar(25)}, {"l_shipmode", Type::getChar(10)}, {"l_comment", Type::getVarchar(44)}});
+   // The cardinalities are the ones of scale factor 1
+   createTable("part", {{"p_partkey", Type::getInteger()}, {"p_name", Type::getVarchar(55)}, {"p_mfgr", Type::getChar(25)}, {"p_brand", Type::getChar(10)}, {"p_type", Type::getVarchar(25)}, {"p_size", Type::getInteger()}, {"p_container", Type::getChar(10)}, {"p_retailprice", Type::getDecimal(12, 2)}, {"p_comment", Type::getVarchar(23)}}, 200000);
+   createTable("region", {{"r_regionkey", Type::getInteger()}, {"r_name", Type::getChar(25)}, {"r_comment", Type::getVarchar(152)}}, 5);
+   createTable("nation", {{"n_nationkey", Type::getInteger()}, {"n_name", Type::getChar(25)}, {"n_regionkey", Type::getInteger()}, {"n_comment", Type::getVarchar(152)}}, 25);
+   createTable("supplier", {{"s_suppkey", Type::getInteger()}, {"s_name", Type::getChar(25)}, {"s_address", Type::getVarchar(40)}, {"s_nationkey", Type::getInteger()}, {"s_phone", Type::getChar(15)}, {"s_acctbal", Type::getDecimal(12, 2)}, {"s_comment", Type::getVarchar(101)}}, 10000);
+   createTable("partsupp", {{"ps_partkey", Type::getInteger()}, {"ps_suppkey", Type::getInteger()}, {"ps_availqty", Type::getInteger()}, {"ps_supplycost", Type::getDecimal(12, 2)}, {"ps_comment", Type::getVarchar(199)}}, 800000);
+   createTable("customer", {{"c_custkey", Type::getInteger()}, {"c_name", Type::getVarchar(25)}, {"c_address", Type::getVarchar(40)}, {"c_nationkey", Type::getInteger()}, {"c_phone", Type::getChar(15)}, {"c_acctbal", Type::getDecimal(12, 2)}, {"c_mktsegment", Type::getChar(10)}, {"c_comment", Type::getVarchar(117)}}, 150000);
+   createTable("orders", {{"o_orderkey", Type::getInteger()}, {"o_custkey", Type::getInteger()}, {"o_orderstatus", Type::getChar(1)}, {"o_totalprice", Type::getDecimal(12, 2)}, {"o_orderdate", Type::getDate()}, {"o_orderpriority", Type::getChar(15)}, {"o_clerk", Type::getChar(15)}, {"o_shippriority", Type::getInteger()}, {"o_comment", Type::getVarchar(79)}}, 1500000);
+   createTable("lineitem", {{"l_orderkey", Type::getInteger()}, {"l_partkey", Type::getInteger()}, {"l_suppkey", Type::getInteger()}, {"l_linenumber", Type::getInteger()}, {"l_quantity", Type::getDecimal(12, 2)}, {"l_extendedprice", Type::getDecimal(12, 2)}, {"l_discount", Type::getDecimal(12, 2)}, {"l_tax", Type::getDecimal(12, 2)}, {"l_returnflag", Type::getChar(1)}, {"l_linestatus", Type::getChar(1)}, {"l_shipdate", Type::getDate()}, {"l_commitdate", Type::getDate()}, {"l_receiptdate", Type::getDate()}, {"l_shipinstruct", Type::getChar(25)}, {"l_shipmode", Type::getChar(10)}, {"l_comment", Type::getVarchar(44)}}, 6001215);
+
+   // The keys
+   setPrimaryKey("part", {"p_partkey"});
+   setPrimaryKey("region", {"r_regionkey"});
+   setPrimaryKey("nation", {"n_nationkey"});
+   setPrimaryKey("supplier", {"s_suppkey"});
+   setPrimaryKey("partsupp", {"ps_partkey", "ps_suppkey"});
+   setPrimaryKey("customer", {"c_custkey"});
+   setPrimaryKey("orders", {"o_orderkey"});
+   setPrimaryKey("lineitem", {"l_orderkey", "l_linenumber"});
+   addForeignKey("nation", {"n_regionkey"}, "region");
+   addForeignKey("supplier", {"s_nationkey"}, "nation");
+   addForeignKey("partsupp", {"ps_partkey"}, "part");
+   addForeignKey("partsupp", {"ps_suppkey"}, "supplier");
+   addForeignKey("customer", {"c_nationkey"}, "nation");
+   addForeignKey("orders", {"o_custkey"}, "customer");
+   addForeignKey("lineitem", {"l_orderkey"}, "orders");
+   addForeignKey("lineitem", {"l_partkey", "l_suppkey"}, "partsupp");
+   addForeignKey("lineitem", {"l_partkey"}, "part");
+   addForeignKey("lineitem", {"l_suppkey"}, "supplier");
 }
 //---------------------------------------------------------------------------
 void Schema::populateSchema()
@@ -50,13 +629,420 @@ void Schema::populateSchema()
    createTPCH();
 }
 //---------------------------------------------------------------------------
-const Schema::Table* Schema::lookupTable(const std::string& name) const
+void Schema::loadSchema(const string& file)
+// Load a schema file
+{
+   ifstream in(file, ios::binary);
+   if (!in.is_open()) throw runtime_error("unable to read " + file);
+   string magic(snapshotMagic.size(), '\0');
+   in.read(magic.data(), magic.size());
+   if (in && (magic == snapshotMagic)) {
+      in.close();
+      loadSnapshot(file);
+      return;
+   }
+   // Snapshots of older versions lack the key constraints
+   if (in && magic.starts_with(snapshotMagic.substr(0, snapshotMagic.size() - 1))) throw runtime_error("unsupported schema snapshot version in " + file);
+   in.clear();
+   in.seekg(0);
+   ostringstream ddl;
+   ddl << in.rdbuf();
+   loadDDL(ddl.str());
+}
+//---------------------------------------------------------------------------
+void Schema::loadDDL(string_view ddl)
+// Create the tables of SQL DDL
+{
+   parseDDL(ddl, [&](string name, Table table) { createTable(move(name), move(table)); });
+}
+//---------------------------------------------------------------------------
+void Schema::parseDDL(string_view ddl, const function<void(string name, Table table)>& callback)
+// Parse SQL DDL and pass the tables to a callback
+{
+   auto tokens = tokenizeDDL(ddl);
+   size_t pos = 0;
+   auto reportError = [&](const string& message) {
+      unsigned line = tokens.empty() ? 1 : tokens[min(pos, tokens.size() - 1)].line;
+      throw runtime_error("schema line " + to_string(line) + ": " + message);
+   };
+   auto peek = [&](string_view str, size_t ahead = 0) { return (pos + ahead < tokens.size()) && tokens[pos + ahead].is(str); };
+   auto next = [&]() -> const DDLToken& {
+      if (pos >= tokens.size()) reportError("unexpected end of input");
+      return tokens[pos++];
+   };
+   auto expect = [&](string_view str) {
+      if (!next().is(str)) reportError("expected '" + string(str) + "'");
+   };
+   // Skip a balanced token sequence until one of the delimiters at nesting depth 0
+   auto skipUntil = [&](initializer_list<string_view> delimiters) {
+      unsigned depth = 0;
+      for (; pos < tokens.size(); ++pos) {
+         if ((!depth) && any_of(delimiters.begin(), delimiters.end(), [&](string_view d) { return peek(d); })) return;
+         if (peek("(")) ++depth;
+         if (peek(")") && depth) --depth;
+      }
+   };
+   // Parse an identifier, possibly qualified with a schema name
+   auto parseName = [&]() {
+      string name = next().text;
+      while (peek(".")) {
+         ++pos;
+         name = next().text;
+      }
+      return name;
+   };
+   // Parse the optional arguments of a type
+   auto parseTypeArguments = [&](unsigned defaultFirst, unsigned defaultSecond) {
+      pair<unsigned, unsigned> result{defaultFirst, defaultSecond};
+      if (!peek("(")) return result;
+      ++pos;
+      result.first = atoi(next().text.c_str());
+      if (peek(",")) {
+         ++pos;
+         result.second = atoi(next().text.c_str());
+      }
+      expect(")");
+      return result;
+   };
+   // Parse a parenthesized list of column names
+   auto parseColumnList = [&]() {
+      vector<string> result;
+      expect("(");
+      while (true) {
+         result.push_back(next().text);
+         if (next().is(")")) break;
+         if (!tokens[pos - 1].is(",")) reportError("expected ',' or ')'");
+      }
+      return result;
+   };
+   // Parse the target of a references clause
+   auto parseReference = [&](vector<string> columns) {
+      ForeignKey foreignKey;
+      foreignKey.table = parseName();
+      if (peek("(")) foreignKey.referencedColumns = parseColumnList();
+      // Skip match and referential actions
+      skipUntil({",", ")", "not", "primary", "unique", "references", "constraint"});
+      return pair{move(columns), move(foreignKey)};
+   };
+   auto parseType = [&]() {
+      string name = next().text;
+      if (((name == "character") && peek("varying")) || ((name == "double") && peek("precision"))) name += " " + next().text;
+      if ((name == "integer") || (name == "int") || (name == "int2") || (name == "int4") || (name == "int8") || (name == "smallint") || (name == "bigint") || (name == "tinyint")) return Type::getInteger();
+      if ((name == "decimal") || (name == "numeric")) {
+         auto [precision, scale] = parseTypeArguments(18, 0);
+         return Type::getDecimal(precision, scale);
+      }
+      if ((name == "char") || (name == "character")) return Type::getChar(parseTypeArguments(1, 0).first);
+      if ((name == "varchar") || (name == "character varying")) {
+         if (!peek("(")) return Type::getText();
+         return Type::getVarchar(parseTypeArguments(0, 0).first);
+      }
+      if ((name == "text") || (name == "string")) return Type::getText();
+      if (name == "date") return Type::getDate();
+      if ((name == "boolean") || (name == "bool")) return Type::getBool();
+      if (name == "interval") return Type::getInterval();
+      --pos;
+      reportError("unknown type '" + name + "'");
+      __builtin_unreachable();
+   };
+
+   while (pos < tokens.size()) {
+      if (peek(";")) {
+         ++pos;
+         continue;
+      }
+      // Ignore everything but create table statements
+      if (!(peek("create") && peek("table", 1))) {
+         skipUntil({";"});
+         continue;
+      }
+      pos += 2;
+      if (peek("if")) {
+         ++pos;
+         expect("not");
+         expect("exists");
+      }
+      string name = parseName();
+      expect("(");
+      Table table;
+      // The keys refer to columns by name until all columns are known
+      vector<string> primaryKey;
+      vector<vector<string>> uniqueKeys;
+      vector<pair<vector<string>, ForeignKey>> foreignKeys;
+      auto setPrimaryKey = [&](vector<string> columns) {
+         if (!primaryKey.empty()) reportError("multiple primary keys for table '" + name + "'");
+         primaryKey = move(columns);
+      };
+      while (true) {
+         if (peek("constraint") || peek("primary") || peek("foreign") || peek("unique") || peek("check")) {
+            // Table constraints
+            if (peek("constraint")) pos += 2;
+            if (peek("primary") && peek("key", 1)) {
+               pos += 2;
+               setPrimaryKey(parseColumnList());
+            } else if (peek("unique")) {
+               ++pos;
+               uniqueKeys.push_back(parseColumnList());
+            } else if (peek("foreign") && peek("key", 1)) {
+               pos += 2;
+               auto columns = parseColumnList();
+               expect("references");
+               foreignKeys.push_back(parseReference(move(columns)));
+            }
+            skipUntil({",", ")"});
+         } else {
+            Column column{next().text, Type::getUnknown()};
+            auto type = parseType();
+            bool nullable = true;
+            while (!(peek(",") || peek(")"))) {
+               if (peek("not") && peek("null", 1)) {
+                  nullable = false;
+                  pos += 2;
+               } else if (peek("primary") && peek("key", 1)) {
+                  nullable = false;
+                  pos += 2;
+                  setPrimaryKey({column.name});
+               } else if (peek("unique")) {
+                  ++pos;
+                  uniqueKeys.push_back({column.name});
+               } else if (peek("references")) {
+                  ++pos;
+                  foreignKeys.push_back(parseReference({column.name}));
+               } else {
+                  ++pos;
+                  skipUntil({",", ")", "not", "primary", "unique", "references"});
+               }
+            }
+            column.type = type.withNullable(nullable);
+            if (table.findColumn(column.name)) reportError("duplicate column '" + column.name + "' in table '" + name + "'");
+            table.columns.push_back(move(column));
+         }
+         if (next().is(")")) break;
+         if (!tokens[pos - 1].is(",")) reportError("expected ',' or ')'");
+      }
+
+      // Resolve the keys
+      try {
+         table.primaryKey = resolveColumns(name, table, primaryKey);
+         for (auto c : table.primaryKey)
+            table.columns[c].type = table.columns[c].type.withNullable(false);
+         for (auto& k : uniqueKeys)
+            table.uniqueKeys.push_back(resolveColumns(name, table, k));
+         for (auto& [columns, foreignKey] : foreignKeys) {
+            foreignKey.columns = resolveColumns(name, table, columns);
+            table.foreignKeys.push_back(move(foreignKey));
+         }
+      } catch (const runtime_error& e) {
+         reportError(e.what());
+      }
+      callback(move(name), move(table));
+      skipUntil({";"});
+   }
+}
+//---------------------------------------------------------------------------
+void Schema::loadSnapshot(const string& file)
+// Map a snapshot file
+{
+   setProvider(Snapshot::map(file));
+}
+//---------------------------------------------------------------------------
+void Schema::setProvider(unique_ptr<Provider> provider, size_t cacheCapacity)
+// Load tables on demand from a provider
+{
+   tables.clear();
+   cache.clear();
+   cacheIndex.clear();
+   this->provider = move(provider);
+   this->cacheCapacity = max<size_t>(cacheCapacity, 1);
+   version = this->provider->getVersion();
+}
+//---------------------------------------------------------------------------
+void Schema::writeSnapshot(ostream& out) const
+// Write a snapshot of all tables
+{
+   auto names = getTableNames();
+   uint64_t dataStart = Snapshot::headerSize + names.size() * Snapshot::entrySize;
+   string index, data;
+   auto writeWord = [](string& out, uint64_t value) { out.append(reinterpret_cast<const char*>(&value), sizeof(value)); };
+   for (auto& name : names) {
+      writeWord(index, dataStart + data.size());
+      writeWord(index, name.size());
+      data += name;
+      uint64_t start = data.size();
+      Snapshot::writeTable(data, *lookupTable(name));
+      writeWord(index, dataStart + start);
+      writeWord(index, data.size() - start);
+   }
+
+   string header(snapshotMagic);
+   writeWord(header, version);
+   writeWord(header, names.size());
+   out << header << index << data;
+}
+//---------------------------------------------------------------------------
+void Schema::setPrimaryKey(const string& table, const vector<string>& columns)
+// Declare the primary key of a table
+{
+   modifyTable(table, [&](Table& t) {
+      t.primaryKey = resolveColumns(table, t, columns);
+      // Primary key columns cannot be NULL
+      for (auto c : t.primaryKey)
+         t.columns[c].type = t.columns[c].type.withNullable(false);
+   });
+}
+//---------------------------------------------------------------------------
+void Schema::addUniqueKey(const string& table, const vector<string>& columns)
+// Declare a unique key of a table
+{
+   modifyTable(table, [&](Table& t) { t.uniqueKeys.push_back(resolveColumns(table, t, columns)); });
+}
+//---------------------------------------------------------------------------
+void Schema::addForeignKey(const string& table, const vector<string>& columns, string referencedTable, vector<string> referencedColumns)
+// Declare a foreign key
+{
+   modifyTable(table, [&](Table& t) { t.foreignKeys.push_back({resolveColumns(table, t, columns), move(referencedTable), move(referencedColumns)}); });
+}
+//---------------------------------------------------------------------------
+void Schema::setStatistics(const string& name, uint64_t cardinality, vector<ColumnStatistics> statistics)
+// Replace the statistics of a table
+{
+   modifyTable(name, [&](Table& t) {
+      if (statistics.size() != t.columns.size()) throw runtime_error("table '" + name + "' has " + to_string(t.columns.size()) + " columns, got statistics for " + to_string(statistics.size()));
+      t.cardinality = cardinality;
+      for (size_t index = 0; index != statistics.size(); ++index)
+         t.columns[index].statistics = move(statistics[index]);
+   });
+}
+//---------------------------------------------------------------------------
+void Schema::loadStatistics(istream& in)
+// Load statistics
+{
+   string line;
+   unsigned lineNo = 0;
+   auto reportError = [&](const string& message) {
+      throw runtime_error("statistics line " + to_string(lineNo) + ": " + message);
+   };
+   if ((!getline(in, line)) || (line != statisticsHeader)) reportError("not a statistics file");
+   ++lineNo;
+
+   // The table that is currently read
+   shared_ptr<const Table> table;
+   string tableName;
+   uint64_t cardinality = 0;
+   vector<ColumnStatistics> statistics;
+   auto finishTable = [&]() {
+      if (table) setStatistics(tableName, cardinality, move(statistics));
+      table = nullptr;
+   };
+
+   while (getline(in, line)) {
+      ++lineNo;
+      if (line.empty()) continue;
+      vector<string_view> fields;
+      for (size_t start = 0;;) {
+         size_t end = line.find('\t', start);
+         fields.push_back(string_view(line).substr(start, end - start));
+         if (end == string::npos) break;
+         start = end + 1;
+      }
+
+      if (fields[0] == "table") {
+         finishTable();
+         if (fields.size() != 3) reportError("malformed table entry");
+         tableName = fields[1];
+         table = lookupTable(tableName);
+         if (!table) reportError("unknown table '" + tableName + "'");
+         auto count = parseNumber(fields[2]);
+         if ((!count) || (*count < 0)) reportError("invalid cardinality");
+         cardinality = *count;
+         statistics.assign(table->columns.size(), {});
+      } else if (fields[0] == "column") {
+         if (!table) reportError("column entry outside of a table");
+         if (fields.size() < 6) reportError("malformed column entry");
+         auto column = find_if(table->columns.begin(), table->columns.end(), [&](const Column& c) { return c.name == fields[1]; });
+         if (column == table->columns.end()) reportError("unknown column '" + string(fields[1]) + "' in table '" + tableName + "'");
+         auto& stats = statistics[column - table->columns.begin()];
+         auto distinct = parseNumber(fields[2]), nullFraction = parseNumber(fields[3]);
+         if ((!distinct) || (*distinct < 0) || (!nullFraction) || (*nullFraction < 0) || (*nullFraction > 1)) reportError("invalid column statistics");
+         stats.distinctValues = *distinct;
+         stats.nullFraction = *nullFraction;
+         stats.min = readValue(fields[4]);
+         stats.max = readValue(fields[5]);
+         for (size_t index = 6; index != fields.size(); ++index) {
+            auto bound = readValue(fields[index]);
+            if (!bound) reportError("invalid histogram bound");
+            stats.histogram.push_back(move(*bound));
+         }
+      } else {
+         reportError("unknown entry '" + string(fields[0]) + "'");
+      }
+   }
+   finishTable();
+}
+//---------------------------------------------------------------------------
+void Schema::writeStatistics(ostream& out) const
+// Write the statistics of all tables
+{
+   out << statisticsHeader << '\n';
+   for (auto& name : getTableNames()) {
+      auto table = lookupTable(name);
+      out << "table\t" << name << '\t' << table->cardinality << '\n';
+      for (auto& c : table->columns) {
+         auto& stats = c.statistics;
+         out << "column\t" << c.name << '\t' << formatNumber(stats.distinctValues) << '\t' << formatNumber(stats.nullFraction);
+         writeValue(out, stats.min);
+         writeValue(out, stats.max);
+         for (auto& v : stats.histogram)
+            writeValue(out, v);
+         out << '\n';
+      }
+   }
+}
+//---------------------------------------------------------------------------
+shared_ptr<const Schema::Table> Schema::lookupTable(const std::string& name) const
 // Check if a table exists in the schema
 {
-   auto iter = tables.find(name);
-   if (iter != tables.end())
-      return &(iter->second);
-   return nullptr;
+   if (auto iter = tables.find(name); iter != tables.end()) return iter->second;
+   if (!provider) return nullptr;
+
+   // The schema is shared between threads, the cache must be synchronized
+   unique_lock lock(cacheMutex);
+   if (auto iter = cacheIndex.find(name); iter != cacheIndex.end()) {
+      cache.splice(cache.begin(), cache, iter->second);
+      return iter->second->second;
+   }
+
+   // Load the table without blocking other lookups. Another thread might load it concurrently
+   lock.unlock();
+   auto table = provider->loadTable(name);
+   if (!table) return nullptr;
+   shared_ptr<const Table> result = make_shared<Table>(move(*table));
+   lock.lock();
+   if (auto iter = cacheIndex.find(name); iter != cacheIndex.end()) {
+      cache.splice(cache.begin(), cache, iter->second);
+      return iter->second->second;
+   }
+   cache.emplace_front(name, result);
+   cacheIndex[cache.front().first] = cache.begin();
+
+   // Evict the least recently used tables. Queries that use them keep their copy alive
+   while (cache.size() > cacheCapacity) {
+      cacheIndex.erase(cache.back().first);
+      cache.pop_back();
+   }
+   return result;
+}
+//---------------------------------------------------------------------------
+vector<string> Schema::getTableNames() const
+// Get the names of all tables in sorted order
+{
+   set<string> names;
+   for (auto& t : tables)
+      names.insert(t.first);
+   if (provider)
+      for (auto& n : provider->getTableNames())
+         names.insert(move(n));
+   return {names.begin(), names.end()};
 }
 //---------------------------------------------------------------------------
 }
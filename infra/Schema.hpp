@@ -1,6 +1,13 @@
 #ifndef H_saneql_Schema
 #define H_saneql_Schema
 //---------------------------------------------------------------------------
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -42,6 +49,10 @@ class Type {
 
    /// Get the name (for error reporting)
    std::string getName() const;
+   /// Get the raw modifier (for serialization)
+   constexpr unsigned getModifier() const { return modifier; }
+   /// Reconstruct a type from its tag and raw modifier
+   static constexpr Type fromRaw(Tag tag, unsigned modifier) { return Type(tag, modifier); }
 
    /// Is the type nullable?
    constexpr bool isNullable() const { return modifier & 1; }
@@ -85,34 +96,156 @@ class Type {
 /// Access to the database schema
 class Schema {
    public:
+   /// Statistics about the values of a column. Values are stored in their SQL text form
+   struct ColumnStatistics {
+      /// The number of distinct non-NULL values. 0 if unknown
+      double distinctValues = 0;
+      /// The fraction of NULL values
+      double nullFraction = 0;
+      /// The smallest value (if known)
+      std::optional<std::string> min;
+      /// The largest value (if known)
+      std::optional<std::string> max;
+      /// The bounds of an equi-depth histogram. The buckets between adjacent bounds contain the same number of non-NULL values
+      std::vector<std::string> histogram;
+
+      /// Are any statistics known?
+      bool isKnown() const { return distinctValues || nullFraction || min; }
+      /// Convert a value into a number that preserves the value order. nullopt for text types and malformed values
+      static std::optional<double> toNumber(Type type, std::string_view value);
+      /// Compare two values of a type
+      static bool less(Type type, std::string_view a, std::string_view b);
+      /// Estimate the fraction of non-NULL values that are less than a value. nullopt if unknown
+      std::optional<double> estimateLess(Type type, std::string_view value) const;
+   };
    /// A column definition
    struct Column {
       /// The name
       std::string name;
       /// The type
       Type type;
+      /// The statistics
+      ColumnStatistics statistics = {};
+   };
+   /// A foreign key
+   struct ForeignKey {
+      /// The positions of the referencing columns
+      std::vector<unsigned> columns;
+      /// The referenced table
+      std::string table;
+      /// The referenced columns. Empty if the primary key is referenced
+      std::vector<std::string> referencedColumns;
    };
    /// A table definition
    struct Table {
       /// The columns
       std::vector<Column> columns;
+      /// The number of rows. 0 if unknown
+      uint64_t cardinality = 0;
+      /// The column positions of the primary key. Empty if there is none
+      std::vector<unsigned> primaryKey = {};
+      /// The column positions of further unique keys
+      std::vector<std::vector<unsigned>> uniqueKeys = {};
+      /// The foreign keys
+      std::vector<ForeignKey> foreignKeys = {};
+
+      /// Get all unique keys, the primary key first
+      std::vector<std::vector<unsigned>> getKeys() const;
+      /// Find a column by name. Returns the position or nullopt
+      std::optional<unsigned> findColumn(std::string_view name) const;
+      /// Get the positions of the columns referenced by a foreign key. Empty if they do not exist
+      std::vector<unsigned> resolveReference(const ForeignKey& foreignKey) const;
+   };
+
+   /// A source of tables that are loaded on demand, for example from an on-disk catalog.
+   /// Must be safe to use from multiple threads
+   class Provider {
+      public:
+      /// Destructor
+      virtual ~Provider();
+
+      /// Load a table. nullopt if the table does not exist
+      virtual std::optional<Table> loadTable(std::string_view name) const = 0;
+      /// Get the names of all tables
+      virtual std::vector<std::string> getTableNames() const = 0;
+      /// Get the catalog version. Must change whenever a table changes
+      virtual uint64_t getVersion() const = 0;
    };
+   /// The default number of provider tables that are kept in memory
+   static constexpr size_t defaultCacheCapacity = 10000;
 
    private:
-   /// The tables
-   std::unordered_map<std::string, Table> tables;
+   class Snapshot;
 
+   /// The tables that were created or modified directly
+   std::unordered_map<std::string, std::shared_ptr<const Table>> tables;
+   /// The provider of all other tables (if any)
+   std::unique_ptr<Provider> provider;
+   /// The recently used provider tables, most recently used first
+   mutable std::list<std::pair<std::string, std::shared_ptr<const Table>>> cache;
+   /// The cache entries by name
+   mutable std::unordered_map<std::string_view, decltype(cache)::iterator> cacheIndex;
+   /// The maximum number of cached tables
+   size_t cacheCapacity = defaultCacheCapacity;
+   /// Protects the cache
+   mutable std::mutex cacheMutex;
+   /// The schema version, a fingerprint of all table definitions
+   uint64_t version = 0;
+
+   /// Compute the fingerprint of a table definition
+   static uint64_t hashTable(const std::string& name, const Table& table);
+   /// Create a table
+   void createTable(std::string name, Table table);
    /// Create a table
-   void createTable(std::string name, std::initializer_list<Column> columns);
+   void createTable(std::string name, std::vector<Column> columns, uint64_t cardinality = 0);
+   /// Modify a copy of a table. The copy replaces the table
+   void modifyTable(const std::string& name, const std::function<void(Table&)>& modify);
+   /// Resolve column names into positions
+   static std::vector<unsigned> resolveColumns(const std::string& name, const Table& table, const std::vector<std::string>& columns);
    /// Create the TPC-H schema
    void createTPCH();
 
    public:
+   /// Constructor
+   Schema();
+   /// Destructor
+   ~Schema();
+
    /// Create some test schema for experiments
    void populateSchema();
+   /// Load a schema file, either a snapshot or SQL DDL
+   void loadSchema(const std::string& file);
+   /// Create the tables of SQL DDL
+   void loadDDL(std::string_view ddl);
+   /// Parse SQL DDL and pass the tables to a callback. Statements other than create table are ignored
+   static void parseDDL(std::string_view ddl, const std::function<void(std::string name, Table table)>& callback);
+   /// Map a snapshot file. Replaces all tables, the tables are read on first use
+   void loadSnapshot(const std::string& file);
+   /// Load tables on demand from a provider. Replaces all tables. At most cacheCapacity provider tables are kept in memory
+   void setProvider(std::unique_ptr<Provider> provider, size_t cacheCapacity = defaultCacheCapacity);
+   /// Write a snapshot of all tables
+   void writeSnapshot(std::ostream& out) const;
+
+   /// Declare the primary key of a table
+   void setPrimaryKey(const std::string& table, const std::vector<std::string>& columns);
+   /// Declare a unique key of a table
+   void addUniqueKey(const std::string& table, const std::vector<std::string>& columns);
+   /// Declare a foreign key. Without referenced columns the primary key of the referenced table is referenced
+   void addForeignKey(const std::string& table, const std::vector<std::string>& columns, std::string referencedTable, std::vector<std::string> referencedColumns = {});
+
+   /// Replace the statistics of a table. The column statistics are in column order
+   void setStatistics(const std::string& name, uint64_t cardinality, std::vector<ColumnStatistics> statistics);
+   /// Load statistics in the format produced by writeStatistics. Unknown tables and columns are an error
+   void loadStatistics(std::istream& in);
+   /// Write the statistics of all tables
+   void writeStatistics(std::ostream& out) const;
 
-   /// Check if a table exists in the schema
-   const Table* lookupTable(const std::string& name) const;
+   /// Check if a table exists in the schema. Thread safe, but not while the schema is modified
+   std::shared_ptr<const Table> lookupTable(const std::string& name) const;
+   /// Get the names of all tables in sorted order
+   std::vector<std::string> getTableNames() const;
+   /// Get the schema version. Identical schemas have identical versions, even across processes
+   uint64_t getVersion() const { return version; }
 };
 //---------------------------------------------------------------------------
 }
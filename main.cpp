@@ -1,13 +1,22 @@
-#include "algebra/Operator.hpp"
+#include "driver/Analyzer.hpp"
+#include "driver/Batch.hpp"
+#include "driver/CompileCache.hpp"
+#include "driver/Compiler.hpp"
+#include "driver/PreparedQuery.hpp"
+#include "driver/Server.hpp"
+#include "execution/Database.hpp"
+#include "execution/Loader.hpp"
+#include "execution/NativeCompiler.hpp"
+#include "execution/TPCHGenerator.hpp"
 #include "infra/Schema.hpp"
-#include "parser/ASTBase.hpp"
-#include "parser/SaneQLLexer.hpp"
-#include "parser/SaneQLParser.hpp"
-#include "semana/SemanticAnalysis.hpp"
-#include "sql/SQLWriter.hpp"
+#include <chrono>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <optional>
 #include <sstream>
+#include <stdexcept>
+#include <vector>
 //---------------------------------------------------------------------------
 using namespace std;
 using namespace saneql;
@@ -29,77 +38,278 @@ static string readFiles(unsigned count, char* files[]) {
 }
 //---------------------------------------------------------------------------
 int main(int argc, char* argv[]) {
-   if (argc < 2) {
-      cerr << "usage: " << argv[0] << " file..." << endl;
+   // Handle the global options
+   string cacheDir, schemaFile, statisticsFile, dataDir = ".";
+   double tpchScale = 0;
+   unsigned executionThreads = 0;
+   optional<SQLWriter::PlaceholderStyle> placeholderStyle;
+   vector<optional<string>> bindings;
+   bool materializeCTEs = false;
+   bool flatSQL = false;
+   bool execute = false;
+   bool compileNative = false;
+   bool validOptions = true;
+   while ((argc > 2) && validOptions) {
+      string_view option = argv[1];
+      if ((option == "--materialize-ctes") || (option == "--flat") || (option == "--execute") || (option == "--compile")) {
+         // Evaluate shared lets only once, merge operators into few SELECT blocks, run the query instead of generating SQL, or run its aggregations as native code
+         (option == "--flat" ? flatSQL : (option == "--execute" ? execute : (option == "--compile" ? compileNative : materializeCTEs))) = true;
+         argv[1] = argv[0];
+         --argc;
+         ++argv;
+         continue;
+      } else if (option == "--cache-dir") {
+         // Persist compiled queries and native code
+         cacheDir = argv[2];
+      } else if (option == "--schema") {
+         // Compile against a schema file instead of TPC-H
+         schemaFile = argv[2];
+      } else if (option == "--data") {
+         // Read the <table>.tbl files for --execute from a directory
+         dataDir = argv[2];
+      } else if (option == "--tpch") {
+         // Generate the TPC-H tables for --execute in memory
+         tpchScale = atof(argv[2]);
+         validOptions = tpchScale > 0;
+      } else if (option == "--threads") {
+         // The number of worker threads for --execute
+         executionThreads = atoi(argv[2]);
+      } else if (option == "--statistics") {
+         // Use table statistics for cost based decisions
+         statisticsFile = argv[2];
+      } else if (option == "--parameterize") {
+         // Lift literals into parameters
+         string_view style = argv[2];
+         if (style == "numbered") {
+            placeholderStyle = SQLWriter::PlaceholderStyle::Numbered;
+         } else if (style == "positional") {
+            placeholderStyle = SQLWriter::PlaceholderStyle::Positional;
+         } else {
+            validOptions = false;
+         }
+      } else if (option == "--bind") {
+         // Embed parameter values
+         bindings.push_back(argv[2]);
+      } else {
+         break;
+      }
+      argv[2] = argv[0];
+      argc -= 2;
+      argv += 2;
+   }
+   if ((argc < 2) || (!validOptions)) {
+      cerr << "usage: " << argv[0] << " [--schema file] [--statistics file] [--cache-dir dir] [--parameterize numbered|positional] [--materialize-ctes] [--flat] file..." << endl;
+      cerr << "       " << argv[0] << " --bind value [--bind value...] file..." << endl;
+      cerr << "       " << argv[0] << " [--schema file] [--cache-dir dir] --execute [--data dir | --tpch scalefactor] [--threads n] [--compile] [--bind value...] file..." << endl;
+      cerr << "       " << argv[0] << " [--cache-dir dir] [--parameterize numbered|positional] [--materialize-ctes] [--flat] --serve socket" << endl;
+      cerr << "       " << argv[0] << " [--cache-dir dir] [--parameterize numbered|positional] [--materialize-ctes] [--flat] --batch [--threads n] file-or-directory..." << endl;
+      cerr << "       " << argv[0] << " --analyze table=datafile..." << endl;
+      cerr << "       " << argv[0] << " --load [--threads n] table=datafile..." << endl;
+      cerr << "       " << argv[0] << " --generate [--threads n] scalefactor dir [table...]" << endl;
+      cerr << "       " << argv[0] << " --write-snapshot file" << endl;
       return 1;
    }
 
    Schema schema;
-   schema.populateSchema();
-
-   string query = readFiles(argc - 1, argv + 1);
-   ASTContainer container;
-   ast::AST* tree = nullptr;
    try {
-      tree = SaneQLParser::parse(container, query);
+      if (schemaFile.empty())
+         schema.populateSchema();
+      else
+         schema.loadSchema(schemaFile);
+      if (!statisticsFile.empty()) {
+         ifstream in(statisticsFile);
+         if (!in.is_open()) throw runtime_error("unable to read " + statisticsFile);
+         schema.loadStatistics(in);
+      }
    } catch (const exception& e) {
       cerr << e.what() << endl;
       return 1;
    }
 
-   SemanticAnalysis semana(schema);
-   try {
-      auto res = semana.analyzeQuery(tree);
-      SQLWriter sql;
-      if (res.isScalar()) {
-         sql.write("select ");
-         res.scalar()->generate(sql);
-      } else {
-         algebra::Sort* sort = nullptr;
-         auto tree = res.table().get();
-         if (auto s = dynamic_cast<algebra::Sort*>(tree)) {
-            sort = s;
-            tree = sort->input.get();
+   // Store the schema for fast loading?
+   if (string_view(argv[1]) == "--write-snapshot") {
+      if (argc != 3) {
+         cerr << "usage: " << argv[0] << " [--schema file] [--statistics file] --write-snapshot file" << endl;
+         return 1;
+      }
+      ofstream out(argv[2], ios::binary);
+      schema.writeSnapshot(out);
+      out.close();
+      if (!out) {
+         cerr << "unable to write " << argv[2] << endl;
+         return 1;
+      }
+      return 0;
+   }
+
+   // Measure the load speed of data files?
+   if (string_view(argv[1]) == "--load") {
+      auto usage = [&]() {
+         cerr << "usage: " << argv[0] << " --load [--threads n] table=datafile..." << endl;
+         return 1;
+      };
+      int first = 2;
+      unsigned threads = 0;
+      if ((argc > 3) && (string_view(argv[2]) == "--threads")) {
+         threads = atoi(argv[3]);
+         first = 4;
+      }
+      if (argc <= first) return usage();
+      try {
+         for (int index = first; index < argc; ++index) {
+            string_view arg = argv[index];
+            auto split = arg.find('=');
+            if (split == string_view::npos) return usage();
+            string name(arg.substr(0, split)), file(arg.substr(split + 1));
+            auto definition = schema.lookupTable(name);
+            if (!definition) throw runtime_error("unknown table '" + name + "'");
+            execution::Loader::Statistics statistics;
+            execution::Loader(name, *definition, threads).loadFile(file, execution::Loader::Format::forFile(file), &statistics);
+            cout << name << ": " << statistics.rows << " rows, " << statistics.bytes << " bytes in " << statistics.seconds << "s, " << static_cast<uint64_t>(statistics.getRowsPerSecond()) << " rows/s" << endl;
          }
-         sql.write("select ");
-         bool first = true;
-         for (auto& c : res.getBinding().getColumns()) {
-            if (first)
-               first = false;
-            else
-               sql.write(", ");
-            sql.writeIU(c.iu);
-            sql.write(" as ");
-            sql.writeIdentifier(c.name);
+      } catch (const exception& e) {
+         cerr << e.what() << endl;
+         return 1;
+      }
+      return 0;
+   }
+
+   // Write the TPC-H tables as .tbl files?
+   if (string_view(argv[1]) == "--generate") {
+      auto usage = [&]() {
+         cerr << "usage: " << argv[0] << " --generate [--threads n] scalefactor dir [table...]" << endl;
+         return 1;
+      };
+      int first = 2;
+      unsigned threads = 0;
+      if ((argc > 3) && (string_view(argv[2]) == "--threads")) {
+         threads = atoi(argv[3]);
+         first = 4;
+      }
+      if (argc < first + 2) return usage();
+      try {
+         execution::TPCHGenerator generator(atof(argv[first]), threads);
+         filesystem::path dir(argv[first + 1]);
+         filesystem::create_directories(dir);
+         vector<string> tables(argv + first + 2, argv + argc);
+         if (tables.empty()) tables = execution::TPCHGenerator::getTableNames();
+         for (auto& name : tables) {
+            auto definition = schema.lookupTable(name);
+            if (!definition) throw runtime_error("unknown table '" + name + "'");
+            auto file = (dir / (name + ".tbl")).string();
+            ofstream out(file, ios::binary);
+            if (!out.is_open()) throw runtime_error("unable to write " + file);
+            auto start = chrono::steady_clock::now();
+            auto rows = generator.write(name, *definition, out);
+            cout << name << ": " << rows << " rows in " << chrono::duration<double>(chrono::steady_clock::now() - start).count() << "s" << endl;
          }
-         sql.write(" from ");
-         tree->generate(sql);
-         sql.write(" s");
-         if (sort) {
-            if (!sort->order.empty()) {
-               sql.write(" order by ");
-               bool first = true;
-               for (auto& o : sort->order) {
-                  if (first)
-                     first = false;
-                  else
-                     sql.write(", ");
-                  o.value->generate(sql);
-                  if (o.collate != Collate{}) sql.write(" collate TODO"); // TODO
-                  if (o.descending) sql.write(" desc");
-               }
-            }
-            if (sort->limit.has_value()) {
-               sql.write(" limit ");
-               sql.write(to_string(*(sort->limit)));
-            }
-            if (sort->offset.has_value()) {
-               sql.write(" offset ");
-               sql.write(to_string(*(sort->offset)));
-            }
+      } catch (const exception& e) {
+         cerr << e.what() << endl;
+         return 1;
+      }
+      return 0;
+   }
+
+   // Compute statistics from data files?
+   if (string_view(argv[1]) == "--analyze") {
+      auto usage = [&]() {
+         cerr << "usage: " << argv[0] << " --analyze table=datafile..." << endl;
+         return 1;
+      };
+      if (argc < 3) return usage();
+      try {
+         Analyzer analyzer(schema);
+         for (int index = 2; index < argc; ++index) {
+            string_view arg = argv[index];
+            auto split = arg.find('=');
+            if (split == string_view::npos) return usage();
+            analyzer.analyze(string(arg.substr(0, split)), string(arg.substr(split + 1)));
          }
+         schema.writeStatistics(cout);
+      } catch (const exception& e) {
+         cerr << e.what() << endl;
+         return 1;
+      }
+      return 0;
+   }
+
+   // Run as compile server?
+   if (string_view(argv[1]) == "--serve") {
+      if (argc != 3) {
+         cerr << "usage: " << argv[0] << " --serve socket" << endl;
+         return 1;
+      }
+      try {
+         CompileCache cache(10000, cacheDir);
+         Server server(schema, argv[2], &cache);
+         if (placeholderStyle) server.setPlaceholderStyle(*placeholderStyle);
+         server.setMaterializeCTEs(materializeCTEs);
+         server.setFlatSQL(flatSQL);
+         server.run();
+      } catch (const exception& e) {
+         cerr << e.what() << endl;
+         return 1;
+      }
+      return 0;
+   }
+
+   // Compile many queries in parallel?
+   if (string_view(argv[1]) == "--batch") {
+      unsigned threads = 0;
+      int first = 2;
+      if ((argc > 3) && (string_view(argv[2]) == "--threads")) {
+         threads = atoi(argv[3]);
+         first = 4;
+      }
+      vector<string> paths(argv + first, argv + argc);
+      if (paths.empty()) {
+         cerr << "usage: " << argv[0] << " --batch [--threads n] file-or-directory..." << endl;
+         return 1;
+      }
+      try {
+         optional<CompileCache> cache;
+         if (!cacheDir.empty()) cache.emplace(10000, cacheDir);
+         BatchCompiler batch(schema, threads, cache ? &*cache : nullptr);
+         if (placeholderStyle) batch.setPlaceholderStyle(*placeholderStyle);
+         batch.setMaterializeCTEs(materializeCTEs);
+         batch.setFlatSQL(flatSQL);
+         return batch.compile(BatchCompiler::collectFiles(paths), cout, cerr) ? 1 : 0;
+      } catch (const exception& e) {
+         cerr << e.what() << endl;
+         return 1;
+      }
+   }
+
+   string query = readFiles(argc - 1, argv + 1);
+   try {
+      if (execute) {
+         execution::Database database(schema);
+         if (tpchScale > 0)
+            database.setGenerator(make_shared<execution::TPCHGenerator>(tpchScale));
+         else
+            database.setDataDirectory(dataDir);
+         optional<execution::NativeCompiler> compiler;
+         if (compileNative) compiler.emplace(cacheDir);
+         PreparedQuery prepared(schema, move(query));
+         prepared.execute(database, bindings, executionThreads, compiler ? &*compiler : nullptr).print(cout);
+         return 0;
+      }
+      if (!bindings.empty()) {
+         PreparedQuery prepared(schema, move(query));
+         cout << prepared.generate(bindings) << endl;
+         return 0;
       }
-      cout << sql.getResult() << endl;
+      optional<CompileCache> cache;
+      if (!cacheDir.empty()) cache.emplace(1, cacheDir);
+      Compiler compiler(schema);
+      compiler.setCache(cache ? &*cache : nullptr);
+      compiler.setMaterializeCTEs(materializeCTEs);
+      compiler.setFlatSQL(flatSQL);
+      if (placeholderStyle)
+         cout << compiler.compileParameterized(query, *placeholderStyle).toString();
+      else
+         compiler.compile(query, cout);
+      cout << endl;
    } catch (const exception& e) {
       cerr << e.what() << endl;
       return 1;
@@ -94,6 +94,36 @@ bool ASTBase::isEquivalent(const ASTBase* other) const
    return true;
 }
 //---------------------------------------------------------------------------
+void ASTBase::serialize(string& out) const
+// Append a canonical representation of the tree
+{
+   vector<const ASTBase*> todo;
+   todo.push_back(this);
+   while (!todo.empty()) {
+      auto current = todo.back();
+      todo.pop_back();
+
+      // Null entries and tokens are written directly
+      if (!current) {
+         out += 'n';
+         continue;
+      }
+      out += current->getRawType() ? 'a' : 't';
+      out.append(reinterpret_cast<const char*>(&current->descriptor), sizeof(current->descriptor));
+      if (!current->getRawType()) {
+         uint32_t len = current->content.size();
+         out.append(reinterpret_cast<const char*>(&len), sizeof(len));
+         out += current->content;
+         continue;
+      }
+
+      // Recurse, in reverse order to keep the entries in order
+      auto node = static_cast<const NodeTemplate*>(current);
+      for (unsigned index = current->getRawEntryCount(); index > 0; --index)
+         todo.push_back(node->entries[index - 1]);
+   }
+}
+//---------------------------------------------------------------------------
 ASTContainer::ASTContainer()
 // Constructor
 {
@@ -109,14 +139,37 @@ ASTContainer::~ASTContainer()
    }
 }
 //---------------------------------------------------------------------------
+void ASTContainer::reset()
+// Release all nodes but keep the largest memory chunk for reuse
+{
+   if (chunks) {
+      // Find the largest chunk, release all others
+      Chunk* largest = chunks;
+      for (auto iter = chunks->next; iter; iter = iter->next)
+         if (iter->size > largest->size) largest = iter;
+      while (chunks) {
+         auto next = chunks->next;
+         if (chunks != largest) delete[] reinterpret_cast<char*>(chunks);
+         chunks = next;
+      }
+      largest->next = nullptr;
+      chunks = largest;
+      freeBegin = chunks->data;
+      freeEnd = reinterpret_cast<char*>(chunks) + chunks->size;
+      lastSize = totalSize = chunks->size;
+   }
+   result = nullptr;
+}
+//---------------------------------------------------------------------------
 void ASTContainer::allocateNewChunk(size_t size)
 // Allocate a new chunk
 {
-   unsigned newSize = sizeof(Chunk) + size;
+   size_t newSize = sizeof(Chunk) + size;
    auto* newChunk = reinterpret_cast<Chunk*>(new char[newSize]);
    lastSize = newSize;
    totalSize += newSize;
    newChunk->next = chunks;
+   newChunk->size = newSize;
    freeBegin = newChunk->data;
    freeEnd = freeBegin + size;
    chunks = newChunk;
@@ -206,5 +259,40 @@ ASTBase* ASTContainer::appendList(string_view view, unsigned descriptor, ASTBase
    return list;
 }
 //---------------------------------------------------------------------------
+string_view ASTContainer::allocateString(string_view str)
+// Copy a string into the container memory
+{
+   // Round up to keep the following nodes aligned
+   auto data = static_cast<char*>(allocateRaw((str.size() + alignof(ASTBase) - 1) & ~(alignof(ASTBase) - 1)));
+   copy(str.begin(), str.end(), data);
+   return {data, str.size()};
+}
+//---------------------------------------------------------------------------
+ASTBase* ASTContainer::rewrite(ASTBase* tree, const function<ASTBase*(ASTBase*)>& replace)
+// Rebuild a tree, replacing nodes
+{
+   if (!tree) return nullptr;
+   if (auto replacement = replace(tree)) return replacement;
+   if (!tree->getRawType()) return tree;
+
+   // Rewrite the entries
+   unsigned count = tree->getRawEntryCount();
+   auto node = static_cast<NodeTemplate*>(tree);
+   vector<ASTBase*> entries(count);
+   bool changed = false;
+   for (unsigned index = 0; index != count; ++index) {
+      entries[index] = rewrite(node->entries[index], replace);
+      changed |= (entries[index] != node->entries[index]);
+   }
+   if (!changed) return tree;
+
+   // Build a copy. Lists become regular nodes, which is fine after parsing
+   auto result = new (allocateRaw(sizeof(NodeTemplate) + count * sizeof(ASTBase*))) NodeTemplate(tree->content, tree->descriptor);
+   for (unsigned index = 0; index != count; ++index)
+      result->entries[index] = entries[index];
+   result->computeHash();
+   return result;
+}
+//---------------------------------------------------------------------------
 }
 //---------------------------------------------------------------------------
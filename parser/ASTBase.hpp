@@ -3,6 +3,7 @@
 //---------------------------------------------------------------------------
 #include <cassert>
 #include <cstdint>
+#include <functional>
 #include <string>
 #include <string_view>
 //---------------------------------------------------------------------------
@@ -66,6 +67,8 @@ class ASTBase {
 
    /// Check for equivalence
    bool isEquivalent(const ASTBase* other) const;
+   /// Append a canonical representation of the tree. Equivalent trees have identical representations
+   void serialize(std::string& out) const;
 };
 //---------------------------------------------------------------------------
 /// A container for AST nodes
@@ -75,6 +78,8 @@ class ASTContainer {
    struct Chunk {
       /// The next chunk
       Chunk* next;
+      /// The size including the header
+      size_t size;
       /// The data
       char data[];
    };
@@ -101,6 +106,9 @@ class ASTContainer {
    /// Destructor
    ~ASTContainer();
 
+   /// Release all nodes but keep the most recent memory chunk for reuse
+   void reset();
+
    /// Set the result
    void setResult(ASTBase* ast) { result = ast; }
    /// Get the result
@@ -117,6 +125,10 @@ class ASTContainer {
    ASTBase* createList(std::string_view view, unsigned descriptor, ASTBase* head);
    /// Append a list result
    ASTBase* appendList(std::string_view view, unsigned descriptor, ASTBase* head, ASTBase* tail);
+   /// Copy a string into the container memory
+   std::string_view allocateString(std::string_view str);
+   /// Rebuild a tree. The callback is invoked top-down and can return a replacement for a node, or nullptr to keep it. Unchanged subtrees are shared with the original tree
+   ASTBase* rewrite(ASTBase* tree, const std::function<ASTBase*(ASTBase*)>& replace);
 };
 //---------------------------------------------------------------------------
 }
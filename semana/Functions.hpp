@@ -10,7 +10,7 @@
 //---------------------------------------------------------------------------
 namespace saneql {
 //---------------------------------------------------------------------------
-/// A collection of functions
+/// A collection of functions. Immutable after static initialization, can be used concurrently
 class Functions {
    public:
    /// Builtins
@@ -112,6 +112,7 @@ class Functions {
 
    /// Get the functions for a given type
    static const Functions* getFunctions(Type type);
+
    /// The functions defined on tables
    static const Functions table;
    /// The free functions
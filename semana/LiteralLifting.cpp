@@ -0,0 +1,78 @@
+#include "semana/LiteralLifting.hpp"
+#include "parser/AST.hpp"
+#include "parser/SaneQLLexer.hpp"
+#include "semana/SemanticAnalysis.hpp"
+#include <unordered_set>
+//---------------------------------------------------------------------------
+// (c) 2023 Thomas Neumann
+//---------------------------------------------------------------------------
+using namespace std;
+//---------------------------------------------------------------------------
+namespace saneql {
+//---------------------------------------------------------------------------
+static string getFunctionName(const ast::Call& call)
+// Get the name of the called function, if it is a simple name
+{
+   if (call.func->getType() == ast::AST::Type::Token) return ast::Token::ref(call.func).asString();
+   if (call.func->getType() == ast::AST::Type::Access) {
+      auto& access = ast::Access::ref(call.func);
+      if (access.part->getType() == ast::AST::Type::Token) return ast::Token::ref(access.part).asString();
+   }
+   return {};
+}
+//---------------------------------------------------------------------------
+ast::AST* LiteralLifting::lift(ASTContainer& container, ast::AST* query, vector<Literal>& literals)
+// Lift the literals
+{
+   // Literals that are interpreted as constants by the semantic analysis
+   unordered_set<const ASTBase*> constants;
+   // Explicit parameters would clash with the lifted ones
+   bool hasParameters = false;
+
+   auto replace = [&](ASTBase* node) -> ASTBase* {
+      auto ast = static_cast<ast::AST*>(node);
+      switch (ast->getType()) {
+         case ast::AST::Type::Call: {
+            // The direct literal arguments of orderby (limit, offset) and foreigncall (name) must stay constants
+            auto& call = ast::Call::ref(ast);
+            auto name = getFunctionName(call);
+            if ((name != "orderby") && (name != "foreigncall")) return nullptr;
+            for (auto iter = call.args; iter; iter = ast::List::ref(iter).tail) {
+               auto& arg = ast::FuncArg::ref(ast::List::ref(iter).head);
+               if (arg.value && (arg.value->getType() == ast::AST::Type::Literal)) constants.insert(arg.value);
+            }
+            return nullptr;
+         }
+         case ast::AST::Type::Parameter: hasParameters = true; return nullptr;
+         case ast::AST::Type::Literal: {
+            if (hasParameters || constants.contains(ast)) return nullptr;
+            auto& literal = ast::Literal::ref(ast);
+            if ((literal.getSubType() != ast::Literal::SubType::Integer) && (literal.getSubType() != ast::Literal::SubType::Float) && (literal.getSubType() != ast::Literal::SubType::String)) return nullptr;
+            auto value = ast::Token::ref(literal.arg).asString();
+            Type type = Type::getText();
+            if (literal.getSubType() == ast::Literal::SubType::Integer) {
+               type = Type::getInteger();
+            } else if (literal.getSubType() == ast::Literal::SubType::Float) {
+               type = SemanticAnalysis::inferDecimalType(value);
+               if (type.getType() == Type::Unknown) return nullptr;
+            }
+
+            // Build a parameter node in place of the literal
+            literals.push_back({move(value), type});
+            auto name = container.allocateString("$" + to_string(literals.size()));
+            auto token = new (container.allocateRaw(sizeof(ast::Token))) ast::Token(SaneQLLexer::TokenInfo{name, SaneQLLexer::TokenInfo::Encoding::Parameter});
+            return new (container.allocateRaw(sizeof(ast::Parameter))) ast::Parameter(name, token);
+         }
+         default: return nullptr;
+      }
+   };
+   auto result = static_cast<ast::AST*>(container.rewrite(query, replace));
+   if (hasParameters) {
+      literals.clear();
+      return query;
+   }
+   return result;
+}
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
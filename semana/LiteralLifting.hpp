@@ -0,0 +1,41 @@
+#ifndef H_saneql_LiteralLifting
+#define H_saneql_LiteralLifting
+//---------------------------------------------------------------------------
+#include "infra/Schema.hpp"
+#include <string>
+#include <vector>
+//---------------------------------------------------------------------------
+// SaneQL
+// (c) 2023 Thomas Neumann
+// SPDX-License-Identifier: BSD-3-Clause
+//---------------------------------------------------------------------------
+namespace saneql {
+//---------------------------------------------------------------------------
+class ASTContainer;
+//---------------------------------------------------------------------------
+namespace ast {
+class AST;
+}
+//---------------------------------------------------------------------------
+/// Replaces the literals of a query by parameters. Queries that only differ
+/// in their constants then share the same AST shape, and thus the same
+/// compiled SQL. Literals that must be constants (limits, foreign function
+/// names) and boolean and NULL literals are kept in place. Queries with
+/// explicit parameters are not changed.
+class LiteralLifting {
+   public:
+   /// A lifted literal
+   struct Literal {
+      /// The value
+      std::string value;
+      /// The type
+      Type type;
+   };
+
+   /// Lift the literals. The result references the original tree, the lifted literals are appended in parameter order
+   static ast::AST* lift(ASTContainer& container, ast::AST* query, std::vector<Literal>& literals);
+};
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
+#endif
@@ -273,6 +273,54 @@ void SemanticAnalysis::BindingInfo::join(const BindingInfo& other)
       }
 }
 //---------------------------------------------------------------------------
+vector<const algebra::IU*> SemanticAnalysis::BindingInfo::collectIUs() const
+// Collect all bound IUs without duplicates
+{
+   vector<const algebra::IU*> result;
+   unordered_set<const algebra::IU*> seen;
+   auto add = [&](const algebra::IU* iu) {
+      if ((iu != ambiguousIU) && seen.insert(iu).second) result.push_back(iu);
+   };
+   for (auto& c : columns)
+      add(c.iu);
+   for (auto& c : columnLookup)
+      add(c.second);
+   for (auto& s : scopes)
+      for (auto& c : s.second.columns)
+         add(c.second);
+   for (auto& a : aliases)
+      for (auto iu : a.second.columns)
+         add(iu);
+   return result;
+}
+//---------------------------------------------------------------------------
+SemanticAnalysis::BindingInfo SemanticAnalysis::BindingInfo::remap(const unordered_map<const algebra::IU*, const algebra::IU*>& mapping) const
+// Copy the binding with replaced IUs
+{
+   auto map = [&](const algebra::IU* iu) {
+      auto iter = mapping.find(iu);
+      return (iter != mapping.end()) ? iter->second : iu;
+   };
+   BindingInfo result;
+   for (auto& c : columns)
+      result.columns.push_back({c.name, map(c.iu)});
+   for (auto& c : columnLookup)
+      result.columnLookup[c.first] = map(c.second);
+   for (auto& s : scopes) {
+      auto& s2 = result.scopes[s.first];
+      s2.ambiguous = s.second.ambiguous;
+      for (auto& c : s.second.columns)
+         s2.columns[c.first] = map(c.second);
+   }
+   for (auto& a : aliases) {
+      auto& a2 = result.aliases[a.first];
+      a2.ambiguous = a.second.ambiguous;
+      for (auto iu : a.second.columns)
+         a2.columns.push_back(map(iu));
+   }
+   return result;
+}
+//---------------------------------------------------------------------------
 SemanticAnalysis::ExpressionResult::ExpressionResult(unique_ptr<algebra::Expression> expression, OrderingInfo ordering)
    : content(ScalarInfo{move(expression), move(ordering)})
 // Constructor
@@ -326,6 +374,17 @@ string SemanticAnalysis::extractSymbol(const BindingInfo& scope, const ast::AST*
    return name;
 }
 //---------------------------------------------------------------------------
+SemanticAnalysis::SemanticAnalysis(const Schema& schema)
+   : schema(schema)
+// Constructor
+{
+}
+//---------------------------------------------------------------------------
+SemanticAnalysis::~SemanticAnalysis()
+// Destructor
+{
+}
+//---------------------------------------------------------------------------
 SemanticAnalysis::ExpressionResult SemanticAnalysis::analyzeQuery(const ast::AST* query)
 // Analyze a query
 {
@@ -337,7 +396,73 @@ SemanticAnalysis::ExpressionResult SemanticAnalysis::analyzeQuery(const ast::AST
          analyzeLet(l);
    }
 
-   return analyzeExpression(BindingInfo::rootScope(), qb.body);
+   auto result = analyzeExpression(BindingInfo::rootScope(), qb.body);
+
+   // The copies of scalar lets reference the subquery inputs, they must not count as uses
+   for (auto& l : lets)
+      l.scalar.reset();
+   return result;
+}
+//---------------------------------------------------------------------------
+static unique_ptr<algebra::Expression> shareScalar(unique_ptr<algebra::Expression> value)
+// Compute a scalar with subqueries once in a single row CTE. Copies of the result only reference the CTE
+{
+   algebra::IUUsage usage;
+   value->collectUsage(usage);
+   if (usage.subqueries.empty()) return value;
+
+   auto type = value->getType();
+   vector<unique_ptr<algebra::IU>> columns;
+   columns.push_back(make_unique<algebra::IU>(type));
+   vector<const algebra::IU*> cteColumns{columns.back().get()};
+   vector<unique_ptr<algebra::Expression>> values;
+   values.push_back(move(value));
+   auto cte = make_shared<algebra::CTE>(make_unique<algebra::InlineTable>(move(columns), move(values), 1), move(cteColumns));
+
+   vector<algebra::Aggregate::Aggregation> aggregates;
+   aggregates.push_back({make_unique<algebra::IURef>(cte->columns.front()), make_unique<algebra::IU>(type), algebra::Aggregate::Op::Min});
+   auto result = make_unique<algebra::IURef>(aggregates.back().iu.get());
+   return make_unique<algebra::Aggregate>(make_unique<algebra::CTERef>(move(cte), vector<unique_ptr<algebra::IU>>()), move(aggregates), move(result));
+}
+//---------------------------------------------------------------------------
+SemanticAnalysis::ExpressionResult SemanticAnalysis::analyzeLetReference(unsigned slot)
+// Analyze a reference to a let without arguments
+{
+   // Reuse the already analyzed body. Every further reference gets its own IUs to keep self joins unambiguous
+   if (auto cte = lets[slot].cte) {
+      vector<unique_ptr<algebra::IU>> columns;
+      unordered_map<const algebra::IU*, const algebra::IU*> mapping;
+      for (auto iu : cte->columns) {
+         columns.push_back(make_unique<algebra::IU>(iu->getType()));
+         mapping[iu] = columns.back().get();
+      }
+      auto binding = lets[slot].cteBinding.remap(mapping);
+      return ExpressionResult(make_unique<algebra::CTERef>(move(cte), move(columns)), move(binding));
+   }
+
+   // Copy an already analyzed scalar body
+   if (lets[slot].scalar)
+      if (auto copy = lets[slot].scalar->clone({})) return ExpressionResult(move(copy), lets[slot].scalarOrdering);
+
+   // Analyze the body
+   auto result = [&]() {
+      SetLetScopeLimit setLetScopeLimit(this, slot);
+      return analyzeExpression(BindingInfo::rootScope(), lets[slot].body);
+   }();
+   if (result.isScalar()) {
+      // Remember a copy for further references. Bodies that cannot be copied are analyzed again
+      if (auto copy = result.scalar()->clone({})) lets[slot].scalar = shareScalar(move(copy));
+      lets[slot].scalarOrdering = result.getOrdering();
+      return result;
+   }
+
+   // Remember tables as shared CTE
+   auto& let = lets[slot];
+   auto& binding = result.accessBinding();
+   binding.parentScope = nullptr;
+   let.cte = make_shared<algebra::CTE>(move(result.table()), binding.collectIUs());
+   let.cteBinding = binding.remap({});
+   return ExpressionResult(make_unique<algebra::CTERef>(let.cte, vector<unique_ptr<algebra::IU>>()), move(binding));
 }
 //---------------------------------------------------------------------------
 string SemanticAnalysis::recognizeGensym(const ast::AST* ast)
@@ -366,7 +491,9 @@ string SemanticAnalysis::recognizeGensym(const ast::AST* ast)
    return " " + name + " " + to_string(nextSymbolId++);
 }
 //---------------------------------------------------------------------------
-static Type inferDecimalType(SemanticAnalysis& semana, const string& s) {
+saneql::Type SemanticAnalysis::inferDecimalType(string_view s)
+// Infer the type of a decimal literal
+{
    auto iter = s.begin(), limit = s.end();
 
    // Skip sign
@@ -384,7 +511,7 @@ static Type inferDecimalType(SemanticAnalysis& semana, const string& s) {
 
    unsigned precision = before + after, scale = after;
    if (precision < 1) precision = 1;
-   if (precision > 38) semana.reportError("decimal value out of range");
+   if (precision > 38) return Type::getUnknown();
    return Type::getDecimal(precision, scale);
 }
 //---------------------------------------------------------------------------
@@ -395,7 +522,13 @@ SemanticAnalysis::ExpressionResult SemanticAnalysis::analyzeLiteral(const ast::L
    unique_ptr<algebra::Expression> exp;
    switch (literal.getSubType()) {
       case SubType::Integer: exp = make_unique<algebra::ConstExpression>(extractString(literal.arg), Type::getInteger()); break;
-      case SubType::Float: exp = make_unique<algebra::ConstExpression>(extractString(literal.arg), inferDecimalType(*this, extractString(literal.arg))); break;
+      case SubType::Float: {
+         auto value = extractString(literal.arg);
+         auto type = inferDecimalType(value);
+         if (type.getType() == Type::Unknown) reportError("decimal value out of range");
+         exp = make_unique<algebra::ConstExpression>(move(value), type);
+         break;
+      }
       case SubType::String: exp = make_unique<algebra::ConstExpression>(extractString(literal.arg), Type::getText()); break;
       case SubType::True: exp = make_unique<algebra::ConstExpression>("true", Type::getBool()); break;
       case SubType::False: exp = make_unique<algebra::ConstExpression>("false", Type::getBool()); break;
@@ -404,6 +537,24 @@ SemanticAnalysis::ExpressionResult SemanticAnalysis::analyzeLiteral(const ast::L
    return ExpressionResult(move(exp), OrderingInfo::defaultOrder());
 }
 //---------------------------------------------------------------------------
+unsigned SemanticAnalysis::getParameterSlot(const ast::Parameter& parameter)
+// Get the slot of a parameter
+{
+   auto name = extractString(parameter.arg);
+   unsigned slot = 0;
+   auto [ptr, ec] = from_chars(name.data(), name.data() + name.size(), slot);
+   if ((ec != errc()) || (ptr != name.data() + name.size()) || (!slot) || (slot > 65535)) reportError("invalid parameter '$" + name + "'");
+   return slot - 1;
+}
+//---------------------------------------------------------------------------
+SemanticAnalysis::ExpressionResult SemanticAnalysis::analyzeParameter(const ast::Parameter& parameter)
+// Analyze a parameter
+{
+   auto slot = getParameterSlot(parameter);
+   if ((slot >= parameterTypes.size()) || (parameterTypes[slot].getType() == Type::Unknown)) reportError("parameter '$" + to_string(slot + 1) + "' has no type, declare it with a cast like $" + to_string(slot + 1) + "::integer");
+   return ExpressionResult(make_unique<algebra::ParameterExpression>(slot, parameterTypes[slot]), OrderingInfo::defaultOrder());
+}
+//---------------------------------------------------------------------------
 SemanticAnalysis::ExpressionResult SemanticAnalysis::analyzeAccess(const BindingInfo& scope, const ast::Access& ast)
 // Analyze access
 {
@@ -671,7 +822,17 @@ SemanticAnalysis::ExpressionResult SemanticAnalysis::analyzeAggregate(Expression
    auto& result = g.front();
    if (!result.value.isScalar()) reportError("aggregate requires scalar aggregates");
 
-   unique_ptr<algebra::Expression> tree = make_unique<algebra::Aggregate>(move(input.table()), move(aggregates), move(result.value.scalar()));
+   // Within lets an uncorrelated input becomes a CTE, copies of the let share it. A CTE that is used once is expanded in place
+   auto op = move(input.table());
+   if (letScopeLimit != ~0u) {
+      algebra::IUUsage usage;
+      unordered_set<const algebra::IU*> produced;
+      op->collectUsage(usage);
+      op->collectProduced(produced);
+      if (all_of(usage.used.begin(), usage.used.end(), [&](const algebra::IU* iu) { return produced.contains(iu); }))
+         op = make_unique<algebra::CTERef>(make_shared<algebra::CTE>(move(op), input.getBinding().collectIUs()), vector<unique_ptr<algebra::IU>>());
+   }
+   unique_ptr<algebra::Expression> tree = make_unique<algebra::Aggregate>(move(op), move(aggregates), move(result.value.scalar()));
 
    return ExpressionResult(move(tree), OrderingInfo::defaultOrder());
 }
@@ -971,11 +1132,23 @@ SemanticAnalysis::ExtendedType SemanticAnalysis::analyzeType(const ast::Type& ty
 SemanticAnalysis::ExpressionResult SemanticAnalysis::analyzeCast(const BindingInfo& scope, const ast::Cast& cast)
 // Analyze a cast expression
 {
-   auto value = analyzeExpression(scope, cast.value);
-   if (!value.isScalar()) reportError("casts require scalar values");
    auto type = analyzeType(ast::Type::ref(cast.type));
    if (!type.isBasic()) reportError("invalid cast type");
 
+   // A cast of an untyped parameter declares its type
+   if (cast.value->getType() == ast::AST::Type::Parameter) {
+      auto slot = getParameterSlot(ast::Parameter::ref(cast.value));
+      if (slot >= parameterTypes.size()) parameterTypes.resize(slot + 1, Type::getUnknown());
+      if (parameterTypes[slot].getType() == Type::Unknown) parameterTypes[slot] = type.getBasicType();
+   }
+
+   auto value = analyzeExpression(scope, cast.value);
+   if (!value.isScalar()) reportError("casts require scalar values");
+
+   // Parameters of the target type or of text type are cast directly into the target type
+   if (auto p = dynamic_cast<algebra::ParameterExpression*>(value.scalar().get()); p && ((p->getType() == type.getBasicType()) || (p->getType().getType() == Type::Text)))
+      return ExpressionResult(make_unique<algebra::ParameterExpression>(p->getSlot(), type.getBasicType()), value.getOrdering());
+
    return ExpressionResult(make_unique<algebra::CastExpression>(move(value.scalar()), type.getBasicType()), value.getOrdering());
 }
 //---------------------------------------------------------------------------
@@ -1582,10 +1755,8 @@ SemanticAnalysis::ExpressionResult SemanticAnalysis::analyzeToken(const BindingI
 
    // A let?
    if (auto iter = letLookup.find(name); iter != letLookup.end()) {
-      auto& l = lets[iter->second];
-      if (!l.signature.arguments.empty()) reportError("'" + name + "' is a function");
-      SetLetScopeLimit setLetScopeLimit(this, iter->second);
-      return analyzeExpression(BindingInfo::rootScope(), l.body);
+      if (!lets[iter->second].signature.arguments.empty()) reportError("'" + name + "' is a function");
+      return analyzeLetReference(iter->second);
    }
 
    // Table scan?
@@ -1601,7 +1772,7 @@ SemanticAnalysis::ExpressionResult SemanticAnalysis::analyzeToken(const BindingI
       columns.push_back({c.name, make_unique<algebra::IU>(c.type)});
       binding.addBinding(resultScope, getInternalName(c.name), columns.back().iu.get());
    }
-   return ExpressionResult(make_unique<algebra::TableScan>(name, move(columns)), move(binding));
+   return ExpressionResult(make_unique<algebra::TableScan>(name, move(columns), table), move(binding));
 }
 //---------------------------------------------------------------------------
 SemanticAnalysis::ExpressionResult SemanticAnalysis::analyzeExpression(const BindingInfo& scope, const ast::AST* exp)
@@ -1613,6 +1784,7 @@ SemanticAnalysis::ExpressionResult SemanticAnalysis::analyzeExpression(const Bin
       case ast::AST::Type::Call: return analyzeCall(scope, ast::Call::ref(exp));
       case ast::AST::Type::Cast: return analyzeCast(scope, ast::Cast::ref(exp));
       case ast::AST::Type::Literal: return analyzeLiteral(ast::Literal::ref(exp));
+      case ast::AST::Type::Parameter: return analyzeParameter(ast::Parameter::ref(exp));
       case ast::AST::Type::Token: return analyzeToken(scope, exp);
       case ast::AST::Type::UnaryExpression: return analyzeUnaryExpression(scope, ast::UnaryExpression::ref(exp));
       default: invalidAST();
@@ -22,11 +22,13 @@ class Cast;
 class FuncArg;
 class LetEntry;
 class Literal;
+class Parameter;
 class Type;
 class UnaryExpression;
 }
 //---------------------------------------------------------------------------
 namespace algebra {
+class CTE;
 class Expression;
 class IU;
 class Operator;
@@ -163,15 +165,15 @@ class SemanticAnalysis {
 
       /// Merge after a join
       void join(const BindingInfo& other);
+      /// Collect all bound IUs without duplicates
+      std::vector<const algebra::IU*> collectIUs() const;
+      /// Copy the binding with replaced IUs
+      BindingInfo remap(const std::unordered_map<const algebra::IU*, const algebra::IU*>& mapping) const;
 
       /// Get the group by scope
       GroupByScope* getGroupByScope() const { return gbs; }
    };
 
-   private:
-   /// The schema
-   const Schema& schema;
-
    /// An expression container
    struct ExpressionResult {
       /// Content for scalar expressions
@@ -219,6 +221,11 @@ class SemanticAnalysis {
       /// Access the binding
       const BindingInfo& getBinding() const { return std::get<1>(content).binding; }
    };
+
+   private:
+   /// The schema
+   const Schema& schema;
+
    /// Information about an extended type
    struct ExtendedType {
       /// The content
@@ -240,6 +247,14 @@ class SemanticAnalysis {
       std::vector<const ast::AST*> defaultValues;
       /// The body of the let
       const ast::AST* body;
+      /// The analyzed body of a table valued let without arguments. Is shared between all references
+      std::shared_ptr<algebra::CTE> cte = {};
+      /// The binding of the analyzed body
+      BindingInfo cteBinding = {};
+      /// A copy of the analyzed body of a scalar let without arguments, computed in a CTE if it contains subqueries. Every further reference gets a copy of its own
+      std::unique_ptr<algebra::Expression> scalar;
+      /// The ordering of the scalar body
+      OrderingInfo scalarOrdering = OrderingInfo::defaultOrder();
    };
 
    /// All lets
@@ -250,6 +265,8 @@ class SemanticAnalysis {
    unsigned letScopeLimit = ~0u;
    /// The next symbol id
    unsigned nextSymbolId = 1;
+   /// The types of the query parameters
+   std::vector<Type> parameterTypes;
 
    /// Change the let scope limit
    class SetLetScopeLimit {
@@ -276,12 +293,24 @@ class SemanticAnalysis {
    saneql::Type parseSimpleTypeName(const std::string& name);
    /// Analyze a type
    ExtendedType analyzeType(const ast::Type& type);
+   /// Infer the type of a decimal literal. Returns the unknown type if the value is out of range
+   static saneql::Type inferDecimalType(std::string_view value);
+   /// Set the types of the query parameters. $1 is the first entry, unknown types can be declared by casts within the query
+   void setParameterTypes(std::vector<saneql::Type> types) { parameterTypes = std::move(types); }
+   /// Get the types of the query parameters. Includes the types declared by casts
+   const std::vector<saneql::Type>& getParameterTypes() const { return parameterTypes; }
 
    private:
    /// Recognize gensym calls. Returns an empty string otherwise
    std::string recognizeGensym(const ast::AST* ast);
+   /// Analyze a reference to a let without arguments
+   ExpressionResult analyzeLetReference(unsigned slot);
    /// Analyze a literal
    ExpressionResult analyzeLiteral(const ast::Literal& literal);
+   /// Get the slot of a parameter
+   unsigned getParameterSlot(const ast::Parameter& parameter);
+   /// Analyze a parameter
+   ExpressionResult analyzeParameter(const ast::Parameter& parameter);
    /// Analyze access
    ExpressionResult analyzeAccess(const BindingInfo& scope, const ast::Access& ast);
    /// Analyze a binary expression
@@ -348,7 +377,9 @@ class SemanticAnalysis {
 
    public:
    /// Constructor
-   explicit SemanticAnalysis(Schema& schema) : schema(schema) {}
+   explicit SemanticAnalysis(const Schema& schema);
+   /// Destructor
+   ~SemanticAnalysis();
 
    /// Analyze a query
    ExpressionResult analyzeQuery(const ast::AST* query);
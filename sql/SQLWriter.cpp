@@ -1,5 +1,7 @@
 #include "sql/SQLWriter.hpp"
 #include "infra/Schema.hpp"
+#include <ostream>
+#include <stdexcept>
 //---------------------------------------------------------------------------
 // (c) 2023 Thomas Neumann
 //---------------------------------------------------------------------------
@@ -8,11 +10,19 @@ using namespace std;
 namespace saneql {
 //---------------------------------------------------------------------------
 SQLWriter::SQLWriter()
-   : target(&result)
+   : target(&result), placeholderTarget(&placeholders)
 // Constructor
 {
 }
 //---------------------------------------------------------------------------
+SQLWriter::SQLWriter(ostream& sink)
+   : SQLWriter()
+// Constructor
+{
+   this->sink = &sink;
+   result.reserve(chunkSize);
+}
+//---------------------------------------------------------------------------
 SQLWriter::~SQLWriter()
 // Destructor
 {
@@ -23,6 +33,27 @@ void SQLWriter::write(std::string_view sql)
 {
    auto& writer = *target;
    writer += sql;
+   if ((target == &result) && (result.size() >= chunkSize)) flushChunk();
+}
+//---------------------------------------------------------------------------
+void SQLWriter::flushChunk()
+// Complete the current result chunk
+{
+   if (sink) {
+      // The WITH clause has to come first, later CTEs are expanded in place instead
+      if (!streamed) {
+         string prefix;
+         writeCTEDefinitions(prefix);
+         sink->write(prefix.data(), prefix.size());
+         streamed = true;
+      }
+      sink->write(result.data(), result.size());
+      result.clear();
+   } else {
+      chunks.push_back(move(result));
+      result = string();
+      result.reserve(chunkSize);
+   }
 }
 //---------------------------------------------------------------------------
 void SQLWriter::writeIdentifier(std::string_view identifier)
@@ -43,6 +74,14 @@ void SQLWriter::writeIdentifier(std::string_view identifier)
 void SQLWriter::writeIU(const algebra::IU* iu)
 // Write an IU
 {
+   if (!replacedIUs.empty())
+      if (auto iter = replacedIUs.find(iu); iter != replacedIUs.end()) {
+         write("(");
+         writeFragment(*iter->second);
+         write(")");
+         return;
+      }
+   if (fragment) fragment->ius.insert(iu);
    auto& writer = *target;
    if (auto iter = iuNames.find(iu); iter != iuNames.end()) {
       writer += iter->second;
@@ -85,5 +124,171 @@ void SQLWriter::writeType(Type type)
    }
 }
 //---------------------------------------------------------------------------
+void SQLWriter::writeParameter(unsigned slot)
+// Write a parameter placeholder
+{
+   auto& writer = *target;
+   if (parameterValues) {
+      if ((slot < parameterValues->size()) && (*parameterValues)[slot])
+         writeString(*(*parameterValues)[slot]);
+      else
+         writer += "NULL";
+      return;
+   }
+   if (placeholderStyle == PlaceholderStyle::Numbered) {
+      writer += '$';
+      writer += to_string(slot + 1);
+   } else {
+      writer += '?';
+   }
+   placeholderTarget->push_back(slot);
+}
+//---------------------------------------------------------------------------
+void SQLWriter::beginCTE(const algebra::CTE* cte)
+// Start the definition of a CTE
+{
+   // The WITH clause was written already, queries with shared CTEs must not be streamed
+   if (streamed) throw runtime_error("CTE defined after the result was streamed");
+   cteLookup[cte] = ctes.size();
+   openCTEs.push_back(ctes.size());
+   auto& def = ctes.emplace_back();
+   def.name = "c_" + to_string(ctes.size());
+   savedTargets.emplace_back(target, placeholderTarget);
+   savedFragments.push_back(fragment);
+   target = &def.sql;
+   placeholderTarget = &def.placeholders;
+   fragment = nullptr;
+}
+//---------------------------------------------------------------------------
+void SQLWriter::endCTE()
+// Finish the definition of a CTE
+{
+   // Nested definitions finish first, which gives a valid definition order
+   cteOrder.push_back(openCTEs.back());
+   openCTEs.pop_back();
+   tie(target, placeholderTarget) = savedTargets.back();
+   savedTargets.pop_back();
+   fragment = savedFragments.back();
+   savedFragments.pop_back();
+}
+//---------------------------------------------------------------------------
+void SQLWriter::writeCTE(const algebra::CTE* cte)
+// Write the name of a CTE
+{
+   *target += ctes[cteLookup.at(cte)].name;
+}
+//---------------------------------------------------------------------------
+void SQLWriter::beginFragment(Fragment& newFragment)
+// Start a fragment
+{
+   savedTargets.emplace_back(target, placeholderTarget);
+   savedFragments.push_back(fragment);
+   target = &newFragment.sql;
+   placeholderTarget = &newFragment.placeholders;
+   fragment = &newFragment;
+}
+//---------------------------------------------------------------------------
+void SQLWriter::endFragment()
+// Finish a fragment
+{
+   tie(target, placeholderTarget) = savedTargets.back();
+   savedTargets.pop_back();
+   fragment = savedFragments.back();
+   savedFragments.pop_back();
+}
+//---------------------------------------------------------------------------
+void SQLWriter::writeFragment(const Fragment& other)
+// Write a fragment
+{
+   *target += other.sql;
+   if ((target == &result) && (result.size() >= chunkSize)) flushChunk();
+   placeholderTarget->insert(placeholderTarget->end(), other.placeholders.begin(), other.placeholders.end());
+   if (fragment) fragment->ius.insert(other.ius.begin(), other.ius.end());
+}
+//---------------------------------------------------------------------------
+void SQLWriter::replaceIU(const algebra::IU* iu, const Fragment* replacement)
+// Write the given fragment instead of the name of an IU
+{
+   if (replacement)
+      replacedIUs[iu] = replacement;
+   else
+      replacedIUs.erase(iu);
+}
+//---------------------------------------------------------------------------
+void SQLWriter::writeTableAlias()
+// Write a fresh table alias
+{
+   *target += "s_" + to_string(++aliasCount);
+}
+//---------------------------------------------------------------------------
+void SQLWriter::writeCTEDefinitions(string& out) const
+// Write the WITH clause for the CTEs
+{
+   if (cteOrder.empty()) return;
+
+   out += "with ";
+   bool first = true;
+   for (auto index : cteOrder) {
+      if (first)
+         first = false;
+      else
+         out += ", ";
+      out += ctes[index].name;
+      out += materializeCTEs ? " as materialized (" : " as (";
+      out += ctes[index].sql;
+      out += ')';
+   }
+   out += ' ';
+}
+//---------------------------------------------------------------------------
+string SQLWriter::getResult() const&
+// Get the result
+{
+   string sql;
+   writeCTEDefinitions(sql);
+   size_t size = sql.size() + result.size();
+   for (auto& c : chunks)
+      size += c.size();
+   sql.reserve(size);
+   for (auto& c : chunks)
+      sql += c;
+   sql += result;
+   return sql;
+}
+//---------------------------------------------------------------------------
+string SQLWriter::getResult() &&
+// Get the result, reusing the buffer if possible
+{
+   if (cteOrder.empty() && chunks.empty()) return move(result);
+   return getResult();
+}
+//---------------------------------------------------------------------------
+void SQLWriter::writeResult(ostream& out) const
+// Write the result to a stream without assembling it first
+{
+   string prefix;
+   writeCTEDefinitions(prefix);
+   out.write(prefix.data(), prefix.size());
+   for (auto& c : chunks)
+      out.write(c.data(), c.size());
+   out.write(result.data(), result.size());
+}
+//---------------------------------------------------------------------------
+void SQLWriter::finish()
+// Write the remaining result to the sink
+{
+   if (sink) flushChunk();
+}
+//---------------------------------------------------------------------------
+vector<unsigned> SQLWriter::getPlaceholders() const
+// Get the parameters in the order their placeholders appear in the result
+{
+   vector<unsigned> all;
+   for (auto index : cteOrder)
+      all.insert(all.end(), ctes[index].placeholders.begin(), ctes[index].placeholders.end());
+   all.insert(all.end(), placeholders.begin(), placeholders.end());
+   return all;
+}
+//---------------------------------------------------------------------------
 }
 //---------------------------------------------------------------------------
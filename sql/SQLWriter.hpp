@@ -1,9 +1,14 @@
 #ifndef H_saneql_SQLWriter
 #define H_saneql_SQLWriter
 //---------------------------------------------------------------------------
+#include <deque>
+#include <iosfwd>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 //---------------------------------------------------------------------------
 // SaneQL
 // (c) 2023 Thomas Neumann
@@ -14,22 +19,97 @@ namespace saneql {
 class Type;
 //---------------------------------------------------------------------------
 namespace algebra {
+class CTE;
 class IU;
 }
 //---------------------------------------------------------------------------
 /// Helper class to generate SQL
 class SQLWriter {
+   public:
+   /// The syntax for query parameters
+   enum class PlaceholderStyle {
+      /// $1, $2, ... (PostgreSQL, DuckDB)
+      Numbered,
+      /// ? in order of appearance (SQLite, JDBC)
+      Positional
+   };
+   /// A SQL fragment that is generated ahead of its final position
+   struct Fragment {
+      /// The SQL text
+      std::string sql;
+      /// The parameters in the order their placeholders appear in the SQL text
+      std::vector<unsigned> placeholders;
+      /// The IUs referenced by the SQL text
+      std::unordered_set<const algebra::IU*> ius;
+   };
+
    private:
-   /// The result buffer
+   /// A common table expression definition
+   struct CTEDefinition {
+      /// The name
+      std::string name;
+      /// The SQL text
+      std::string sql;
+      /// The parameters in the order their placeholders appear in the SQL text
+      std::vector<unsigned> placeholders;
+   };
+
+   /// The size of output chunks
+   static constexpr size_t chunkSize = 64 * 1024;
+
+   /// The result buffer. Holds the tail of the result, completed chunks are moved to chunks or written to the sink
    std::string result;
+   /// The completed result chunks
+   std::vector<std::string> chunks;
+   /// The output sink (if any)
+   std::ostream* sink = nullptr;
+   /// Did we write to the sink already?
+   bool streamed = false;
    /// The current target
    std::string* target;
+   /// The saved targets of enclosing CTEs and fragments
+   std::vector<std::pair<std::string*, std::vector<unsigned>*>> savedTargets;
+   /// The current fragment (if any)
+   Fragment* fragment = nullptr;
+   /// The saved enclosing fragments
+   std::vector<Fragment*> savedFragments;
+   /// IUs that are written as an inlined fragment instead of their name
+   std::unordered_map<const algebra::IU*, const Fragment*> replacedIUs;
+   /// The number of table aliases
+   unsigned aliasCount = 0;
    /// All assigned IU names
    std::unordered_map<const algebra::IU*, std::string> iuNames;
+   /// The placeholder style
+   PlaceholderStyle placeholderStyle = PlaceholderStyle::Numbered;
+   /// The parameters in the order their placeholders appear in the result
+   std::vector<unsigned> placeholders;
+   /// The current placeholder target
+   std::vector<unsigned>* placeholderTarget;
+   /// The CTE definitions
+   std::deque<CTEDefinition> ctes;
+   /// The CTE lookup
+   std::unordered_map<const algebra::CTE*, unsigned> cteLookup;
+   /// The completed CTEs in definition order. Each CTE only references CTEs defined before it
+   std::vector<unsigned> cteOrder;
+   /// The CTEs that are currently being defined
+   std::vector<unsigned> openCTEs;
+   /// Emit CTEs as materialized?
+   bool materializeCTEs = false;
+   /// Merge operators into as few SELECT blocks as possible?
+   bool flatSQL = false;
+   /// The parameter values to write instead of placeholders (if any)
+   const std::vector<std::optional<std::string>>* parameterValues = nullptr;
+
+   /// Complete the current result chunk
+   void flushChunk();
+   /// Write the WITH clause for the CTEs
+   void writeCTEDefinitions(std::string& out) const;
 
    public:
    /// Constructor
    SQLWriter();
+   /// Constructor. The result is written to the sink in chunks while it is generated, call finish at the end. Queries with shared CTEs must be buffered instead
+   explicit SQLWriter(std::ostream& sink);
    /// Destructor
    ~SQLWriter();
 
@@ -43,9 +123,49 @@ class SQLWriter {
    void writeString(std::string_view str);
    /// Write a type
    void writeType(Type type);
+   /// Write a parameter placeholder. Parameters are numbered from 0
+   void writeParameter(unsigned slot);
+
+   /// Is a CTE defined?
+   bool isCTEDefined(const algebra::CTE* cte) const { return cteLookup.contains(cte); }
+   /// Start the definition of a CTE. Output goes into the definition until endCTE is called. Throws once the beginning of the result was written to the sink
+   void beginCTE(const algebra::CTE* cte);
+   /// Finish the definition of a CTE
+   void endCTE();
+   /// Write the name of a CTE
+   void writeCTE(const algebra::CTE* cte);
+
+   /// Start a fragment. Output goes into the fragment until endFragment is called
+   void beginFragment(Fragment& fragment);
+   /// Finish a fragment
+   void endFragment();
+   /// Write a fragment
+   void writeFragment(const Fragment& fragment);
+   /// Write the given fragment instead of the name of an IU. A nullptr fragment restores the name
+   void replaceIU(const algebra::IU* iu, const Fragment* fragment);
+   /// Write a fresh table alias
+   void writeTableAlias();
 
+   /// Change the placeholder style
+   void setPlaceholderStyle(PlaceholderStyle style) { placeholderStyle = style; }
+   /// Emit CTEs as materialized, preventing the database from inlining them
+   void setMaterializeCTEs(bool materialize) { materializeCTEs = materialize; }
+   /// Merge consecutive operators into shared SELECT blocks instead of nesting a derived table per operator
+   void setFlatSQL(bool flat) { flatSQL = flat; }
+   /// Generate flat SQL?
+   bool isFlatSQL() const { return flatSQL; }
+   /// Write parameter values instead of placeholders. Missing values are written as NULL
+   void setParameterValues(const std::vector<std::optional<std::string>>* values) { parameterValues = values; }
    /// Get the result
-   std::string getResult() const { return result; }
+   std::string getResult() const&;
+   /// Get the result, reusing the buffer if possible
+   std::string getResult() &&;
+   /// Write the result to a stream without assembling it first
+   void writeResult(std::ostream& out) const;
+   /// Write the remaining result to the sink
+   void finish();
+   /// Get the parameters in the order their placeholders appear in the result
+   std::vector<unsigned> getPlaceholders() const;
 };
 //---------------------------------------------------------------------------
 }